@@ -0,0 +1,290 @@
+#include "backend_pool.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <errno.h>
+#include <stdint.h>
+#include <time.h>
+#include <pthread.h>
+#include <sys/socket.h>
+#include <sys/uio.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <netdb.h>
+
+// LSRP framing (same wire format as lsrp_client_send / lsrp_server):
+//   request:  "LSRP" | u32 params length (big-endian) | params
+//   response: "LSRP" | u8 status | u32 data length (big-endian) | data
+#define LSRP_MAGIC "LSRP"
+#define REQUEST_HEAD_LEN 8
+#define RESPONSE_HEAD_LEN 9
+
+typedef struct {
+    int fd;
+    time_t last_used;
+} idle_conn_t;
+
+typedef struct backend {
+    char host[256];
+    int port;
+    idle_conn_t *idle;      // capacity slots, most recently used last
+    int idle_count;
+    int capacity;           // max_idle when the entry was created
+    struct backend *next;
+} backend_t;
+
+static struct {
+    pthread_mutex_t lock;
+    backend_t *backends;
+    int max_idle;
+    int idle_sec;
+} pool = {
+    .lock = PTHREAD_MUTEX_INITIALIZER,
+    .max_idle = BACKEND_POOL_DEFAULT_MAX_IDLE,
+    .idle_sec = BACKEND_POOL_DEFAULT_IDLE_SEC
+};
+
+void backend_pool_init(int max_idle, int idle_sec) {
+    pthread_mutex_lock(&pool.lock);
+    if (max_idle >= 0) pool.max_idle = max_idle;
+    if (idle_sec > 0) pool.idle_sec = idle_sec;
+    pthread_mutex_unlock(&pool.lock);
+}
+
+// Find or create the entry for host:port (pool.lock held)
+static backend_t *find_backend(const char *host, int port, int create) {
+    for (backend_t *b = pool.backends; b; b = b->next) {
+        if (b->port == port && strcmp(b->host, host) == 0) return b;
+    }
+    if (!create || pool.max_idle == 0) return NULL;
+
+    backend_t *b = calloc(1, sizeof(backend_t));
+    if (!b) return NULL;
+    b->idle = calloc((size_t)pool.max_idle, sizeof(idle_conn_t));
+    if (!b->idle) {
+        free(b);
+        return NULL;
+    }
+    snprintf(b->host, sizeof(b->host), "%s", host);
+    b->port = port;
+    b->capacity = pool.max_idle;
+    b->next = pool.backends;
+    pool.backends = b;
+    return b;
+}
+
+// An idle connection is healthy if the backend has neither closed it nor
+// sent anything unsolicited
+static int conn_healthy(int fd) {
+    char c;
+    ssize_t n = recv(fd, &c, 1, MSG_PEEK | MSG_DONTWAIT);
+    return n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK);
+}
+
+// Pop a healthy idle connection, closing expired or broken ones; -1 if none
+static int pool_take(const char *host, int port) {
+    int fd = -1;
+    time_t now = time(NULL);
+
+    pthread_mutex_lock(&pool.lock);
+    backend_t *b = find_backend(host, port, 0);
+    while (b && b->idle_count > 0 && fd < 0) {
+        idle_conn_t conn = b->idle[--b->idle_count];
+        if (now - conn.last_used <= pool.idle_sec && conn_healthy(conn.fd)) {
+            fd = conn.fd;
+        } else {
+            close(conn.fd);
+        }
+    }
+    pthread_mutex_unlock(&pool.lock);
+    return fd;
+}
+
+// Return a connection after a complete exchange, or close it if it is not
+// reusable or the pool is full
+static void pool_put(const char *host, int port, int fd) {
+    if (!conn_healthy(fd)) {
+        close(fd);
+        return;
+    }
+
+    time_t now = time(NULL);
+    pthread_mutex_lock(&pool.lock);
+    backend_t *b = find_backend(host, port, 1);
+    if (b) {
+        // Expired connections sit at the bottom of the stack
+        int expired = 0;
+        while (expired < b->idle_count && now - b->idle[expired].last_used > pool.idle_sec) {
+            close(b->idle[expired].fd);
+            expired++;
+        }
+        if (expired > 0) {
+            b->idle_count -= expired;
+            memmove(b->idle, b->idle + expired, (size_t)b->idle_count * sizeof(idle_conn_t));
+        }
+        if (b->idle_count < b->capacity) {
+            b->idle[b->idle_count].fd = fd;
+            b->idle[b->idle_count].last_used = now;
+            b->idle_count++;
+            fd = -1;
+        }
+    }
+    pthread_mutex_unlock(&pool.lock);
+
+    if (fd >= 0) close(fd);
+}
+
+static int dial(const char *host, int port) {
+    char port_str[16];
+    snprintf(port_str, sizeof(port_str), "%d", port);
+
+    struct addrinfo hints = { .ai_family = AF_INET, .ai_socktype = SOCK_STREAM };
+    struct addrinfo *res = NULL;
+    if (getaddrinfo(host, port_str, &hints, &res) != 0) {
+        fprintf(stderr, "backend pool: cannot resolve %s\n", host);
+        return -1;
+    }
+
+    int fd = socket(res->ai_family, res->ai_socktype, res->ai_protocol);
+    if (fd >= 0 && connect(fd, res->ai_addr, res->ai_addrlen) != 0) {
+        close(fd);
+        fd = -1;
+    }
+    freeaddrinfo(res);
+    if (fd < 0) return -1;
+
+    struct timeval tv = { .tv_sec = BACKEND_POOL_IO_TIMEOUT_SEC };
+    setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+    setsockopt(fd, SOL_SOCKET, SO_SNDTIMEO, &tv, sizeof(tv));
+    int one = 1;
+    setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+    return fd;
+}
+
+static int recv_full(int fd, void *buf, size_t len) {
+    size_t got = 0;
+    while (got < len) {
+        ssize_t n = recv(fd, (char *)buf + got, len - got, 0);
+        if (n > 0) {
+            got += (size_t)n;
+        } else if (n < 0 && errno == EINTR) {
+            continue;
+        } else {
+            // Closed or reset before any byte: the backend dropped an idle
+            // connection. Timeouts and mid-response failures are not retried.
+            int dropped = n == 0 || errno == ECONNRESET || errno == EPIPE;
+            return (dropped && got == 0) ? -1 : -2;
+        }
+    }
+    return 0;
+}
+
+// One request/response on fd. Returns 0 on success, -1 if nothing was
+// received (safe to retry on another connection), -2 on any later failure.
+static int exchange(int fd, const char *params, size_t params_len, lsrp_response_t *resp) {
+    unsigned char head[RESPONSE_HEAD_LEN];
+    memcpy(head, LSRP_MAGIC, 4);
+    head[4] = (unsigned char)(params_len >> 24);
+    head[5] = (unsigned char)(params_len >> 16);
+    head[6] = (unsigned char)(params_len >> 8);
+    head[7] = (unsigned char)params_len;
+
+    struct iovec iov[2] = {
+        { .iov_base = head, .iov_len = REQUEST_HEAD_LEN },
+        { .iov_base = (void *)params, .iov_len = params_len }
+    };
+    struct msghdr msg = { .msg_iov = iov, .msg_iovlen = 2 };
+    size_t total = REQUEST_HEAD_LEN + params_len;
+    ssize_t sent = sendmsg(fd, &msg, MSG_NOSIGNAL);
+    if (sent < 0) return -1;
+    while ((size_t)sent < total) {
+        // Short write: finish the rest from the right offset
+        size_t off = (size_t)sent;
+        const char *rest = off < REQUEST_HEAD_LEN ? (const char *)head + off : params + (off - REQUEST_HEAD_LEN);
+        size_t rest_len = off < REQUEST_HEAD_LEN ? REQUEST_HEAD_LEN - off : total - off;
+        ssize_t n = send(fd, rest, rest_len, MSG_NOSIGNAL);
+        if (n <= 0) return -2;
+        sent += n;
+    }
+
+    int rc = recv_full(fd, head, RESPONSE_HEAD_LEN);
+    if (rc != 0) return rc;
+    if (memcmp(head, LSRP_MAGIC, 4) != 0) return -2;
+
+    uint32_t len = ((uint32_t)head[5] << 24) | ((uint32_t)head[6] << 16) |
+                   ((uint32_t)head[7] << 8) | (uint32_t)head[8];
+    if (len > BACKEND_POOL_MAX_RESPONSE) {
+        fprintf(stderr, "backend pool: response of %u bytes exceeds the limit\n", len);
+        return -2;
+    }
+
+    char *data = malloc((size_t)len + 1);
+    if (!data) return -2;
+    if (len > 0 && recv_full(fd, data, len) != 0) {
+        free(data);
+        return -2;
+    }
+    data[len] = '\0';
+
+    resp->status = head[4];
+    resp->data = (void *)data;
+    resp->data_len = len;
+    return 0;
+}
+
+int backend_pool_send(const char *host, int port, const char *params, lsrp_response_t *resp) {
+    if (!host || !params || !resp) return -1;
+    size_t params_len = strlen(params);
+    if (params_len > LSRP_MAX_PARAMS_LEN) return -1;
+
+    // A reused connection may have been closed by the backend since the
+    // health probe; such a request is retried once on a fresh connection
+    int fd = pool_take(host, port);
+    if (fd >= 0) {
+        int rc = exchange(fd, params, params_len, resp);
+        if (rc == 0) {
+            pool_put(host, port, fd);
+            return 0;
+        }
+        close(fd);
+        if (rc != -1) return -1;
+    }
+
+    fd = dial(host, port);
+    if (fd < 0) {
+        // The backend is down or moved: its idle connections are stale too
+        backend_pool_evict(host, port);
+        return -1;
+    }
+    if (exchange(fd, params, params_len, resp) != 0) {
+        close(fd);
+        return -1;
+    }
+    pool_put(host, port, fd);
+    return 0;
+}
+
+void backend_pool_evict(const char *host, int port) {
+    pthread_mutex_lock(&pool.lock);
+    backend_t *b = find_backend(host, port, 0);
+    if (b) {
+        for (int i = 0; i < b->idle_count; i++) close(b->idle[i].fd);
+        b->idle_count = 0;
+    }
+    pthread_mutex_unlock(&pool.lock);
+}
+
+void backend_pool_free(void) {
+    pthread_mutex_lock(&pool.lock);
+    backend_t *b = pool.backends;
+    while (b) {
+        backend_t *next = b->next;
+        for (int i = 0; i < b->idle_count; i++) close(b->idle[i].fd);
+        free(b->idle);
+        free(b);
+        b = next;
+    }
+    pool.backends = NULL;
+    pthread_mutex_unlock(&pool.lock);
+}
@@ -0,0 +1,38 @@
+#ifndef BACKEND_POOL_H
+#define BACKEND_POOL_H
+
+#include "../lsrp/lsrp_client.h"
+
+// Persistent LSRP connections from the gate to its backends.
+//
+// Idle connections are kept per backend (host:port, so datasources pointing
+// at the same svgd share them) and reused LIFO. A connection is dropped when
+// it has been idle longer than the idle timeout, when a health probe finds
+// it closed or readable before a request, or after any I/O error. A request
+// that fails on a reused connection before any response byte arrived is
+// retried once on a fresh one. Backends that close the connection after
+// each response still work: the close is seen when the connection is
+// returned, and the next request dials again.
+
+#define BACKEND_POOL_DEFAULT_MAX_IDLE 16      // idle connections kept per backend
+#define BACKEND_POOL_DEFAULT_IDLE_SEC 30      // idle connections older than this are closed
+#define BACKEND_POOL_IO_TIMEOUT_SEC 10        // send/recv timeout, as lsrp_client_send
+#define BACKEND_POOL_MAX_RESPONSE (64 * 1024 * 1024)  // _batch responses exceed lsrp_client's 1 MiB
+
+// Set pool limits (before the first request)
+// max_idle: idle connections kept per backend; 0 disables pooling (one connection per request)
+// idle_sec: idle timeout in seconds (<= 0 keeps the default)
+void backend_pool_init(int max_idle, int idle_sec);
+
+// Send one request over a pooled connection; drop-in for lsrp_client_send()
+// resp->data is malloc'd and NUL-terminated (caller frees)
+// Returns 0 on success, -1 on error
+int backend_pool_send(const char *host, int port, const char *params, lsrp_response_t *resp);
+
+// Close the idle connections of one backend (datasource removed or moved)
+void backend_pool_evict(const char *host, int port);
+
+// Close every idle connection
+void backend_pool_free(void);
+
+#endif
@@ -0,0 +1,66 @@
+#!/bin/sh
+# gate/embed_static.sh — встраивает gate/static/* в svgd-gate.
+#
+#   sh gate/embed_static.sh <static_dir> <out.c>
+#
+# Для каждого файла пишет два массива: исходные байты и gzip -9 -n (без имени
+# и mtime, чтобы сборка была воспроизводимой), плюс сильные ETag'и из
+# sha256 содержимого. Вызывается из makefile перед сборкой gate; результат
+# (gate/static_assets.c) генерируется заново и не коммитится.
+set -eu
+
+src_dir="$1"
+out="$2"
+tmp="$out.tmp"
+
+# Байты файла как "0x3c,0x21,..." по 16 в строке
+c_bytes() {
+    od -An -v -tx1 | sed -e 's/^ *//' -e 's/ *$//' -e '/^$/d' \
+        -e 's/ \{1,\}/,0x/g' -e 's/^/    0x/' -e 's/$/,/'
+}
+
+{
+    echo "// Generated by gate/embed_static.sh from $src_dir - do not edit"
+    echo '#include "static_assets.h"'
+    echo
+} > "$tmp"
+
+entries=""
+i=0
+for f in "$src_dir"/*; do
+    [ -f "$f" ] || continue
+    name=$(basename "$f")
+    hash=$(sha256sum < "$f" | cut -c1-16)
+    size=$(wc -c < "$f" | tr -d ' ')
+    gz_size=$(gzip -9 -n -c < "$f" | wc -c | tr -d ' ')
+
+    {
+        echo "static const unsigned char asset_${i}[] = {"
+        c_bytes < "$f"
+        echo "};"
+        echo "static const unsigned char asset_${i}_gz[] = {"
+        gzip -9 -n -c < "$f" | c_bytes
+        echo "};"
+        echo
+    } >> "$tmp"
+
+    entries="$entries    { \"/$name\", asset_${i}, $size, asset_${i}_gz, $gz_size, \"\\\"$hash\\\"\", \"\\\"$hash-gz\\\"\" },
+"
+    i=$((i + 1))
+done
+
+{
+    echo "const StaticAsset static_assets[] = {"
+    printf '%s' "$entries"
+    echo "    { 0 }"
+    echo "};"
+    echo "const int static_asset_count = $i;"
+} >> "$tmp"
+
+# Не трогать файл без изменений — иначе gate пересобирается на каждом make
+if cmp -s "$tmp" "$out" 2>/dev/null; then
+    rm -f "$tmp"
+else
+    mv "$tmp" "$out"
+    echo "  GEN     $out ($i files)"
+fi
@@ -1,24 +1,29 @@
+#define _GNU_SOURCE             // strndup, memmem
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <strings.h>
 #include <unistd.h>
 #include <signal.h>
-#include <sys/socket.h>
-#include <netinet/in.h>
-#include <arpa/inet.h>
 #include <errno.h>
-#include <sys/time.h>
+#include <pthread.h>
 #include "../lsrp/lsrp_client.h"
 #include "auth/auth.h"
+#include "backend_pool.h"
+#include "../include/http_server.h"
+#include "../include/compress.h"
+#include "static_assets.h"
 
 #define DEFAULT_SVGD_HOST "127.0.0.1"
 #define DEFAULT_SVGD_PORT 8081
 #define DEFAULT_HTTP_PORT 8080
 #define DEFAULT_STATIC_PATH "./gate/static"
-#define MAX_REQUEST_LEN 65536   // large enough for Grafana /query POST bodies
 #define MAX_PARAMS_LEN LSRP_MAX_PARAMS_LEN
 #define MAX_FILE_SIZE (1024 * 1024)  // 1MB max for static files
-#define CLIENT_RECV_TIMEOUT_SEC 5    // Timeout for client recv (seconds)
+#define STATIC_DISK_ENV "SVGD_GATE_STATIC_DISK"  // =1: serve the UI from static_path (development)
+#define DEFAULT_LISTEN_SHARDS 1      // SO_REUSEPORT reactors (0 = one per CPU)
+#define DEFAULT_WORKERS 8            // request worker threads across all shards
+#define MAX_LISTEN_SHARDS 64
 
 // Datasource configuration
 #define MAX_DATASOURCES 16
@@ -43,16 +48,27 @@ struct Config {
     int svgd_port;
     int http_port;
     const char *static_path;
+    int static_from_disk;   // serve static_path instead of the embedded UI
+    int listen_shards;
+    int workers;            // request worker threads across all shards
+    int pool_max_idle;      // idle backend connections kept per backend (0 = no pooling)
+    int pool_idle_sec;      // idle backend connections older than this are closed
 };
 
 static struct Config global_config = {
     .svgd_host = DEFAULT_SVGD_HOST,
     .svgd_port = DEFAULT_SVGD_PORT,
     .http_port = DEFAULT_HTTP_PORT,
-    .static_path = DEFAULT_STATIC_PATH
+    .static_path = DEFAULT_STATIC_PATH,
+    .listen_shards = DEFAULT_LISTEN_SHARDS,
+    .workers = DEFAULT_WORKERS,
+    .pool_max_idle = BACKEND_POOL_DEFAULT_MAX_IDLE,
+    .pool_idle_sec = BACKEND_POOL_DEFAULT_IDLE_SEC
 };
 
 static DatasourceList datasources = {0};
+// Guards datasources: requests run concurrently on the accept shards
+static pthread_mutex_t ds_lock = PTHREAD_MUTEX_INITIALIZER;
 
 static int load_datasources(void) {
     FILE *f = fopen(DATASOURCES_FILE, "r");
@@ -215,6 +231,26 @@ static char* extract_datasource_param(const char *query) {
     return value;
 }
 
+// Resolve the backend for a request: the named datasource, else the default,
+// else the command-line backend. Copies host/port out under ds_lock so a
+// concurrent DELETE cannot pull the entry from under the caller.
+// Returns -1 if ds_name is given but unknown.
+static int resolve_datasource(const char *ds_name, char host[MAX_DS_HOST_LEN], int *port) {
+    int ret = 0;
+    pthread_mutex_lock(&ds_lock);
+    Datasource *target_ds = NULL;
+    if (ds_name) {
+        target_ds = find_datasource(ds_name);
+        if (!target_ds) ret = -1;
+    } else if (datasources.count > 0 && datasources.default_name[0]) {
+        target_ds = find_datasource(datasources.default_name);
+    }
+    snprintf(host, MAX_DS_HOST_LEN, "%s", target_ds ? target_ds->host : global_config.svgd_host);
+    *port = target_ds ? target_ds->port : global_config.svgd_port;
+    pthread_mutex_unlock(&ds_lock);
+    return ret;
+}
+
 static int add_datasource(const char *name, const char *host, int port) {
     if (datasources.count >= MAX_DATASOURCES) return -1;
     if (find_datasource(name)) return -2; // Already exists
@@ -243,6 +279,8 @@ static int add_datasource(const char *name, const char *host, int port) {
 static int remove_datasource(const char *name) {
     for (int i = 0; i < datasources.count; i++) {
         if (strcmp(datasources.items[i].name, name) == 0) {
+            backend_pool_evict(datasources.items[i].host, datasources.items[i].port);
+
             // Shift remaining
             for (int j = i; j < datasources.count - 1; j++) {
                 datasources.items[j] = datasources.items[j + 1];
@@ -266,31 +304,53 @@ static int remove_datasource(const char *name) {
     return -1; // Not found
 }
 
-// Send JSON response with status code
-static void send_json(int client_sock, int status, const char *json) {
-    char header[256];
-    int header_len = snprintf(header, sizeof(header),
-                              "HTTP/1.1 %d %s\r\n"
-                              "Content-Type: application/json\r\n"
-                              "Content-Length: %zu\r\n"
-                              "Access-Control-Allow-Origin: *\r\n"
-                              "Connection: close\r\n\r\n",
-                              status,
-                              status == 200 ? "OK" : status == 201 ? "Created" :
-                              status == 204 ? "No Content" : status == 404 ? "Not Found" :
-                              status == 409 ? "Conflict" : "Error",
-                              strlen(json));
-    send(client_sock, header, header_len, MSG_NOSIGNAL);
-    if (strlen(json) > 0) {
-        send(client_sock, json, strlen(json), MSG_NOSIGNAL);
+// Fill reply with a status line, the common headers, extra_headers (each
+// ending in CRLF) and body (malloc'd, taken over; NULL for none). A body that
+// failed to allocate leaves the reply empty, which closes the connection.
+static void set_reply_headers(http_reply_t *reply, int status, const char *status_text,
+                              const char *content_type, const char *extra_headers,
+                              char *body, size_t body_len) {
+    if (!body && body_len > 0) return;
+    int len = snprintf(reply->head, sizeof(reply->head),
+                       "HTTP/1.1 %d %s\r\n"
+                       "Content-Type: %s\r\n"
+                       "Content-Length: %zu\r\n"
+                       "%s"
+                       "Access-Control-Allow-Origin: *\r\n"
+                       "Connection: %s\r\n\r\n",
+                       status, status_text, content_type, body_len, extra_headers,
+                       reply->keep_alive ? "keep-alive" : "close");
+    if (len < 0 || (size_t)len >= sizeof(reply->head)) {
+        free(body);
+        return;
     }
+    reply->head_len = (size_t)len;
+    reply->body = body;
+    reply->body_len = body ? body_len : 0;
+}
+
+static void set_reply(http_reply_t *reply, int status, const char *status_text,
+                      const char *content_type, char *body, size_t body_len) {
+    set_reply_headers(reply, status, status_text, content_type, "", body, body_len);
+}
+
+// Send JSON response with status code
+static void send_json(http_reply_t *reply, int status, const char *json) {
+    size_t len = strlen(json);
+    set_reply(reply, status,
+              status == 200 ? "OK" : status == 201 ? "Created" :
+              status == 204 ? "No Content" : status == 404 ? "Not Found" :
+              status == 409 ? "Conflict" : "Error",
+              "application/json", len > 0 ? strdup(json) : NULL, len);
 }
 
 // Handle GET /_datasources - list all datasources
-static void handle_get_datasources(int client_sock) {
+static void handle_get_datasources(http_reply_t *reply) {
+    pthread_mutex_lock(&ds_lock);
     char *json = malloc(4096 + datasources.count * 256);
     if (!json) {
-        send_json(client_sock, 500, "{\"error\":\"Out of memory\"}");
+        pthread_mutex_unlock(&ds_lock);
+        send_json(reply, 500, "{\"error\":\"Out of memory\"}");
         return;
     }
 
@@ -306,12 +366,13 @@ static void handle_get_datasources(int client_sock) {
     }
 
     offset += snprintf(json + offset, 4096 + datasources.count * 256 - offset, "]}");
-    send_json(client_sock, 200, json);
+    pthread_mutex_unlock(&ds_lock);
+    send_json(reply, 200, json);
     free(json);
 }
 
 // Handle POST /_datasources - add new datasource
-static void handle_post_datasource(int client_sock, const char *body) {
+static void handle_post_datasource(http_reply_t *reply, const char *body) {
     // Parse JSON body (simple parsing)
     char name[64] = "", host[256] = "";
     int port = 0;
@@ -351,55 +412,58 @@ static void handle_post_datasource(int client_sock, const char *body) {
     }
 
     if (!name[0] || !host[0] || port <= 0) {
-        send_json(client_sock, 400, "{\"error\":\"Missing name, host, or port\"}");
+        send_json(reply, 400, "{\"error\":\"Missing name, host, or port\"}");
         return;
     }
 
+    pthread_mutex_lock(&ds_lock);
     int ret = add_datasource(name, host, port);
+    pthread_mutex_unlock(&ds_lock);
     if (ret == -1) {
-        send_json(client_sock, 500, "{\"error\":\"Maximum datasources reached\"}");
+        send_json(reply, 500, "{\"error\":\"Maximum datasources reached\"}");
     } else if (ret == -2) {
-        send_json(client_sock, 409, "{\"error\":\"Datasource already exists\"}");
+        send_json(reply, 409, "{\"error\":\"Datasource already exists\"}");
     } else {
-        send_json(client_sock, 201, "{\"success\":true}");
+        send_json(reply, 201, "{\"success\":true}");
     }
 }
 
 // Handle DELETE /_datasources/<name> - remove datasource
-static void handle_delete_datasource(int client_sock, const char *name) {
-    if (remove_datasource(name) == 0) {
-        send_json(client_sock, 204, "");
+static void handle_delete_datasource(http_reply_t *reply, const char *name) {
+    pthread_mutex_lock(&ds_lock);
+    int ret = remove_datasource(name);
+    pthread_mutex_unlock(&ds_lock);
+    if (ret == 0) {
+        send_json(reply, 204, "");
     } else {
         char error[128];
         snprintf(error, sizeof(error), "{\"error\":\"Datasource '%s' not found\"}", name);
-        send_json(client_sock, 404, error);
+        send_json(reply, 404, error);
     }
 }
 
 // Handle PUT /_datasources/<name>/default - set default datasource
-static void handle_set_default(int client_sock, const char *name) {
-    if (find_datasource(name)) {
+static void handle_set_default(http_reply_t *reply, const char *name) {
+    pthread_mutex_lock(&ds_lock);
+    int found = find_datasource(name) != NULL;
+    if (found) {
         strncpy(datasources.default_name, name, MAX_DS_NAME_LEN - 1);
         datasources.default_name[MAX_DS_NAME_LEN - 1] = '\0';
         save_datasources();
-        send_json(client_sock, 200, "{\"success\":true}");
+    }
+    pthread_mutex_unlock(&ds_lock);
+    if (found) {
+        send_json(reply, 200, "{\"success\":true}");
     } else {
         char error[128];
         snprintf(error, sizeof(error), "{\"error\":\"Datasource '%s' not found\"}", name);
-        send_json(client_sock, 404, error);
+        send_json(reply, 404, error);
     }
 }
 
-static volatile sig_atomic_t running = 1;
-static int server_sock = -1;
-
 static void signal_handler(int sig) {
     (void)sig;
-    running = 0;
-    if (server_sock >= 0) {
-        shutdown(server_sock, SHUT_RDWR);
-        close(server_sock);
-    }
+    http_server_stop();
 }
 
 // Extract path from HTTP request (returns malloc'd string, caller must free)
@@ -436,11 +500,8 @@ static char *extract_path(const char *request) {
 }
 
 // Extract body from HTTP request (returns malloc'd string, caller must free)
-static char* extract_body(const char *request) {
-    const char *body = strstr(request, "\r\n\r\n");
-    if (!body) return NULL;
-    body += 4;
-    return strdup(body);
+static char* extract_body(const http_raw_request_t *req) {
+    return strndup(req->body, req->body_len);
 }
 
 // Parse GET request and extract path and query parameters for API
@@ -462,8 +523,8 @@ static char *parse_api_request(const char *request, size_t *params_len) {
     strncpy(path, path_start + 1, path_len);
     path[path_len] = '\0';
 
-    // Extract query (after '?', if present)
-    char query[256] = "";
+    // Extract query (after '?', if present); _batch panel lists run long
+    char query[MAX_PARAMS_LEN] = "";
     if (query_start && query_start < path_end) {
         query_start++;
         size_t query_len = path_end - query_start;
@@ -489,55 +550,63 @@ static char *parse_api_request(const char *request, size_t *params_len) {
     return params;
 }
 
+// JSON {"error":"<message>"} body (malloc'd); *len set
+static char *error_body(const char *message, size_t *len) {
+    size_t size = strlen(message) + 13;
+    char *body = malloc(size);
+    if (body) snprintf(body, size, "{\"error\":\"%s\"}", message);
+    *len = size - 1;
+    return body;
+}
+
 // Send HTTP error response (JSON format)
-static void send_error(int client_sock, const char *message) {
-    char response[512];
-    int len = snprintf(response, sizeof(response),
-                       "HTTP/1.1 400 Bad Request\r\n"
-                       "Content-Type: application/json\r\n"
-                       "Content-Length: %zu\r\n"
-                       "Access-Control-Allow-Origin: *\r\n"
-                       "Connection: close\r\n\r\n"
-                       "{\"error\":\"%s\"}",
-                       strlen(message) + 12, message);
-    send(client_sock, response, len, MSG_NOSIGNAL);
+static void send_error(http_reply_t *reply, const char *message) {
+    size_t len;
+    char *body = error_body(message, &len);
+    set_reply(reply, 400, "Bad Request", "application/json", body, len);
 }
 
 // Send HTTP 404 response
-static void send_404(int client_sock) {
-    const char *response =
-        "HTTP/1.1 404 Not Found\r\n"
-        "Content-Type: text/plain\r\n"
-        "Content-Length: 9\r\n"
-        "Connection: close\r\n\r\n"
-        "Not Found";
-    send(client_sock, response, strlen(response), MSG_NOSIGNAL);
+static void send_404(http_reply_t *reply) {
+    set_reply(reply, 404, "Not Found", "text/plain", strdup("Not Found"), 9);
 }
 
-// Send HTTP success response
-static void send_response(int client_sock, const char *content_type, const char *data, size_t data_len) {
-    char header[512];
-    int header_len = snprintf(header, sizeof(header),
-                              "HTTP/1.1 200 OK\r\n"
-                              "Content-Type: %s\r\n"
-                              "Content-Length: %zu\r\n"
-                              "Access-Control-Allow-Origin: *\r\n"
-                              "Connection: close\r\n\r\n",
-                              content_type, data_len);
-    send(client_sock, header, header_len, MSG_NOSIGNAL);
-    send(client_sock, data, data_len, MSG_NOSIGNAL);
+// Send HTTP success response; data (malloc'd) is handed to the server
+// without a copy
+static void send_response(http_reply_t *reply, const char *content_type, char *data, size_t data_len) {
+    set_reply(reply, 200, "OK", content_type, data, data_len);
+}
+
+// Relay a backend body (malloc'd, handed over). LSRP carries no headers: when
+// the request asked for encoding=gzip (asked_gzip), svgd answers with a gzip
+// member if compressing paid off and with the plain SVG/JSON text otherwise,
+// and the gzip header (1f 8b 08) tells them apart - text never starts with 0x1f.
+static void send_backend_response(http_reply_t *reply, const char *content_type,
+                                  char *data, size_t data_len, int asked_gzip) {
+    const unsigned char *b = (const unsigned char *)data;
+    int gz = asked_gzip && data_len >= 3 && b[0] == 0x1f && b[1] == 0x8b && b[2] == 0x08;
+    set_reply_headers(reply, 200, "OK", content_type,
+                      gz ? "Content-Encoding: gzip\r\nVary: Accept-Encoding\r\n"
+                         : "Vary: Accept-Encoding\r\n",
+                      data, data_len);
+}
+
+// Send CORS preflight response
+static void send_preflight(http_reply_t *reply, const char *methods, const char *headers) {
+    int len = snprintf(reply->head, sizeof(reply->head),
+                       "HTTP/1.1 200 OK\r\n"
+                       "Access-Control-Allow-Origin: *\r\n"
+                       "Access-Control-Allow-Methods: %s\r\n"
+                       "Access-Control-Allow-Headers: %s\r\n"
+                       "Content-Length: 0\r\n"
+                       "Connection: %s\r\n\r\n",
+                       methods, headers, reply->keep_alive ? "keep-alive" : "close");
+    reply->head_len = len > 0 && (size_t)len < sizeof(reply->head) ? (size_t)len : 0;
 }
 
 // Handle CORS preflight request
-static void handle_options(int client_sock) {
-    const char *response =
-        "HTTP/1.1 200 OK\r\n"
-        "Access-Control-Allow-Origin: *\r\n"
-        "Access-Control-Allow-Methods: GET, OPTIONS\r\n"
-        "Access-Control-Allow-Headers: Content-Type\r\n"
-        "Content-Length: 0\r\n"
-        "Connection: close\r\n\r\n";
-    send(client_sock, response, strlen(response), MSG_NOSIGNAL);
+static void handle_options(http_reply_t *reply) {
+    send_preflight(reply, "GET, OPTIONS", "Content-Type");
 }
 
 // Check if path has a file extension (likely a static file)
@@ -582,8 +651,87 @@ static const char* get_mime_type(const char *path) {
     return "application/octet-stream";
 }
 
-// Serve static file from disk
-static int serve_static_file(int client_sock, const char *path) {
+// Whether the response may be gzip, negotiated like svgd's HTTP mode. The
+// gate only has gzip variants (embedded assets, svgd's encoding=gzip), so a
+// client that prefers deflate gets the identity body.
+static int accepts_gzip(const http_raw_request_t *req) {
+    size_t len = 0;
+    const char *v = http_find_header(req->raw, req->head_len, "Accept-Encoding", &len);
+    return compress_negotiate(v, len) == COMPRESS_GZIP;
+}
+
+// Ask svgd for a gzip body when the client takes gzip: it answers from the
+// compressed variant cached with the panel. params is a MAX_PARAMS_LEN
+// buffer; if the parameter does not fit, the body simply comes uncompressed.
+// Returns 1 if the parameter was added (pass it on to send_backend_response).
+static int add_encoding_param(const http_raw_request_t *req, char *params) {
+    if (!accepts_gzip(req)) return 0;
+    size_t len = strlen(params);
+    static const char param[] = "&encoding=gzip";
+    if (len + sizeof(param) > MAX_PARAMS_LEN) return 0;
+    memcpy(params + len, param, sizeof(param));
+    return 1;
+}
+
+// Serve a UI file embedded at build time: gzip variant when the client takes
+// it, 304 when If-None-Match already has the representation's ETag
+static void serve_embedded(const http_raw_request_t *req, http_reply_t *reply, const StaticAsset *asset) {
+    int gz = accepts_gzip(req);
+    const char *etag = gz ? asset->etag_gz : asset->etag;
+
+    size_t inm_len;
+    const char *inm = http_find_header(req->raw, req->head_len, "If-None-Match", &inm_len);
+    int not_modified = inm && (memmem(inm, inm_len, etag, strlen(etag)) ||
+                               (inm_len == 1 && inm[0] == '*'));
+
+    // A 304 has no body and no Content-Length (it would describe the 200)
+    size_t body_len = gz ? asset->gz_len : asset->len;
+    char length[48] = "";
+    if (!not_modified) snprintf(length, sizeof(length), "Content-Length: %zu\r\n", body_len);
+
+    int len = snprintf(reply->head, sizeof(reply->head),
+                       "HTTP/1.1 %s\r\n"
+                       "Content-Type: %s\r\n"
+                       "%s%s"
+                       "ETag: %s\r\n"
+                       "Cache-Control: no-cache\r\n"
+                       "Vary: Accept-Encoding\r\n"
+                       "Access-Control-Allow-Origin: *\r\n"
+                       "Connection: %s\r\n\r\n",
+                       not_modified ? "304 Not Modified" : "200 OK",
+                       get_mime_type(asset->path), length,
+                       gz ? "Content-Encoding: gzip\r\n" : "",
+                       etag, reply->keep_alive ? "keep-alive" : "close");
+    if (len < 0 || (size_t)len >= sizeof(reply->head)) return;
+    reply->head_len = (size_t)len;
+
+    // Embedded data is sent in place, never copied or freed
+    if (!not_modified) {
+        reply->body = (char *)(gz ? asset->gz : asset->data);
+        reply->body_len = body_len;
+        reply->body_static = 1;
+    }
+}
+
+static const StaticAsset *find_static_asset(const char *path) {
+    if (strcmp(path, "/") == 0) path = "/index.html";
+    for (int i = 0; i < static_asset_count; i++) {
+        if (strcmp(static_assets[i].path, path) == 0) return &static_assets[i];
+    }
+    return NULL;
+}
+
+// Serve static file: embedded UI from memory, anything else (or everything
+// in development mode) from disk
+static int serve_static_file(const http_raw_request_t *req, http_reply_t *reply, const char *path) {
+    if (!global_config.static_from_disk) {
+        const StaticAsset *asset = find_static_asset(path);
+        if (asset) {
+            serve_embedded(req, reply, asset);
+            return 0;
+        }
+    }
+
     char filepath[512];
 
     // Map URL path to file path
@@ -597,7 +745,7 @@ static int serve_static_file(int client_sock, const char *path) {
     FILE *f = fopen(filepath, "rb");
     if (!f) {
         fprintf(stderr, "Static file not found: %s\n", filepath);
-        send_404(client_sock);
+        send_404(reply);
         return -1;
     }
 
@@ -608,7 +756,7 @@ static int serve_static_file(int client_sock, const char *path) {
 
     if (file_size > MAX_FILE_SIZE || file_size < 0) {
         fclose(f);
-        send_error(client_sock, "File too large");
+        send_error(reply, "File too large");
         return -1;
     }
 
@@ -616,7 +764,7 @@ static int serve_static_file(int client_sock, const char *path) {
     char *content = malloc(file_size);
     if (!content) {
         fclose(f);
-        send_error(client_sock, "Memory allocation failed");
+        send_error(reply, "Memory allocation failed");
         return -1;
     }
 
@@ -625,14 +773,13 @@ static int serve_static_file(int client_sock, const char *path) {
 
     if (read_size != (size_t)file_size) {
         free(content);
-        send_error(client_sock, "Failed to read file");
+        send_error(reply, "Failed to read file");
         return -1;
     }
 
-    // Send response
+    // Send response (the server frees content)
     const char *mime_type = get_mime_type(path);
-    send_response(client_sock, mime_type, content, file_size);
-    free(content);
+    send_response(reply, mime_type, content, file_size);
 
     fprintf(stderr, "Served static: %s (%ld bytes)\n", filepath, file_size);
     return 0;
@@ -640,7 +787,7 @@ static int serve_static_file(int client_sock, const char *path) {
 
 // Determine content type based on endpoint for API responses
 static const char* get_api_content_type(const char *endpoint) {
-    if (strncmp(endpoint, "_config/", 8) == 0) {
+    if (strncmp(endpoint, "_config/", 8) == 0 || strcmp(endpoint, "_batch") == 0) {
         return "application/json";
     }
     return "image/svg+xml";
@@ -667,18 +814,10 @@ static char* extract_auth_token(const char *request) {
 }
 
 // Send 401 Unauthorized response
-static void send_401_auth(int client_sock, const char *message) {
-    char response[512];
-    int body_len = strlen(message) + 12; // {"error":"..."} = 10 + len + 2
-    int len = snprintf(response, sizeof(response),
-                       "HTTP/1.1 401 Unauthorized\r\n"
-                       "Content-Type: application/json\r\n"
-                       "Content-Length: %d\r\n"
-                       "Access-Control-Allow-Origin: *\r\n"
-                       "Connection: close\r\n\r\n"
-                       "{\"error\":\"%s\"}",
-                       body_len, message);
-    send(client_sock, response, len, MSG_NOSIGNAL);
+static void send_401_auth(http_reply_t *reply, const char *message) {
+    size_t len;
+    char *body = error_body(message, &len);
+    set_reply(reply, 401, "Unauthorized", "application/json", body, len);
 }
 
 // Check if path requires authentication
@@ -698,9 +837,9 @@ static int requires_auth(const char *path) {
 }
 
 // Handle POST /_auth/login - exchange password for token
-static void handle_login(int client_sock, const char *body) {
+static void handle_login(http_reply_t *reply, const char *body) {
     if (!auth_is_configured()) {
-        send_401_auth(client_sock, "Auth not configured");
+        send_401_auth(reply, "Auth not configured");
         return;
     }
 
@@ -723,26 +862,26 @@ static void handle_login(int client_sock, const char *body) {
     }
 
     if (!password[0]) {
-        send_401_auth(client_sock, "Password required");
+        send_401_auth(reply, "Password required");
         return;
     }
 
     if (!auth_verify_password(password)) {
-        send_401_auth(client_sock, "Invalid password");
+        send_401_auth(reply, "Invalid password");
         return;
     }
 
     // Create token
     char *token = auth_create_token();
     if (!token) {
-        send_json(client_sock, 500, "{\"error\":\"Failed to create token\"}");
+        send_json(reply, 500, "{\"error\":\"Failed to create token\"}");
         return;
     }
 
     // Return token
     char response[MAX_TOKEN_SIZE + 64];
     snprintf(response, sizeof(response), "{\"token\":\"%s\"}", token);
-    send_json(client_sock, 200, response);
+    send_json(reply, 200, response);
     free(token);
 }
 
@@ -768,92 +907,87 @@ static char *url_encode(const char *s) {
 
 // Forward a prebuilt LSRP params string to the target backend and relay its JSON
 // response. Resolves the datasource from ?datasource= (or the configured default).
-static void grafana_forward(int client_sock, const char *buffer, const char *params) {
+// asked_gzip: params carry encoding=gzip (add_encoding_param)
+static void grafana_forward(http_reply_t *reply, const char *buffer, const char *params,
+                            int asked_gzip) {
     char *ds_name = NULL;
     const char *query_start = strchr(buffer, '?');
     if (query_start) ds_name = extract_datasource_param(query_start);
 
-    Datasource *target_ds = NULL;
-    if (ds_name) {
-        target_ds = find_datasource(ds_name);
-        if (!target_ds) {
-            char err[256];
-            snprintf(err, sizeof(err), "{\"error\":\"Datasource '%s' not found\"}", ds_name);
-            send_json(client_sock, 404, err);
-            free(ds_name);
-            return;
-        }
-    } else if (datasources.count > 0 && datasources.default_name[0]) {
-        target_ds = find_datasource(datasources.default_name);
+    char target_host[MAX_DS_HOST_LEN];
+    int target_port;
+    if (resolve_datasource(ds_name, target_host, &target_port) != 0) {
+        char err[256];
+        snprintf(err, sizeof(err), "{\"error\":\"Datasource '%s' not found\"}", ds_name);
+        send_json(reply, 404, err);
+        free(ds_name);
+        return;
     }
-    const char *target_host = target_ds ? target_ds->host : global_config.svgd_host;
-    int target_port = target_ds ? target_ds->port : global_config.svgd_port;
     if (ds_name) free(ds_name);
 
     lsrp_response_t lsrp_resp = {0};
-    int ret = lsrp_client_send(target_host, target_port, params, &lsrp_resp);
+    int ret = backend_pool_send(target_host, target_port, params, &lsrp_resp);
     if (ret != 0) {
-        send_error(client_sock, "Failed to communicate with svgd service");
+        send_error(reply, "Failed to communicate with svgd service");
         return;
     }
 
     if (lsrp_resp.status == 0) {
-        send_response(client_sock, "application/json", lsrp_resp.data, lsrp_resp.data_len);
+        send_backend_response(reply, "application/json", lsrp_resp.data, lsrp_resp.data_len,
+                              asked_gzip);
     } else {
         // Backend-level error (unknown metric, no data): return an empty result so
         // Grafana shows "no data" instead of erroring the whole panel.
         fprintf(stderr, "grafana: backend status=%d: %.*s\n",
                 lsrp_resp.status, (int)lsrp_resp.data_len,
                 lsrp_resp.data ? (const char *)lsrp_resp.data : "");
-        send_json(client_sock, 200, "[]");
+        send_json(reply, 200, "[]");
+        free(lsrp_resp.data);
     }
-    free(lsrp_resp.data);
 }
 
 // Handle /grafana/* — the simpod / classic-SimpleJson structured datasource contract.
 // The gate is a thin forwarder; JSON parsing and time-series assembly happen in the
 // backend (which has Duktape). Configure in Grafana: URL .../grafana, Access = Server,
 // custom header Authorization: Bearer <svgd-token>.
-static void handle_grafana(int client_sock, const char *path, const char *buffer) {
+static void handle_grafana(http_reply_t *reply, const char *path, const http_raw_request_t *req) {
+    const char *buffer = req->raw;
     const char *sub = path + 8;     // skip "/grafana"
     if (*sub == '/') sub++;         // "/grafana/search" -> "search"
 
     if (strncmp(buffer, "OPTIONS ", 8) == 0) {
-        const char *resp = "HTTP/1.1 200 OK\r\n"
-            "Access-Control-Allow-Origin: *\r\n"
-            "Access-Control-Allow-Methods: GET, POST, OPTIONS\r\n"
-            "Access-Control-Allow-Headers: Content-Type, Authorization\r\n"
-            "Content-Length: 0\r\n\r\n";
-        send(client_sock, resp, strlen(resp), MSG_NOSIGNAL);
+        send_preflight(reply, "GET, POST, OPTIONS", "Content-Type, Authorization");
         return;
     }
 
     // GET /grafana (or /grafana/) — Grafana "Save & Test" connection check
     if (strncmp(buffer, "GET ", 4) == 0) {
-        send_json(client_sock, 200, "{}");
+        send_json(reply, 200, "{}");
         return;
     }
 
     if (strncmp(buffer, "POST ", 5) != 0) {
-        send_404(client_sock);
+        send_404(reply);
         return;
     }
 
     if (strcmp(sub, "search") == 0) {
-        grafana_forward(client_sock, buffer, "endpoint=_grafana/search");
+        char params[MAX_PARAMS_LEN] = "endpoint=_grafana/search";
+        int gzip = add_encoding_param(req, params);
+        grafana_forward(reply, buffer, params, gzip);
         return;
     }
 
     if (strcmp(sub, "query") == 0) {
-        char *body = extract_body(buffer);
+        char *body = extract_body(req);
         if (!body) {
-            send_json(client_sock, 400, "{\"error\":\"Missing request body\"}");
+            send_json(reply, 400, "{\"error\":\"Missing request body\"}");
             return;
         }
         char *enc = url_encode(body);
         free(body);
         if (!enc) {
-            send_json(client_sock, 500, "{\"error\":\"Failed to encode body\"}");
+            send_json(reply, 500, "{\"error\":\"Failed to encode body\"}");
             return;
         }
         char params[MAX_PARAMS_LEN];
@@ -861,387 +995,298 @@ static void handle_grafana(int client_sock, const char *path, const char *buffer
         free(enc);
         if (n < 0 || (size_t)n >= sizeof(params)) {
             // URL-encoded body exceeded the LSRP params cap — documented v1 limit.
-            send_json(client_sock, 413, "{\"error\":\"Request body too large\"}");
+            send_json(reply, 413, "{\"error\":\"Request body too large\"}");
             return;
         }
-        grafana_forward(client_sock, buffer, params);
+        int gzip = add_encoding_param(req, params);
+        grafana_forward(reply, buffer, params, gzip);
         return;
     }
 
     if (strcmp(sub, "annotations") == 0) {
-        send_json(client_sock, 200, "[]");
+        send_json(reply, 200, "[]");
         return;
     }
 
-    send_json(client_sock, 404, "{\"error\":\"Unknown grafana endpoint\"}");
+    send_json(reply, 404, "{\"error\":\"Unknown grafana endpoint\"}");
 }
 
-int main(int argc, char *argv[]) {
-    // Parse command-line arguments
-    if (argc > 1 && argv[1][0] != '\0') global_config.svgd_host = argv[1];
-    if (argc > 2) {
-        int port = atoi(argv[2]);
-        if (port > 0) global_config.svgd_port = port;
-    }
-    if (argc > 3) {
-        int port = atoi(argv[3]);
-        if (port > 0) global_config.http_port = port;
-    }
-    if (argc > 4 && argv[4][0] != '\0') global_config.static_path = argv[4];
-
-    // Load datasources configuration
-    if (load_datasources() <= 0) {
-        // Create default datasource from command-line args
-        fprintf(stderr, "No datasources loaded, creating default from args\n");
-        add_datasource("default", global_config.svgd_host, global_config.svgd_port);
-    }
-
-    // Load auth configuration (try multiple paths)
-    if (auth_load_config("auth.json") != 0 &&
-        auth_load_config("gate/auth/auth.json") != 0) {
-        fprintf(stderr, "Warning: Auth config not loaded, API endpoints will return 401\n");
-    }
+// Answer one complete request (runs on a gate worker thread)
+static int handle_client(const http_raw_request_t *req, http_reply_t *reply) {
+    const char *buffer = req->raw;
 
-    // Setup signal handlers
-    struct sigaction sa;
-    sa.sa_handler = signal_handler;
-    sigemptyset(&sa.sa_mask);
-    sa.sa_flags = 0;
-    sigaction(SIGINT, &sa, NULL);
-    sigaction(SIGTERM, &sa, NULL);
-
-    // Create socket
-    server_sock = socket(AF_INET, SOCK_STREAM, 0);
-    if (server_sock < 0) {
-        fprintf(stderr, "Failed to create socket: %s\n", strerror(errno));
-        return 1;
-    }
-
-    // Set socket options
-    int opt = 1;
-    setsockopt(server_sock, SOL_SOCKET, SO_REUSEADDR, &opt, sizeof(opt));
-
-    // Bind
-    struct sockaddr_in server_addr;
-    memset(&server_addr, 0, sizeof(server_addr));
-    server_addr.sin_family = AF_INET;
-    server_addr.sin_addr.s_addr = INADDR_ANY;
-    server_addr.sin_port = htons(global_config.http_port);
-    if (bind(server_sock, (struct sockaddr *)&server_addr, sizeof(server_addr)) < 0) {
-        fprintf(stderr, "Failed to bind socket: %s\n", strerror(errno));
-        close(server_sock);
-        return 1;
-    }
-
-    // Listen
-    if (listen(server_sock, 10) < 0) {
-        fprintf(stderr, "Failed to listen: %s\n", strerror(errno));
-        close(server_sock);
-        return 1;
+    // Extract path from request
+    char *path = extract_path(buffer);
+    if (!path) {
+        send_error(reply, "Invalid request");
+        return 0;
     }
 
-    printf("svgd-gate running on http://localhost:%d\n", global_config.http_port);
-    printf("  Static files: %s\n", global_config.static_path);
-    printf("  Backend: %s:%d\n", global_config.svgd_host, global_config.svgd_port);
-
-    // Main loop
-    static char buffer[MAX_REQUEST_LEN];
-    while (running) {
-        struct sockaddr_in client_addr;
-        socklen_t client_len = sizeof(client_addr);
-        int client_sock = accept(server_sock, (struct sockaddr *)&client_addr, &client_len);
-        if (client_sock < 0) {
-            fprintf(stderr, "Failed to accept connection: %s\n", strerror(errno));
-            continue;
+    // Handle auth login
+    if (strcmp(path, "/_auth/login") == 0) {
+        if (strncmp(buffer, "POST ", 5) == 0) {
+            char *body = extract_body(req);
+            if (body) {
+                handle_login(reply, body);
+                free(body);
+            } else {
+                send_json(reply, 400, "{\"error\":\"Missing request body\"}");
+            }
+        } else if (strncmp(buffer, "OPTIONS ", 8) == 0) {
+            send_preflight(reply, "POST, OPTIONS", "Content-Type, Authorization");
+        } else {
+            send_404(reply);
         }
+        free(path);
+        return 0;
+    }
 
-        // Set recv timeout to prevent blocking forever on idle clients
-        struct timeval tv = { .tv_sec = CLIENT_RECV_TIMEOUT_SEC, .tv_usec = 0 };
-        setsockopt(client_sock, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
-
-        // Read full request (handle TCP fragmentation)
-        ssize_t total_read = 0;
-        while (total_read < (ssize_t)(sizeof(buffer) - 1)) {
-            ssize_t bytes_read = recv(client_sock, buffer + total_read,
-                                             sizeof(buffer) - 1 - total_read, 0);
-            if (bytes_read <= 0) break;
-            total_read += bytes_read;
-            buffer[total_read] = '\0';
-
-            // Check if we have the full request (HTTP headers end with \r\n\r\n)
-            if (total_read >= 4 && strstr(buffer, "\r\n\r\n")) {
-                // For POST requests, check if body is complete
-                char *content_len_str = strstr(buffer, "Content-Length:");
-                if (content_len_str) {
-                    long content_len = atol(content_len_str + 15);
-                    char *body_start = strstr(buffer, "\r\n\r\n");
-                    if (body_start) {
-                        size_t header_size = body_start - buffer + 4;
-                        if ((size_t)(total_read - (ssize_t)header_size) >= (size_t)content_len) {
-                            break; // Full body received
-                        }
-                    }
+    // Handle GET /_auth/verify - check if token is valid
+    if (strcmp(path, "/_auth/verify") == 0) {
+        if (strncmp(buffer, "GET ", 4) == 0 || strncmp(buffer, "OPTIONS ", 8) == 0) {
+            if (strncmp(buffer, "OPTIONS ", 8) == 0) {
+                send_preflight(reply, "GET, OPTIONS", "Content-Type, Authorization");
+            } else {
+                char *token = extract_auth_token(buffer);
+                if (token && auth_validate_token(token) == 0) {
+                    send_json(reply, 200, "{\"valid\":true}");
                 } else {
-                    break; // No body expected
+                    send_401_auth(reply, "Invalid or expired token");
                 }
+                if (token) free(token);
             }
+        } else {
+            send_404(reply);
         }
+        free(path);
+        return 0;
+    }
 
-        if (total_read <= 0) {
-            close(client_sock);
-            continue;
-        }
+    // Handle CORS preflight for all routes BEFORE auth check
+    if (strncmp(buffer, "OPTIONS ", 8) == 0) {
+        handle_options(reply);
+        free(path);
+        return 0;
+    }
 
-        // Extract path from request
-        char *path = extract_path(buffer);
-        if (!path) {
-            send_error(client_sock, "Invalid request");
-            shutdown(client_sock, SHUT_WR);
-            close(client_sock);
-            continue;
-        }
+    // Check authentication for protected routes
+    if (requires_auth(path)) {
+        char *token = extract_auth_token(buffer);
+        int auth_valid = (token && auth_validate_token(token) == 0);
+        if (token) free(token);
 
-        // Handle auth login
-        if (strcmp(path, "/_auth/login") == 0) {
-            if (strncmp(buffer, "POST ", 5) == 0) {
-                char *body = extract_body(buffer);
-                if (body) {
-                    handle_login(client_sock, body);
-                    free(body);
-                } else {
-                    send_json(client_sock, 400, "{\"error\":\"Missing request body\"}");
-                }
-            } else if (strncmp(buffer, "OPTIONS ", 8) == 0) {
-                const char *resp = "HTTP/1.1 200 OK\r\n"
-                    "Access-Control-Allow-Origin: *\r\n"
-                    "Access-Control-Allow-Methods: POST, OPTIONS\r\n"
-                    "Access-Control-Allow-Headers: Content-Type, Authorization\r\n"
-                    "Content-Length: 0\r\n\r\n";
-                send(client_sock, resp, strlen(resp), MSG_NOSIGNAL);
-            } else {
-                send_404(client_sock);
-            }
+        if (!auth_valid) {
+            send_401_auth(reply, "Missing or invalid token");
             free(path);
-            shutdown(client_sock, SHUT_WR);
-            close(client_sock);
-            continue;
+            return 0;
         }
+    }
 
-        // Handle GET /_auth/verify - check if token is valid
-        if (strcmp(path, "/_auth/verify") == 0) {
-            if (strncmp(buffer, "GET ", 4) == 0 || strncmp(buffer, "OPTIONS ", 8) == 0) {
-                if (strncmp(buffer, "OPTIONS ", 8) == 0) {
-                    const char *resp = "HTTP/1.1 200 OK\r\n"
-                        "Access-Control-Allow-Origin: *\r\n"
-                        "Access-Control-Allow-Methods: GET, OPTIONS\r\n"
-                        "Access-Control-Allow-Headers: Content-Type, Authorization\r\n"
-                        "Content-Length: 0\r\n\r\n";
-                    send(client_sock, resp, strlen(resp), MSG_NOSIGNAL);
-                } else {
-                    char *token = extract_auth_token(buffer);
-                    if (token && auth_validate_token(token) == 0) {
-                        send_json(client_sock, 200, "{\"valid\":true}");
-                    } else {
-                        send_401_auth(client_sock, "Invalid or expired token");
-                    }
-                    if (token) free(token);
-                }
+    // Grafana datasource routes (JSON; forwarded to the backend which has Duktape)
+    if (strncmp(path, "/grafana", 8) == 0 &&
+        (path[8] == '\0' || path[8] == '/')) {
+        handle_grafana(reply, path, req);
+        free(path);
+        return 0;
+    }
+
+    // Handle datasources API
+    if (strcmp(path, "/_datasources") == 0) {
+        if (strncmp(buffer, "GET ", 4) == 0) {
+            handle_get_datasources(reply);
+        } else if (strncmp(buffer, "POST ", 5) == 0) {
+            char *body = extract_body(req);
+            if (body) {
+                handle_post_datasource(reply, body);
+                free(body);
             } else {
-                send_404(client_sock);
+                send_json(reply, 400, "{\"error\":\"Missing request body\"}");
             }
-            free(path);
-            shutdown(client_sock, SHUT_WR);
-            close(client_sock);
-            continue;
+        } else if (strncmp(buffer, "OPTIONS ", 8) == 0) {
+            send_preflight(reply, "GET, POST, DELETE, OPTIONS", "Content-Type");
         }
+        free(path);
+        return 0;
+    }
 
-        // Handle CORS preflight for all routes BEFORE auth check
-        if (strncmp(buffer, "OPTIONS ", 8) == 0) {
-            handle_options(client_sock);
-            free(path);
-            shutdown(client_sock, SHUT_WR);
-            close(client_sock);
-            continue;
+    // Handle delete/set-default datasources
+    if (strncmp(path, "/_datasources/", 14) == 0) {
+        const char *name_in_path = path + 14;
+        const char *slash = strchr(name_in_path, '/');
+        char ds_name[MAX_DS_NAME_LEN];
+
+        // Extract datasource name (copy to avoid modifying path)
+        if (slash) {
+            size_t len = slash - name_in_path;
+            if (len >= MAX_DS_NAME_LEN) len = MAX_DS_NAME_LEN - 1;
+            strncpy(ds_name, name_in_path, len);
+            ds_name[len] = '\0';
+        } else {
+            strncpy(ds_name, name_in_path, MAX_DS_NAME_LEN - 1);
+            ds_name[MAX_DS_NAME_LEN - 1] = '\0';
         }
 
-        // Check authentication for protected routes
-        if (requires_auth(path)) {
-            char *token = extract_auth_token(buffer);
-            int auth_valid = (token && auth_validate_token(token) == 0);
-            if (token) free(token);
-
-            if (!auth_valid) {
-                send_401_auth(client_sock, "Missing or invalid token");
-                free(path);
-                shutdown(client_sock, SHUT_WR);
-                close(client_sock);
-                continue;
-            }
+        if (strncmp(buffer, "DELETE ", 7) == 0) {
+            handle_delete_datasource(reply, ds_name);
+        } else if (slash && strcmp(slash + 1, "default") == 0 && strncmp(buffer, "PUT ", 4) == 0) {
+            handle_set_default(reply, ds_name);
+        } else if (strncmp(buffer, "OPTIONS ", 8) == 0) {
+            send_preflight(reply, "GET, POST, DELETE, PUT, OPTIONS", "Content-Type");
+        } else {
+            send_404(reply);
         }
+        free(path);
+        return 0;
+    }
 
-        // Grafana datasource routes (JSON; forwarded to the backend which has Duktape)
-        if (strncmp(path, "/grafana", 8) == 0 &&
-            (path[8] == '\0' || path[8] == '/')) {
-            handle_grafana(client_sock, path, buffer);
-            free(path);
-            shutdown(client_sock, SHUT_WR);
-            close(client_sock);
-            continue;
-        }
+    // Check if static file request
+    if (is_static_request(path)) {
+        serve_static_file(req, reply, path);
+        free(path);
+        return 0;
+    }
 
-        // Handle datasources API
-        if (strcmp(path, "/_datasources") == 0) {
-            if (strncmp(buffer, "GET ", 4) == 0) {
-                handle_get_datasources(client_sock);
-            } else if (strncmp(buffer, "POST ", 5) == 0) {
-                char *body = extract_body(buffer);
-                if (body) {
-                    handle_post_datasource(client_sock, body);
-                    free(body);
-                } else {
-                    send_json(client_sock, 400, "{\"error\":\"Missing request body\"}");
-                }
-            } else if (strncmp(buffer, "OPTIONS ", 8) == 0) {
-                const char *resp = "HTTP/1.1 200 OK\r\n"
-                    "Access-Control-Allow-Origin: *\r\n"
-                    "Access-Control-Allow-Methods: GET, POST, DELETE, OPTIONS\r\n"
-                    "Access-Control-Allow-Headers: Content-Type\r\n"
-                    "Content-Length: 0\r\n\r\n";
-                send(client_sock, resp, strlen(resp), MSG_NOSIGNAL);
-            }
-            free(path);
-            shutdown(client_sock, SHUT_WR);
-            close(client_sock);
-            continue;
-        }
+    free(path);
 
-        // Handle delete/set-default datasources
-        if (strncmp(path, "/_datasources/", 14) == 0) {
-            const char *name_in_path = path + 14;
-            const char *slash = strchr(name_in_path, '/');
-            char ds_name[MAX_DS_NAME_LEN];
-
-            // Extract datasource name (copy to avoid modifying path)
-            if (slash) {
-                size_t len = slash - name_in_path;
-                if (len >= MAX_DS_NAME_LEN) len = MAX_DS_NAME_LEN - 1;
-                strncpy(ds_name, name_in_path, len);
-                ds_name[len] = '\0';
-            } else {
-                strncpy(ds_name, name_in_path, MAX_DS_NAME_LEN - 1);
-                ds_name[MAX_DS_NAME_LEN - 1] = '\0';
-            }
+    // Parse as API request
+    size_t params_len;
+    char *params = parse_api_request(buffer, &params_len);
+    if (!params) {
+        send_error(reply, "Invalid or missing query parameters");
+        return 0;
+    }
 
-            if (strncmp(buffer, "DELETE ", 7) == 0) {
-                handle_delete_datasource(client_sock, ds_name);
-            } else if (slash && strcmp(slash + 1, "default") == 0 && strncmp(buffer, "PUT ", 4) == 0) {
-                handle_set_default(client_sock, ds_name);
-            } else if (strncmp(buffer, "OPTIONS ", 8) == 0) {
-                const char *resp = "HTTP/1.1 200 OK\r\n"
-                    "Access-Control-Allow-Origin: *\r\n"
-                    "Access-Control-Allow-Methods: GET, POST, DELETE, PUT, OPTIONS\r\n"
-                    "Access-Control-Allow-Headers: Content-Type\r\n"
-                    "Content-Length: 0\r\n\r\n";
-                send(client_sock, resp, strlen(resp), MSG_NOSIGNAL);
-            } else {
-                send_404(client_sock);
-            }
-            free(path);
-            shutdown(client_sock, SHUT_WR);
-            close(client_sock);
-            continue;
+    // Extract endpoint from params for content type determination
+    char endpoint[256] = "";
+    const char *endpoint_param = strstr(params, "endpoint=");
+    if (endpoint_param) {
+        endpoint_param += 9; // Skip "endpoint="
+        const char *end = strchr(endpoint_param, '&');
+        size_t len = end ? (size_t)(end - endpoint_param) : strlen(endpoint_param);
+        if (len < sizeof(endpoint)) {
+            strncpy(endpoint, endpoint_param, len);
+            endpoint[len] = '\0';
         }
+    }
 
-        // Check if static file request
-        if (is_static_request(path)) {
-            serve_static_file(client_sock, path);
-            free(path);
-            shutdown(client_sock, SHUT_WR);
-            close(client_sock);
-            continue;
-        }
+    // Extract datasource parameter
+    char *ds_name = NULL;
+    const char *query_start = strchr(buffer, '?');
+    if (query_start) {
+        ds_name = extract_datasource_param(query_start);
+    }
 
-        free(path);
+    // Determine target datasource
+    char target_host[MAX_DS_HOST_LEN];
+    int target_port;
+    if (resolve_datasource(ds_name, target_host, &target_port) != 0) {
+        char error[256];
+        snprintf(error, sizeof(error), "{\"error\":\"Datasource '%s' not found\"}", ds_name);
+        send_json(reply, 404, error);
+        free(ds_name);
+        free(params);
+        return 0;
+    }
 
-        // Parse as API request
-        size_t params_len;
-        char *params = parse_api_request(buffer, &params_len);
-        if (!params) {
-            send_error(client_sock, "Invalid or missing query parameters");
-            shutdown(client_sock, SHUT_WR);
-            close(client_sock);
-            continue;
-        }
+    if (ds_name) free(ds_name);
 
-        // Extract endpoint from params for content type determination
-        char endpoint[256] = "";
-        const char *endpoint_param = strstr(params, "endpoint=");
-        if (endpoint_param) {
-            endpoint_param += 9; // Skip "endpoint="
-            const char *end = strchr(endpoint_param, '&');
-            size_t len = end ? (size_t)(end - endpoint_param) : strlen(endpoint_param);
-            if (len < sizeof(endpoint)) {
-                strncpy(endpoint, endpoint_param, len);
-                endpoint[len] = '\0';
-            }
-        }
+    int gzip = add_encoding_param(req, params);
 
-        // Extract datasource parameter
-        char *ds_name = NULL;
-        const char *query_start = strchr(buffer, '?');
-        if (query_start) {
-            ds_name = extract_datasource_param(query_start);
-        }
+    // Send LSRP request
+    lsrp_response_t lsrp_resp = {0};
+    int ret = backend_pool_send(target_host, target_port, params, &lsrp_resp);
+    free(params);
 
-        // Determine target datasource
-        Datasource *target_ds = NULL;
-        if (ds_name) {
-            target_ds = find_datasource(ds_name);
-            if (!target_ds) {
-                char error[256];
-                snprintf(error, sizeof(error), "{\"error\":\"Datasource '%s' not found\"}", ds_name);
-                send_json(client_sock, 404, error);
-                free(ds_name);
-                free(params);
-                shutdown(client_sock, SHUT_WR);
-                close(client_sock);
-                continue;
-            }
-        } else if (datasources.count > 0 && datasources.default_name[0]) {
-            target_ds = find_datasource(datasources.default_name);
-        }
+    if (ret != 0) {
+        send_error(reply, "Failed to communicate with svgd service");
+        return 0;
+    }
 
-        const char *target_host = target_ds ? target_ds->host : global_config.svgd_host;
-        int target_port = target_ds ? target_ds->port : global_config.svgd_port;
+    // Send response with appropriate content type
+    if (lsrp_resp.status == 0) {
+        const char *content_type = get_api_content_type(endpoint);
+        send_backend_response(reply, content_type, lsrp_resp.data, lsrp_resp.data_len, gzip);
+    } else {
+        send_error(reply, lsrp_resp.data);
+        free(lsrp_resp.data);
+    }
+    return 0;
+}
 
-        if (ds_name) free(ds_name);
+int main(int argc, char *argv[]) {
+    // Parse command-line arguments
+    if (argc > 1 && argv[1][0] != '\0') global_config.svgd_host = argv[1];
+    if (argc > 2) {
+        int port = atoi(argv[2]);
+        if (port > 0) global_config.svgd_port = port;
+    }
+    if (argc > 3) {
+        int port = atoi(argv[3]);
+        if (port > 0) global_config.http_port = port;
+    }
+    if (argc > 4 && argv[4][0] != '\0') global_config.static_path = argv[4];
+    if (argc > 5) global_config.listen_shards = atoi(argv[5]);
+    if (argc > 6) global_config.pool_max_idle = atoi(argv[6]);
+    if (argc > 7) global_config.pool_idle_sec = atoi(argv[7]);
+    if (argc > 8) global_config.workers = atoi(argv[8]);
+    const char *static_disk = getenv(STATIC_DISK_ENV);
+    global_config.static_from_disk = static_disk && strcmp(static_disk, "1") == 0;
+    if (global_config.listen_shards <= 0) {
+        long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+        global_config.listen_shards = cpus > 0 ? (int)cpus : 1;
+    }
+    if (global_config.listen_shards > MAX_LISTEN_SHARDS) global_config.listen_shards = MAX_LISTEN_SHARDS;
+    if (global_config.workers <= 0) global_config.workers = DEFAULT_WORKERS;
+    // Every shard needs a worker of its own (http_server_start would cap it too)
+    if (global_config.listen_shards > global_config.workers) {
+        global_config.listen_shards = global_config.workers;
+    }
+    if (global_config.pool_max_idle < 0) global_config.pool_max_idle = 0;
+    if (global_config.pool_idle_sec <= 0) global_config.pool_idle_sec = BACKEND_POOL_DEFAULT_IDLE_SEC;
+    backend_pool_init(global_config.pool_max_idle, global_config.pool_idle_sec);
 
-        // Send LSRP request
-        lsrp_response_t lsrp_resp = {0};
-        int ret = lsrp_client_send(target_host, target_port, params, &lsrp_resp);
-        free(params);
+    // Load datasources configuration
+    if (load_datasources() <= 0) {
+        // Create default datasource from command-line args
+        fprintf(stderr, "No datasources loaded, creating default from args\n");
+        add_datasource("default", global_config.svgd_host, global_config.svgd_port);
+    }
 
-        if (ret != 0) {
-            send_error(client_sock, "Failed to communicate with svgd service");
-            shutdown(client_sock, SHUT_WR);
-            close(client_sock);
-            continue;
-        }
+    // Load auth configuration (try multiple paths)
+    if (auth_load_config("auth.json") != 0 &&
+        auth_load_config("gate/auth/auth.json") != 0) {
+        fprintf(stderr, "Warning: Auth config not loaded, API endpoints will return 401\n");
+    }
 
-        // Send response with appropriate content type
-        if (lsrp_resp.status == 0) {
-            const char *content_type = get_api_content_type(endpoint);
-            send_response(client_sock, content_type, lsrp_resp.data, lsrp_resp.data_len);
-        } else {
-            send_error(client_sock, lsrp_resp.data);
-        }
-        free(lsrp_resp.data);
-        shutdown(client_sock, SHUT_WR);
-        close(client_sock);
+    // Setup signal handlers
+    struct sigaction sa;
+    sa.sa_handler = signal_handler;
+    sigemptyset(&sa.sa_mask);
+    sa.sa_flags = 0;
+    sigaction(SIGINT, &sa, NULL);
+    sigaction(SIGTERM, &sa, NULL);
+
+    printf("svgd-gate running on http://localhost:%d\n", global_config.http_port);
+    if (global_config.static_from_disk) {
+        printf("  Static files: %s (%s=1)\n", global_config.static_path, STATIC_DISK_ENV);
+    } else {
+        printf("  Static files: %d embedded, others from %s\n",
+               static_asset_count, global_config.static_path);
+    }
+    printf("  Backend: %s:%d\n", global_config.svgd_host, global_config.svgd_port);
+    if (global_config.listen_shards > 1) {
+        printf("  Shards: %d (SO_REUSEPORT, pinned)\n", global_config.listen_shards);
     }
+    printf("  Workers: %d, keep-alive %ds\n", global_config.workers, HTTP_IDLE_TIMEOUT_SEC);
+    if (global_config.pool_max_idle > 0) {
+        printf("  Backend connections: up to %d idle per backend, %ds idle timeout\n",
+               global_config.pool_max_idle, global_config.pool_idle_sec);
+    }
+
+    int ret = http_server_start(global_config.http_port, handle_client, NULL,
+                                global_config.workers, global_config.listen_shards);
 
     printf("\nShutting down...\n");
-    shutdown(server_sock, SHUT_RDWR);
-    close(server_sock);
-    return 0;
+    backend_pool_free();
+    return ret == 0 ? 0 : 1;
 }
@@ -509,6 +509,29 @@ async function fetchSVG(endpoint, period, width, height) {
     }
 }
 
+// Render many panels in one round trip (backend _batch endpoint).
+// items: [{endpoint, period, width, height}]; resolves to one result per item,
+// in order, or null if the batch as a whole failed.
+async function fetchBatch(items) {
+    try {
+        const panels = items
+            .map(i => `${i.endpoint},${i.period},${i.width || 800},${i.height || 450}`)
+            .join(';');
+        const ds = config.activeDatasource ? `&datasource=${config.activeDatasource}` : '';
+        const url = `${config.apiBaseUrl}/_batch?panels=${encodeURIComponent(panels)}${ds}`;
+        const response = await fetchWithAuth(url);
+        if (!response.ok) return null;
+
+        const data = await response.json();
+        if (!Array.isArray(data) || data.length !== items.length) return null;
+        return data.map(p => p.svg !== undefined
+            ? { success: true, svg: p.svg }
+            : { success: false, error: p.error || 'Unknown error' });
+    } catch (error) {
+        return null;
+    }
+}
+
 // ===== UI Functions =====
 function populateMetricsDropdown() {
     const select = document.getElementById('newPanelType');
@@ -745,20 +768,34 @@ function initResize(panelElement) {
     }
 }
 
-async function updatePanel(panelConfig) {
+// Size to render a panel at; null if the panel is not in the DOM
+function getPanelSize(panelConfig) {
     const graphContainer = document.getElementById(`graph-${panelConfig.id}`);
-    const statusBadge = document.getElementById(`status-${panelConfig.id}`);
-
-    if (!graphContainer) return;
+    if (!graphContainer) return null;
 
     const panel = document.getElementById(`panel-${panelConfig.id}`);
     // Use graphContainer dimensions when available, otherwise estimate from panel
     const width = graphContainer.offsetWidth > 0 ? graphContainer.offsetWidth : (panel ? panel.offsetWidth : 800);
     const height = graphContainer.offsetHeight > 0 ? graphContainer.offsetHeight : (panel ? panel.offsetHeight - 80 : 450);
+    return { width, height };
+}
+
+async function updatePanel(panelConfig) {
+    const size = getPanelSize(panelConfig);
+    if (!size) return;
+
+    document.getElementById(`graph-${panelConfig.id}`).innerHTML = '<div class="loading"></div>';
+
+    const result = await fetchSVG(panelConfig.endpoint, config.currentPeriod, size.width, size.height);
+    showPanelResult(panelConfig, result, size.width, size.height);
+}
 
-    graphContainer.innerHTML = '<div class="loading"></div>';
+// Put a fetchSVG()/fetchBatch() result into the panel
+function showPanelResult(panelConfig, result, width, height) {
+    const graphContainer = document.getElementById(`graph-${panelConfig.id}`);
+    const statusBadge = document.getElementById(`status-${panelConfig.id}`);
 
-    const result = await fetchSVG(panelConfig.endpoint, config.currentPeriod, width, height);
+    if (!graphContainer) return;
 
     if (result.success) {
         graphContainer.innerHTML = result.svg;
@@ -836,8 +873,24 @@ async function updateAllPanels() {
         return p.title.toLowerCase().includes(searchTerm.toLowerCase());
     });
     
-    for (const panel of visiblePanels) {
-        await updatePanel(panel);
+    // One _batch request for the whole page; per-panel requests if the
+    // backend (or an older svgd) cannot serve it
+    const sized = visiblePanels
+        .map(panel => ({ panel, size: getPanelSize(panel) }))
+        .filter(p => p.size);
+    const results = sized.length > 1 ? await fetchBatch(sized.map(p => ({
+        endpoint: p.panel.endpoint,
+        period: config.currentPeriod,
+        width: p.size.width,
+        height: p.size.height
+    }))) : null;
+
+    if (results) {
+        sized.forEach((p, i) => showPanelResult(p.panel, results[i], p.size.width, p.size.height));
+    } else {
+        for (const panel of visiblePanels) {
+            await updatePanel(panel);
+        }
     }
     document.getElementById('lastUpdate').textContent = new Date().toLocaleTimeString();
 }
@@ -0,0 +1,21 @@
+#ifndef STATIC_ASSETS_H
+#define STATIC_ASSETS_H
+
+#include <stddef.h>
+
+// UI files from gate/static/, embedded at build time by gate/embed_static.sh
+// (generated gate/static_assets.c), so the gate serves them from memory.
+typedef struct {
+    const char *path;                   // URL path, e.g. "/index.html"
+    const unsigned char *data;          // file as is
+    size_t len;
+    const unsigned char *gz;            // gzip -9 of data
+    size_t gz_len;
+    const char *etag;                   // strong ETag of data, quoted
+    const char *etag_gz;                // strong ETag of the gzip variant
+} StaticAsset;
+
+extern const StaticAsset static_assets[];   // terminated by an entry with path NULL
+extern const int static_asset_count;
+
+#endif
@@ -41,6 +41,7 @@ typedef struct {
     // Additional metadata (passed to JS)
     char value_format[32];        // e.g., "%.1f", "%.2f", "%d"
     char panel_type[16];          // "chart" (default) or "stat"
+    char decimate[8];             // Point decimation: "none" (default), "m4", "lttb"; ?decimate= overrides
 } MetricConfig;
 
 typedef struct {
@@ -49,11 +50,24 @@ typedef struct {
     char allowed_ips[1024];
     char rrd_base_path[256];
     char rrdcached_addr[256];
+    char rrd_flush_policy[16];  // rrd.flush_policy: "fetch" (default) | "always" | "interval"
+    char rrd_reader[16];        // rrd.reader: "librrd" (default) | "mmap" (native reader for direct reads)
+    int rrd_flush_interval;     // rrd.flush_interval_seconds: staleness bound for "interval" (default: 30)
     char js_script_path[256];
-    int thread_pool_size;       // LSRP worker threads (default: 4)
+    char js_series_format[16];  // js.series_format: "typed" (default, Float64Arrays) | "objects"
+    char js_reload[16];         // js.reload: "sighup" (default) | "inotify" (also on script file changes)
+    size_t js_heap_max_bytes;   // js.heap_max_bytes: live-byte ceiling per render heap (default: 128 MiB, 0 = unlimited)
+    size_t js_heap_gc_bytes;    // js.heap_gc_bytes: heap growth that forces duk_gc() (default: 8 MiB, 0 = never)
+    int thread_pool_size;       // Request workers + _batch render pool (default: 4)
+    int listen_shards;          // HTTP: SO_REUSEPORT listeners, one per pinned core (default: 1, 0 = one per CPU)
     int cache_ttl_seconds;      // RRD data cache TTL (default: 5)
+    size_t cache_max_bytes;     // cache.max_bytes: RRD data cache budget (default: 32 MiB, 0 = unlimited)
+    size_t svg_cache_max_bytes; // cache.svg_max_bytes: rendered-SVG cache budget (default: 16 MiB, 0 = unlimited)
+    int compression_level;      // compression.level: gzip/deflate level 1-9 for responses (default: 6, 0 = off)
+    size_t compression_min_bytes;  // compression.min_bytes: smaller bodies are sent uncompressed (default: 1024)
     int verbose;                // Verbose logging (default: 0)
     char theme[16];             // SVG render theme: "light"|"dark"|"high-contrast" (default: "light")
+    char render_engine[16];     // server.render_engine: "js" (default, generate_svg.js) | "native" (C port)
 
     MetricConfig *metrics;
     int metrics_count;
@@ -0,0 +1,67 @@
+/**
+ * @file compress.h
+ * @brief HTTP response compression (gzip / deflate via zlib)
+ *
+ * Content negotiation from Accept-Encoding and one-shot compression of a
+ * response body. Bodies below the configured minimum are left as is (the
+ * headers would eat the gain), and so are bodies that do not shrink.
+ * Rendered panels are compressed once per cache entry: the compressed
+ * variant is kept next to the SVG in svg_cache.h.
+ */
+
+#ifndef SVGD_COMPRESS_H
+#define SVGD_COMPRESS_H
+
+#include <stddef.h>
+
+/** Content-Encoding of a body */
+typedef enum {
+    COMPRESS_IDENTITY = 0,      /* Not compressed */
+    COMPRESS_GZIP,              /* gzip (RFC 1952) */
+    COMPRESS_DEFLATE,           /* HTTP "deflate": zlib stream (RFC 1950) */
+    COMPRESS_ENCODING_COUNT
+} compress_encoding_t;
+
+#define COMPRESS_DEFAULT_LEVEL 6            /* zlib's own default */
+#define COMPRESS_DEFAULT_MIN_BYTES 1024
+
+/**
+ * Set the compression policy (once at startup)
+ * @param level zlib level 1-9; 0 disables compression (> 9 is clamped)
+ * @param min_bytes Bodies shorter than this are sent uncompressed
+ */
+void compress_configure(int level, size_t min_bytes);
+
+/**
+ * Pick the encoding for a response from the request's Accept-Encoding value
+ *
+ * Honors q-values and "*"; gzip wins a tie with deflate. Returns
+ * COMPRESS_IDENTITY when compression is disabled or nothing is acceptable.
+ *
+ * @param accept Header value (not NUL-terminated), or NULL if absent
+ * @param len Value length
+ */
+compress_encoding_t compress_negotiate(const char *accept, size_t len);
+
+/**
+ * Encoding from its Content-Encoding token ("gzip", "deflate")
+ * @return The encoding, COMPRESS_IDENTITY for NULL or unknown names
+ */
+compress_encoding_t compress_encoding_parse(const char *name);
+
+/** Content-Encoding token of enc ("gzip", "deflate"), NULL for identity */
+const char *compress_encoding_name(compress_encoding_t enc);
+
+/**
+ * Compress data with enc at the configured level
+ * @param data Body bytes
+ * @param len Body length
+ * @param enc COMPRESS_GZIP or COMPRESS_DEFLATE
+ * @param out_len Set to the compressed length
+ * @return Compressed body (caller must free), or NULL if compression is
+ *         disabled, the body is below the minimum size, would not shrink,
+ *         or zlib failed - the body is then sent as is
+ */
+char *compress_body(const char *data, size_t len, compress_encoding_t enc, size_t *out_len);
+
+#endif /* SVGD_COMPRESS_H */
@@ -8,6 +8,8 @@
 
 #include <stddef.h>
 #include "cfg.h"  /* For Config definition */
+#include "compress.h"
+#include "rrd/svg_cache.h"
 
 /**
  * Handler result structure
@@ -15,8 +17,10 @@
 typedef struct {
     char *data;           /* Response data (SVG or JSON) */
     size_t data_len;      /* Response length */
+    svg_buf_t *shared;    /* If set, data is shared->data (SVG cache): release, don't free */
     int is_json;          /* 1 if JSON, 0 if SVG */
     int status;           /* 0 = success, non-zero = error */
+    compress_encoding_t encoding;  /* Content-Encoding of data (errors: always identity) */
 } handler_result_t;
 
 /**
@@ -29,6 +33,8 @@ typedef struct {
  * @param width SVG width in pixels (0 for default)
  * @param height SVG height in pixels (0 for default)
  * @param use_cache Whether to use RRD data caching
+ * @param encoding Encoding the client accepts (compress_negotiate()); the
+ *                 result may still be identity (small body, disabled)
  * @return Handler result (caller must free with handler_result_free)
  */
 handler_result_t* handler_process(Config *config,
@@ -37,10 +43,11 @@ handler_result_t* handler_process(Config *config,
                                   int period,
                                   int width,
                                   int height,
-                                  int use_cache);
+                                  int use_cache,
+                                  compress_encoding_t encoding);
 
 /**
- * Free handler result
+ * Free handler result (releases a shared SVG buffer instead of freeing it)
  */
 void handler_result_free(handler_result_t *result);
 
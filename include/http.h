@@ -2,15 +2,21 @@
 #define HTTP_H
 
 #include <stddef.h>
+#include <sys/uio.h>
 
 #define HTTP_MAX_PATH 256
 #define HTTP_MAX_QUERY 512
 #define HTTP_MAX_METHOD 8
+#define HTTP_MAX_REQUEST 65536    // Upper bound for headers + body of one request
+#define HTTP_MAX_HEAD 512         // Status line + headers of one response
+#define HTTP_MAX_ACCEPT_ENCODING 128
 
 typedef struct {
     char method[8];           // GET, POST, OPTIONS
     char path[HTTP_MAX_PATH];     // /cpu/usage
     char query[HTTP_MAX_QUERY];  // period=3600
+    int keep_alive;           // 1 if the connection may be reused after the response
+    char accept_encoding[HTTP_MAX_ACCEPT_ENCODING];  // Accept-Encoding value ("" if absent, cut if longer)
 } http_request_t;
 
 typedef struct {
@@ -18,20 +24,50 @@ typedef struct {
     char content_type[64];    // image/svg+xml, application/json
     const char *body;
     size_t body_len;
+    int keep_alive;           // 0 = "Connection: close", 1 = "Connection: keep-alive"
+    const char *content_encoding;  // "gzip", "deflate", or NULL for an uncompressed body
 } http_response_t;
 
 // Parse HTTP request from raw bytes
 // Returns 0 on success, -1 on error
 int http_parse_request(const char *raw, size_t len, http_request_t *req);
 
+// Length of the first complete request (headers + Content-Length body) in raw.
+// Returns the length, 0 if more bytes are needed, -1 if malformed or larger
+// than HTTP_MAX_REQUEST. scan_pos (may be NULL) carries the header-terminator
+// search position across calls so partial reads are not rescanned. head_len
+// (may be NULL) is set to the header length once the headers are complete.
+long http_request_length(const char *raw, size_t len, size_t *scan_pos, size_t *head_len);
+
+// Value of header name (case-insensitive) in the header block raw[0..len),
+// blanks trimmed, not NUL-terminated; NULL if absent
+const char *http_find_header(const char *raw, size_t len, const char *name, size_t *value_len);
+
+// Whether the connection stays open after the request in raw[0..len):
+// HTTP/1.1 unless "Connection: close", HTTP/1.0 only with "Connection: keep-alive"
+int http_request_keep_alive(const char *raw, size_t len);
+
+// Format the status line and headers of resp (body not included) into buf.
+// Returns the header length, or -1 if it does not fit in size bytes
+int http_format_head(const http_response_t *resp, char *buf, size_t size);
+
+// Drop the first n sent bytes from iov[0..count) (finished entries end up empty)
+void http_iov_advance(struct iovec *iov, int count, size_t n);
+
 // Build HTTP response to raw bytes (caller must free)
 // Returns allocated buffer, sets out_len
 char *http_build_response(const http_response_t *resp, size_t *out_len);
 
+// Build JSON error response ({"error":"..."}) to raw bytes (caller must free)
+char *http_build_error(int status, const char *message, int keep_alive, size_t *out_len);
+
+// Build CORS preflight response to raw bytes (caller must free)
+char *http_build_options(int keep_alive, size_t *out_len);
+
 // Helper to send error response (JSON format)
 void http_send_error(int client_sock, int status, const char *message);
 
-// Helper to send success response
+// Helper to send success response (headers and body in one writev, body not copied)
 void http_send_response(int client_sock, const char *content_type,
                         const char *body, size_t body_len);
 
@@ -0,0 +1,96 @@
+/**
+ * @file http_server.h
+ * @brief Non-blocking HTTP/1.1 server (svgd `protocol: "http"`, svgd-gate)
+ *
+ * One epoll reactor thread owns every socket: it accepts, reads requests
+ * incrementally, and writes responses (partial writes are resumed on
+ * EPOLLOUT). Complete requests are handed to a worker pool that runs the
+ * handler, so a slow render never stalls other connections. Connections are
+ * kept alive per HTTP/1.1 semantics and closed after an idle timeout.
+ *
+ * With more than one shard, each shard has its own SO_REUSEPORT listener,
+ * reactor and workers pinned to one CPU; the kernel load-balances accepts.
+ */
+
+#ifndef SVGD_HTTP_SERVER_H
+#define SVGD_HTTP_SERVER_H
+
+#include <stddef.h>
+#include "http.h"
+
+/** Idle keep-alive connections are closed after this many seconds */
+#define HTTP_IDLE_TIMEOUT_SEC 5
+
+/** Connections whose response makes no progress (client not reading) are
+ *  closed after this many seconds */
+#define HTTP_WRITE_TIMEOUT_SEC 10
+
+/** Default worker count when http_server_start() gets worker_count <= 0 */
+#define HTTP_DEFAULT_WORKERS 4
+
+/**
+ * Complete request handed to a handler, unparsed: framing (request length,
+ * keep-alive) is the server's job, everything else the handler's, so svgd
+ * parses it into http_request_t while svgd-gate routes on the raw text.
+ */
+typedef struct {
+    const char *raw;            /* the request, NUL-terminated at len */
+    size_t len;
+    size_t head_len;            /* request line + headers, up to the blank line */
+    const char *body;           /* raw + head_len */
+    size_t body_len;
+    int keep_alive;             /* 1 if the client may send another request */
+} http_raw_request_t;
+
+/**
+ * Response handed from a handler to the server. head (formatted with
+ * http_format_head()) is written first, then body, in one writev, so a
+ * rendered SVG is sent without being copied behind the headers. A complete
+ * response from http_build_error() / http_build_response() goes in body
+ * with head_len = 0. An empty reply closes the connection.
+ */
+typedef struct {
+    char head[HTTP_MAX_HEAD];
+    size_t head_len;
+    char *body;                 /* malloc'd; the server frees it */
+    size_t body_len;
+    int body_static;            /* body is static data (embedded asset): not freed */
+    void (*body_release)(void *owner);  /* if set, called with body_owner once
+                                           body is sent, instead of free(body) */
+    void *body_owner;           /* e.g. a shared cache buffer holding body */
+    int keep_alive;             /* preset from the request; the handler may clear it */
+} http_reply_t;
+
+/**
+ * Request handler, called on a worker thread.
+ *
+ * @param req Complete request
+ * @param reply Zeroed except keep_alive; filled with the response
+ * @return 0 on success, -1 for a 500 error (reply->body must then be NULL)
+ */
+typedef int (*http_handler_fn)(const http_raw_request_t *req, http_reply_t *reply);
+
+/**
+ * Run the server until http_server_stop() is called. Blocks the caller,
+ * which becomes the reactor thread of shard 0.
+ *
+ * @param port TCP port to listen on
+ * @param handler Request handler
+ * @param worker_init Run once on every worker thread before its first
+ *                    request (e.g. to warm thread-local state); may be NULL
+ * @param worker_count Total worker threads, split across shards
+ *                     (<= 0 means HTTP_DEFAULT_WORKERS)
+ * @param shard_count Listener shards (1 = single listener, unpinned;
+ *                    <= 0 = one per online CPU); at most worker_count,
+ *                    larger values are reduced with a warning
+ * @return 0 on clean shutdown, -1 if the server could not start
+ */
+int http_server_start(int port, http_handler_fn handler, void (*worker_init)(void),
+                      int worker_count, int shard_count);
+
+/**
+ * Ask the server to shut down. Async-signal-safe.
+ */
+void http_server_stop(void);
+
+#endif /* SVGD_HTTP_SERVER_H */
@@ -49,17 +49,32 @@ static inline metric_source_t metric_source_from_string(const char *s) {
  *
  * Инкапсулирует построение пути (RRD) / URL (Prometheus) / имени (proc),
  * обращение к кэшу (если use_cache) и вызов соответствующего бэкенда.
- * Для SRC_RRD — побайтово идентично прежней inline-логике handler.c
- * (build_rrd_path + cache_get/put + fetch_metric_data).
+ * Для SRC_RRD — build_rrd_path + выбор шага + cache_get/put + fetch (с
+ * дельта-дочитыванием истёкшей записи).
  *
  * @param config Конфиг сервера (использует rrd_base_path, rrdcached_addr)
  * @param metric Конфиг метрики (поле source выбирает бэкенд)
  * @param param  Параметр пути (может быть NULL; используется RRD-бэкендом)
  * @param period Запрошенный период в секундах
+ * @param width  Ширина графика в пикселях: RRD-бэкенд выбирает архив с ~1–2
+ *               точками на пиксель (см. select_step_for_width); 0 — не задана
  * @param use_cache 1 = использовать кэш (LSRP-режим), 0 = всегда свежие данные
  * @return MetricData (вызывающий освобождает free_metric_data) или NULL при ошибке
  */
 MetricData* metric_source_fetch(Config *config, MetricConfig *metric,
-                                const char *param, int period, int use_cache);
+                                const char *param, int period, int width, int use_cache);
+
+/**
+ * @brief Шаг, который metric_source_fetch() выберет для этой ширины
+ *
+ * Панели одной серии с одинаковым шагом получают одни и те же данные, так
+ * что батч (_batch) делит между ними одну выборку. Для RRD — шаг архива
+ * (с тем же запоминанием на (путь, период, ширина), что и у fetch, если
+ * use_cache); proc и prometheus от ширины не зависят — 0.
+ *
+ * @return Шаг в секундах; 0 — данные не зависят от ширины
+ */
+unsigned long metric_source_step(Config *config, MetricConfig *metric,
+                                 const char *param, int period, int width, int use_cache);
 
 #endif /* SVGD_METRIC_SOURCE_H */
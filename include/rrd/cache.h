@@ -3,7 +3,8 @@
  * @brief RRD data caching module
  *
  * Provides thread-safe caching of fetched RRD data to reduce I/O operations.
- * Uses hash table with TTL-based expiration.
+ * Uses a resizable hash table with TTL-based expiration, a background sweeper
+ * for expired entries and CLOCK eviction under a byte budget.
  */
 
 #ifndef SVGD_RRD_CACHE_H
@@ -12,36 +13,66 @@
 #include <stddef.h>
 #include "reader.h"  /* For MetricData definition */
 
+/** Cache counters, see rrd_cache_stats() */
+typedef struct {
+    size_t entries;               /* Live entries (including expired, not yet swept) */
+    size_t bytes;                 /* Accounted bytes (entries + keys + MetricData) */
+    size_t max_bytes;             /* Budget, 0 = unlimited */
+    size_t buckets;               /* Current hash table size */
+    unsigned long evictions;      /* Entries evicted to stay within max_bytes */
+    unsigned long expirations;    /* Expired entries removed by sweeper/eviction */
+    unsigned long stale_hits;     /* Expired entries handed out for delta refresh */
+} rrd_cache_stats_t;
+
 /**
- * Initialize the RRD cache
+ * Initialize the RRD cache and start its expiry sweeper thread
  * @param ttl_seconds Time-to-live for cached entries (0 = default 5s)
+ * @param max_bytes Memory budget in bytes (0 = unlimited)
  */
-void rrd_cache_init(int ttl_seconds);
+void rrd_cache_init(int ttl_seconds, size_t max_bytes);
 
 /**
  * Get cached data for RRD path and period
  * @param rrd_path Full path to RRD file
  * @param period Time period in seconds
- * @return Cloned MetricData (caller must free with rrd_data_free), or NULL if not cached/expired
+ * @return Shared, read-only MetricData (caller must metric_data_release it), or NULL if not cached/expired
  */
 MetricData* rrd_cache_get(const char *rrd_path, int period);
 
+/**
+ * Get data even if its TTL has passed, for incremental refresh with
+ * rrd_fetch_delta(). Expired RRD data stays available for 12 more TTLs.
+ * @param rrd_path Full path to RRD file
+ * @param period Time period in seconds
+ * @return Shared, read-only MetricData (caller must metric_data_release it), or NULL if not cached
+ */
+MetricData* rrd_cache_get_stale(const char *rrd_path, int period);
+
 /**
  * Store data in cache
  * @param rrd_path Full path to RRD file
  * @param period Time period in seconds
- * @param data Data to cache (cache takes ownership)
+ * @param data Data to cache (cache takes over the caller's reference;
+ *             retain it first to keep using it). Must not be modified afterwards.
+ *             Data larger than the whole budget is released without caching.
  */
 void rrd_cache_put(const char *rrd_path, int period, MetricData *data);
 
 /**
- * Free the RRD cache and all stored data
+ * Snapshot cache counters
+ * @param out Filled with current values
+ */
+void rrd_cache_stats(rrd_cache_stats_t *out);
+
+/**
+ * Stop the sweeper and free the RRD cache and all stored data
  */
 void rrd_cache_free(void);
 
 /* Compatibility aliases for existing code */
 #define cache_get rrd_cache_get
 #define cache_put rrd_cache_put
+#define cache_get_stale rrd_cache_get_stale
 #define init_rrd_cache rrd_cache_init
 #define free_rrd_cache rrd_cache_free
 
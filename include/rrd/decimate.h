@@ -0,0 +1,80 @@
+/**
+ * @file decimate.h
+ * @brief Point decimation between data fetch and SVG rendering
+ *
+ * svg_generate() marshals every point into Duktape, so render time and SVG size
+ * grow with the number of points, not with the chart size. Decimation caps
+ * each series at about two points per pixel of the plot width before the
+ * data is handed to Duktape:
+ *
+ *   - M4: per time bucket keep the first, minimum, maximum and last point.
+ *     Every spike and the line's entry/exit per bucket survive, so a line
+ *     chart drawn from the result is visually the same as the full one.
+ *   - LTTB (Largest-Triangle-Three-Buckets): keep one point per bucket, the
+ *     one spanning the largest triangle with its neighbours. Fewer points for
+ *     the same budget and smoother lines, extremes are kept in most cases.
+ *
+ * Selected per metric ("decimate" in config.json) or per request
+ * (?decimate=). The default is "none".
+ */
+
+#ifndef SVGD_RRD_DECIMATE_H
+#define SVGD_RRD_DECIMATE_H
+
+#include "reader.h"
+
+typedef enum {
+    DECIMATE_NONE = 0,
+    DECIMATE_M4,
+    DECIMATE_LTTB
+} decimate_mode_t;
+
+/**
+ * Parse a decimation mode name: "none" (or ""), "m4", "lttb"
+ * @param name Mode name
+ * @param out Set to the mode on success
+ * @return 0 on success, -1 for an unknown name
+ */
+int decimate_mode_parse(const char *name, decimate_mode_t *out);
+
+/**
+ * Point budget per series for an SVG of the given width: about two points
+ * per pixel of the plot area (the SVG width minus the chart margins used by
+ * generate_svg.js)
+ */
+int decimate_max_points(int svg_width);
+
+/**
+ * M4 over time buckets: up to max_points points (first/min/max/last of
+ * max_points / 4 buckets), in time order
+ *
+ * @param in Points sorted by timestamp
+ * @param n Number of input points
+ * @param out Output buffer with room for max_points points (may not alias in)
+ * @param max_points Point budget, >= 4
+ * @return Number of points written; n (and a plain copy) if n <= max_points
+ */
+int decimate_m4(const DataPoint *in, int n, DataPoint *out, int max_points);
+
+/**
+ * Largest-Triangle-Three-Buckets down to max_points points, keeping the
+ * first and the last point
+ *
+ * @param in Points sorted by timestamp
+ * @param n Number of input points
+ * @param out Output buffer with room for max_points points (may not alias in)
+ * @param max_points Point budget, >= 3
+ * @return Number of points written; n (and a plain copy) if n <= max_points
+ */
+int decimate_lttb(const DataPoint *in, int n, DataPoint *out, int max_points);
+
+/**
+ * Decimate every series of data that exceeds max_points.
+ *
+ * Consumes the caller's reference to data. Returns data itself when nothing
+ * needs decimating (or on allocation failure), otherwise a new sole-owner
+ * MetricData; shared (cached) data is never modified.
+ */
+MetricData* metric_data_decimate(MetricData *data, decimate_mode_t mode, int max_points);
+
+#endif /* SVGD_RRD_DECIMATE_H */
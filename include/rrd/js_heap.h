@@ -0,0 +1,75 @@
+/**
+ * @file js_heap.h
+ * @brief Pooled allocator and byte ceiling for per-thread Duktape heaps
+ *
+ * Render contexts (svg.c) are Duktape heaps created with these alloc /
+ * realloc / free functions instead of system malloc. Blocks up to 4 KiB come
+ * from per-heap size-class free lists carved out of 64 KiB chunks; a heap is
+ * only used by its own thread, so the pool takes no locks. Larger blocks go
+ * to malloc.
+ *
+ * Each heap counts its live bytes. An allocation that would take a heap past
+ * js.heap_max_bytes fails; Duktape then throws "alloc failed" inside the
+ * protected render call and only that request fails. js_heap_maybe_gc()
+ * runs a full duk_gc() once a heap has grown by js.heap_gc_bytes since the
+ * last one (cyclic garbage is not freed by reference counting).
+ */
+
+#ifndef SVGD_RRD_JS_HEAP_H
+#define SVGD_RRD_JS_HEAP_H
+
+#include <stddef.h>
+#include <duktape.h>
+
+/* Heaps reported individually in js_heap_stats_t.thread_bytes */
+#define JS_HEAP_STATS_THREADS 64
+
+typedef struct js_heap js_heap_t;
+
+/** Heap counters, see js_heap_stats() */
+typedef struct {
+    int heaps;                        /* Live heaps (one per rendering thread) */
+    size_t bytes;                     /* Live bytes, all heaps */
+    size_t max_bytes;                 /* Per-heap ceiling (0 = unlimited) */
+    unsigned long forced_gcs;         /* duk_gc() runs from js_heap_maybe_gc() */
+    unsigned long limit_failures;     /* Allocations refused at the ceiling */
+    size_t thread_bytes[JS_HEAP_STATS_THREADS];  /* Live bytes per heap */
+} js_heap_stats_t;
+
+/**
+ * Set the per-heap limits (once at startup, before any heap exists)
+ * @param max_bytes Live-byte ceiling per heap (0 = unlimited)
+ * @param gc_bytes Growth since the last forced GC that triggers the next (0 = never)
+ */
+void js_heap_set_limits(size_t max_bytes, size_t gc_bytes);
+
+/**
+ * Create a Duktape heap on the pooled allocator
+ * @param out Allocator state; pass it to js_heap_maybe_gc() / js_heap_destroy()
+ * @return New context, or NULL on allocation failure
+ */
+duk_context *js_heap_create(js_heap_t **out);
+
+/**
+ * Destroy the Duktape heap and release its pool
+ */
+void js_heap_destroy(js_heap_t *heap);
+
+/**
+ * Run duk_gc() if the heap grew by gc_bytes since the last forced GC.
+ * Call between requests, never from inside a Duktape call.
+ */
+void js_heap_maybe_gc(js_heap_t *heap);
+
+/**
+ * Live bytes of one heap
+ */
+size_t js_heap_bytes(const js_heap_t *heap);
+
+/**
+ * Snapshot counters of all live heaps
+ * @param out Filled with current values
+ */
+void js_heap_stats(js_heap_stats_t *out);
+
+#endif /* SVGD_RRD_JS_HEAP_H */
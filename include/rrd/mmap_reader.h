@@ -0,0 +1,60 @@
+/**
+ * @file mmap_reader.h
+ * @brief Native read-only RRD reader over mmap (rrd.reader: "mmap")
+ *
+ * rrd_fetch_r() opens the file, parses the header and reads the archive on
+ * every call. This reader maps each RRD file read-only once, validates and
+ * parses its header once, and walks the RRA ring buffer in place, copying
+ * only the requested window. A warm fetch is one stat() (to notice a
+ * replaced file) plus the copy.
+ *
+ * Only files in the host's native format are supported (librrd writes them
+ * that way): a foreign cookie, version or float cookie makes the calls fail
+ * and the caller falls back to librrd. Results match rrd_fetch_r() row for
+ * row, including its RRA choice and time alignment.
+ */
+
+#ifndef SVGD_RRD_MMAP_READER_H
+#define SVGD_RRD_MMAP_READER_H
+
+#include <time.h>
+#include "reader.h"  /* RRDLayout */
+
+/**
+ * Fetch a window, same contract as rrd_fetch_r()
+ * @param filename RRD file
+ * @param cf Consolidation function ("AVERAGE", "MAX", ...)
+ * @param start In: requested start; out: aligned start of the returned rows
+ * @param end In: requested end; out: aligned end
+ * @param step In: desired step; out: step of the chosen RRA
+ * @param ds_cnt Out: number of data sources
+ * @param ds_names Out: DS names; one allocation, release with free()
+ * @param data Out: rows x ds_cnt values, release with free()
+ * @return 0 on success, -1 on error (unreadable or non-native file, no RRA for cf)
+ */
+int rrd_mmap_fetch(const char *filename, const char *cf, time_t *start, time_t *end,
+                   unsigned long *step, unsigned long *ds_cnt, char ***ds_names,
+                   double **data);
+
+/**
+ * Read the base step and RRA table from the mapped header
+ * @param filename RRD file
+ * @param layout Filled like the rrd_info_r() based loader (first_timestamp = -1)
+ * @return 0 on success, -1 on error
+ */
+int rrd_mmap_layout(const char *filename, RRDLayout *layout);
+
+/**
+ * First timestamp of an RRA, same as rrd_first_r()
+ * @param filename RRD file
+ * @param rra_index RRA index in the file
+ * @return Timestamp, or -1 on error
+ */
+time_t rrd_mmap_first(const char *filename, int rra_index);
+
+/**
+ * Unmap all files
+ */
+void rrd_mmap_free(void);
+
+#endif /* SVGD_RRD_MMAP_READER_H */
@@ -19,6 +19,15 @@ typedef struct {
     double value;
 } DataPoint;
 
+/*
+ * MetricData is immutable once published (e.g. put into the RRD cache) and
+ * shared by reference: holders call metric_data_retain() to keep it and
+ * metric_data_release() when done. `refs` counts owners beyond the first, so
+ * a zero-initialized (calloc'd) MetricData is a valid sole-owner object.
+ *
+ * Data read from an RRD file also records where the fetch stopped, so an
+ * expired copy can be extended with rrd_fetch_delta() instead of refetched.
+ */
 typedef struct MetricData {
     int series_count;
     char **series_names;
@@ -26,6 +35,9 @@ typedef struct MetricData {
     int *series_counts;
     char *param1;
     MetricConfig *metric_config;
+    int refs;                     /* extra owners (atomic), 0 = sole owner */
+    time_t fetch_end;             /* first row not yet written when fetched */
+    unsigned long fetch_step;     /* row step; 0 = not extendable (non-RRD data) */
 } MetricData;
 
 /**
@@ -61,6 +73,87 @@ unsigned long select_step_from_rras(const RRAStepInfo *rras, int rra_count,
                                     time_t range, time_t period,
                                     unsigned long base_step);
 
+/**
+ * @brief Выбрать шаг под ширину графика в пикселях
+ *
+ * Чистая функция. Среди AVERAGE-RRA берётся шаг, число точек которого за
+ * range ближе всего (по отношению) к окну [width, 2*width] — 1–2 точки на
+ * пиксель; при равенстве — более грубый. Узкой панели (спарклайну) так
+ * достаётся грубый архив, а не 2400 точек, которые она не может отобразить.
+ *
+ * @param rras Массив описаний RRA (рассматриваются только AVERAGE)
+ * @param rra_count Число элементов rras
+ * @param range Диапазон выборки в секундах, > 0
+ * @param width Ширина графика в пикселях, > 0
+ * @return Выбранный шаг в секундах, 0 — AVERAGE-RRA нет
+ */
+unsigned long select_step_for_width(const RRAStepInfo *rras, int rra_count,
+                                    time_t range, int width);
+
+#define RRD_LAYOUT_MAX_RRAS 20
+
+/**
+ * @brief Описание одного RRA из заголовка RRD-файла
+ */
+typedef struct {
+    unsigned long pdp_per_row;    /**< PDP на строку */
+    unsigned long rows;           /**< Число строк */
+    unsigned long effective_step; /**< pdp_per_row * base_step */
+    char cf[16];                  /**< Функция консолидации */
+    int index;                    /**< Индекс RRA в файле (для rrd_first_r) */
+} RRDRraLayout;
+
+/**
+ * @brief Раскладка RRD-файла, нужная для выбора шага
+ *
+ * Всё, что select_optimal_step раньше читал через rrd_info_r/rrd_first_r на
+ * каждом промахе кэша. Кэшируется по идентичности файла (см. rra_cache.h).
+ */
+typedef struct {
+    unsigned long base_step;      /**< Базовый шаг RRD */
+    int rra_count;
+    RRDRraLayout rras[RRD_LAYOUT_MAX_RRAS];
+    time_t first_timestamp;       /**< Первая метка AVERAGE-данных, -1 если неизвестна */
+} RRDLayout;
+
+/**
+ * @brief Выбрать шаг по раскладке файла (без I/O)
+ *
+ * Обрезает начало диапазона по first_timestamp (при -1 — по end - period) и
+ * делегирует select_step_for_width (если задана ширина и есть AVERAGE-RRA),
+ * иначе select_step_from_rras; при пустом диапазоне возвращает 15.
+ *
+ * @param layout Раскладка файла
+ * @param start Начало запрошенного диапазона
+ * @param end Конец диапазона
+ * @param period Запрошенный период в секундах
+ * @param width Ширина графика в пикселях, 0 — не задана (окно 100–2400 точек)
+ * @return Выбранный шаг в секундах
+ */
+unsigned long select_step_for_layout(const RRDLayout *layout, time_t start,
+                                     time_t end, int period, int width);
+
+/** How direct (non-rrdcached) reads are done */
+typedef enum {
+    RRD_READER_LIBRRD = 0,  /* rrd_fetch_r / rrd_info_r (default) */
+    RRD_READER_MMAP         /* Native mmap reader, see rrd/mmap_reader.h */
+} rrd_reader_backend_t;
+
+/**
+ * Parse a reader backend name ("librrd", "mmap")
+ * @param name Backend name from rrd.reader
+ * @param out Parsed backend
+ * @return 0 on success, -1 for an unknown name (out is left unchanged)
+ */
+int rrd_reader_backend_parse(const char *name, rrd_reader_backend_t *out);
+
+/**
+ * Select the backend for direct reads (call once at startup). With
+ * RRD_READER_MMAP, files the native reader cannot handle still go to librrd.
+ * @param backend Backend to use
+ */
+void rrd_reader_set_backend(rrd_reader_backend_t backend);
+
 /**
  * Fetch metric data from RRD file
  *
@@ -69,18 +162,66 @@ unsigned long select_step_from_rras(const RRAStepInfo *rras, int rra_count,
  * @param start Start timestamp
  * @param param1 Optional parameter for template substitution
  * @param metric_config Metric configuration for transformations
- * @return Allocated MetricData (caller must free with rrd_data_free), or NULL on error
+ * @return Allocated MetricData (caller must release with metric_data_release), or NULL on error
  */
 MetricData* rrd_fetch_data(const char *rrdcached_addr, const char *filename,
                            time_t start, const char *param1, MetricConfig *metric_config);
 
 /**
- * Free MetricData structure
+ * Choose the fetch step for a window ending now (see select_step_for_layout)
+ *
+ * @param filename Path to RRD file
+ * @param start Start timestamp
+ * @param width Chart width in pixels, 0 if unknown
+ * @return Step in seconds (a default when the file cannot be read)
+ */
+unsigned long rrd_select_step(const char *filename, time_t start, int width);
+
+/**
+ * Fetch metric data at a step chosen by the caller (rrd_select_step), so the
+ * step can also be part of a cache key. rrd_fetch_data() is this with the
+ * width-agnostic step.
+ */
+MetricData* rrd_fetch_data_step(const char *rrdcached_addr, const char *filename,
+                                time_t start, unsigned long step, const char *param1,
+                                MetricConfig *metric_config);
+
+/**
+ * Refresh expired RRD data by reading only the rows written since it was
+ * fetched: points before the new window start are dropped, rows from
+ * base->fetch_end on are fetched and appended.
+ *
+ * @param rrdcached_addr Address of rrdcached daemon (NULL or empty for direct file access)
+ * @param filename Path to RRD file (the one base was read from)
+ * @param base Previous result of rrd_fetch_data/rrd_fetch_delta (not modified)
+ * @param start Start of the new window (now - period)
+ * @return New MetricData (caller must release), or NULL if base cannot be
+ *         extended (non-RRD data, different archive answered, read error):
+ *         fall back to rrd_fetch_data
+ */
+MetricData* rrd_fetch_delta(const char *rrdcached_addr, const char *filename,
+                            const MetricData *base, time_t start);
+
+/**
+ * Take an additional reference to MetricData
+ * @param data Data to share (may be NULL)
+ * @return data
+ */
+MetricData* metric_data_retain(MetricData *data);
+
+/**
+ * Drop a reference; the last owner frees the data
+ * @param data Data to release (may be NULL)
+ */
+void metric_data_release(MetricData *data);
+
+/**
+ * Free MetricData structure (same as metric_data_release)
  */
 void rrd_data_free(MetricData *data);
 
 /* Compatibility aliases */
 #define fetch_metric_data rrd_fetch_data
-#define free_metric_data rrd_data_free
+#define free_metric_data metric_data_release
 
 #endif /* SVGD_RRD_READER_H */
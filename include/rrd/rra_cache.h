@@ -0,0 +1,48 @@
+/**
+ * @file rra_cache.h
+ * @brief Per-file RRA layout cache
+ *
+ * Step selection needs the base step, the RRA table and the first AVERAGE
+ * timestamp of an RRD file. Reading them costs an rrd_info_r() (which parses
+ * every header key) plus one rrd_first_r() per AVERAGE RRA — several opens
+ * and reads per uncached fetch, painful on NFS. This cache keeps them per
+ * path, validated by the file's identity from stat(): device, inode and size
+ * pin the layout, mtime pins the first timestamp.
+ */
+
+#ifndef SVGD_RRD_RRA_CACHE_H
+#define SVGD_RRD_RRA_CACHE_H
+
+#include <sys/stat.h>
+#include "reader.h"  /* For RRDLayout definition */
+
+/** Lookup result */
+typedef enum {
+    RRA_CACHE_MISS = 0,   /* Unknown path or file replaced/resized: read everything */
+    RRA_CACHE_STALE,      /* Layout valid, file updated: refresh first_timestamp */
+    RRA_CACHE_HIT         /* Layout and first_timestamp valid */
+} rra_cache_status_t;
+
+/**
+ * Look up the layout of an RRD file
+ * @param path Full path to RRD file
+ * @param st stat() of the file, taken by the caller
+ * @param out Filled with the cached layout on HIT or STALE
+ * @return Lookup result
+ */
+rra_cache_status_t rra_cache_get(const char *path, const struct stat *st, RRDLayout *out);
+
+/**
+ * Store (or refresh) the layout of an RRD file
+ * @param path Full path to RRD file
+ * @param st stat() of the file the layout was read from
+ * @param layout Layout to store (copied)
+ */
+void rra_cache_put(const char *path, const struct stat *st, const RRDLayout *layout);
+
+/**
+ * Free the RRA layout cache
+ */
+void rra_cache_free(void);
+
+#endif /* SVGD_RRD_RRA_CACHE_H */
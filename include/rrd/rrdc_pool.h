@@ -0,0 +1,116 @@
+/**
+ * @file rrdc_pool.h
+ * @brief Pool of persistent rrdcached connections
+ *
+ * librrd's rrdc_* calls share one process-global connection, so every fetch
+ * used to connect, flush and disconnect, and concurrent workers serialized on
+ * that single socket. The pool hands out independent rrd_client_t handles
+ * (librrd >= 1.7) that stay connected between fetches. A connection that
+ * breaks is dropped on release and replaced on the next acquire; after a
+ * failed connect the daemon is considered down for RRDC_POOL_RETRY_SEC and
+ * callers fall back to direct file I/O without paying a connect attempt.
+ *
+ * The pool also owns the flush policy. An explicit FLUSH before every fetch
+ * made rrdcached write each hot file on every dashboard refresh; see
+ * rrdc_flush_policy_t for the alternatives.
+ */
+
+#ifndef SVGD_RRD_RRDC_POOL_H
+#define SVGD_RRD_RRDC_POOL_H
+
+#include <rrd_client.h>
+
+/** Seconds to skip connect attempts after rrdcached was unreachable */
+#define RRDC_POOL_RETRY_SEC 5
+
+/** When to make rrdcached write a file's pending updates before reading it */
+typedef enum {
+    RRDC_FLUSH_FETCH = 0,  /* No explicit FLUSH: rrdcached's FETCH flushes the file
+                              itself, and only if it has pending updates (default) */
+    RRDC_FLUSH_ALWAYS,     /* FLUSH before every FETCH (the old behaviour) */
+    RRDC_FLUSH_INTERVAL    /* Read the file directly if rrdcached served it within
+                              the interval, otherwise FETCH through the daemon */
+} rrdc_flush_policy_t;
+
+/** Pool counters, see rrdc_pool_stats() */
+typedef struct {
+    unsigned long connects;          /* Successful connects */
+    unsigned long connect_failures;  /* Failed connects */
+    unsigned long dropped;           /* Broken connections discarded on release */
+    int idle;                        /* Connected handles waiting in the pool */
+    int healthy;                     /* 0 while in the retry backoff */
+    unsigned long flushes;           /* Explicit FLUSH commands sent */
+    unsigned long flushes_avoided;   /* Fetches served without an explicit FLUSH */
+} rrdc_pool_stats_t;
+
+/**
+ * Parse a flush policy name ("fetch", "always", "interval")
+ * @param name Policy name from rrd.flush_policy
+ * @param out Parsed policy
+ * @return 0 on success, -1 for an unknown name (out is left unchanged)
+ */
+int rrdc_flush_policy_parse(const char *name, rrdc_flush_policy_t *out);
+
+/**
+ * Configure the pool (call once at startup)
+ * @param daemon_addr rrdcached address ("unix:/path" or "host:port"); empty = disabled
+ * @param max_idle Connections kept open between fetches (<= 0 means 4)
+ */
+void rrdc_pool_init(const char *daemon_addr, int max_idle);
+
+/**
+ * Select the flush policy (call once at startup)
+ * @param policy Policy to apply
+ * @param interval_seconds Freshness window for RRDC_FLUSH_INTERVAL (<= 0 means 30)
+ */
+void rrdc_pool_set_flush_policy(rrdc_flush_policy_t policy, int interval_seconds);
+
+/**
+ * Check out a connected client
+ * @param daemon_addr Address to use if the pool was not initialized
+ * @return Connected client (return it with rrdc_pool_release), or NULL if
+ *         rrdcached is not configured or unreachable
+ */
+rrd_client_t *rrdc_pool_acquire(const char *daemon_addr);
+
+/**
+ * Return a client to the pool. Clients whose connection broke are destroyed.
+ * @param client Client from rrdc_pool_acquire (NULL is ignored)
+ */
+void rrdc_pool_release(rrd_client_t *client);
+
+/**
+ * Decide whether a fetch may bypass rrdcached (RRDC_FLUSH_INTERVAL only)
+ * @param filename RRD file about to be read
+ * @return 1 if rrdcached served this file within the interval, so the copy on
+ *         disk is at most that stale and can be read directly; 0 otherwise
+ */
+int rrdc_pool_fresh_on_disk(const char *filename);
+
+/**
+ * Prepare a file for FETCH according to the flush policy: sends FLUSH under
+ * RRDC_FLUSH_ALWAYS, otherwise only counts the flush as avoided
+ * @param client Client from rrdc_pool_acquire
+ * @param filename RRD file about to be fetched
+ */
+void rrdc_pool_flush(rrd_client_t *client, const char *filename);
+
+/**
+ * Record that rrdcached just served a file, i.e. its pending updates are on
+ * disk now (used by RRDC_FLUSH_INTERVAL)
+ * @param filename RRD file that was fetched through rrdcached
+ */
+void rrdc_pool_mark_flushed(const char *filename);
+
+/**
+ * Snapshot pool counters
+ * @param out Filled with current values
+ */
+void rrdc_pool_stats(rrdc_pool_stats_t *out);
+
+/**
+ * Close all idle connections and reset the pool, flush policy and counters
+ */
+void rrdc_pool_free(void);
+
+#endif /* SVGD_RRD_RRDC_POOL_H */
@@ -11,13 +11,89 @@
 #include "reader.h"  /* For MetricData definition */
 #include <duktape.h>  /* For duk_context (svg_get_context declaration) */
 
+/**
+ * How series are handed to generateSVG(series, options)
+ *
+ * SVG_SERIES_TYPED:   series[i].timestamps / series[i].values are
+ *                     Float64Arrays (two views over one buffer per series)
+ * SVG_SERIES_OBJECTS: series[i].data = [{timestamp, value}, ...], one JS
+ *                     object per point (the original format)
+ */
+typedef enum {
+    SVG_SERIES_TYPED = 0,
+    SVG_SERIES_OBJECTS
+} svg_series_format_t;
+
+/**
+ * Parse a series format name ("typed", "objects")
+ * @return 0 on success, -1 for an unknown name
+ */
+int svg_series_format_parse(const char *name, svg_series_format_t *out);
+
+/**
+ * Select the series format for subsequent svg_generate() calls
+ * (set once at startup; default SVG_SERIES_TYPED)
+ */
+void svg_set_series_format(svg_series_format_t format);
+
+/**
+ * What renders svg_generate() output
+ *
+ * SVG_ENGINE_JS:     generateSVG() from the configured script in Duktape
+ *                    (default; the customizable path)
+ * SVG_ENGINE_NATIVE: svg_native_generate(), a C port of the bundled
+ *                    generate_svg.js (same output, no interpreter)
+ */
+typedef enum {
+    SVG_ENGINE_JS = 0,
+    SVG_ENGINE_NATIVE
+} svg_render_engine_t;
+
+/**
+ * Parse a render engine name ("js", "native")
+ * @return 0 on success, -1 for an unknown name
+ */
+int svg_render_engine_parse(const char *name, svg_render_engine_t *out);
+
+/**
+ * Select the render engine for subsequent svg_generate() calls
+ * (set once at startup; default SVG_ENGINE_JS)
+ */
+void svg_set_render_engine(svg_render_engine_t engine);
+
 /**
  * Initialize the JavaScript cache
+ *
+ * Reads the script and compiles it once to Duktape bytecode; every new
+ * thread context then loads the bytecode instead of parsing the source.
+ * If the dump fails, contexts evaluate the source as before. Thread-safe:
+ * svg_generate() calls it lazily, and concurrent callers load the script once.
+ *
  * @param filename Path to JavaScript file (e.g., generate_svg.js)
  * @return 0 on success, -1 on error
  */
 int svg_init_cache(const char *filename);
 
+/**
+ * Re-read the script passed to svg_init_cache() and publish it
+ *
+ * The new source is compiled and run once in a scratch heap first; if it
+ * fails to compile, throws or defines no generateSVG function, the current
+ * version stays in place. On success the script generation is bumped and
+ * every thread context re-evaluates the script on its next request, keeping
+ * its heap (and all RRD / SVG caches stay warm). Thread-safe.
+ *
+ * @return 0 on success, -1 if the cache is not initialized or the new
+ *         script was rejected (the old one keeps serving)
+ */
+int svg_reload_script(void);
+
+/**
+ * Current script generation: 1 after svg_init_cache(), +1 per successful
+ * svg_reload_script(). Part of the rendered-SVG cache key.
+ */
+unsigned svg_script_generation(void);
+
 /**
  * Free the JavaScript cache
  */
@@ -30,15 +106,18 @@ void svg_free_cache(void);
 void svg_prewarm_context(void);
 
 /**
- * Generate SVG from metric data
- * @param script_path Path to JavaScript file
- * @param data Metric data to render
+ * Generate SVG from metric data with the selected render engine
+ * @param script_path Path to JavaScript file (JS engine only)
+ * @param data Metric data to render (read-only; may be shared with the cache)
+ * @param metric Metric configuration (NULL = data->metric_config)
  * @param width SVG width in pixels
  * @param height SVG height in pixels
  * @param theme Render theme ("light"|"dark"|"high-contrast"); NULL/unknown -> light
+ * @param out_len Set to the SVG length on success (may be NULL)
  * @return Allocated SVG string (caller must free), or NULL on error
  */
-char* svg_generate(const char *script_path, MetricData *data, int width, int height, const char *theme);
+char* svg_generate(const char *script_path, const MetricData *data, const MetricConfig *metric,
+                   int width, int height, const char *theme, size_t *out_len);
 
 /**
  * Acquire a thread-safe Duktape context for non-rendering JS work (e.g. JSON parsing).
@@ -48,7 +127,7 @@ char* svg_generate(const char *script_path, MetricData *data, int width, int hei
 duk_context *svg_get_context(void);
 
 /* Compatibility aliases */
-#define generate_svg(ctx, path, data, width, height, theme) svg_generate(path, data, width, height, theme)
+#define generate_svg(ctx, path, data, metric, width, height, theme) svg_generate(path, data, metric, width, height, theme, NULL)
 #define init_js_cache svg_init_cache
 #define free_js_cache svg_free_cache
 #define prewarm_thread_context svg_prewarm_context
@@ -0,0 +1,169 @@
+/**
+ * @file svg_cache.h
+ * @brief Rendered-SVG output cache
+ *
+ * Second cache tier in front of svg_generate(): stores the final SVG string
+ * for a (endpoint, param, period, width, height, theme, decimation, script
+ * generation) tuple, so identical panel requests within the TTL skip data
+ * fetch, JS marshalling and rendering entirely, and a reloaded script is
+ * never answered with the old one's output. Same hash table + TTL scheme as
+ * cache.h.
+ *
+ * Misses are coalesced (single-flight): the first request for a key renders,
+ * concurrent requests for the same key wait for that result instead of
+ * rendering it again.
+ *
+ * An entry can also hold compressed variants of its SVG (one per
+ * Content-Encoding, see compress.h), attached by the first request that
+ * compressed it, so later hits are sent without recompressing. They are
+ * dropped with the render they were made from.
+ *
+ * Memory is bounded by a byte budget covering SVGs and their variants; past
+ * it, entries not hit since the last eviction pass are evicted first (CLOCK,
+ * as in cache.h).
+ *
+ * SVGs and variants are stored as immutable, refcounted svg_buf_t (like
+ * MetricData in the RRD cache): a hit retains the cached buffer instead of
+ * copying it, and an entry replaced or evicted meanwhile stays valid for
+ * whoever still holds it.
+ */
+
+#ifndef SVGD_RRD_SVG_CACHE_H
+#define SVGD_RRD_SVG_CACHE_H
+
+#include <stddef.h>
+#include "../compress.h"
+
+/**
+ * Shared SVG or compressed variant. Never modified once created; `refs`
+ * counts owners beyond the first, so a fresh buffer has one owner.
+ */
+typedef struct {
+    int refs;
+    size_t len;
+    char *data;             /* malloc'd bytes */
+} svg_buf_t;
+
+/**
+ * Wrap malloc'd bytes in a buffer with one owner
+ * @param data Bytes (ownership taken; freed here on allocation failure)
+ * @param len Length of data
+ * @return Buffer, or NULL if data is NULL or out of memory
+ */
+svg_buf_t* svg_buf_wrap(char *data, size_t len);
+
+/**
+ * Take an additional reference
+ * @param buf Buffer to share (may be NULL)
+ * @return buf
+ */
+svg_buf_t* svg_buf_retain(svg_buf_t *buf);
+
+/**
+ * Drop a reference; the last owner frees the buffer and its data
+ * @param buf Buffer to release (may be NULL)
+ */
+void svg_buf_release(svg_buf_t *buf);
+
+/**
+ * Everything that changes the rendered bytes of a chart
+ */
+typedef struct {
+    const char *endpoint;   /* Metric endpoint from config (e.g., "cpu/process") */
+    const char *param;      /* Path parameter, or NULL */
+    int period;             /* Time period in seconds */
+    int width;              /* Clamped SVG width */
+    int height;             /* Clamped SVG height */
+    const char *theme;      /* Resolved theme name */
+    int decimate;           /* Resolved decimation mode (decimate_mode_t) */
+    unsigned script;        /* svg_script_generation() at request time */
+} svg_cache_key_t;
+
+/** Cache counters, see svg_cache_stats() */
+typedef struct {
+    size_t entries;               /* Stored entries (including expired, not yet replaced) */
+    size_t bytes;                 /* Accounted bytes (entries + SVGs + variants) */
+    size_t max_bytes;             /* Budget, 0 = unlimited */
+    unsigned long evictions;      /* Entries evicted to stay within max_bytes */
+    unsigned long expirations;    /* Expired entries removed */
+} svg_cache_stats_t;
+
+/**
+ * Initialize the SVG cache
+ * @param ttl_seconds Time-to-live for cached entries (0 = default 5s)
+ * @param max_bytes Memory budget in bytes (0 = unlimited)
+ */
+void svg_cache_init(int ttl_seconds, size_t max_bytes);
+
+/**
+ * Get cached SVG
+ * @param key Render key
+ * @return Shared SVG (caller must svg_buf_release it), or NULL if not cached/expired
+ */
+svg_buf_t* svg_cache_get(const svg_cache_key_t *key);
+
+/**
+ * Store rendered SVG in cache
+ * @param key Render key
+ * @param svg SVG (the cache takes its own reference; caller keeps theirs).
+ *            SVGs larger than the whole budget are not cached.
+ */
+void svg_cache_put(const svg_cache_key_t *key, svg_buf_t *svg);
+
+/**
+ * Get a compressed variant of a cached SVG
+ * @param key Render key
+ * @param encoding COMPRESS_GZIP or COMPRESS_DEFLATE
+ * @return Shared compressed bytes (caller must svg_buf_release them), or NULL
+ *         if the SVG is not cached or has no such variant yet
+ */
+svg_buf_t* svg_cache_get_variant(const svg_cache_key_t *key, compress_encoding_t encoding);
+
+/**
+ * Attach a compressed variant to the cached SVG it was made from.
+ * Ignored if that entry is gone, re-rendered since (another buffer), or
+ * already has the variant.
+ * @param key Render key
+ * @param encoding Encoding of data
+ * @param svg The SVG buffer that was compressed (as returned by the cache)
+ * @param data Compressed bytes (the cache takes its own reference)
+ */
+void svg_cache_put_variant(const svg_cache_key_t *key, compress_encoding_t encoding,
+                           const svg_buf_t *svg, svg_buf_t *data);
+
+/**
+ * Get cached SVG, or become the one request that renders it.
+ *
+ * On a hit returns a reference to the cached SVG. On a miss with a render of
+ * the same key already in flight, blocks until it completes and returns a
+ * reference to its result (NULL if it failed). Otherwise claims the key, sets
+ * *leader = 1 and returns NULL: the caller must then render and call
+ * svg_cache_complete() exactly once.
+ *
+ * @param key Render key
+ * @param leader Set to 1 if the caller must render, 0 otherwise
+ * @return Shared SVG (caller must svg_buf_release it), or NULL
+ */
+svg_buf_t* svg_cache_acquire(const svg_cache_key_t *key, int *leader);
+
+/**
+ * Publish the leader's render: caches it and wakes the waiting requests,
+ * which all share the one buffer.
+ * @param key Render key passed to svg_cache_acquire()
+ * @param svg Rendered SVG (the cache and waiters take their own references),
+ *            or NULL if rendering failed
+ */
+void svg_cache_complete(const svg_cache_key_t *key, svg_buf_t *svg);
+
+/**
+ * Snapshot cache counters
+ * @param out Filled with current values
+ */
+void svg_cache_stats(svg_cache_stats_t *out);
+
+/**
+ * Free the SVG cache and all stored entries
+ */
+void svg_cache_free(void);
+
+#endif /* SVGD_RRD_SVG_CACHE_H */
@@ -0,0 +1,34 @@
+/**
+ * @file svg_native.h
+ * @brief Native C chart / stat renderer (server.render_engine: "native")
+ *
+ * A C port of generateSVG() and generateStatSVG() from
+ * src/scripts/generate_svg.js: same THEMES, margins, grid, segments, hover
+ * points, legend and stat sparkline, and the same number formatting (JS
+ * Number-to-string and toFixed() rounding), so for the bundled script the
+ * output is byte-identical. tests/c/test_svg_native.c holds both renderers to
+ * the golden files in tests/c/golden/.
+ *
+ * The JS engine remains the customizable path: changes to generate_svg.js
+ * are not picked up here.
+ */
+
+#ifndef SVGD_RRD_SVG_NATIVE_H
+#define SVGD_RRD_SVG_NATIVE_H
+
+#include "reader.h"  /* For MetricData definition */
+
+/**
+ * Render metric data without Duktape
+ * @param data Metric data to render (read-only; may be shared with the cache)
+ * @param metric Metric configuration (NULL = data->metric_config)
+ * @param width SVG width in pixels (0 = renderer default)
+ * @param height SVG height in pixels (0 = renderer default)
+ * @param theme Render theme ("light"|"dark"|"high-contrast"); NULL/unknown -> light
+ * @param out_len Set to the SVG length on success (may be NULL)
+ * @return Allocated SVG string (caller must free), or NULL on allocation failure
+ */
+char* svg_native_generate(const MetricData *data, const MetricConfig *metric,
+                          int width, int height, const char *theme, size_t *out_len);
+
+#endif /* SVGD_RRD_SVG_NATIVE_H */
@@ -0,0 +1,47 @@
+/**
+ * @file svg_reload.h
+ * @brief Hot reload of the generate_svg script (js.reload)
+ *
+ * A background thread calls svg_reload_script() when SIGHUP arrives
+ * (svg_reload_request() from the signal handler) and, in "inotify" mode,
+ * when the script file is written or replaced. Bursts of events are
+ * debounced into one reload. A rejected script keeps the old one serving.
+ */
+
+#ifndef SVGD_RRD_SVG_RELOAD_H
+#define SVGD_RRD_SVG_RELOAD_H
+
+/**
+ * What triggers a reload
+ */
+typedef enum {
+    SVG_RELOAD_SIGHUP = 0,  /* "sighup": only SIGHUP (kill -HUP, systemctl reload) */
+    SVG_RELOAD_INOTIFY      /* "inotify": SIGHUP, and any write/rename of the script */
+} svg_reload_mode_t;
+
+/**
+ * Parse a js.reload name ("sighup" | "inotify")
+ * @return 0 on success, -1 on unknown name (*out untouched)
+ */
+int svg_reload_mode_parse(const char *name, svg_reload_mode_t *out);
+
+/**
+ * Start the reload thread; call after svg_init_cache()
+ * @param script_path Script path (watched in SVG_RELOAD_INOTIFY mode)
+ * @param mode Reload trigger
+ * @return 0 on success, -1 on error (inotify failure falls back to SIGHUP only)
+ */
+int svg_reload_start(const char *script_path, svg_reload_mode_t mode);
+
+/**
+ * Ask the reload thread for a reload. Async-signal-safe (SIGHUP handler);
+ * a no-op when the thread is not running.
+ */
+void svg_reload_request(void);
+
+/**
+ * Stop and join the reload thread
+ */
+void svg_reload_stop(void);
+
+#endif /* SVGD_RRD_SVG_RELOAD_H */
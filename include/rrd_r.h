@@ -4,8 +4,14 @@
  *
  * This header includes all RRD-related submodules:
  * - reader.h: RRD file reading
+ * - rra_cache.h: Per-file RRA layout caching
+ * - rrdc_pool.h: Persistent rrdcached connections
+ * - mmap_reader.h: Native mmap RRD reader
  * - cache.h: Data caching
+ * - svg_cache.h: Rendered-SVG caching
  * - svg.h: SVG generation
+ * - js_heap.h: Pooled allocator for the render heaps
+ * - svg_reload.h: Script hot reload
  */
 
 #ifndef RRD_READER_H
@@ -13,8 +19,15 @@
 
 /* Include all submodules */
 #include "rrd/reader.h"
+#include "rrd/rra_cache.h"
+#include "rrd/rrdc_pool.h"
+#include "rrd/mmap_reader.h"
+#include "rrd/decimate.h"
 #include "rrd/cache.h"
+#include "rrd/svg_cache.h"
 #include "rrd/svg.h"
+#include "rrd/js_heap.h"
+#include "rrd/svg_reload.h"
 
 /* Legacy definitions for backward compatibility */
 #define MAX_POINTS 1000
@@ -0,0 +1,42 @@
+/**
+ * @file task_pool.h
+ * @brief Render thread pool for fan-out inside one request (_batch)
+ *
+ * task_pool_run() spreads count independent tasks over the pool threads and
+ * the calling thread, and returns when all of them are done. The caller
+ * always takes part, so a request makes progress even while the pool is
+ * busy with other batches, and nothing deadlocks when the pool is not
+ * started (tests, thread_pool_size 1): everything then runs inline.
+ *
+ * main.c sizes the pool at half of thread_pool_size and gives the rest to the
+ * request workers, so both together never exceed it. Pool threads pre-warm
+ * their thread-local Duktape context like the server workers do.
+ */
+
+#ifndef SVGD_TASK_POOL_H
+#define SVGD_TASK_POOL_H
+
+/** Task body: index is 0..count-1, arg is the task_pool_run() argument */
+typedef void (*task_fn)(void *arg, int index);
+
+/**
+ * Start the pool threads (once at startup)
+ * @param threads Pool threads; <= 0 starts none (tasks run on the caller)
+ * @return 0 on success, -1 if no thread could be started
+ */
+int task_pool_start(int threads);
+
+/**
+ * Run fn(arg, 0..count-1) in parallel; returns when every task finished
+ * @param fn Task body (must be thread-safe)
+ * @param arg Shared argument
+ * @param count Number of tasks
+ */
+void task_pool_run(task_fn fn, void *arg, int count);
+
+/**
+ * Stop and join the pool threads; pending batches are finished by their callers
+ */
+void task_pool_stop(void);
+
+#endif /* SVGD_TASK_POOL_H */
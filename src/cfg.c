@@ -108,6 +108,7 @@ static MetricConfig parse_metric_config(duk_context *ctx) {
     metric.transform_divisor = get_double_field(ctx, "transform_divisor", 1.0);
     set_string_field(ctx, "value_format", metric.value_format, sizeof(metric.value_format), "%.2f");
     set_string_field(ctx, "panel_type", metric.panel_type, sizeof(metric.panel_type), "chart");
+    set_string_field(ctx, "decimate", metric.decimate, sizeof(metric.decimate), "none");
 
     // Источник данных (Фаза 2). По умолчанию "rrd" → SRC_RRD (обратная совместимость).
     // metric_source_from_string — static inline из include/metric_source.h.
@@ -130,11 +131,24 @@ Config load_config(duk_context *ctx, const char *filename) {
         .allowed_ips = "127.0.0.1",
         .rrdcached_addr = "unix:/var/run/rrdcached.sock",
         .rrd_base_path = "/opt/collectd/var/lib/collectd/rrd/localhost",
+        .rrd_flush_policy = "fetch", // Default: let rrdcached's FETCH flush (no explicit FLUSH)
+        .rrd_flush_interval = 30,
+        .rrd_reader = "librrd",      // Default: read through librrd
         .js_script_path = "/home/workerpool/svgd/scripts/generate_cpu_svg.js",
+        .js_series_format = "typed", // Default: series as Float64Arrays
+        .js_reload = "sighup",       // Default: reload generate_svg.js on SIGHUP only
+        .js_heap_max_bytes = 128 * 1024 * 1024,  // Default: 128 MiB per render heap
+        .js_heap_gc_bytes = 8 * 1024 * 1024,     // Default: full GC after 8 MiB of growth
         .thread_pool_size = 4,       // Default: 4 workers (optimal for CPU-bound JS)
+        .listen_shards = 1,          // Default: one listener, no CPU pinning
         .cache_ttl_seconds = 5,      // Default: 5 second RRD cache
+        .cache_max_bytes = 32 * 1024 * 1024,  // Default: 32 MiB RRD cache budget
+        .svg_cache_max_bytes = 16 * 1024 * 1024,  // Default: 16 MiB rendered-SVG cache budget
+        .compression_level = 6,      // Default: zlib's default level
+        .compression_min_bytes = 1024,  // Default: skip bodies under 1 KiB
         .verbose = 0,                // Default: quiet mode
         .theme = "light",            // Default: light theme (see docs/gallery.md)
+        .render_engine = "js",       // Default: render with generate_svg.js
         .metrics = NULL,
         .metrics_count = 0
     };
@@ -196,9 +210,11 @@ Config load_config(duk_context *ctx, const char *filename) {
         set_string_field(ctx, "allowed_ips", config.allowed_ips, sizeof(config.allowed_ips), "127.0.0.1");
         set_string_field(ctx, "rrdcached_addr", config.rrdcached_addr, sizeof(config.rrdcached_addr), "");
         config.thread_pool_size = get_int_field(ctx, "thread_pool_size", 4);
+        config.listen_shards = get_int_field(ctx, "listen_shards", 1);
         config.cache_ttl_seconds = get_int_field(ctx, "cache_ttl_seconds", 5);
         config.verbose = get_int_field(ctx, "verbose", 0);
         set_string_field(ctx, "theme", config.theme, sizeof(config.theme), "light");
+        set_string_field(ctx, "render_engine", config.render_engine, sizeof(config.render_engine), "js");
     }
     duk_pop(ctx);
 
@@ -206,6 +222,28 @@ Config load_config(duk_context *ctx, const char *filename) {
     (void)duk_get_prop_string(ctx, -1, "rrd");
     if (duk_is_object(ctx, -1)) {
         set_string_field(ctx, "base_path", config.rrd_base_path, sizeof(config.rrd_base_path), "/opt/collectd/var/lib/collectd/rrd/localhost");
+        set_string_field(ctx, "flush_policy", config.rrd_flush_policy, sizeof(config.rrd_flush_policy), "fetch");
+        config.rrd_flush_interval = get_int_field(ctx, "flush_interval_seconds", 30);
+        set_string_field(ctx, "reader", config.rrd_reader, sizeof(config.rrd_reader), "librrd");
+    }
+    duk_pop(ctx);
+
+    // Parse cache section (size may exceed int range, hence the double)
+    (void)duk_get_prop_string(ctx, -1, "cache");
+    if (duk_is_object(ctx, -1)) {
+        double max_bytes = get_double_field(ctx, "max_bytes", (double)config.cache_max_bytes);
+        config.cache_max_bytes = max_bytes > 0 ? (size_t)max_bytes : 0;
+        double svg_max = get_double_field(ctx, "svg_max_bytes", (double)config.svg_cache_max_bytes);
+        config.svg_cache_max_bytes = svg_max > 0 ? (size_t)svg_max : 0;
+    }
+    duk_pop(ctx);
+
+    // Parse compression section
+    (void)duk_get_prop_string(ctx, -1, "compression");
+    if (duk_is_object(ctx, -1)) {
+        config.compression_level = get_int_field(ctx, "level", config.compression_level);
+        double min_bytes = get_double_field(ctx, "min_bytes", (double)config.compression_min_bytes);
+        config.compression_min_bytes = min_bytes > 0 ? (size_t)min_bytes : 0;
     }
     duk_pop(ctx);
 
@@ -213,6 +251,12 @@ Config load_config(duk_context *ctx, const char *filename) {
     (void)duk_get_prop_string(ctx, -1, "js");
     if (duk_is_object(ctx, -1)) {
         set_string_field(ctx, "script_path", config.js_script_path, sizeof(config.js_script_path), "");
+        set_string_field(ctx, "series_format", config.js_series_format, sizeof(config.js_series_format), "typed");
+        set_string_field(ctx, "reload", config.js_reload, sizeof(config.js_reload), "sighup");
+        double heap_max = get_double_field(ctx, "heap_max_bytes", (double)config.js_heap_max_bytes);
+        config.js_heap_max_bytes = heap_max > 0 ? (size_t)heap_max : 0;
+        double heap_gc = get_double_field(ctx, "heap_gc_bytes", (double)config.js_heap_gc_bytes);
+        config.js_heap_gc_bytes = heap_gc > 0 ? (size_t)heap_gc : 0;
     }
     duk_pop(ctx);
 
@@ -0,0 +1,118 @@
+/**
+ * @file compress.c
+ * @brief HTTP response compression implementation
+ *
+ * One deflate() call per body into a deflateBound()-sized buffer: bodies are
+ * whole SVGs or JSON documents of at most a few hundred KB, so streaming
+ * would only add copies.
+ */
+
+#include "../include/compress.h"
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <zlib.h>
+
+/* Set once at startup before the workers run, read-only afterwards */
+static int compress_level = COMPRESS_DEFAULT_LEVEL;
+static size_t compress_min_bytes = COMPRESS_DEFAULT_MIN_BYTES;
+
+void compress_configure(int level, size_t min_bytes) {
+    compress_level = level < 0 ? 0 : level > 9 ? 9 : level;
+    compress_min_bytes = min_bytes;
+}
+
+compress_encoding_t compress_encoding_parse(const char *name) {
+    if (!name) return COMPRESS_IDENTITY;
+    if (strcasecmp(name, "gzip") == 0 || strcasecmp(name, "x-gzip") == 0) return COMPRESS_GZIP;
+    if (strcasecmp(name, "deflate") == 0) return COMPRESS_DEFLATE;
+    return COMPRESS_IDENTITY;
+}
+
+const char *compress_encoding_name(compress_encoding_t enc) {
+    switch (enc) {
+        case COMPRESS_GZIP:    return "gzip";
+        case COMPRESS_DEFLATE: return "deflate";
+        default:               return NULL;
+    }
+}
+
+compress_encoding_t compress_negotiate(const char *accept, size_t len) {
+    if (!accept || compress_level == 0) return COMPRESS_IDENTITY;
+
+    char value[256];
+    if (len >= sizeof(value)) len = sizeof(value) - 1;
+    memcpy(value, accept, len);
+    value[len] = '\0';
+
+    /* q of each coding; -1 = not listed */
+    double q_gzip = -1, q_deflate = -1, q_any = -1;
+    char *save = NULL;
+    for (char *tok = strtok_r(value, ",", &save); tok; tok = strtok_r(NULL, ",", &save)) {
+        while (*tok == ' ' || *tok == '\t') tok++;
+        char *params = strchr(tok, ';');
+        if (params) *params++ = '\0';
+        char *end = tok + strlen(tok);
+        while (end > tok && (end[-1] == ' ' || end[-1] == '\t')) *--end = '\0';
+
+        double q = 1;
+        if (params) {
+            const char *qp = strstr(params, "q=");
+            if (qp) q = strtod(qp + 2, NULL);
+        }
+
+        if (strcmp(tok, "*") == 0) {
+            q_any = q;
+        } else {
+            compress_encoding_t enc = compress_encoding_parse(tok);
+            if (enc == COMPRESS_GZIP) q_gzip = q;
+            else if (enc == COMPRESS_DEFLATE) q_deflate = q;
+        }
+    }
+
+    if (q_gzip < 0) q_gzip = q_any;
+    if (q_deflate < 0) q_deflate = q_any;
+    if (q_gzip > 0 && q_gzip >= q_deflate) return COMPRESS_GZIP;
+    if (q_deflate > 0) return COMPRESS_DEFLATE;
+    return COMPRESS_IDENTITY;
+}
+
+char *compress_body(const char *data, size_t len, compress_encoding_t enc, size_t *out_len) {
+    if (!data || compress_level == 0 || len < compress_min_bytes) return NULL;
+    if (enc != COMPRESS_GZIP && enc != COMPRESS_DEFLATE) return NULL;
+    if (len > (size_t)(uInt)-1) return NULL;
+
+    /* windowBits 15 = zlib wrapper, +16 = gzip wrapper */
+    z_stream zs = {0};
+    int window_bits = enc == COMPRESS_GZIP ? 15 + 16 : 15;
+    if (deflateInit2(&zs, compress_level, Z_DEFLATED, window_bits, 8,
+                     Z_DEFAULT_STRATEGY) != Z_OK) {
+        return NULL;
+    }
+
+    uLong bound = deflateBound(&zs, (uLong)len);
+    char *out = malloc(bound);
+    if (!out) {
+        deflateEnd(&zs);
+        return NULL;
+    }
+
+    zs.next_in = (Bytef *)data;
+    zs.avail_in = (uInt)len;
+    zs.next_out = (Bytef *)out;
+    zs.avail_out = (uInt)bound;
+    int rc = deflate(&zs, Z_FINISH);
+    size_t n = zs.total_out;
+    deflateEnd(&zs);
+
+    /* Not worth a Content-Encoding header if it did not shrink */
+    if (rc != Z_STREAM_END || n >= len) {
+        free(out);
+        return NULL;
+    }
+
+    /* Give the unused tail of the bound back */
+    char *fit = realloc(out, n);
+    *out_len = n;
+    return fit ? fit : out;
+}
@@ -7,15 +7,14 @@
 #include "../include/path_util.h"
 #include "../include/metric_source.h"
 #include "../include/rrd_r.h"
+#include "../include/task_pool.h"
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 #include <ctype.h>
 #include <stdarg.h>
 #include <time.h>
-
-/* External JS context from main.c */
-extern duk_context *global_ctx;
+#include <pthread.h>
 
 /**
  * Extract parameter value from query string
@@ -45,7 +44,7 @@ char* handler_get_param(const char *params, const char *key) {
  * Create error result
  */
 static handler_result_t* create_error_result(const char *message) {
-    handler_result_t *result = malloc(sizeof(handler_result_t));
+    handler_result_t *result = calloc(1, sizeof(handler_result_t));
     if (!result) return NULL;
 
     result->data = strdup(message);
@@ -161,7 +160,7 @@ static handler_result_t* grafana_search(Config *config) {
     }
     if (buf_append(&json, &cap, &off, "]") != 0) { free(json); return create_error_result("Out of memory"); }
 
-    handler_result_t *r = malloc(sizeof(handler_result_t));
+    handler_result_t *r = calloc(1, sizeof(handler_result_t));
     if (!r) { free(json); return create_error_result("Out of memory"); }
     r->data = json;
     r->data_len = off;
@@ -170,6 +169,54 @@ static handler_result_t* grafana_search(Config *config) {
     return r;
 }
 
+/* _config/stats: RRD cache, rrdcached and JS heap counters as a JSON object. */
+static handler_result_t* runtime_stats(void) {
+    rrd_cache_stats_t cs;
+    svg_cache_stats_t ss;
+    rrdc_pool_stats_t ps;
+    js_heap_stats_t hs;
+    rrd_cache_stats(&cs);
+    svg_cache_stats(&ss);
+    rrdc_pool_stats(&ps);
+    js_heap_stats(&hs);
+
+    /* Per-thread heap sizes: at most JS_HEAP_STATS_THREADS numbers */
+    char threads[JS_HEAP_STATS_THREADS * 22 + 1];
+    size_t toff = 0;
+    int shown = hs.heaps < JS_HEAP_STATS_THREADS ? hs.heaps : JS_HEAP_STATS_THREADS;
+    threads[0] = '\0';
+    for (int i = 0; i < shown; i++) {
+        toff += snprintf(threads + toff, sizeof(threads) - toff, "%s%zu",
+                         i ? "," : "", hs.thread_bytes[i]);
+    }
+
+    size_t cap = 1536 + sizeof(threads);
+    char *json = malloc(cap);
+    if (!json) return create_error_result("Out of memory");
+    int len = snprintf(json, cap,
+        "{\"rrd_cache\":{\"entries\":%zu,\"bytes\":%zu,\"max_bytes\":%zu,"
+        "\"evictions\":%lu,\"expirations\":%lu,\"stale_hits\":%lu},"
+        "\"svg_cache\":{\"entries\":%zu,\"bytes\":%zu,\"max_bytes\":%zu,"
+        "\"evictions\":%lu,\"expirations\":%lu},"
+        "\"rrdcached\":{\"connects\":%lu,\"connect_failures\":%lu,\"dropped\":%lu,"
+        "\"idle\":%d,\"healthy\":%s,\"flushes\":%lu,\"flushes_avoided\":%lu},"
+        "\"js_heap\":{\"heaps\":%d,\"bytes\":%zu,\"max_bytes\":%zu,"
+        "\"forced_gcs\":%lu,\"limit_failures\":%lu,\"thread_bytes\":[%s]}}",
+        cs.entries, cs.bytes, cs.max_bytes, cs.evictions, cs.expirations, cs.stale_hits,
+        ss.entries, ss.bytes, ss.max_bytes, ss.evictions, ss.expirations,
+        ps.connects, ps.connect_failures, ps.dropped, ps.idle,
+        ps.healthy ? "true" : "false", ps.flushes, ps.flushes_avoided,
+        hs.heaps, hs.bytes, hs.max_bytes, hs.forced_gcs, hs.limit_failures, threads);
+
+    handler_result_t *r = calloc(1, sizeof(handler_result_t));
+    if (!r) { free(json); return create_error_result("Out of memory"); }
+    r->data = json;
+    r->data_len = (size_t)len;
+    r->is_json = 1;
+    r->status = 0;
+    return r;
+}
+
 /* _grafana/query: parse the Grafana query body, fetch each target metric, and
    return Grafana time-series JSON. Body arrives URL-encoded in the `body` param. */
 static handler_result_t* grafana_query(Config *config, const char *query) {
@@ -262,7 +309,7 @@ static handler_result_t* grafana_query(Config *config, const char *query) {
         /* Grafana datasource также идёт через диспетчер источников, чтобы
          * prometheus/proc-метрики были видны из Grafana наравне с RRD.
          * use_cache=0: grafana-query сам по себе редок, отдаём свежие данные. */
-        MetricData *data = metric_source_fetch(config, m, param, (int)period, 0);
+        MetricData *data = metric_source_fetch(config, m, param, (int)period, 0, 0);
         if (param) free(param);
 
         if (data) {
@@ -297,7 +344,7 @@ static handler_result_t* grafana_query(Config *config, const char *query) {
     free(targets);
 
     {
-        handler_result_t *r = malloc(sizeof(handler_result_t));
+        handler_result_t *r = calloc(1, sizeof(handler_result_t));
         if (!r) { free(out); return create_error_result("Out of memory"); }
         r->data = out;
         r->data_len = off;
@@ -313,16 +360,355 @@ gf_oom:
     return create_error_result("Out of memory");
 }
 
-/**
- * Process a metric request
- */
-handler_result_t* handler_process(Config *config,
-                                  const char *endpoint,
-                                  const char *query,
-                                  int period,
-                                  int width,
-                                  int height,
-                                  int use_cache) {
+/* Clamp a panel size to the range the renderer supports (0 = default). */
+static void clamp_svg_size(int *width, int *height) {
+    if (*width <= 0) *width = 800;
+    if (*width < 200) *width = 200;
+    if (*width > 1600) *width = 1600;
+
+    if (*height <= 0) *height = 450;
+    if (*height < 120) *height = 120;
+    if (*height > 800) *height = 800;
+}
+
+/* Decimation: ?decimate= overrides the metric's "decimate"; unknown names
+   mean none. Stat panels show single values and are never decimated. */
+static decimate_mode_t panel_decimate(const MetricConfig *metric, const char *decimate_query) {
+    decimate_mode_t decimate = DECIMATE_NONE;
+    if (strcmp(metric->panel_type, "stat") == 0) return DECIMATE_NONE;
+    if (decimate_mode_parse(decimate_query ? decimate_query : metric->decimate,
+                            &decimate) != 0) {
+        decimate = DECIMATE_NONE;
+    }
+    return decimate;
+}
+
+/* ============================================================================
+ * Dashboard batch
+ *
+ *   _batch?panels=<endpoint>,<period>,<width>,<height>;...   (URL-encoded)
+ *     -> [{"endpoint": ..., "svg": "<svg ...>"} | {"endpoint": ..., "error": ...}, ...]
+ *
+ * One request renders a whole dashboard. Panels reading the same series
+ * (endpoint, parameter and period) at the same step share one fetch: the
+ * step is the one metric_source_fetch() picks for a panel's width, so a
+ * panel gets the data a single request for it would, and what it publishes
+ * to the SVG cache does not depend on the other panels of the batch. Each
+ * panel is then decimated and rendered at its own size.
+ * Panels render in parallel on the task pool (task_pool.h) and go through
+ * the rendered-SVG cache like single requests. Empty period/width/height
+ * fields take the batch's period and the default size; theme and decimate
+ * query params apply to every panel. Results keep the request order.
+ * ============================================================================ */
+
+#define BATCH_MAX_PANELS 64
+
+/* One fetch shared by the panels of a series and step; done by the first
+   panel that misses the SVG cache. */
+typedef struct {
+    MetricConfig *metric;
+    const char *param;
+    int period;
+    unsigned long step;         /* metric_source_step(), 0 = any width */
+    int width;                  /* A member's width: selects that step */
+    pthread_mutex_t lock;
+    int fetched;
+    MetricData *data;           /* Owned reference, NULL if the fetch failed */
+} batch_source_t;
+
+typedef struct {
+    char *endpoint;
+    int period;
+    int width;
+    int height;
+    MetricConfig *metric;       /* NULL if the panel failed to resolve */
+    char *param;
+    decimate_mode_t decimate;
+    batch_source_t *source;
+    svg_buf_t *svg;             /* Shared with the SVG cache */
+    char error[160];            /* Set when svg is NULL */
+} batch_panel_t;
+
+typedef struct {
+    Config *config;
+    batch_panel_t *panels;
+    const char *theme;
+    int use_cache;
+} batch_t;
+
+/* Split "<endpoint>,<period>,<width>,<height>" from the right, so endpoint
+   parameters may contain commas. Returns 0 on success. */
+static int batch_parse_panel(char *item, int default_period, batch_panel_t *p) {
+    int fields[3];
+    for (int i = 2; i >= 0; i--) {
+        char *comma = strrchr(item, ',');
+        if (!comma) return -1;
+        *comma = '\0';
+        fields[i] = atoi(comma + 1);
+    }
+    while (*item == '/') item++;
+    if (!*item) return -1;
+
+    p->endpoint = strdup(item);
+    if (!p->endpoint) return -1;
+    p->period = fields[0] > 0 ? fields[0] : default_period;
+    p->width = fields[1];
+    p->height = fields[2];
+    clamp_svg_size(&p->width, &p->height);
+    return 0;
+}
+
+/* Resolve the panel's metric and parameter; records an error on failure. */
+static void batch_resolve_panel(Config *config, const char *decimate_query, batch_panel_t *p) {
+    MetricConfig *metric = find_metric_config(config, p->endpoint);
+    if (!metric) {
+        snprintf(p->error, sizeof(p->error), "Unknown endpoint: %s", p->endpoint);
+        return;
+    }
+    if (metric->requires_param) {
+        p->param = extract_param_from_path(p->endpoint, metric->endpoint);
+        if (!p->param || !*p->param) {
+            snprintf(p->error, sizeof(p->error), "Endpoint '%s' requires parameter '%s'",
+                     metric->endpoint, metric->param_name);
+            free(p->param);
+            p->param = NULL;
+            return;
+        }
+    }
+    p->metric = metric;
+    p->decimate = panel_decimate(metric, decimate_query);
+}
+
+static int same_param(const char *a, const char *b) {
+    if (!a || !b) return a == b;
+    return strcmp(a, b) == 0;
+}
+
+/* Attach every resolved panel to the source of its series and step; returns
+   the number of sources filled in sources[]. */
+static int batch_group_sources(Config *config, batch_panel_t *panels, int count,
+                               batch_source_t *sources, int use_cache) {
+    int n = 0;
+    for (int i = 0; i < count; i++) {
+        batch_panel_t *p = &panels[i];
+        if (!p->metric) continue;
+
+        unsigned long step = metric_source_step(config, p->metric, p->param, p->period,
+                                                p->width, use_cache);
+        batch_source_t *src = NULL;
+        for (int j = 0; j < n && !src; j++) {
+            if (sources[j].metric == p->metric && sources[j].period == p->period &&
+                sources[j].step == step && same_param(sources[j].param, p->param)) {
+                src = &sources[j];
+            }
+        }
+        if (!src) {
+            src = &sources[n++];
+            src->metric = p->metric;
+            src->param = p->param;
+            src->period = p->period;
+            src->step = step;
+            src->width = p->width;
+            pthread_mutex_init(&src->lock, NULL);
+        }
+        p->source = src;
+    }
+    return n;
+}
+
+/* Task body: one panel, from the SVG cache or fetch + decimate + render. */
+static void batch_render_panel(void *arg, int index) {
+    batch_t *b = arg;
+    batch_panel_t *p = &b->panels[index];
+    if (!p->metric) return;
+
+    svg_cache_key_t svg_key = {
+        .endpoint = p->metric->endpoint,
+        .param = p->param,
+        .period = p->period,
+        .width = p->width,
+        .height = p->height,
+        .theme = b->theme,
+        .decimate = p->decimate,
+        .script = svg_script_generation()
+    };
+    int leader = 1;
+    if (b->use_cache) {
+        p->svg = svg_cache_acquire(&svg_key, &leader);
+        if (p->svg) return;
+        if (!leader) {
+            snprintf(p->error, sizeof(p->error), "Failed to generate SVG");
+            return;
+        }
+    }
+
+    batch_source_t *src = p->source;
+    pthread_mutex_lock(&src->lock);
+    if (!src->fetched) {
+        src->data = metric_source_fetch(b->config, src->metric, src->param, src->period,
+                                        src->width, b->use_cache);
+        src->fetched = 1;
+    }
+    MetricData *data = src->data ? metric_data_retain(src->data) : NULL;
+    pthread_mutex_unlock(&src->lock);
+
+    if (!data) {
+        if (b->use_cache) svg_cache_complete(&svg_key, NULL);
+        snprintf(p->error, sizeof(p->error), "Failed to fetch metric data");
+        return;
+    }
+
+    data = metric_data_decimate(data, p->decimate, decimate_max_points(p->width));
+    size_t svg_len = 0;
+    char *svg = svg_generate(b->config->js_script_path, data, p->metric,
+                             p->width, p->height, b->theme, &svg_len);
+    metric_data_release(data);
+
+    p->svg = svg_buf_wrap(svg, svg_len);
+    if (b->use_cache) svg_cache_complete(&svg_key, p->svg);
+    if (!p->svg) snprintf(p->error, sizeof(p->error), "Failed to generate SVG");
+}
+
+/* Append s as a JSON string literal. Returns 0 on success, -1 on error. */
+static int buf_append_json_string(char **buf, size_t *cap, size_t *off,
+                                  const char *s, size_t len) {
+    /* Worst case is \u00XX for every byte */
+    if (*off + len * 6 + 3 > *cap) {
+        size_t newcap = *cap * 2;
+        while (*off + len * 6 + 3 > newcap) newcap *= 2;
+        char *nb = realloc(*buf, newcap);
+        if (!nb) return -1;
+        *buf = nb;
+        *cap = newcap;
+    }
+
+    char *out = *buf + *off;
+    *out++ = '"';
+    for (size_t i = 0; i < len; i++) {
+        unsigned char c = (unsigned char)s[i];
+        if (c == '"' || c == '\\') {
+            *out++ = '\\';
+            *out++ = (char)c;
+        } else if (c == '\n') {
+            *out++ = '\\';
+            *out++ = 'n';
+        } else if (c < 0x20) {
+            out += sprintf(out, "\\u%04x", c);
+        } else {
+            *out++ = (char)c;
+        }
+    }
+    *out++ = '"';
+    *out = '\0';
+    *off = (size_t)(out - *buf);
+    return 0;
+}
+
+/* Serialize the panel results as a JSON array, in request order. */
+static handler_result_t* batch_format(const batch_panel_t *panels, int count) {
+    size_t cap = 256;
+    for (int i = 0; i < count; i++) cap += (panels[i].svg ? panels[i].svg->len : 0) + 256;
+    char *json = malloc(cap);
+    if (!json) return create_error_result("Out of memory");
+
+    size_t off = 0;
+    int rc = buf_append(&json, &cap, &off, "[");
+    for (int i = 0; i < count && rc == 0; i++) {
+        const batch_panel_t *p = &panels[i];
+        rc = buf_append(&json, &cap, &off, "%s{\"endpoint\":", i ? "," : "");
+        if (rc == 0) rc = buf_append_json_string(&json, &cap, &off, p->endpoint, strlen(p->endpoint));
+        if (rc == 0 && p->svg) {
+            rc = buf_append(&json, &cap, &off, ",\"svg\":");
+            if (rc == 0) rc = buf_append_json_string(&json, &cap, &off, p->svg->data, p->svg->len);
+        } else if (rc == 0) {
+            rc = buf_append(&json, &cap, &off, ",\"error\":");
+            if (rc == 0) rc = buf_append_json_string(&json, &cap, &off, p->error, strlen(p->error));
+        }
+        if (rc == 0) rc = buf_append(&json, &cap, &off, "}");
+    }
+    if (rc == 0) rc = buf_append(&json, &cap, &off, "]");
+
+    handler_result_t *r = rc == 0 ? calloc(1, sizeof(handler_result_t)) : NULL;
+    if (!r) { free(json); return create_error_result("Out of memory"); }
+    r->data = json;
+    r->data_len = off;
+    r->is_json = 1;
+    r->status = 0;
+    return r;
+}
+
+static handler_result_t* batch_process(Config *config, const char *query, int period,
+                                       const char *theme, int use_cache) {
+    char *panels_enc = query ? handler_get_param(query, "panels") : NULL;
+    if (!panels_enc) return create_error_result("Missing panels");
+    char *list = url_decode(panels_enc);
+    free(panels_enc);
+    if (!list) return create_error_result("Invalid panels encoding");
+
+    batch_panel_t *panels = calloc(BATCH_MAX_PANELS, sizeof(batch_panel_t));
+    batch_source_t *sources = calloc(BATCH_MAX_PANELS, sizeof(batch_source_t));
+    if (!panels || !sources) {
+        free(panels);
+        free(sources);
+        free(list);
+        return create_error_result("Out of memory");
+    }
+
+    const char *error = NULL;
+    int count = 0;
+    char *saveptr = NULL;
+    for (char *item = strtok_r(list, ";", &saveptr); item && !error;
+         item = strtok_r(NULL, ";", &saveptr)) {
+        if (count == BATCH_MAX_PANELS) {
+            error = "Too many panels (max 64)";
+        } else if (batch_parse_panel(item, period, &panels[count]) != 0) {
+            error = "Invalid panel, expected endpoint,period,width,height";
+        } else {
+            count++;
+        }
+    }
+    free(list);
+    if (!error && count == 0) error = "Missing panels";
+
+    handler_result_t *result;
+    if (error) {
+        result = create_error_result(error);
+    } else {
+        char *decimate_query = handler_get_param(query, "decimate");
+        for (int i = 0; i < count; i++) batch_resolve_panel(config, decimate_query, &panels[i]);
+        free(decimate_query);
+        int source_count = batch_group_sources(config, panels, count, sources, use_cache);
+
+        batch_t batch = { .config = config, .panels = panels, .theme = theme, .use_cache = use_cache };
+        task_pool_run(batch_render_panel, &batch, count);
+
+        for (int i = 0; i < source_count; i++) {
+            if (sources[i].data) metric_data_release(sources[i].data);
+            pthread_mutex_destroy(&sources[i].lock);
+        }
+        result = batch_format(panels, count);
+    }
+
+    for (int i = 0; i < count; i++) {
+        free(panels[i].endpoint);
+        free(panels[i].param);
+        svg_buf_release(panels[i].svg);
+    }
+    free(panels);
+    free(sources);
+    return result;
+}
+
+/* Panel and special endpoints; SVG panels are compressed here, against the
+ * SVG cache, JSON results by handler_process() */
+static handler_result_t* process_request(Config *config,
+                                         const char *endpoint,
+                                         const char *query,
+                                         int period,
+                                         int width,
+                                         int height,
+                                         int use_cache,
+                                         compress_encoding_t encoding) {
     if (!config || !endpoint) {
         return create_error_result("Invalid parameters");
     }
@@ -358,13 +744,14 @@ handler_result_t* handler_process(Config *config,
                         : (config->theme[0] ? config->theme : "light");
 
     /* Apply defaults and bounds checking */
-    if (svg_width <= 0) svg_width = 800;
-    if (svg_width < 200) svg_width = 200;
-    if (svg_width > 1600) svg_width = 1600;
+    clamp_svg_size(&svg_width, &svg_height);
 
-    if (svg_height <= 0) svg_height = 450;
-    if (svg_height < 120) svg_height = 120;
-    if (svg_height > 800) svg_height = 800;
+    /* Dashboard batch: many panels in one round trip */
+    if (strcmp(endpoint, "_batch") == 0) {
+        handler_result_t *batch = batch_process(config, query, period, theme, use_cache);
+        if (theme_query) free(theme_query);
+        return batch;
+    }
 
     /* Special endpoint: metrics configuration */
     if (strcmp(endpoint, "_config/metrics") == 0) {
@@ -373,7 +760,7 @@ handler_result_t* handler_process(Config *config,
             return create_error_result("Failed to generate metrics config");
         }
 
-        handler_result_t *result = malloc(sizeof(handler_result_t));
+        handler_result_t *result = calloc(1, sizeof(handler_result_t));
         if (!result) {
             free(json);
             return create_error_result("Out of memory");
@@ -386,6 +773,11 @@ handler_result_t* handler_process(Config *config,
         return result;
     }
 
+    /* Special endpoint: cache and rrdcached counters */
+    if (strcmp(endpoint, "_config/stats") == 0) {
+        return runtime_stats();
+    }
+
     /* Grafana datasource endpoints (forwarded by svgd-gate). */
     if (strcmp(endpoint, "_grafana/search") == 0) {
         return grafana_search(config);
@@ -415,38 +807,149 @@ handler_result_t* handler_process(Config *config,
         }
     }
 
-    /* Fetch data via the pluggable source dispatcher (see metric_source.h).
-     * Dispatcher selects rrd/proc/prometheus by metric->source and handles
-     * path/URL/key building + caching. For SRC_RRD this is byte-for-byte
-     * identical to the former inline path-building + rrd_fetch_data logic. */
-    MetricData *data = metric_source_fetch(config, metric, param, period, use_cache);
+    char *decimate_query = query ? handler_get_param(query, "decimate") : NULL;
+    decimate_mode_t decimate = panel_decimate(metric, decimate_query);
+    free(decimate_query);
+
+    /* Rendered-SVG cache: identical panel requests within the TTL are served
+     * without fetching or rendering. The endpoint from config plus the path
+     * parameter identify the series; size and theme complete the key.
+     * Concurrent misses on one key are coalesced: only the leader fetches and
+     * renders, the others wait in svg_cache_acquire() and share its result. */
+    svg_cache_key_t svg_key = {
+        .endpoint = metric->endpoint,
+        .param = param,
+        .period = period,
+        .width = svg_width,
+        .height = svg_height,
+        .theme = theme,
+        .decimate = decimate,
+        .script = svg_script_generation()
+    };
+    svg_buf_t *svg = NULL;
+    int leader = 1;
+
+    /* A hit on the compressed variant skips the deflate; hits share the
+     * cached buffer, nothing is copied */
+    if (use_cache && encoding != COMPRESS_IDENTITY) {
+        svg = svg_cache_get_variant(&svg_key, encoding);
+        if (svg) {
+            if (param) free(param);
+            if (theme_query) free(theme_query);
+            handler_result_t *hit = calloc(1, sizeof(handler_result_t));
+            if (!hit) {
+                svg_buf_release(svg);
+                return create_error_result("Out of memory");
+            }
+            hit->data = svg->data;
+            hit->data_len = svg->len;
+            hit->shared = svg;
+            hit->encoding = encoding;
+            return hit;
+        }
+    }
 
-    if (param) free(param);
+    if (use_cache) {
+        svg = svg_cache_acquire(&svg_key, &leader);
+        if (!svg && !leader) {
+            /* The render we waited for failed; don't retry it in lockstep. */
+            if (param) free(param);
+            if (theme_query) free(theme_query);
+            return create_error_result("Failed to generate SVG");
+        }
+    }
 
-    if (!data) {
-        return create_error_result("Failed to fetch metric data");
+    if (!svg) {
+        /* Fetch data via the pluggable source dispatcher (see metric_source.h).
+         * Dispatcher selects rrd/proc/prometheus by metric->source and handles
+         * path/URL/key building + caching. The SVG width picks the RRA, so
+         * small panels and thumbnails fetch coarse data. */
+        MetricData *data = metric_source_fetch(config, metric, param, period,
+                                               svg_width, use_cache);
+
+        if (!data) {
+            if (use_cache) svg_cache_complete(&svg_key, NULL);
+            if (param) free(param);
+            if (theme_query) free(theme_query);
+            return create_error_result("Failed to fetch metric data");
+        }
+
+        /* Cap points at ~2 per plot pixel; shared data is copied, not cut */
+        data = metric_data_decimate(data, decimate, decimate_max_points(svg_width));
+
+        /* Generate SVG. data may be shared with the RRD cache and is
+         * read-only here, so the metric config is passed alongside it. */
+        size_t svg_len = 0;
+        char *rendered = svg_generate(config->js_script_path, data, metric,
+                                      svg_width, svg_height, theme, &svg_len);
+        metric_data_release(data);
+
+        /* The render itself goes into the cache and to the waiters */
+        svg = svg_buf_wrap(rendered, svg_len);
+        if (use_cache) svg_cache_complete(&svg_key, svg);
     }
 
-    /* Generate SVG */
-    data->metric_config = metric;
-    char *svg = generate_svg(global_ctx, config->js_script_path, data, svg_width, svg_height, theme);
-    free_metric_data(data);
+    /* Compress once per cache entry; the variant serves the later hits */
+    compress_encoding_t svg_encoding = COMPRESS_IDENTITY;
+    if (svg && encoding != COMPRESS_IDENTITY) {
+        size_t z_len = 0;
+        char *z = compress_body(svg->data, svg->len, encoding, &z_len);
+        svg_buf_t *zbuf = z ? svg_buf_wrap(z, z_len) : NULL;
+        if (zbuf) {
+            if (use_cache) svg_cache_put_variant(&svg_key, encoding, svg, zbuf);
+            svg_buf_release(svg);
+            svg = zbuf;
+            svg_encoding = encoding;
+        }
+    }
+
+    if (param) free(param);
     if (theme_query) free(theme_query);
 
     if (!svg) {
         return create_error_result("Failed to generate SVG");
     }
 
-    handler_result_t *result = malloc(sizeof(handler_result_t));
+    handler_result_t *result = calloc(1, sizeof(handler_result_t));
     if (!result) {
-        free(svg);
+        svg_buf_release(svg);
         return create_error_result("Out of memory");
     }
 
-    result->data = svg;
-    result->data_len = strlen(svg);
+    result->data = svg->data;
+    result->data_len = svg->len;
+    result->shared = svg;
     result->is_json = 0;
     result->status = 0;
+    result->encoding = svg_encoding;
+    return result;
+}
+
+/**
+ * Process a metric request
+ */
+handler_result_t* handler_process(Config *config,
+                                  const char *endpoint,
+                                  const char *query,
+                                  int period,
+                                  int width,
+                                  int height,
+                                  int use_cache,
+                                  compress_encoding_t encoding) {
+    handler_result_t *result = process_request(config, endpoint, query, period,
+                                               width, height, use_cache, encoding);
+
+    /* JSON (_batch, _config, _grafana) is built per request: compress it here */
+    if (result && result->status == 0 && result->is_json && encoding != COMPRESS_IDENTITY) {
+        size_t z_len = 0;
+        char *z = compress_body(result->data, result->data_len, encoding, &z_len);
+        if (z) {
+            free(result->data);
+            result->data = z;
+            result->data_len = z_len;
+            result->encoding = encoding;
+        }
+    }
     return result;
 }
 
@@ -455,6 +958,7 @@ handler_result_t* handler_process(Config *config,
  */
 void handler_result_free(handler_result_t *result) {
     if (!result) return;
-    if (result->data) free(result->data);
+    if (result->shared) svg_buf_release(result->shared);
+    else if (result->data) free(result->data);
     free(result);
 }
@@ -7,8 +7,11 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <strings.h>
+#include <errno.h>
 #include <unistd.h>
 #include <sys/socket.h>
+#include <sys/uio.h>
 
 /* Escape a string for safe embedding in a JSON string value.
  * Returns number of characters written (excluding NUL). */
@@ -35,6 +38,41 @@ static size_t http_json_escape(const char *src, char *dest, size_t dest_size) {
     return j;
 }
 
+const char *http_find_header(const char *raw, size_t len, const char *name,
+                             size_t *value_len) {
+    size_t name_len = strlen(name);
+    const char *end = raw + len;
+    const char *line = memchr(raw, '\n', len);   /* skip request line */
+
+    while (line && ++line < end) {
+        const char *eol = memchr(line, '\n', end - line);
+        const char *line_end = eol ? eol : end;
+        if (line_end > line && line_end[-1] == '\r') line_end--;
+        if (line_end == line) break;               /* blank line: end of headers */
+
+        if ((size_t)(line_end - line) > name_len && line[name_len] == ':' &&
+            strncasecmp(line, name, name_len) == 0) {
+            const char *v = line + name_len + 1;
+            while (v < line_end && (*v == ' ' || *v == '\t')) v++;
+            const char *ve = line_end;
+            while (ve > v && (ve[-1] == ' ' || ve[-1] == '\t')) ve--;
+            *value_len = ve - v;
+            return v;
+        }
+        line = eol;
+    }
+    return NULL;
+}
+
+/* Case-insensitive token search inside a header value (e.g. "keep-alive"). */
+static int http_value_has_token(const char *v, size_t v_len, const char *token) {
+    size_t t_len = strlen(token);
+    for (size_t i = 0; i + t_len <= v_len; i++) {
+        if (strncasecmp(v + i, token, t_len) == 0) return 1;
+    }
+    return 0;
+}
+
 const char *http_status_text(int status) {
     switch (status) {
         case 200: return "OK";
@@ -93,30 +131,113 @@ int http_parse_request(const char *raw, size_t len, http_request_t *req) {
         req->query[0] = '\0';
     }
 
+    req->keep_alive = http_request_keep_alive(raw, len);
+
+    size_t ae_len = 0;
+    const char *ae = http_find_header(raw, len, "Accept-Encoding", &ae_len);
+    if (ae) {
+        if (ae_len >= sizeof(req->accept_encoding)) ae_len = sizeof(req->accept_encoding) - 1;
+        memcpy(req->accept_encoding, ae, ae_len);
+        req->accept_encoding[ae_len] = '\0';
+    }
+
     return 0;
 }
 
-char *http_build_response(const http_response_t *resp, size_t *out_len) {
-    const char *status_text = http_status_text(resp->status);
+int http_request_keep_alive(const char *raw, size_t len) {
+    const char *eol = memchr(raw, '\n', len);
+    size_t line_len = eol ? (size_t)(eol - raw) : len;
+    if (line_len > 0 && raw[line_len - 1] == '\r') line_len--;
+
+    /* HTTP/1.1 defaults to persistent, HTTP/1.0 to close; an explicit
+     * Connection header overrides either default. */
+    int keep_alive = line_len >= 8 && memcmp(raw + line_len - 8, "HTTP/1.1", 8) == 0;
+
+    size_t conn_len = 0;
+    const char *conn = http_find_header(raw, len, "Connection", &conn_len);
+    if (conn) {
+        if (http_value_has_token(conn, conn_len, "close")) keep_alive = 0;
+        else if (http_value_has_token(conn, conn_len, "keep-alive")) keep_alive = 1;
+    }
+    return keep_alive;
+}
+
+long http_request_length(const char *raw, size_t len, size_t *scan_pos, size_t *head_len) {
+    if (!raw) return -1;
+
+    /* Resume the terminator search 3 bytes before the previous end so a
+     * "\r\n\r\n" split across two reads is still found. */
+    size_t from = scan_pos ? *scan_pos : 0;
+    from = from > 3 ? from - 3 : 0;
+
+    const char *hdr_end = NULL;
+    for (size_t i = from; i + 4 <= len; i++) {
+        if (raw[i] == '\r' && memcmp(raw + i, "\r\n\r\n", 4) == 0) {
+            hdr_end = raw + i + 4;
+            break;
+        }
+    }
+
+    if (!hdr_end) {
+        if (scan_pos) *scan_pos = len;
+        return len >= HTTP_MAX_REQUEST ? -1 : 0;
+    }
+
+    size_t header_len = hdr_end - raw;
+    size_t body_len = 0;
+    size_t cl_len = 0;
+    const char *cl = http_find_header(raw, header_len, "Content-Length", &cl_len);
+    if (cl) {
+        char *endptr;
+        long v = strtol(cl, &endptr, 10);
+        if (endptr == cl || v < 0) return -1;
+        body_len = (size_t)v;
+    }
 
-    /* Build headers */
-    char header[1024];
-    int header_len = snprintf(header, sizeof(header),
+    if (header_len + body_len > HTTP_MAX_REQUEST) return -1;
+    /* Body still incomplete: the next call must find the terminator again,
+     * so resume right at it (the 3-byte step back lands on its first byte). */
+    if (scan_pos) *scan_pos = header_len - 1;
+    if (head_len) *head_len = header_len;
+    return len >= header_len + body_len ? (long)(header_len + body_len) : 0;
+}
+
+int http_format_head(const http_response_t *resp, char *buf, size_t size) {
+    /* Bodies are negotiated on Accept-Encoding, so shared caches must key on it */
+    int len = snprintf(buf, size,
         "HTTP/1.1 %d %s\r\n"
         "Content-Type: %s\r\n"
         "Content-Length: %zu\r\n"
+        "%s%s%s"
+        "Vary: Accept-Encoding\r\n"
         "Access-Control-Allow-Origin: *\r\n"
         "Access-Control-Allow-Methods: GET, OPTIONS\r\n"
         "Access-Control-Allow-Headers: Content-Type\r\n"
-        "Connection: close\r\n"
+        "Connection: %s\r\n"
         "\r\n",
-        resp->status, status_text,
+        resp->status, http_status_text(resp->status),
         resp->content_type,
-        resp->body_len);
+        resp->body_len,
+        resp->content_encoding ? "Content-Encoding: " : "",
+        resp->content_encoding ? resp->content_encoding : "",
+        resp->content_encoding ? "\r\n" : "",
+        resp->keep_alive ? "keep-alive" : "close");
+    return len < 0 || (size_t)len >= size ? -1 : len;
+}
 
-    if (header_len < 0 || header_len >= (int)sizeof(header)) {
-        return NULL;
+void http_iov_advance(struct iovec *iov, int count, size_t n) {
+    for (int i = 0; i < count && n > 0; i++) {
+        size_t take = n < iov[i].iov_len ? n : iov[i].iov_len;
+        iov[i].iov_base = (char *)iov[i].iov_base + take;
+        iov[i].iov_len -= take;
+        n -= take;
     }
+}
+
+char *http_build_response(const http_response_t *resp, size_t *out_len) {
+    char header[HTTP_MAX_HEAD];
+    int header_len = http_format_head(resp, header, sizeof(header));
+    if (header_len < 0) return NULL;
 
     /* Allocate response buffer */
     *out_len = header_len + resp->body_len;
@@ -131,7 +252,7 @@ char *http_build_response(const http_response_t *resp, size_t *out_len) {
     return response;
 }
 
-void http_send_error(int client_sock, int status, const char *message) {
+char *http_build_error(int status, const char *message, int keep_alive, size_t *out_len) {
     char body[512];
     char escaped[256];
     http_json_escape(message, escaped, sizeof(escaped));
@@ -142,9 +263,14 @@ void http_send_error(int client_sock, int status, const char *message) {
     strncpy(resp.content_type, "application/json", sizeof(resp.content_type) - 1);
     resp.body = body;
     resp.body_len = body_len;
+    resp.keep_alive = keep_alive;
 
+    return http_build_response(&resp, out_len);
+}
+
+void http_send_error(int client_sock, int status, const char *message) {
     size_t resp_len;
-    char *raw = http_build_response(&resp, &resp_len);
+    char *raw = http_build_error(status, message, 0, &resp_len);
     if (raw) {
         send(client_sock, raw, resp_len, MSG_NOSIGNAL);
         free(raw);
@@ -156,25 +282,47 @@ void http_send_response(int client_sock, const char *content_type,
     http_response_t resp = {0};
     resp.status = 200;
     strncpy(resp.content_type, content_type, sizeof(resp.content_type) - 1);
-    resp.body = body;
     resp.body_len = body_len;
 
-    size_t resp_len;
-    char *raw = http_build_response(&resp, &resp_len);
-    if (raw) {
-        send(client_sock, raw, resp_len, MSG_NOSIGNAL);
-        free(raw);
+    char header[HTTP_MAX_HEAD];
+    int header_len = http_format_head(&resp, header, sizeof(header));
+    if (header_len < 0) return;
+
+    struct iovec iov[2] = {
+        { .iov_base = header, .iov_len = (size_t)header_len },
+        { .iov_base = (void *)body, .iov_len = body ? body_len : 0 },
+    };
+    struct msghdr msg = { .msg_iov = iov, .msg_iovlen = 2 };
+    while (iov[0].iov_len + iov[1].iov_len > 0) {
+        ssize_t n = sendmsg(client_sock, &msg, MSG_NOSIGNAL);
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) return;
+        http_iov_advance(iov, 2, (size_t)n);
     }
 }
 
-void http_send_options(int client_sock) {
-    const char *response =
+char *http_build_options(int keep_alive, size_t *out_len) {
+    char header[512];
+    int len = snprintf(header, sizeof(header),
         "HTTP/1.1 200 OK\r\n"
         "Access-Control-Allow-Origin: *\r\n"
         "Access-Control-Allow-Methods: GET, OPTIONS\r\n"
         "Access-Control-Allow-Headers: Content-Type\r\n"
         "Content-Length: 0\r\n"
-        "Connection: close\r\n"
-        "\r\n";
-    send(client_sock, response, strlen(response), MSG_NOSIGNAL);
+        "Connection: %s\r\n"
+        "\r\n",
+        keep_alive ? "keep-alive" : "close");
+    if (len < 0 || len >= (int)sizeof(header)) return NULL;
+
+    *out_len = (size_t)len;
+    return strdup(header);
+}
+
+void http_send_options(int client_sock) {
+    size_t resp_len;
+    char *raw = http_build_options(0, &resp_len);
+    if (raw) {
+        send(client_sock, raw, resp_len, MSG_NOSIGNAL);
+        free(raw);
+    }
 }
@@ -0,0 +1,687 @@
+/**
+ * @file http_server.c
+ * @brief epoll reactor + worker pool HTTP server
+ *
+ * Connection life cycle:
+ *   READING    - registered for EPOLLIN; bytes are appended to conn->in until
+ *                http_request_length() reports a complete request.
+ *   PROCESSING - removed from epoll and queued to the worker pool; a worker
+ *                runs the handler on the request (NUL-terminated in place),
+ *                builds conn->out and hands the connection back through the
+ *                done queue + eventfd wake-up.
+ *   WRITING    - the reactor sends conn->out (headers + body gathered by one
+ *                sendmsg per attempt), registering EPOLLOUT only when
+ *                the socket buffer is full. After the last byte the request is
+ *                dropped from conn->in and, on keep-alive, the connection goes
+ *                back to READING (pipelined bytes are dispatched immediately).
+ *
+ * A client that half-closes (shutdown(SHUT_WR), `nc -N`) after sending still
+ * gets its answers: EOF only marks the connection, the requests already in
+ * conn->in are dispatched, and it is closed once none is left.
+ *
+ * Only the reactor touches a connection outside PROCESSING, and only one
+ * worker touches it during PROCESSING, so connections need no locks of their
+ * own; the two queues share one mutex.
+ *
+ * Sharding (server.listen_shards > 1): every shard is a complete copy of the
+ * above - its own SO_REUSEPORT listener, epoll reactor, queues and workers -
+ * pinned to one CPU. The kernel spreads incoming connections across the
+ * listeners, so shards share nothing but the handler and the running flag.
+ *
+ * The server only frames requests; parsing and routing are the handler's.
+ * svgd (main.c) and svgd-gate (gate/main.c) both run on it.
+ */
+
+#define _GNU_SOURCE
+#include "../include/http_server.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <signal.h>
+#include <stdint.h>
+#include <time.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <sched.h>
+#include <sys/socket.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+
+#define HTTP_READ_CHUNK 4096
+#define HTTP_EPOLL_EVENTS 256
+
+typedef enum {
+    CONN_READING,
+    CONN_PROCESSING,
+    CONN_WRITING
+} conn_state_t;
+
+struct http_shard;
+
+typedef struct http_conn {
+    int fd;
+    struct http_shard *shard;
+    conn_state_t state;
+    uint32_t watched;           /* epoll events currently registered (0 = not in epoll) */
+
+    char *in;                   /* request bytes (may hold pipelined requests) */
+    size_t in_len;
+    size_t in_cap;
+    size_t scan_pos;            /* header-terminator search position */
+    size_t req_len;             /* length of the request being processed */
+    size_t head_len;            /* its headers */
+    char saved;                 /* byte under the request's NUL terminator */
+
+    http_reply_t out;           /* response being written */
+    size_t out_off;             /* bytes of head + body already sent */
+    int keep_alive;
+    int peer_closed;            /* EOF read: answer what is buffered, then close */
+
+    time_t last_active;
+    struct http_conn *prev, *next;  /* all connections (idle sweep, shutdown) */
+    struct http_conn *qnext;        /* job / done queue link */
+} http_conn_t;
+
+/* One listener + reactor + worker pool */
+typedef struct http_shard {
+    int index;
+    int cpu;                    /* CPU the shard's threads are pinned to (-1 = unpinned) */
+    int listen_fd;
+    int epoll_fd;
+    int wake_fd;                /* eventfd: workers -> reactor, stop requests */
+
+    pthread_t reactor;          /* unused for shard 0, which runs on the caller */
+    int reactor_started;
+    pthread_t *workers;
+    int worker_count;
+    pthread_mutex_t lock;       /* guards both queues */
+    pthread_cond_t job_ready;
+    http_conn_t *jobs_head, *jobs_tail;
+    http_conn_t *done_head, *done_tail;
+
+    http_conn_t *conns;
+} http_shard_t;
+
+/* Server state (one server per process) */
+static struct {
+    http_handler_fn handler;
+    void (*worker_init)(void);
+    http_shard_t *shards;
+    int shard_count;
+    volatile sig_atomic_t running;
+} srv;
+
+/* epoll tags for the two non-connection descriptors */
+static char listen_tag;
+static char wake_tag;
+
+/* ============================================================================
+ * Queues
+ * ============================================================================ */
+
+static void queue_push(http_conn_t **head, http_conn_t **tail, http_conn_t *conn) {
+    conn->qnext = NULL;
+    if (*tail) (*tail)->qnext = conn;
+    else *head = conn;
+    *tail = conn;
+}
+
+static http_conn_t *queue_pop(http_conn_t **head, http_conn_t **tail) {
+    http_conn_t *conn = *head;
+    if (conn) {
+        *head = conn->qnext;
+        if (!*head) *tail = NULL;
+        conn->qnext = NULL;
+    }
+    return conn;
+}
+
+static void wake_reactor(http_shard_t *sh) {
+    uint64_t one = 1;
+    ssize_t n = write(sh->wake_fd, &one, sizeof(one));
+    (void)n;  /* counter saturation is harmless: the reactor is already awake */
+}
+
+/* ============================================================================
+ * Workers
+ * ============================================================================ */
+
+static void reply_free(http_reply_t *out) {
+    if (out->body_release) out->body_release(out->body_owner);
+    else if (!out->body_static) free(out->body);
+    memset(out, 0, sizeof(*out));
+}
+
+/* Build conn->out for the request at the start of conn->in. */
+static void process_request(http_conn_t *conn) {
+    http_reply_t *out = &conn->out;
+    memset(out, 0, sizeof(*out));
+    conn->out_off = 0;
+
+    http_raw_request_t req = {
+        .raw = conn->in,
+        .len = conn->req_len,
+        .head_len = conn->head_len,
+        .body = conn->in + conn->head_len,
+        .body_len = conn->req_len - conn->head_len,
+        .keep_alive = http_request_keep_alive(conn->in, conn->head_len)
+    };
+    out->keep_alive = req.keep_alive;
+    if (srv.handler(&req, out) != 0) {
+        reply_free(out);
+        out->keep_alive = req.keep_alive;
+        out->body = http_build_error(500, "Internal Server Error", req.keep_alive,
+                                     &out->body_len);
+    }
+
+    /* OOM (or a handler with nothing to say): nothing to send, just close */
+    conn->keep_alive = (out->body || out->head_len) ? out->keep_alive : 0;
+}
+
+/* Pin the calling thread to the shard's CPU (no-op when unpinned). */
+static void pin_to_shard_cpu(const http_shard_t *sh) {
+    if (sh->cpu < 0) return;
+
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    CPU_SET(sh->cpu, &set);
+    int rc = pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+    if (rc != 0) {
+        fprintf(stderr, "HTTP shard %d: cannot pin to CPU %d: %s\n",
+                sh->index, sh->cpu, strerror(rc));
+    }
+}
+
+static void *worker_main(void *arg) {
+    http_shard_t *sh = arg;
+    pin_to_shard_cpu(sh);
+
+    if (srv.worker_init) srv.worker_init();
+
+    for (;;) {
+        pthread_mutex_lock(&sh->lock);
+        while (srv.running && !sh->jobs_head) {
+            pthread_cond_wait(&sh->job_ready, &sh->lock);
+        }
+        if (!srv.running) {
+            pthread_mutex_unlock(&sh->lock);
+            break;
+        }
+        http_conn_t *conn = queue_pop(&sh->jobs_head, &sh->jobs_tail);
+        pthread_mutex_unlock(&sh->lock);
+
+        process_request(conn);
+
+        pthread_mutex_lock(&sh->lock);
+        queue_push(&sh->done_head, &sh->done_tail, conn);
+        pthread_mutex_unlock(&sh->lock);
+        wake_reactor(sh);
+    }
+    return NULL;
+}
+
+/* ============================================================================
+ * Connections (owning shard's reactor thread only)
+ * ============================================================================ */
+
+static int conn_watch(http_conn_t *conn, uint32_t events) {
+    if (events == conn->watched) return 0;
+
+    struct epoll_event ev = { .events = events, .data.ptr = conn };
+    int op = !conn->watched ? EPOLL_CTL_ADD : (events ? EPOLL_CTL_MOD : EPOLL_CTL_DEL);
+    if (epoll_ctl(conn->shard->epoll_fd, op, conn->fd, &ev) < 0) return -1;
+    conn->watched = events;
+    return 0;
+}
+
+static void conn_close(http_conn_t *conn) {
+    http_shard_t *sh = conn->shard;
+    if (conn->watched) epoll_ctl(sh->epoll_fd, EPOLL_CTL_DEL, conn->fd, NULL);
+    close(conn->fd);
+
+    if (conn->prev) conn->prev->next = conn->next;
+    else sh->conns = conn->next;
+    if (conn->next) conn->next->prev = conn->prev;
+
+    free(conn->in);
+    reply_free(&conn->out);
+    free(conn);
+}
+
+static void conn_write(http_conn_t *conn);
+
+/* Queue the next complete request in conn->in, if any. */
+static void conn_dispatch(http_conn_t *conn) {
+    size_t head_len = 0;
+    long req_len = http_request_length(conn->in, conn->in_len, &conn->scan_pos, &head_len);
+
+    if (req_len == 0) {
+        /* After EOF an incomplete request can never complete */
+        if (conn->peer_closed || conn_watch(conn, EPOLLIN) < 0) conn_close(conn);
+        return;
+    }
+
+    if (req_len < 0) {
+        /* Malformed or oversized: answer 400 and drop the connection. */
+        conn->keep_alive = 0;
+        conn->req_len = conn->in_len;
+        memset(&conn->out, 0, sizeof(conn->out));
+        conn->out.body = http_build_error(400, "Bad Request", 0, &conn->out.body_len);
+        conn->out_off = 0;
+        if (!conn->out.body) {
+            conn_close(conn);
+            return;
+        }
+        conn->state = CONN_WRITING;
+        conn_write(conn);
+        return;
+    }
+
+    /* conn_read keeps in_cap > in_len, so the terminator always fits; the
+     * byte it covers (start of a pipelined request) is restored afterwards. */
+    conn->req_len = (size_t)req_len;
+    conn->head_len = head_len;
+    conn->saved = conn->in[conn->req_len];
+    conn->in[conn->req_len] = '\0';
+    conn->state = CONN_PROCESSING;
+    if (conn_watch(conn, 0) < 0) {
+        conn_close(conn);
+        return;
+    }
+
+    http_shard_t *sh = conn->shard;
+    pthread_mutex_lock(&sh->lock);
+    queue_push(&sh->jobs_head, &sh->jobs_tail, conn);
+    pthread_cond_signal(&sh->job_ready);
+    pthread_mutex_unlock(&sh->lock);
+}
+
+/* Response fully sent: close, or recycle the connection for the next request. */
+static void conn_finish(http_conn_t *conn) {
+    reply_free(&conn->out);
+    conn->out_off = 0;
+
+    if (!conn->keep_alive) {
+        conn_close(conn);
+        return;
+    }
+
+    conn->in[conn->req_len] = conn->saved;
+    memmove(conn->in, conn->in + conn->req_len, conn->in_len - conn->req_len);
+    conn->in_len -= conn->req_len;
+    conn->req_len = 0;
+    conn->scan_pos = 0;
+    conn->state = CONN_READING;
+    conn->last_active = time(NULL);
+    conn_dispatch(conn);
+}
+
+static void conn_write(http_conn_t *conn) {
+    http_reply_t *out = &conn->out;
+    while (conn->out_off < out->head_len + out->body_len) {
+        struct iovec iov[2] = {
+            { .iov_base = out->head, .iov_len = out->head_len },
+            { .iov_base = out->body, .iov_len = out->body_len },
+        };
+        http_iov_advance(iov, 2, conn->out_off);
+        struct msghdr msg = { .msg_iov = iov, .msg_iovlen = 2 };
+        ssize_t n = sendmsg(conn->fd, &msg, MSG_NOSIGNAL);
+        if (n > 0) {
+            conn->out_off += (size_t)n;
+            conn->last_active = time(NULL);  /* progress resets the write timeout */
+            continue;
+        }
+        if (n < 0 && errno == EINTR) continue;
+        if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+            if (conn_watch(conn, EPOLLOUT) < 0) conn_close(conn);
+            return;
+        }
+        conn_close(conn);
+        return;
+    }
+    conn->last_active = time(NULL);
+    conn_finish(conn);
+}
+
+static void conn_read(http_conn_t *conn) {
+    for (;;) {
+        if (conn->in_cap - conn->in_len < HTTP_READ_CHUNK) {
+            if (conn->in_cap >= HTTP_MAX_REQUEST + HTTP_READ_CHUNK) break;  /* dispatch rejects it */
+            size_t new_cap = conn->in_cap ? conn->in_cap * 2 : HTTP_READ_CHUNK * 2;
+            char *nb = realloc(conn->in, new_cap);
+            if (!nb) {
+                conn_close(conn);
+                return;
+            }
+            conn->in = nb;
+            conn->in_cap = new_cap;
+        }
+
+        ssize_t n = recv(conn->fd, conn->in + conn->in_len, conn->in_cap - conn->in_len, 0);
+        if (n > 0) {
+            conn->in_len += (size_t)n;
+            continue;
+        }
+        if (n < 0 && errno == EINTR) continue;
+        if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) break;
+        if (n == 0) {
+            conn->peer_closed = 1;  /* half-close: dispatch what was sent */
+            break;
+        }
+        conn_close(conn);
+        return;
+    }
+
+    conn->last_active = time(NULL);
+    conn_dispatch(conn);
+}
+
+static void accept_connections(http_shard_t *sh) {
+    for (;;) {
+        int fd = accept4(sh->listen_fd, NULL, NULL, SOCK_NONBLOCK | SOCK_CLOEXEC);
+        if (fd < 0) {
+            if (errno == EINTR) continue;
+            if (errno != EAGAIN && errno != EWOULDBLOCK) {
+                fprintf(stderr, "Accept failed: %s\n", strerror(errno));
+            }
+            return;
+        }
+
+        int one = 1;
+        setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+
+        http_conn_t *conn = calloc(1, sizeof(http_conn_t));
+        if (!conn) {
+            close(fd);
+            continue;
+        }
+        conn->fd = fd;
+        conn->shard = sh;
+        conn->state = CONN_READING;
+        conn->last_active = time(NULL);
+        conn->next = sh->conns;
+        if (sh->conns) sh->conns->prev = conn;
+        sh->conns = conn;
+
+        if (conn_watch(conn, EPOLLIN) < 0) conn_close(conn);
+    }
+}
+
+/* Hand finished responses from the done queue to the writer. */
+static void drain_done_queue(http_shard_t *sh) {
+    uint64_t count;
+    ssize_t n = read(sh->wake_fd, &count, sizeof(count));
+    (void)n;
+
+    for (;;) {
+        pthread_mutex_lock(&sh->lock);
+        http_conn_t *conn = queue_pop(&sh->done_head, &sh->done_tail);
+        pthread_mutex_unlock(&sh->lock);
+        if (!conn) break;
+
+        if (!conn->out.body && !conn->out.head_len) {
+            conn_close(conn);
+            continue;
+        }
+        conn->state = CONN_WRITING;
+        conn->last_active = time(NULL);
+        conn_write(conn);
+    }
+}
+
+/* Close connections idle in READING longer than HTTP_IDLE_TIMEOUT_SEC, and
+ * those whose response has not moved for HTTP_WRITE_TIMEOUT_SEC (a client
+ * that never reads would otherwise hold its fd and response forever). */
+static void sweep_idle(http_shard_t *sh, time_t now) {
+    http_conn_t *conn = sh->conns;
+    while (conn) {
+        http_conn_t *next = conn->next;
+        time_t idle = now - conn->last_active;
+        if ((conn->state == CONN_READING && idle >= HTTP_IDLE_TIMEOUT_SEC) ||
+            (conn->state == CONN_WRITING && idle >= HTTP_WRITE_TIMEOUT_SEC)) {
+            conn_close(conn);
+        }
+        conn = next;
+    }
+}
+
+/* ============================================================================
+ * Reactor
+ * ============================================================================ */
+
+static void run_reactor(http_shard_t *sh) {
+    struct epoll_event events[HTTP_EPOLL_EVENTS];
+    time_t last_sweep = time(NULL);
+
+    while (srv.running) {
+        int n = epoll_wait(sh->epoll_fd, events, HTTP_EPOLL_EVENTS, 1000);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            fprintf(stderr, "epoll_wait failed: %s\n", strerror(errno));
+            /* One broken shard takes the server down rather than silently
+             * dropping its share of the connections. */
+            http_server_stop();
+            break;
+        }
+
+        for (int i = 0; i < n && srv.running; i++) {
+            void *tag = events[i].data.ptr;
+            uint32_t e = events[i].events;
+
+            if (tag == &listen_tag) {
+                accept_connections(sh);
+            } else if (tag == &wake_tag) {
+                drain_done_queue(sh);
+            } else {
+                http_conn_t *conn = tag;
+                if (conn->state == CONN_READING && (e & (EPOLLIN | EPOLLHUP | EPOLLERR))) {
+                    conn_read(conn);
+                } else if (conn->state == CONN_WRITING && (e & EPOLLOUT)) {
+                    conn_write(conn);
+                } else if (e & (EPOLLHUP | EPOLLERR)) {
+                    conn_close(conn);
+                }
+            }
+        }
+
+        time_t now = time(NULL);
+        if (now != last_sweep) {
+            sweep_idle(sh, now);
+            last_sweep = now;
+        }
+    }
+}
+
+static void *reactor_main(void *arg) {
+    http_shard_t *sh = arg;
+    pin_to_shard_cpu(sh);
+    run_reactor(sh);
+    return NULL;
+}
+
+/* ============================================================================
+ * Lifecycle
+ * ============================================================================ */
+
+static int open_listener(int port, int reuseport) {
+    int fd = socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (fd < 0) {
+        fprintf(stderr, "Failed to create socket: %s\n", strerror(errno));
+        return -1;
+    }
+
+    int opt = 1;
+    setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &opt, sizeof(opt));
+    if (reuseport && setsockopt(fd, SOL_SOCKET, SO_REUSEPORT, &opt, sizeof(opt)) < 0) {
+        fprintf(stderr, "Failed to set SO_REUSEPORT: %s\n", strerror(errno));
+        close(fd);
+        return -1;
+    }
+
+    struct sockaddr_in addr = {
+        .sin_family = AF_INET,
+        .sin_addr.s_addr = INADDR_ANY,
+        .sin_port = htons(port)
+    };
+
+    if (bind(fd, (struct sockaddr*)&addr, sizeof(addr)) < 0 ||
+        listen(fd, SOMAXCONN) < 0) {
+        fprintf(stderr, "Failed to bind/listen: %s\n", strerror(errno));
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+/* Create the shard's listener, epoll set and workers. Reactor not started. */
+static int shard_open(http_shard_t *sh, int port, int reuseport, int worker_count) {
+    sh->listen_fd = open_listener(port, reuseport);
+    sh->epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+    sh->wake_fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (sh->listen_fd < 0) return -1;
+    if (sh->epoll_fd < 0 || sh->wake_fd < 0) {
+        fprintf(stderr, "Failed to create epoll/eventfd: %s\n", strerror(errno));
+        return -1;
+    }
+
+    struct epoll_event ev = { .events = EPOLLIN, .data.ptr = &listen_tag };
+    epoll_ctl(sh->epoll_fd, EPOLL_CTL_ADD, sh->listen_fd, &ev);
+    ev.data.ptr = &wake_tag;
+    epoll_ctl(sh->epoll_fd, EPOLL_CTL_ADD, sh->wake_fd, &ev);
+
+    sh->workers = calloc(worker_count, sizeof(pthread_t));
+    for (int i = 0; sh->workers && i < worker_count; i++) {
+        if (pthread_create(&sh->workers[i], NULL, worker_main, sh) != 0) break;
+        sh->worker_count++;
+    }
+    if (sh->worker_count == 0) {
+        fprintf(stderr, "Failed to start HTTP worker threads\n");
+        return -1;
+    }
+    return 0;
+}
+
+/* Join the shard's threads and free it. srv.running must already be 0. */
+static void shard_close(http_shard_t *sh) {
+    pthread_mutex_lock(&sh->lock);
+    pthread_cond_broadcast(&sh->job_ready);
+    pthread_mutex_unlock(&sh->lock);
+
+    if (sh->reactor_started) pthread_join(sh->reactor, NULL);
+    for (int i = 0; i < sh->worker_count; i++) {
+        pthread_join(sh->workers[i], NULL);
+    }
+    free(sh->workers);
+
+    /* Every connection, queued or not, is still on the list. */
+    while (sh->conns) conn_close(sh->conns);
+
+    if (sh->listen_fd >= 0) close(sh->listen_fd);
+    if (sh->wake_fd >= 0) close(sh->wake_fd);
+    if (sh->epoll_fd >= 0) close(sh->epoll_fd);
+    pthread_mutex_destroy(&sh->lock);
+    pthread_cond_destroy(&sh->job_ready);
+}
+
+static void shutdown_server(void) {
+    srv.running = 0;
+    for (int i = 0; i < srv.shard_count; i++) {
+        shard_close(&srv.shards[i]);
+    }
+    free(srv.shards);
+    srv.shards = NULL;
+    srv.shard_count = 0;
+}
+
+int http_server_start(int port, http_handler_fn handler, void (*worker_init)(void),
+                      int worker_count, int shard_count) {
+    if (!handler) return -1;
+    if (worker_count <= 0) worker_count = HTTP_DEFAULT_WORKERS;
+
+    long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+    if (cpus < 1) cpus = 1;
+    if (shard_count <= 0) shard_count = (int)cpus;
+    /* Every shard needs a worker of its own; more shards than workers would
+     * start more threads than configured. */
+    if (shard_count > worker_count) {
+        fprintf(stderr, "HTTP server: %d shards but %d workers, using %d shards\n",
+                shard_count, worker_count, worker_count);
+        shard_count = worker_count;
+    }
+
+    srv.shards = calloc(shard_count, sizeof(http_shard_t));
+    if (!srv.shards) return -1;
+    srv.handler = handler;
+    srv.worker_init = worker_init;
+    srv.running = 1;
+
+    for (int i = 0; i < shard_count; i++) {
+        http_shard_t *sh = &srv.shards[i];
+        sh->index = i;
+        sh->cpu = shard_count > 1 ? (int)(i % cpus) : -1;
+        sh->listen_fd = sh->epoll_fd = sh->wake_fd = -1;
+        pthread_mutex_init(&sh->lock, NULL);
+        pthread_cond_init(&sh->job_ready, NULL);
+    }
+    srv.shard_count = shard_count;
+
+    /* Spawned threads must not take SIGINT/SIGTERM: the caller thread has to
+     * see them so its epoll_wait returns and the loop observes the stop. */
+    sigset_t block, old;
+    sigemptyset(&block);
+    sigaddset(&block, SIGINT);
+    sigaddset(&block, SIGTERM);
+    pthread_sigmask(SIG_BLOCK, &block, &old);
+
+    /* Workers are split across shards, so the total is exactly worker_count. */
+    int failed = 0;
+    for (int i = 0; i < shard_count && !failed; i++) {
+        int workers = worker_count / shard_count + (i < worker_count % shard_count);
+        if (shard_open(&srv.shards[i], port, shard_count > 1, workers) != 0) failed = 1;
+    }
+    for (int i = 1; i < shard_count && !failed; i++) {
+        http_shard_t *sh = &srv.shards[i];
+        if (pthread_create(&sh->reactor, NULL, reactor_main, sh) != 0) {
+            fprintf(stderr, "Failed to start HTTP reactor thread %d\n", i);
+            failed = 1;
+            break;
+        }
+        sh->reactor_started = 1;
+    }
+
+    pthread_sigmask(SIG_SETMASK, &old, NULL);
+
+    if (failed) {
+        shutdown_server();
+        return -1;
+    }
+
+    int total_workers = 0;
+    for (int i = 0; i < shard_count; i++) total_workers += srv.shards[i].worker_count;
+    if (shard_count > 1) {
+        fprintf(stderr, "HTTP server listening on port %d (%d SO_REUSEPORT shards, "
+                "%d workers, keep-alive %ds)\n",
+                port, shard_count, total_workers, HTTP_IDLE_TIMEOUT_SEC);
+    } else {
+        fprintf(stderr, "HTTP server listening on port %d (%d workers, keep-alive %ds)\n",
+                port, total_workers, HTTP_IDLE_TIMEOUT_SEC);
+    }
+
+    /* Shard 0 runs on the caller. */
+    pin_to_shard_cpu(&srv.shards[0]);
+    run_reactor(&srv.shards[0]);
+
+    shutdown_server();
+    return 0;
+}
+
+void http_server_stop(void) {
+    srv.running = 0;
+    for (int i = 0; i < srv.shard_count; i++) {
+        if (srv.shards[i].wake_fd >= 0) wake_reactor(&srv.shards[i]);
+    }
+}
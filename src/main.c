@@ -3,7 +3,7 @@
  * @brief SVGD server entry point
  *
  * Supports two modes:
- * - HTTP: Native HTTP server (single-threaded)
+ * - HTTP: Native HTTP/1.1 server (epoll reactor + worker pool, keep-alive)
  * - LSRP: Custom binary protocol with thread pool
  */
 
@@ -20,7 +20,10 @@
 #include "../lsrp/lsrp.h"
 #include "../lsrp/lsrp_server.h"
 #include "../include/http.h"
+#include "../include/http_server.h"
 #include "../include/handler.h"
+#include "../include/compress.h"
+#include "../include/task_pool.h"
 #include "../include/version.h"  /* SVGD_VERSION, SVGD_REPO_URL (generated) */
 
 /* ============================================================================
@@ -41,8 +44,6 @@ static void crash_handler(int sig) {
 
 duk_context *global_ctx = NULL;  /* Used by handler.c */
 static Config global_config;
-static volatile sig_atomic_t running = 1;
-static int server_sock = -1;
 static int verbose_logging = 0;
 
 /* Verbose logging accessor for other modules */
@@ -54,114 +55,114 @@ int is_verbose_logging(void) { return verbose_logging; }
 
 static void http_signal_handler(int sig) {
     (void)sig;
-    running = 0;
-    if (server_sock >= 0) {
-        shutdown(server_sock, SHUT_RDWR);
-        close(server_sock);
-    }
+    http_server_stop();
 }
 
-static void run_http_server(int port) {
-    struct sigaction sa = { .sa_handler = http_signal_handler };
-    sigemptyset(&sa.sa_mask);
-    sigaction(SIGINT, &sa, NULL);
-    sigaction(SIGTERM, &sa, NULL);
-    sigaction(SIGPIPE, &sa, NULL);
-
-    server_sock = socket(AF_INET, SOCK_STREAM, 0);
-    if (server_sock < 0) {
-        fprintf(stderr, "Failed to create socket: %s\n", strerror(errno));
-        return;
-    }
-
-    int opt = 1;
-    setsockopt(server_sock, SOL_SOCKET, SO_REUSEADDR, &opt, sizeof(opt));
+/* SIGHUP: reload generate_svg.js on the reload thread (both modes) */
+static void reload_signal_handler(int sig) {
+    (void)sig;
+    svg_reload_request();
+}
 
-    struct sockaddr_in addr = {
-        .sin_family = AF_INET,
-        .sin_addr.s_addr = INADDR_ANY,
-        .sin_port = htons(port)
-    };
+/* http_reply_t.body_release for bodies shared with the SVG cache */
+static void release_shared_body(void *owner) {
+    svg_buf_release(owner);
+}
 
-    if (bind(server_sock, (struct sockaddr*)&addr, sizeof(addr)) < 0 ||
-        listen(server_sock, SOMAXCONN) < 0) {
-        fprintf(stderr, "Failed to bind/listen: %s\n", strerror(errno));
-        close(server_sock);
-        return;
+/* Runs on an HTTP worker thread (see http_server.c). The rendered body is
+ * handed to the server as is and written after the headers with writev. */
+static int http_handler(const http_raw_request_t *raw, http_reply_t *reply) {
+    http_request_t parsed;
+    const http_request_t *req = &parsed;
+    if (http_parse_request(raw->raw, raw->len, &parsed) != 0) {
+        reply->keep_alive = 0;
+        reply->body = http_build_error(400, "Bad Request", 0, &reply->body_len);
+        return 0;
+    }
+    if (strcmp(req->method, "OPTIONS") == 0) {
+        reply->body = http_build_options(req->keep_alive, &reply->body_len);
+        return 0;
     }
 
-    fprintf(stderr, "HTTP server listening on port %d\n", port);
-
-    char buffer[8192];
-    while (running) {
-        struct sockaddr_in client_addr;
-        socklen_t client_len = sizeof(client_addr);
-        int client_sock = accept(server_sock, (struct sockaddr*)&client_addr, &client_len);
-
-        if (client_sock < 0) {
-            if (running) fprintf(stderr, "Accept failed: %s\n", strerror(errno));
-            continue;
-        }
-
-        ssize_t n = recv(client_sock, buffer, sizeof(buffer) - 1, 0);
-        if (n <= 0) {
-            close(client_sock);
-            continue;
-        }
-        buffer[n] = '\0';
+    /* Extract endpoint and period */
+    const char *endpoint = req->path;
+    if (*endpoint == '/') endpoint++;
 
-        /* Handle CORS preflight */
-        if (strncmp(buffer, "OPTIONS", 7) == 0) {
-            http_send_options(client_sock);
-            close(client_sock);
-            continue;
+    int period = 3600;
+    if (req->query[0]) {
+        const char *p = strstr(req->query, "period=");
+        if (p) {
+            period = atoi(p + 7);
+            if (period <= 0) period = 3600;
         }
+    }
 
-        /* Parse HTTP request */
-        http_request_t req;
-        if (http_parse_request(buffer, n, &req) != 0) {
-            http_send_error(client_sock, 400, "Bad Request");
-            close(client_sock);
-            continue;
-        }
+    if (verbose_logging) {
+        fprintf(stderr, "HTTP: %s %s (period=%d)\n", req->method, req->path, period);
+    }
 
-        /* Extract endpoint and period */
-        const char *endpoint = req.path;
-        if (*endpoint == '/') endpoint++;
+    /* Process request with caching (width/height parsed from query in handler).
+     * use_cache=1: repeated requests within cache_ttl_seconds are served from
+     * the RRD cache instead of re-reading the file. Parity with LSRP mode.
+     * The body comes back compressed when Accept-Encoding allows it. */
+    compress_encoding_t encoding = compress_negotiate(req->accept_encoding,
+                                                      strlen(req->accept_encoding));
+    handler_result_t *result = handler_process(&global_config, endpoint, req->query, period,
+                                               0, 0, 1, encoding);
 
-        int period = 3600;
-        if (req.query[0]) {
-            char *p = strstr(req.query, "period=");
-            if (p) {
-                period = atoi(p + 7);
-                if (period <= 0) period = 3600;
+    int rc = 0;
+    if (result && result->status == 0) {
+        http_response_t resp = {0};
+        resp.status = 200;
+        strncpy(resp.content_type, result->is_json ? "application/json" : "image/svg+xml",
+                sizeof(resp.content_type) - 1);
+        resp.body_len = result->data_len;
+        resp.keep_alive = req->keep_alive;
+        resp.content_encoding = compress_encoding_name(result->encoding);
+        int head_len = http_format_head(&resp, reply->head, sizeof(reply->head));
+        if (head_len < 0) {
+            rc = -1;
+        } else {
+            reply->head_len = (size_t)head_len;
+            reply->body = result->data;
+            reply->body_len = result->data_len;
+            if (result->shared) {
+                /* SVG cache buffer: the reference goes with the reply and is
+                 * dropped once the socket has the bytes */
+                reply->body_release = release_shared_body;
+                reply->body_owner = result->shared;
+                result->shared = NULL;
             }
+            result->data = NULL;  /* Transfer ownership */
         }
+    } else {
+        reply->body = http_build_error(400, result && result->data ? result->data : "Unknown error",
+                                       req->keep_alive, &reply->body_len);
+        if (!reply->body) rc = -1;
+    }
 
-        if (verbose_logging) {
-            fprintf(stderr, "HTTP: %s %s (period=%d)\n", req.method, req.path, period);
-        }
+    handler_result_free(result);
+    return rc;
+}
 
-        /* Process request with caching (width/height parsed from query in handler).
-         * use_cache=1: repeated requests within cache_ttl_seconds are served from
-         * the RRD cache instead of re-reading the file. Parity with LSRP mode. */
-        handler_result_t *result = handler_process(&global_config, endpoint, req.query, period, 0, 0, 1);
+static void run_http_server(int port, int workers) {
+    struct sigaction sa = { .sa_handler = http_signal_handler };
+    sigemptyset(&sa.sa_mask);
+    sigaction(SIGINT, &sa, NULL);
+    sigaction(SIGTERM, &sa, NULL);
 
-        if (result && result->status == 0) {
-            http_send_response(client_sock,
-                result->is_json ? "application/json" : "image/svg+xml",
-                result->data, result->data_len);
-        } else {
-            http_send_error(client_sock, 400,
-                result && result->data ? result->data : "Unknown error");
-        }
+    /* Peer resets must never stop the server; sends use MSG_NOSIGNAL anyway. */
+    signal(SIGPIPE, SIG_IGN);
 
-        handler_result_free(result);
-        close(client_sock);
+    /* Same as LSRP workers: the Duktape context is thread-local, warm it
+     * before the first request lands on a worker. */
+    if (http_server_start(port, http_handler, svg_prewarm_context,
+                          workers, global_config.listen_shards) != 0) {
+        fprintf(stderr, "Failed to start HTTP server on port %d\n", port);
+        return;
     }
 
     fprintf(stderr, "\nShutting down HTTP server...\n");
-    close(server_sock);
 }
 
 /* ============================================================================
@@ -203,13 +204,36 @@ static int lsrp_handler(lsrp_request_t *req, lsrp_response_t *resp) {
         free(height_str);
     }
 
+    /* encoding=gzip: the client (svgd-gate) relays the body with
+     * Content-Encoding: gzip. LSRP carries no headers, so it tells a
+     * compressed body apart by the gzip header (1f 8b 08; SVG/JSON text never
+     * starts with 0x1f). A deflate stream has no such marker, so only gzip is
+     * honored here; anything else gets the plain body. */
+    char *encoding_str = handler_get_param(req->params, "encoding");
+    compress_encoding_t encoding = compress_encoding_parse(encoding_str) == COMPRESS_GZIP
+                                   ? COMPRESS_GZIP : COMPRESS_IDENTITY;
+    free(encoding_str);
+
     /* Process request with caching enabled (width/height 0 = use defaults) */
     /* Pass req->params as the query so handler_process can read grafana `body`,
        width/height/format params. (Re-parsing width/height is harmless — same values.) */
-    handler_result_t *result = handler_process(&global_config, endpoint, req->params, period, width, height, 1);
+    handler_result_t *result = handler_process(&global_config, endpoint, req->params, period,
+                                               width, height, 1, encoding);
     free(endpoint);
 
-    if (result && result->status == 0) {
+    if (result && result->status == 0 && result->shared) {
+        /* The LSRP server frees resp->data itself: copy out of the shared
+         * SVG cache buffer */
+        resp->status = 0;
+        resp->data = malloc(result->data_len + 1);
+        if (!resp->data) {
+            handler_result_free(result);
+            return -1;
+        }
+        memcpy(resp->data, result->data, result->data_len);
+        resp->data[result->data_len] = '\0';
+        resp->data_len = result->data_len;
+    } else if (result && result->status == 0) {
         resp->status = 0;
         resp->data = result->data;
         resp->data_len = result->data_len;
@@ -265,25 +289,53 @@ int main(int argc, char *argv[]) {
 
     /* Initialize RRD data cache + JS context cache for BOTH modes.
      *
-     * Formerly HTTP mode skipped this (protocol != "http" guard), leaving it
-     * cache-less with a cold-start JS context on every request. With cache
-     * parity, HTTP now serves repeated requests from the RRD cache and reuses
-     * a pre-warmed Duktape context — closing the feature gap with LSRP without
-     * the complexity of a thread pool (HTTP stays single-threaded).
-     *
-     * LSRP worker threads pre-warm their own thread-local contexts in
-     * worker_thread() (lsrp_server.c); the HTTP main thread handles all
-     * requests itself, so we pre-warm its sole context here. */
-    init_rrd_cache(global_config.cache_ttl_seconds);
+     * Both transports render on worker threads: LSRP workers pre-warm their
+     * thread-local contexts in worker_thread() (lsrp_server.c), HTTP workers
+     * in worker_main() (http_server.c). */
+    init_rrd_cache(global_config.cache_ttl_seconds, global_config.cache_max_bytes);
+    rrdc_pool_init(global_config.rrdcached_addr, global_config.thread_pool_size);
+    rrdc_flush_policy_t flush_policy = RRDC_FLUSH_FETCH;
+    if (rrdc_flush_policy_parse(global_config.rrd_flush_policy, &flush_policy) != 0) {
+        fprintf(stderr, "Warning: unknown rrd.flush_policy \"%s\", using \"fetch\"\n",
+                global_config.rrd_flush_policy);
+    }
+    rrdc_pool_set_flush_policy(flush_policy, global_config.rrd_flush_interval);
+    rrd_reader_backend_t reader_backend = RRD_READER_LIBRRD;
+    if (rrd_reader_backend_parse(global_config.rrd_reader, &reader_backend) != 0) {
+        fprintf(stderr, "Warning: unknown rrd.reader \"%s\", using \"librrd\"\n",
+                global_config.rrd_reader);
+    }
+    rrd_reader_set_backend(reader_backend);
+    svg_series_format_t series_format = SVG_SERIES_TYPED;
+    if (svg_series_format_parse(global_config.js_series_format, &series_format) != 0) {
+        fprintf(stderr, "Warning: unknown js.series_format \"%s\", using \"typed\"\n",
+                global_config.js_series_format);
+    }
+    svg_set_series_format(series_format);
+    svg_render_engine_t render_engine = SVG_ENGINE_JS;
+    if (svg_render_engine_parse(global_config.render_engine, &render_engine) != 0) {
+        fprintf(stderr, "Warning: unknown server.render_engine \"%s\", using \"js\"\n",
+                global_config.render_engine);
+    }
+    svg_set_render_engine(render_engine);
+    svg_cache_init(global_config.cache_ttl_seconds, global_config.svg_cache_max_bytes);
+    compress_configure(global_config.compression_level, global_config.compression_min_bytes);
+    js_heap_set_limits(global_config.js_heap_max_bytes, global_config.js_heap_gc_bytes);
     init_js_cache(global_config.js_script_path);
-
-    if (strcmp(protocol, "http") == 0) {
-        svg_prewarm_context();  /* HTTP: single main thread — pre-warm here */
-        fprintf(stderr, "RRD cache + JS context initialized for HTTP (ttl=%ds)\n",
-                global_config.cache_ttl_seconds);
-    } else {
-        fprintf(stderr, "RRD cache + JS cache initialized for LSRP workers\n");
+    svg_reload_mode_t reload_mode = SVG_RELOAD_SIGHUP;
+    if (svg_reload_mode_parse(global_config.js_reload, &reload_mode) != 0) {
+        fprintf(stderr, "Warning: unknown js.reload \"%s\", using \"sighup\"\n",
+                global_config.js_reload);
     }
+    svg_reload_start(global_config.js_script_path, reload_mode);
+    struct sigaction sa_reload = { .sa_handler = reload_signal_handler, .sa_flags = SA_RESTART };
+    sigemptyset(&sa_reload.sa_mask);
+    sigaction(SIGHUP, &sa_reload, NULL);
+
+    fprintf(stderr, "RRD + SVG cache + JS cache initialized for %s workers (ttl=%ds, rrd budget=%zu bytes, svg budget=%zu bytes)\n",
+            strcmp(protocol, "http") == 0 ? "HTTP" : "LSRP",
+            global_config.cache_ttl_seconds, global_config.cache_max_bytes,
+            global_config.svg_cache_max_bytes);
 
     if (global_config.metrics_count == 0) {
         fprintf(stderr, "Error: No metrics configured\n");
@@ -294,22 +346,37 @@ int main(int argc, char *argv[]) {
     fprintf(stderr, "Starting %s server on port %d (%d metrics)\n",
             protocol, global_config.tcp_port, global_config.metrics_count);
 
+    /* The render pool for _batch comes out of thread_pool_size: half of the
+     * threads help with batch panels, the rest (at least one) take requests.
+     * Every one of them holds a Duktape context, so the total stays at
+     * thread_pool_size. */
+    int render_threads = global_config.thread_pool_size / 2;
+    int request_workers = global_config.thread_pool_size - render_threads;
+    if (request_workers < 1) request_workers = 1;
+    task_pool_start(render_threads);
+
     /* Start appropriate server */
     if (strcmp(protocol, "http") == 0) {
-        run_http_server(global_config.tcp_port);
+        run_http_server(global_config.tcp_port, request_workers);
     } else {
         int ret = lsrp_server_start(global_config.tcp_port, lsrp_handler,
-                                    global_config.thread_pool_size);
+                                    request_workers);
         if (ret < 0) {
             fprintf(stderr, "Failed to start LSRP server: %d\n", ret);
         }
     }
 
     /* Cleanup */
+    task_pool_stop();
+    svg_reload_stop();
     free_config(&global_config);
     duk_destroy_heap(global_ctx);
     free_js_cache();
+    svg_cache_free();
     free_rrd_cache();
+    rra_cache_free();
+    rrdc_pool_free();
+    rrd_mmap_free();
 
     return 0;
 }
@@ -11,10 +11,22 @@
  * SRC_PROMETHEUS (Stage 3) добавлены позже.
  *
  * Кэш: используется существующий универсальный кэш (src/rrd/cache.c), ключ
- * строится как "<spec>:<period>". Для RRD spec = rrd_path (как раньше); для proc
+ * строится как "<spec>:<period>". Для RRD spec = "<rrd_path>@<step>" (шаг
+ * выбирается под ширину панели); для proc
  * и prometheus spec = "proc:<metric>" / "prom:<url>" (не коллидирует с RRD-путями,
  * те начинаются с '/'). TTL общий (config.cache_ttl_seconds); для live-данных proc
  * и опроса prometheus короткий TTL (по умолчанию 5 с) склеивает всплески запросов.
+ *
+ * Для RRD истёкшая запись не перечитывается целиком: rrd_fetch_delta() берёт
+ * её (cache_get_stale), дочитывает только строки, записанные с прошлого
+ * fetch, и отрезает голову за пределами окна. Полный fetch — только если
+ * дельта невозможна (нет старой записи, сменился архив/шаг).
+ *
+ * Выбор шага (rrd_select_step) — это stat() файла, а после каждой записи в
+ * RRD (раз в ~10 с) ещё и rrd_first_r(). Чтобы попадание в кэш этого не
+ * платило, выбранный шаг запоминается на (путь, период, ширина) с тем же TTL,
+ * что и данные: попадание ищется по запомненному шагу, а заново шаг
+ * выбирается только на промахе.
  */
 #include "../include/metric_source.h"
 #include "../include/path_util.h"
@@ -23,38 +35,149 @@
 #include "../include/rrd/cache.h"
 #include <time.h>
 #include <stdio.h>
+#include <string.h>
+#include <pthread.h>
+
+/* Запомненные шаги: прямое отображение без цепочек, коллизия просто
+ * вытесняет слот. Ширина приходит из query string, так что таблица
+ * фиксированного размера — это и есть ограничение по памяти. */
+#define STEP_MEMO_SLOTS 256
+#define STEP_MEMO_KEY_SIZE 560
+
+typedef struct {
+    char key[STEP_MEMO_KEY_SIZE];   /* "<rrd_path>|<period>|<width>", "" — пусто */
+    unsigned long step;
+    time_t expires_at;
+} step_memo_t;
+
+static step_memo_t step_memo[STEP_MEMO_SLOTS];
+static pthread_mutex_t step_memo_mutex = PTHREAD_MUTEX_INITIALIZER;
+
+/* DJB2, как у остальных кэшей */
+static unsigned int step_memo_hash(const char *key) {
+    unsigned int hash = 5381;
+    int c;
+    while ((c = *key++)) {
+        hash = ((hash << 5) + hash) + c;
+    }
+    return hash % STEP_MEMO_SLOTS;
+}
+
+/* Запомненный шаг для key или 0, если его нет или он истёк */
+static unsigned long step_memo_get(const char *key, time_t now) {
+    step_memo_t *m = &step_memo[step_memo_hash(key)];
+    unsigned long step = 0;
+    pthread_mutex_lock(&step_memo_mutex);
+    if (m->expires_at > now && strcmp(m->key, key) == 0) step = m->step;
+    pthread_mutex_unlock(&step_memo_mutex);
+    return step;
+}
+
+static void step_memo_put(const char *key, unsigned long step, time_t expires_at) {
+    step_memo_t *m = &step_memo[step_memo_hash(key)];
+    pthread_mutex_lock(&step_memo_mutex);
+    snprintf(m->key, sizeof(m->key), "%s", key);
+    m->step = step;
+    m->expires_at = expires_at;
+    pthread_mutex_unlock(&step_memo_mutex);
+}
+
+unsigned long metric_source_step(Config *config, MetricConfig *metric,
+                                 const char *param, int period, int width, int use_cache) {
+    if (!config || !metric || metric->source != SRC_RRD) return 0;
+
+    char rrd_path[512] = {0};
+    build_rrd_path(rrd_path, sizeof(rrd_path), config->rrd_base_path,
+                   metric->rrd_path, param);
+
+    time_t now = time(NULL);
+    char memo_key[STEP_MEMO_KEY_SIZE];
+    unsigned long step = 0;
+    memo_key[0] = '\0';
+    if (use_cache) {
+        int n = snprintf(memo_key, sizeof(memo_key), "%s|%d|%d", rrd_path, period, width);
+        if (n < 0 || (size_t)n >= sizeof(memo_key)) memo_key[0] = '\0';
+        if (memo_key[0]) step = step_memo_get(memo_key, now);
+    }
+    if (!step) {
+        step = rrd_select_step(rrd_path, now - period, width);
+        if (memo_key[0]) {
+            int ttl = config->cache_ttl_seconds > 0 ? config->cache_ttl_seconds : 5;
+            step_memo_put(memo_key, step, now + ttl);
+        }
+    }
+    return step;
+}
 
 MetricData* metric_source_fetch(Config *config, MetricConfig *metric,
-                                const char *param, int period, int use_cache) {
+                                const char *param, int period, int width, int use_cache) {
     if (!config || !metric) return NULL;
 
     MetricData *data = NULL;
 
     switch (metric->source) {
     case SRC_RRD: {
-        /* Полностью повторяет прежнюю inline-логику handler.c (нулевая стадия). */
         char rrd_path[512] = {0};
         build_rrd_path(rrd_path, sizeof(rrd_path), config->rrd_base_path,
                        metric->rrd_path, param);
 
+        /* Шаг зависит от ширины панели, поэтому входит в ключ кэша: панели,
+         * выбравшие один архив, делят запись, а грубые данные спарклайна не
+         * попадают на широкий график. */
+        time_t now = time(NULL);
+        char memo_key[STEP_MEMO_KEY_SIZE];
+        char cache_spec[544];
+        unsigned long step = 0;
+        memo_key[0] = '\0';
+
         if (use_cache) {
-            data = cache_get(rrd_path, period);
+            /* Попадание не выбирает шаг заново: ни stat(), ни rrd_first_r() */
+            int n = snprintf(memo_key, sizeof(memo_key), "%s|%d|%d", rrd_path, period, width);
+            if (n < 0 || (size_t)n >= sizeof(memo_key)) memo_key[0] = '\0';
+            if (memo_key[0]) step = step_memo_get(memo_key, now);
+            if (step) {
+                snprintf(cache_spec, sizeof(cache_spec), "%s@%lu", rrd_path, step);
+                data = cache_get(cache_spec, period);
+            }
+        }
+
+        if (!data) {
+            /* Промах: шаг выбирается по текущему состоянию файла (архив мог
+             * смениться), и запись с новым шагом уже могла положить другая
+             * панель. */
+            unsigned long fresh_step = rrd_select_step(rrd_path, now - period, width);
+            if (use_cache && memo_key[0]) {
+                int ttl = config->cache_ttl_seconds > 0 ? config->cache_ttl_seconds : 5;
+                step_memo_put(memo_key, fresh_step, now + ttl);
+            }
+            if (fresh_step != step) {
+                step = fresh_step;
+                snprintf(cache_spec, sizeof(cache_spec), "%s@%lu", rrd_path, step);
+                if (use_cache) data = cache_get(cache_spec, period);
+            }
         }
 
         if (!data) {
-            time_t now = time(NULL);
-            MetricData *fresh_data = fetch_metric_data(config->rrdcached_addr, rrd_path,
-                                                       now - period, param, metric);
+            MetricData *fresh_data = NULL;
+            if (use_cache) {
+                MetricData *stale = cache_get_stale(cache_spec, period);
+                if (stale) {
+                    fresh_data = rrd_fetch_delta(config->rrdcached_addr, rrd_path,
+                                                 stale, now - period);
+                    metric_data_release(stale);
+                }
+            }
+            if (!fresh_data) {
+                fresh_data = rrd_fetch_data_step(config->rrdcached_addr, rrd_path,
+                                                 now - period, step, param, metric);
+            }
             if (fresh_data) {
                 if (use_cache) {
-                    cache_put(rrd_path, period, fresh_data);
-                    /* cache_put забирает владение fresh_data; клонируем обратно. */
-                    data = cache_get(rrd_path, period);
-                    /* При неудаче клонирования (OOM) данные остались в кэше, но
-                     * сейчас вернуть нечего — следующий запрос попробует снова. */
-                } else {
-                    data = fresh_data;
+                    /* Кэш забирает одну ссылку, вторую оставляем себе: после
+                     * публикации данные неизменяемы и делятся без копирования. */
+                    cache_put(cache_spec, period, metric_data_retain(fresh_data));
                 }
+                data = fresh_data;
             }
         }
         break;
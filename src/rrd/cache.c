@@ -1,6 +1,32 @@
 /**
  * @file cache.c
  * @brief RRD data caching implementation
+ *
+ * The table is a power-of-two array of chained buckets that doubles when the
+ * average chain exceeds CACHE_LOAD_FACTOR, so lookups stay short no matter
+ * how many path x period keys a dashboard produces.
+ *
+ * Locking is striped: CACHE_LOCK_STRIPES rwlocks, bucket i guarded by stripe
+ * (i % CACHE_LOCK_STRIPES). The bucket count is always a multiple of the
+ * stripe count, so a key's stripe depends only on its hash and survives a
+ * resize. Hits on different stripes never contend, and hits on the same key
+ * (the common case for a shared dashboard) proceed concurrently under the
+ * read lock. Put, eviction and the sweeper lock one stripe exclusively at a
+ * time; only a resize takes all of them.
+ *
+ * Cached MetricData is immutable and refcounted: a hit only retains the
+ * entry's data, so its cost no longer depends on the number of points.
+ *
+ * Memory is bounded by max_bytes (0 = unlimited). Before an insert that
+ * would exceed it, a CLOCK hand sweeps the buckets: expired entries and
+ * entries not hit since the last pass are evicted, hit entries get a second
+ * chance. A background thread removes expired entries every TTL, so keys
+ * that are never requested again do not linger until evicted.
+ *
+ * Expired RRD data is not dropped at once: it stays for CACHE_DELTA_KEEP_TTLS
+ * more TTLs so rrd_cache_get_stale() can hand it to rrd_fetch_delta(), which
+ * reads only the rows written since. Eviction still takes expired entries
+ * first.
  */
 
 #include "../include/rrd/cache.h"
@@ -11,22 +37,63 @@
 #include <pthread.h>
 #include <time.h>
 
-#define CACHE_MAX_ENTRIES 64
+#define CACHE_LOCK_STRIPES 64       /* power of two */
+#define CACHE_MIN_BUCKETS 64        /* multiple of CACHE_LOCK_STRIPES */
+#define CACHE_MAX_BUCKETS 65536
+#define CACHE_LOAD_FACTOR 2         /* grow when entries > buckets * factor */
 #define CACHE_KEY_SIZE 512
+#define CACHE_DELTA_KEEP_TTLS 12    /* expired RRD data kept for delta refresh */
 
 /* Cache entry structure */
 typedef struct cache_entry {
-    char key[CACHE_KEY_SIZE];
+    char *key;
+    unsigned int hash;
     MetricData *data;
+    size_t bytes;                   /* accounted size: entry + key + data */
     time_t expires_at;
+    time_t keep_until;              /* removed by the sweeper after this */
+    int referenced;                 /* CLOCK bit, set by hits (atomic) */
     struct cache_entry *next;
 } cache_entry_t;
 
-/* Global cache state */
-static cache_entry_t *cache_slots[CACHE_MAX_ENTRIES] = {0};
-static pthread_mutex_t cache_mutex = PTHREAD_MUTEX_INITIALIZER;
-static int cache_ttl_seconds = 5;
-static int cache_initialized = 0;
+/* One lock per cache line to avoid false sharing between stripes */
+typedef struct {
+    pthread_rwlock_t lock;
+} __attribute__((aligned(64))) cache_stripe_t;
+
+/* Global cache state. cache_table/cache_nbuckets change only while every
+ * stripe is write-locked, so holding any stripe makes them stable. */
+static cache_stripe_t cache_stripes[CACHE_LOCK_STRIPES];
+static pthread_once_t cache_locks_once = PTHREAD_ONCE_INIT;
+static cache_entry_t **cache_table = NULL;
+static size_t cache_nbuckets = 0;
+static volatile int cache_ttl_seconds = 5;
+static volatile int cache_initialized = 0;
+static size_t cache_max_bytes = 0;
+
+/* Counters, updated with __atomic builtins */
+static size_t cache_entries = 0;
+static size_t cache_bytes = 0;
+static unsigned long cache_evictions = 0;
+static unsigned long cache_expirations = 0;
+static unsigned long cache_stale_hits = 0;
+
+/* Serializes eviction and resize; also guards the CLOCK hand */
+static pthread_mutex_t cache_evict_lock = PTHREAD_MUTEX_INITIALIZER;
+static size_t cache_hand = 0;
+
+/* Background sweeper */
+static pthread_t sweeper_thread;
+static pthread_mutex_t sweeper_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t sweeper_cond = PTHREAD_COND_INITIALIZER;
+static int sweeper_running = 0;
+static int sweeper_stop = 0;
+
+static void init_stripe_locks(void) {
+    for (int i = 0; i < CACHE_LOCK_STRIPES; i++) {
+        pthread_rwlock_init(&cache_stripes[i].lock, NULL);
+    }
+}
 
 /* Simple DJB2 hash function */
 static unsigned int cache_hash(const char *key) {
@@ -35,7 +102,11 @@ static unsigned int cache_hash(const char *key) {
     while ((c = *key++)) {
         hash = ((hash << 5) + hash) + c;
     }
-    return hash % CACHE_MAX_ENTRIES;
+    return hash;
+}
+
+static pthread_rwlock_t *stripe_lock(size_t hash_or_index) {
+    return &cache_stripes[hash_or_index & (CACHE_LOCK_STRIPES - 1)].lock;
 }
 
 /* Build cache key from rrd_path and period */
@@ -43,64 +114,211 @@ static void build_cache_key(char *buf, size_t size, const char *rrd_path, int pe
     snprintf(buf, size, "%s:%d", rrd_path, period);
 }
 
-/* Clone MetricData for thread-safe return */
-static MetricData* clone_metric_data(MetricData *src) {
-    if (!src) return NULL;
+/* Approximate heap footprint of MetricData (payload, not malloc overhead) */
+static size_t metric_data_bytes(const MetricData *d) {
+    size_t n = sizeof(MetricData);
+    n += (size_t)d->series_count * (sizeof(char *) + sizeof(DataPoint *) + sizeof(int));
+    for (int i = 0; i < d->series_count; i++) {
+        if (d->series_names && d->series_names[i]) n += strlen(d->series_names[i]) + 1;
+        if (d->series_counts) n += (size_t)d->series_counts[i] * sizeof(DataPoint);
+    }
+    if (d->param1) n += strlen(d->param1) + 1;
+    return n;
+}
+
+/* Unlink an entry whose stripe is write-locked; its data goes to *dead so it
+ * can be released after unlock. */
+static void unlink_entry(cache_entry_t **link, cache_entry_t *entry, cache_entry_t **dead) {
+    *link = entry->next;
+    __atomic_sub_fetch(&cache_entries, 1, __ATOMIC_RELAXED);
+    __atomic_sub_fetch(&cache_bytes, entry->bytes, __ATOMIC_RELAXED);
+    entry->next = *dead;
+    *dead = entry;
+}
+
+static void free_dead(cache_entry_t *dead) {
+    while (dead) {
+        cache_entry_t *next = dead->next;
+        metric_data_release(dead->data);
+        free(dead->key);
+        free(dead);
+        dead = next;
+    }
+}
 
-    MetricData *dst = malloc(sizeof(MetricData));
-    if (!dst) return NULL;
+/* CLOCK eviction until `need` more bytes fit in the budget (or two full
+ * passes found nothing more to evict). Called without any stripe held. */
+static void cache_make_room(size_t need) {
+    pthread_mutex_lock(&cache_evict_lock);
 
-    dst->series_count = src->series_count;
-    dst->series_names = calloc(dst->series_count, sizeof(char*));
-    dst->series_data = calloc(dst->series_count, sizeof(DataPoint*));
-    dst->series_counts = calloc(dst->series_count, sizeof(int));
-    dst->param1 = strdup(src->param1 ? src->param1 : "");
-    dst->metric_config = src->metric_config;
+    size_t visited = 0;
+    while (__atomic_load_n(&cache_bytes, __ATOMIC_RELAXED) + need > cache_max_bytes) {
+        size_t idx = cache_hand;
+        pthread_rwlock_t *lock = stripe_lock(idx);
+        cache_entry_t *dead = NULL;
 
-    if (dst->series_count > 0 && (!dst->series_names || !dst->series_data || !dst->series_counts)) {
-        free(dst->series_names);
-        free(dst->series_data);
-        free(dst->series_counts);
-        free(dst->param1);
-        free(dst);
-        return NULL;
+        pthread_rwlock_wrlock(lock);
+        if (!cache_table || visited >= 2 * cache_nbuckets) {
+            pthread_rwlock_unlock(lock);
+            break;
+        }
+
+        time_t now = time(NULL);
+        cache_entry_t **link = &cache_table[idx];
+        while (*link) {
+            cache_entry_t *entry = *link;
+            if (__atomic_load_n(&cache_bytes, __ATOMIC_RELAXED) + need <= cache_max_bytes) break;
+            if (entry->expires_at <= now) {
+                unlink_entry(link, entry, &dead);
+                __atomic_add_fetch(&cache_expirations, 1, __ATOMIC_RELAXED);
+            } else if (!__atomic_load_n(&entry->referenced, __ATOMIC_RELAXED)) {
+                unlink_entry(link, entry, &dead);
+                __atomic_add_fetch(&cache_evictions, 1, __ATOMIC_RELAXED);
+            } else {
+                /* Hit since the last pass: second chance */
+                __atomic_store_n(&entry->referenced, 0, __ATOMIC_RELAXED);
+                link = &entry->next;
+            }
+        }
+        cache_hand = (idx + 1) & (cache_nbuckets - 1);
+        pthread_rwlock_unlock(lock);
+
+        free_dead(dead);
+        visited++;
     }
 
-    int i;
-    for (i = 0; i < dst->series_count; i++) {
-        if (!src->series_names[i]) goto clone_fail;
-        dst->series_names[i] = strdup(src->series_names[i]);
-        if (!dst->series_names[i]) goto clone_fail;
-        dst->series_counts[i] = src->series_counts[i];
-        dst->series_data[i] = malloc(dst->series_counts[i] * sizeof(DataPoint));
-        if (!dst->series_data[i]) {
-            free(dst->series_names[i]);
-            goto clone_fail;
+    pthread_mutex_unlock(&cache_evict_lock);
+}
+
+/* Double the bucket array when chains get long. Takes every stripe. */
+static void cache_grow(void) {
+    pthread_mutex_lock(&cache_evict_lock);
+
+    size_t old_n = __atomic_load_n(&cache_nbuckets, __ATOMIC_RELAXED);
+    if (!cache_table || old_n >= CACHE_MAX_BUCKETS ||
+        __atomic_load_n(&cache_entries, __ATOMIC_RELAXED) <= old_n * CACHE_LOAD_FACTOR) {
+        pthread_mutex_unlock(&cache_evict_lock);
+        return;
+    }
+
+    size_t new_n = old_n * 2;
+    cache_entry_t **new_table = calloc(new_n, sizeof(cache_entry_t *));
+    if (!new_table) {
+        /* Keep the current table; lookups only get slower */
+        pthread_mutex_unlock(&cache_evict_lock);
+        return;
+    }
+
+    for (int i = 0; i < CACHE_LOCK_STRIPES; i++) {
+        pthread_rwlock_wrlock(&cache_stripes[i].lock);
+    }
+
+    for (size_t i = 0; i < old_n; i++) {
+        cache_entry_t *entry = cache_table[i];
+        while (entry) {
+            cache_entry_t *next = entry->next;
+            size_t idx = entry->hash & (new_n - 1);
+            entry->next = new_table[idx];
+            new_table[idx] = entry;
+            entry = next;
+        }
+    }
+    cache_entry_t **old_table = cache_table;
+    cache_table = new_table;
+    __atomic_store_n(&cache_nbuckets, new_n, __ATOMIC_RELAXED);
+    cache_hand &= new_n - 1;
+
+    for (int i = CACHE_LOCK_STRIPES - 1; i >= 0; i--) {
+        pthread_rwlock_unlock(&cache_stripes[i].lock);
+    }
+    pthread_mutex_unlock(&cache_evict_lock);
+
+    free(old_table);
+}
+
+/* Expiry and removal times for data stored now */
+static void set_expiry(cache_entry_t *entry, const MetricData *data) {
+    entry->expires_at = time(NULL) + cache_ttl_seconds;
+    entry->keep_until = entry->expires_at +
+        (data->fetch_step ? CACHE_DELTA_KEEP_TTLS * cache_ttl_seconds : 0);
+}
+
+/* Remove every entry past its keep time, one stripe at a time */
+static void cache_sweep_expired(void) {
+    for (int s = 0; s < CACHE_LOCK_STRIPES; s++) {
+        cache_entry_t *dead = NULL;
+
+        pthread_rwlock_wrlock(&cache_stripes[s].lock);
+        if (!cache_table) {
+            pthread_rwlock_unlock(&cache_stripes[s].lock);
+            return;
+        }
+        time_t now = time(NULL);
+        for (size_t b = (size_t)s; b < cache_nbuckets; b += CACHE_LOCK_STRIPES) {
+            cache_entry_t **link = &cache_table[b];
+            while (*link) {
+                cache_entry_t *entry = *link;
+                if (entry->keep_until <= now) {
+                    unlink_entry(link, entry, &dead);
+                    __atomic_add_fetch(&cache_expirations, 1, __ATOMIC_RELAXED);
+                } else {
+                    link = &entry->next;
+                }
+            }
         }
-        memcpy(dst->series_data[i], src->series_data[i],
-               dst->series_counts[i] * sizeof(DataPoint));
+        pthread_rwlock_unlock(&cache_stripes[s].lock);
+
+        free_dead(dead);
     }
+}
 
-    return dst;
+static void *sweeper_main(void *arg) {
+    (void)arg;
+    pthread_mutex_lock(&sweeper_lock);
+    while (!sweeper_stop) {
+        struct timespec deadline;
+        clock_gettime(CLOCK_REALTIME, &deadline);
+        deadline.tv_sec += cache_ttl_seconds;
+        pthread_cond_timedwait(&sweeper_cond, &sweeper_lock, &deadline);
+        if (sweeper_stop) break;
 
-clone_fail:
-    for (int j = 0; j < i; j++) {
-        free(dst->series_names[j]);
-        free(dst->series_data[j]);
+        pthread_mutex_unlock(&sweeper_lock);
+        cache_sweep_expired();
+        pthread_mutex_lock(&sweeper_lock);
     }
-    free(dst->series_names);
-    free(dst->series_data);
-    free(dst->series_counts);
-    free(dst->param1);
-    free(dst);
+    pthread_mutex_unlock(&sweeper_lock);
     return NULL;
 }
 
-void rrd_cache_init(int ttl_seconds) {
-    pthread_mutex_lock(&cache_mutex);
+void rrd_cache_init(int ttl_seconds, size_t max_bytes) {
+    /* Called once at startup, before any worker thread exists */
+    pthread_once(&cache_locks_once, init_stripe_locks);
     cache_ttl_seconds = ttl_seconds > 0 ? ttl_seconds : 5;
+    cache_max_bytes = max_bytes;
+    if (cache_initialized) return;
+
+    cache_table = calloc(CACHE_MIN_BUCKETS, sizeof(cache_entry_t *));
+    if (!cache_table) {
+        fprintf(stderr, "Warning: RRD cache disabled (out of memory)\n");
+        return;
+    }
+    cache_nbuckets = CACHE_MIN_BUCKETS;
+    cache_hand = 0;
+    cache_entries = 0;
+    cache_bytes = 0;
+    cache_evictions = 0;
+    cache_expirations = 0;
+    cache_stale_hits = 0;
+
+    sweeper_stop = 0;
+    if (pthread_create(&sweeper_thread, NULL, sweeper_main, NULL) == 0) {
+        sweeper_running = 1;
+    } else {
+        /* Expired entries are still replaced on put and evicted on pressure */
+        fprintf(stderr, "Warning: RRD cache sweeper thread not started\n");
+    }
+
     cache_initialized = 1;
-    pthread_mutex_unlock(&cache_mutex);
 }
 
 MetricData* rrd_cache_get(const char *rrd_path, int period) {
@@ -108,91 +326,189 @@ MetricData* rrd_cache_get(const char *rrd_path, int period) {
 
     char key[CACHE_KEY_SIZE];
     build_cache_key(key, sizeof(key), rrd_path, period);
-    unsigned int slot = cache_hash(key);
+    unsigned int hash = cache_hash(key);
+    pthread_rwlock_t *lock = stripe_lock(hash);
 
-    pthread_mutex_lock(&cache_mutex);
-    cache_entry_t *entry = cache_slots[slot];
+    pthread_rwlock_rdlock(lock);
+    if (!cache_table) {
+        pthread_rwlock_unlock(lock);
+        return NULL;
+    }
+    cache_entry_t *entry = cache_table[hash & (cache_nbuckets - 1)];
 
     while (entry) {
-        if (strcmp(entry->key, key) == 0) {
+        if (entry->hash == hash && strcmp(entry->key, key) == 0) {
             if (entry->expires_at > time(NULL)) {
-                /* Cache hit - return clone for thread safety */
-                MetricData *result = clone_metric_data(entry->data);
-                pthread_mutex_unlock(&cache_mutex);
+                /* Cache hit - share the immutable data. The reference is
+                 * taken under the lock, so a concurrent put cannot free it.
+                 * The CLOCK bit is only written when clear, so a hot key
+                 * does not bounce its cache line between readers. */
+                if (!__atomic_load_n(&entry->referenced, __ATOMIC_RELAXED)) {
+                    __atomic_store_n(&entry->referenced, 1, __ATOMIC_RELAXED);
+                }
+                MetricData *result = metric_data_retain(entry->data);
+                pthread_rwlock_unlock(lock);
                 return result;
             }
-            /* Expired entry - will be replaced on next put */
+            /* Expired entry - replaced on next put or removed by the sweeper */
             break;
         }
         entry = entry->next;
     }
 
-    pthread_mutex_unlock(&cache_mutex);
+    pthread_rwlock_unlock(lock);
     return NULL;
 }
 
+MetricData* rrd_cache_get_stale(const char *rrd_path, int period) {
+    if (!cache_initialized || !rrd_path) return NULL;
+
+    char key[CACHE_KEY_SIZE];
+    build_cache_key(key, sizeof(key), rrd_path, period);
+    unsigned int hash = cache_hash(key);
+    pthread_rwlock_t *lock = stripe_lock(hash);
+
+    MetricData *result = NULL;
+    pthread_rwlock_rdlock(lock);
+    if (cache_table) {
+        cache_entry_t *entry = cache_table[hash & (cache_nbuckets - 1)];
+        while (entry && (entry->hash != hash || strcmp(entry->key, key) != 0)) {
+            entry = entry->next;
+        }
+        if (entry && entry->keep_until > time(NULL)) {
+            result = metric_data_retain(entry->data);
+            __atomic_add_fetch(&cache_stale_hits, 1, __ATOMIC_RELAXED);
+        }
+    }
+    pthread_rwlock_unlock(lock);
+    return result;
+}
+
 void rrd_cache_put(const char *rrd_path, int period, MetricData *data) {
-    if (!cache_initialized || !data || !rrd_path) return;
+    if (!data) return;
+    if (!cache_initialized || !rrd_path) {
+        metric_data_release(data);  /* ownership was transferred */
+        return;
+    }
 
     char key[CACHE_KEY_SIZE];
     build_cache_key(key, sizeof(key), rrd_path, period);
-    unsigned int slot = cache_hash(key);
+    unsigned int hash = cache_hash(key);
+    size_t key_len = strlen(key);
+    size_t bytes = sizeof(cache_entry_t) + key_len + 1 + metric_data_bytes(data);
+
+    if (cache_max_bytes) {
+        if (bytes > cache_max_bytes) {
+            /* Larger than the whole budget: serve it uncached */
+            metric_data_release(data);
+            return;
+        }
+        /* Make room before inserting so the new entry is never the victim.
+         * Concurrent puts may overshoot the budget by one entry each. */
+        cache_make_room(bytes);
+    }
 
-    pthread_mutex_lock(&cache_mutex);
+    pthread_rwlock_t *lock = stripe_lock(hash);
+    pthread_rwlock_wrlock(lock);
+    if (!cache_table) {
+        pthread_rwlock_unlock(lock);
+        metric_data_release(data);
+        return;
+    }
 
     /* Look for existing entry */
-    cache_entry_t *entry = cache_slots[slot];
-    cache_entry_t *prev = NULL;
+    cache_entry_t **head = &cache_table[hash & (cache_nbuckets - 1)];
+    cache_entry_t *entry = *head;
 
     while (entry) {
-        if (strcmp(entry->key, key) == 0) {
-            /* Update existing entry */
-            free_metric_data(entry->data);
+        if (entry->hash == hash && strcmp(entry->key, key) == 0) {
+            /* Update existing entry; the cache's reference to the old data
+             * is dropped after unlock (readers may still hold their own) */
+            MetricData *old = entry->data;
+            __atomic_add_fetch(&cache_bytes, bytes - entry->bytes, __ATOMIC_RELAXED);
             entry->data = data;
-            entry->expires_at = time(NULL) + cache_ttl_seconds;
-            pthread_mutex_unlock(&cache_mutex);
+            entry->bytes = bytes;
+            set_expiry(entry, data);
+            pthread_rwlock_unlock(lock);
+            metric_data_release(old);
             return;
         }
-        prev = entry;
         entry = entry->next;
     }
 
-    /* Create new entry */
+    /* Create new entry; it must be hit once to survive the next CLOCK pass */
     entry = malloc(sizeof(cache_entry_t));
-    if (!entry) {
-        pthread_mutex_unlock(&cache_mutex);
+    char *key_copy = entry ? malloc(key_len + 1) : NULL;
+    if (!key_copy) {
+        pthread_rwlock_unlock(lock);
+        free(entry);
+        metric_data_release(data);  /* ownership was transferred */
         return;
     }
+    memcpy(key_copy, key, key_len + 1);
 
-    strncpy(entry->key, key, CACHE_KEY_SIZE - 1);
-    entry->key[CACHE_KEY_SIZE - 1] = '\0';
+    entry->key = key_copy;
+    entry->hash = hash;
     entry->data = data;
-    entry->expires_at = time(NULL) + cache_ttl_seconds;
-    entry->next = NULL;
+    entry->bytes = bytes;
+    set_expiry(entry, data);
+    entry->referenced = 0;
+    entry->next = *head;
+    *head = entry;
 
-    if (prev) {
-        prev->next = entry;
-    } else {
-        cache_slots[slot] = entry;
+    size_t count = __atomic_add_fetch(&cache_entries, 1, __ATOMIC_RELAXED);
+    __atomic_add_fetch(&cache_bytes, bytes, __ATOMIC_RELAXED);
+    size_t nbuckets = cache_nbuckets;
+    pthread_rwlock_unlock(lock);
+
+    if (count > nbuckets * CACHE_LOAD_FACTOR && nbuckets < CACHE_MAX_BUCKETS) {
+        cache_grow();
     }
+}
 
-    pthread_mutex_unlock(&cache_mutex);
+void rrd_cache_stats(rrd_cache_stats_t *out) {
+    if (!out) return;
+    out->entries = __atomic_load_n(&cache_entries, __ATOMIC_RELAXED);
+    out->bytes = __atomic_load_n(&cache_bytes, __ATOMIC_RELAXED);
+    out->max_bytes = cache_max_bytes;
+    out->buckets = __atomic_load_n(&cache_nbuckets, __ATOMIC_RELAXED);
+    out->evictions = __atomic_load_n(&cache_evictions, __ATOMIC_RELAXED);
+    out->expirations = __atomic_load_n(&cache_expirations, __ATOMIC_RELAXED);
+    out->stale_hits = __atomic_load_n(&cache_stale_hits, __ATOMIC_RELAXED);
 }
 
 void rrd_cache_free(void) {
-    pthread_mutex_lock(&cache_mutex);
+    pthread_once(&cache_locks_once, init_stripe_locks);
+    cache_initialized = 0;
 
-    for (int i = 0; i < CACHE_MAX_ENTRIES; i++) {
-        cache_entry_t *entry = cache_slots[i];
-        while (entry) {
-            cache_entry_t *next = entry->next;
-            if (entry->data) free_metric_data(entry->data);
-            free(entry);
-            entry = next;
+    if (sweeper_running) {
+        pthread_mutex_lock(&sweeper_lock);
+        sweeper_stop = 1;
+        pthread_cond_signal(&sweeper_cond);
+        pthread_mutex_unlock(&sweeper_lock);
+        pthread_join(sweeper_thread, NULL);
+        sweeper_running = 0;
+    }
+
+    pthread_mutex_lock(&cache_evict_lock);
+    for (int i = 0; i < CACHE_LOCK_STRIPES; i++) {
+        pthread_rwlock_wrlock(&cache_stripes[i].lock);
+    }
+
+    cache_entry_t *dead = NULL;
+    for (size_t b = 0; cache_table && b < cache_nbuckets; b++) {
+        while (cache_table[b]) {
+            unlink_entry(&cache_table[b], cache_table[b], &dead);
         }
-        cache_slots[i] = NULL;
     }
+    free(cache_table);
+    cache_table = NULL;
+    cache_nbuckets = 0;
 
-    cache_initialized = 0;
-    pthread_mutex_unlock(&cache_mutex);
+    for (int i = CACHE_LOCK_STRIPES - 1; i >= 0; i--) {
+        pthread_rwlock_unlock(&cache_stripes[i].lock);
+    }
+    pthread_mutex_unlock(&cache_evict_lock);
+
+    free_dead(dead);
 }
@@ -0,0 +1,164 @@
+/**
+ * @file decimate.c
+ * @brief M4 / LTTB point decimation (see decimate.h)
+ */
+
+#include "../include/rrd/decimate.h"
+#include <stdlib.h>
+#include <string.h>
+
+int decimate_mode_parse(const char *name, decimate_mode_t *out) {
+    if (!name || !out) return -1;
+    if (name[0] == '\0' || strcmp(name, "none") == 0) *out = DECIMATE_NONE;
+    else if (strcmp(name, "m4") == 0) *out = DECIMATE_M4;
+    else if (strcmp(name, "lttb") == 0) *out = DECIMATE_LTTB;
+    else return -1;
+    return 0;
+}
+
+int decimate_max_points(int svg_width) {
+    /* Same margins as generateSVG() in generate_svg.js */
+    int left = svg_width * 8 / 100 > 50 ? svg_width * 8 / 100 : 50;
+    int right = svg_width * 5 / 100 > 30 ? svg_width * 5 / 100 : 30;
+    int plot = svg_width - left - right;
+    if (plot < 50) plot = 50;
+    return 2 * plot;
+}
+
+/* Append the bucket's first/min/max/last points in time order, once each */
+static int m4_emit(const DataPoint *in, int first, int lo, int hi, int last, DataPoint *out) {
+    int idx[4] = { first, lo, hi, last };
+    for (int i = 1; i < 4; i++) {
+        for (int j = i; j > 0 && idx[j] < idx[j - 1]; j--) {
+            int t = idx[j]; idx[j] = idx[j - 1]; idx[j - 1] = t;
+        }
+    }
+    int k = 0;
+    for (int i = 0; i < 4; i++) {
+        if (i > 0 && idx[i] == idx[i - 1]) continue;
+        out[k++] = in[idx[i]];
+    }
+    return k;
+}
+
+int decimate_m4(const DataPoint *in, int n, DataPoint *out, int max_points) {
+    if (n <= max_points || max_points < 4) {
+        memcpy(out, in, (size_t)(n > 0 ? n : 0) * sizeof(DataPoint));
+        return n > 0 ? n : 0;
+    }
+
+    int buckets = max_points / 4;
+    double t0 = (double)in[0].timestamp;
+    double span = (double)in[n - 1].timestamp - t0 + 1;
+    int k = 0;
+
+    int bucket = -1, first = 0, lo = 0, hi = 0;
+    for (int i = 0; i < n; i++) {
+        int b = (int)(((double)in[i].timestamp - t0) * buckets / span);
+        if (b >= buckets) b = buckets - 1;
+        if (b != bucket) {
+            if (bucket >= 0) k += m4_emit(in, first, lo, hi, i - 1, out + k);
+            bucket = b;
+            first = lo = hi = i;
+            continue;
+        }
+        if (in[i].value < in[lo].value) lo = i;
+        if (in[i].value > in[hi].value) hi = i;
+    }
+    k += m4_emit(in, first, lo, hi, n - 1, out + k);
+    return k;
+}
+
+int decimate_lttb(const DataPoint *in, int n, DataPoint *out, int max_points) {
+    if (n <= max_points || max_points < 3) {
+        memcpy(out, in, (size_t)(n > 0 ? n : 0) * sizeof(DataPoint));
+        return n > 0 ? n : 0;
+    }
+
+    /* x relative to the first point keeps the areas exact in doubles */
+    double t0 = (double)in[0].timestamp;
+    double every = (double)(n - 2) / (max_points - 2);
+    int a = 0, k = 0;
+    out[k++] = in[0];
+
+    for (int i = 0; i < max_points - 2; i++) {
+        /* Average of the next bucket is the third triangle vertex */
+        int next_from = (int)((i + 1) * every) + 1;
+        int next_to = (int)((i + 2) * every) + 1;
+        if (next_to > n) next_to = n;
+        double avg_x = 0, avg_y = 0;
+        for (int j = next_from; j < next_to; j++) {
+            avg_x += (double)in[j].timestamp - t0;
+            avg_y += in[j].value;
+        }
+        int len = next_to - next_from;
+        if (len > 0) {
+            avg_x /= len;
+            avg_y /= len;
+        }
+
+        int from = (int)(i * every) + 1;
+        int to = (int)((i + 1) * every) + 1;
+        double ax = (double)in[a].timestamp - t0, ay = in[a].value;
+        double best_area = -1;
+        int best = from;
+        for (int j = from; j < to; j++) {
+            double area = (ax - avg_x) * (in[j].value - ay) -
+                          (ax - ((double)in[j].timestamp - t0)) * (avg_y - ay);
+            if (area < 0) area = -area;
+            if (area > best_area) {
+                best_area = area;
+                best = j;
+            }
+        }
+        out[k++] = in[best];
+        a = best;
+    }
+
+    out[k++] = in[n - 1];
+    return k;
+}
+
+MetricData* metric_data_decimate(MetricData *data, decimate_mode_t mode, int max_points) {
+    if (!data || mode == DECIMATE_NONE) return data;
+    if (max_points < 4) max_points = 4;
+
+    int needed = 0;
+    for (int s = 0; s < data->series_count; s++) {
+        if (data->series_counts[s] > max_points) needed = 1;
+    }
+    if (!needed) return data;
+
+    MetricData *md = calloc(1, sizeof(MetricData));
+    if (!md) return data;
+    md->series_count = data->series_count;
+    md->series_names = calloc(md->series_count, sizeof(char*));
+    md->series_data = calloc(md->series_count, sizeof(DataPoint*));
+    md->series_counts = calloc(md->series_count, sizeof(int));
+    md->param1 = strdup(data->param1 ? data->param1 : "");
+    md->metric_config = data->metric_config;
+    /* Not extendable by rrd_fetch_delta: points were dropped */
+    md->fetch_step = 0;
+    if (!md->series_names || !md->series_data || !md->series_counts || !md->param1) {
+        md->series_count = 0;
+        metric_data_release(md);
+        return data;
+    }
+
+    for (int s = 0; s < md->series_count; s++) {
+        int n = data->series_counts[s];
+        int cap = n < max_points ? n : max_points;
+        md->series_names[s] = strdup(data->series_names[s]);
+        md->series_data[s] = malloc((size_t)(cap > 0 ? cap : 1) * sizeof(DataPoint));
+        if (!md->series_names[s] || !md->series_data[s]) {
+            metric_data_release(md);
+            return data;
+        }
+        md->series_counts[s] = mode == DECIMATE_LTTB
+            ? decimate_lttb(data->series_data[s], n, md->series_data[s], max_points)
+            : decimate_m4(data->series_data[s], n, md->series_data[s], max_points);
+    }
+
+    metric_data_release(data);
+    return md;
+}
@@ -0,0 +1,231 @@
+/**
+ * @file js_heap.c
+ * @brief Pooled allocator and byte ceiling for per-thread Duktape heaps
+ *
+ * Every block carries a 16-byte header with its usable size and size class,
+ * so free() and realloc() (which Duktape calls without a size) know where
+ * the block belongs. Pooled blocks are never returned to malloc while the
+ * heap lives; chunks are released together in js_heap_destroy().
+ */
+
+#include "../include/rrd/js_heap.h"
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+
+#define JS_HEAP_CLASSES 9                   /* 16 B .. 4 KiB */
+#define JS_HEAP_MIN_SIZE 16
+#define JS_HEAP_MAX_POOLED (JS_HEAP_MIN_SIZE << (JS_HEAP_CLASSES - 1))
+#define JS_HEAP_CHUNK_SIZE (64 * 1024)
+#define JS_HEAP_LARGE ((size_t)-1)
+
+typedef struct {
+    size_t size;                    /* Bytes charged: class size, or exact size */
+    size_t cls;                     /* Size class, JS_HEAP_LARGE for malloc'd blocks */
+} __attribute__((aligned(16))) block_hdr_t;
+
+typedef struct free_block {
+    struct free_block *next;
+} free_block_t;
+
+typedef struct chunk {
+    struct chunk *next;
+} __attribute__((aligned(16))) chunk_t;
+
+struct js_heap {
+    duk_context *ctx;
+    free_block_t *free_list[JS_HEAP_CLASSES];
+    chunk_t *chunks;
+    char *bump;                     /* Uncarved rest of the newest chunk */
+    char *bump_end;
+    size_t bytes;                   /* Live bytes (atomic: read by js_heap_stats) */
+    size_t gc_mark;                 /* bytes after the last forced GC */
+    struct js_heap *prev, *next;    /* Registry of live heaps */
+};
+
+static size_t heap_max_bytes = 0;
+static size_t heap_gc_bytes = 0;
+
+/* Registry for js_heap_stats(); counters updated with __atomic builtins */
+static pthread_mutex_t registry_lock = PTHREAD_MUTEX_INITIALIZER;
+static js_heap_t *registry = NULL;
+static unsigned long forced_gcs = 0;
+static unsigned long limit_failures = 0;
+
+void js_heap_set_limits(size_t max_bytes, size_t gc_bytes) {
+    heap_max_bytes = max_bytes;
+    heap_gc_bytes = gc_bytes;
+}
+
+/* Smallest class holding size, -1 if larger than the pooled maximum */
+static int size_class(size_t size) {
+    if (size > JS_HEAP_MAX_POOLED) return -1;
+    int cls = 0;
+    while ((size_t)(JS_HEAP_MIN_SIZE << cls) < size) cls++;
+    return cls;
+}
+
+static void charge(js_heap_t *h, size_t add, size_t sub) {
+    size_t bytes = __atomic_load_n(&h->bytes, __ATOMIC_RELAXED);
+    __atomic_store_n(&h->bytes, bytes + add - sub, __ATOMIC_RELAXED);
+}
+
+/* 1 if add more bytes would cross the ceiling */
+static int over_limit(js_heap_t *h, size_t add) {
+    if (!heap_max_bytes || __atomic_load_n(&h->bytes, __ATOMIC_RELAXED) + add <= heap_max_bytes) {
+        return 0;
+    }
+    __atomic_add_fetch(&limit_failures, 1, __ATOMIC_RELAXED);
+    return 1;
+}
+
+static block_hdr_t *pool_take(js_heap_t *h, int cls) {
+    free_block_t *fb = h->free_list[cls];
+    if (fb) {
+        h->free_list[cls] = fb->next;
+        return (block_hdr_t *)fb - 1;
+    }
+
+    size_t need = sizeof(block_hdr_t) + ((size_t)JS_HEAP_MIN_SIZE << cls);
+    if ((size_t)(h->bump_end - h->bump) < need) {
+        chunk_t *c = malloc(JS_HEAP_CHUNK_SIZE);
+        if (!c) return NULL;
+        c->next = h->chunks;
+        h->chunks = c;
+        h->bump = (char *)(c + 1);
+        h->bump_end = (char *)c + JS_HEAP_CHUNK_SIZE;
+    }
+    block_hdr_t *b = (block_hdr_t *)h->bump;
+    h->bump += need;
+    return b;
+}
+
+static void *heap_alloc(void *udata, duk_size_t size) {
+    js_heap_t *h = udata;
+    int cls = size_class(size ? size : 1);
+    size_t bytes = cls >= 0 ? (size_t)JS_HEAP_MIN_SIZE << cls : size;
+    if (over_limit(h, bytes)) return NULL;
+
+    block_hdr_t *b = cls >= 0 ? pool_take(h, cls) : malloc(sizeof(block_hdr_t) + size);
+    if (!b) return NULL;
+    b->size = bytes;
+    b->cls = cls >= 0 ? (size_t)cls : JS_HEAP_LARGE;
+    charge(h, bytes, 0);
+    return b + 1;
+}
+
+static void heap_free(void *udata, void *ptr) {
+    if (!ptr) return;
+    js_heap_t *h = udata;
+    block_hdr_t *b = (block_hdr_t *)ptr - 1;
+    charge(h, 0, b->size);
+    if (b->cls == JS_HEAP_LARGE) {
+        free(b);
+    } else {
+        free_block_t *fb = ptr;
+        fb->next = h->free_list[b->cls];
+        h->free_list[b->cls] = fb;
+    }
+}
+
+static void *heap_realloc(void *udata, void *ptr, duk_size_t size) {
+    js_heap_t *h = udata;
+    if (!ptr) return heap_alloc(udata, size);
+    if (size == 0) {
+        heap_free(udata, ptr);
+        return NULL;
+    }
+
+    block_hdr_t *b = (block_hdr_t *)ptr - 1;
+    if (b->cls != JS_HEAP_LARGE) {
+        /* Still the same class: nothing to do */
+        if (size <= b->size && (b->cls == 0 || size > b->size / 2)) return ptr;
+    } else if (size > JS_HEAP_MAX_POOLED) {
+        if (size > b->size && over_limit(h, size - b->size)) return NULL;
+        size_t old = b->size;
+        block_hdr_t *nb = realloc(b, sizeof(block_hdr_t) + size);
+        if (!nb) return NULL;
+        nb->size = size;
+        charge(h, size, old);
+        return nb + 1;
+    }
+
+    void *np = heap_alloc(udata, size);
+    if (!np) return NULL;
+    memcpy(np, ptr, b->size < size ? b->size : size);
+    heap_free(udata, ptr);
+    return np;
+}
+
+duk_context *js_heap_create(js_heap_t **out) {
+    js_heap_t *h = calloc(1, sizeof(*h));
+    if (!h) return NULL;
+
+    h->ctx = duk_create_heap(heap_alloc, heap_realloc, heap_free, h, NULL);
+    if (!h->ctx) {
+        for (chunk_t *c = h->chunks, *next; c; c = next) {
+            next = c->next;
+            free(c);
+        }
+        free(h);
+        return NULL;
+    }
+    h->gc_mark = js_heap_bytes(h);
+
+    pthread_mutex_lock(&registry_lock);
+    h->next = registry;
+    if (registry) registry->prev = h;
+    registry = h;
+    pthread_mutex_unlock(&registry_lock);
+
+    *out = h;
+    return h->ctx;
+}
+
+void js_heap_destroy(js_heap_t *h) {
+    if (!h) return;
+    pthread_mutex_lock(&registry_lock);
+    if (h->prev) h->prev->next = h->next;
+    else registry = h->next;
+    if (h->next) h->next->prev = h->prev;
+    pthread_mutex_unlock(&registry_lock);
+
+    duk_destroy_heap(h->ctx);
+    for (chunk_t *c = h->chunks, *next; c; c = next) {
+        next = c->next;
+        free(c);
+    }
+    free(h);
+}
+
+void js_heap_maybe_gc(js_heap_t *h) {
+    if (!h || !heap_gc_bytes) return;
+    size_t bytes = js_heap_bytes(h);
+    if (bytes < h->gc_mark) {
+        h->gc_mark = bytes;         /* Shrank on its own: measure growth from here */
+    } else if (bytes - h->gc_mark > heap_gc_bytes) {
+        duk_gc(h->ctx, 0);
+        __atomic_add_fetch(&forced_gcs, 1, __ATOMIC_RELAXED);
+        h->gc_mark = js_heap_bytes(h);
+    }
+}
+
+size_t js_heap_bytes(const js_heap_t *h) {
+    return __atomic_load_n(&h->bytes, __ATOMIC_RELAXED);
+}
+
+void js_heap_stats(js_heap_stats_t *out) {
+    memset(out, 0, sizeof(*out));
+    out->max_bytes = heap_max_bytes;
+    out->forced_gcs = __atomic_load_n(&forced_gcs, __ATOMIC_RELAXED);
+    out->limit_failures = __atomic_load_n(&limit_failures, __ATOMIC_RELAXED);
+
+    pthread_mutex_lock(&registry_lock);
+    for (js_heap_t *h = registry; h; h = h->next) {
+        size_t bytes = js_heap_bytes(h);
+        if (out->heaps < JS_HEAP_STATS_THREADS) out->thread_bytes[out->heaps] = bytes;
+        out->heaps++;
+        out->bytes += bytes;
+    }
+    pthread_mutex_unlock(&registry_lock);
+}
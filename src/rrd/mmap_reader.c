@@ -0,0 +1,433 @@
+/**
+ * @file mmap_reader.c
+ * @brief Native read-only RRD reader over mmap
+ *
+ * One mapping per RRD path, kept until the file is replaced (different
+ * device, inode or size) or rrd_mmap_free(). Updates by rrdtool/rrdcached
+ * write into the same file and are visible through the shared mapping, so
+ * only the live head and RRA pointers are re-read per fetch. Files that are
+ * not in the native format are remembered as unsupported so the caller's
+ * librrd fallback does not pay for a mapping attempt every time.
+ *
+ * Readers hold the read lock while copying out of a mapping; remapping takes
+ * the write lock, so no mapping is unmapped under a reader. RRD files are
+ * never truncated in place (rrdtool resize writes a new file), which would
+ * otherwise fault a reader with SIGBUS.
+ */
+
+#include "../include/rrd/mmap_reader.h"
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#define RRD_MAP_BUCKETS 64
+#define RRD_MAP_MAX_DS 4096
+#define RRD_MAP_MAX_RRA 4096
+
+/* On-disk layout, mirrors librrd's rrd_format.h (native word size and
+ * alignment, as librrd writes it) */
+#define RRD_FLOAT_COOKIE ((double)8.642135E130)
+#define RRD_DS_NAM_SIZE 20
+
+typedef union {
+    unsigned long u_cnt;
+    double u_val;
+} rrd_unival_t;
+
+typedef struct {
+    char cookie[4];
+    char version[5];
+    double float_cookie;
+    unsigned long ds_cnt;
+    unsigned long rra_cnt;
+    unsigned long pdp_step;
+    rrd_unival_t par[10];
+} rrd_stat_head_t;
+
+typedef struct {
+    char ds_nam[RRD_DS_NAM_SIZE];
+    char dst[20];
+    rrd_unival_t par[10];
+} rrd_ds_def_t;
+
+typedef struct {
+    char cf_nam[20];
+    unsigned long row_cnt;
+    unsigned long pdp_cnt;
+    rrd_unival_t par[10];
+} rrd_rra_def_t;
+
+typedef struct {
+    time_t last_up;
+    long last_up_usec;  /* Absent before format version 3 */
+} rrd_live_head_t;
+
+typedef struct {
+    char last_ds[30];
+    rrd_unival_t scratch[10];
+} rrd_pdp_prep_t;
+
+typedef struct {
+    rrd_unival_t scratch[10];
+} rrd_cdp_prep_t;
+
+/* Mapping of one RRD file; base == NULL marks an unsupported file */
+typedef struct rrd_map {
+    char *path;
+    dev_t dev;
+    ino_t ino;
+    off_t size;
+    void *base;
+    size_t len;
+    const rrd_stat_head_t *head;
+    const rrd_ds_def_t *ds;
+    const rrd_rra_def_t *rra;
+    const time_t *last_up;
+    const unsigned long *cur_row;
+    const double *values;           /* Start of the first RRA's rows */
+    struct rrd_map *next;
+} rrd_map_t;
+
+/* Global map state */
+static rrd_map_t *map_slots[RRD_MAP_BUCKETS] = {0};
+static pthread_rwlock_t map_lock = PTHREAD_RWLOCK_INITIALIZER;
+
+/* Simple DJB2 hash function */
+static unsigned int map_hash(const char *key) {
+    unsigned int hash = 5381;
+    int c;
+    while ((c = *key++)) {
+        hash = ((hash << 5) + hash) + c;
+    }
+    return hash % RRD_MAP_BUCKETS;
+}
+
+static rrd_map_t *find_map(const char *path) {
+    rrd_map_t *m = map_slots[map_hash(path)];
+    while (m && strcmp(m->path, path) != 0) m = m->next;
+    return m;
+}
+
+static int same_file(const rrd_map_t *m, const struct stat *st) {
+    return m->dev == st->st_dev && m->ino == st->st_ino && m->size == st->st_size;
+}
+
+/* Validate the header and locate the sections; 0 if the file is usable */
+static int parse_header(rrd_map_t *m) {
+    const char *p = m->base;
+    if (m->len < sizeof(rrd_stat_head_t)) return -1;
+
+    const rrd_stat_head_t *head = (const rrd_stat_head_t *)p;
+    if (memcmp(head->cookie, "RRD", 4) != 0 || head->version[4] != '\0') return -1;
+    int version = atoi(head->version);
+    if (version < 1 || version > 5) return -1;
+    if (head->float_cookie != RRD_FLOAT_COOKIE) return -1;  /* Foreign architecture */
+    if (head->ds_cnt == 0 || head->ds_cnt > RRD_MAP_MAX_DS ||
+        head->rra_cnt == 0 || head->rra_cnt > RRD_MAP_MAX_RRA || head->pdp_step == 0) {
+        return -1;
+    }
+
+    size_t ds_cnt = head->ds_cnt;
+    size_t rra_cnt = head->rra_cnt;
+    size_t off = sizeof(rrd_stat_head_t);
+    size_t ds_off = off;
+    off += ds_cnt * sizeof(rrd_ds_def_t);
+    size_t rra_off = off;
+    off += rra_cnt * sizeof(rrd_rra_def_t);
+    if (off > m->len) return -1;
+
+    const rrd_rra_def_t *rra = (const rrd_rra_def_t *)(p + rra_off);
+    size_t live_off = off;
+    off += version < 3 ? sizeof(time_t) : sizeof(rrd_live_head_t);
+    off += ds_cnt * sizeof(rrd_pdp_prep_t);
+    off += rra_cnt * ds_cnt * sizeof(rrd_cdp_prep_t);
+    size_t ptr_off = off;
+    off += rra_cnt * sizeof(unsigned long);
+    if (off > m->len) return -1;
+
+    size_t rows = 0;
+    for (size_t i = 0; i < rra_cnt; i++) {
+        if (rra[i].row_cnt == 0 || rra[i].pdp_cnt == 0) return -1;
+        if (rra[i].row_cnt > (m->len - off) / sizeof(double)) return -1;
+        rows += rra[i].row_cnt;
+        if (rows > (m->len - off) / sizeof(double) / ds_cnt) return -1;
+    }
+
+    m->head = head;
+    m->ds = (const rrd_ds_def_t *)(p + ds_off);
+    m->rra = rra;
+    m->last_up = (const time_t *)(p + live_off);
+    m->cur_row = (const unsigned long *)(p + ptr_off);
+    m->values = (const double *)(p + off);
+    return 0;
+}
+
+/* Map and parse a file outside the lock; m->base stays NULL if unsupported.
+ * Returns -1 only if the file cannot be opened. */
+static int map_open(const char *filename, rrd_map_t *m) {
+    memset(m, 0, sizeof(*m));
+    int fd = open(filename, O_RDONLY | O_CLOEXEC);
+    if (fd < 0) return -1;
+
+    struct stat st;
+    if (fstat(fd, &st) != 0) {
+        close(fd);
+        return -1;
+    }
+    m->dev = st.st_dev;
+    m->ino = st.st_ino;
+    m->size = st.st_size;
+
+    if (st.st_size > 0) {
+        void *base = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+        if (base != MAP_FAILED) {
+            m->base = base;
+            m->len = (size_t)st.st_size;
+            if (parse_header(m) != 0) {
+                munmap(base, m->len);
+                m->base = NULL;
+                m->len = 0;
+            }
+        }
+    }
+    close(fd);
+    return 0;
+}
+
+/* Install a fresh mapping for path, replacing a stale one */
+static void map_install(const char *path, rrd_map_t *fresh) {
+    pthread_rwlock_wrlock(&map_lock);
+
+    rrd_map_t *m = find_map(path);
+    if (m && m->dev == fresh->dev && m->ino == fresh->ino && m->size == fresh->size) {
+        /* Another thread got there first */
+        if (fresh->base) munmap(fresh->base, fresh->len);
+    } else if (m) {
+        if (m->base) munmap(m->base, m->len);
+        fresh->path = m->path;
+        fresh->next = m->next;
+        *m = *fresh;
+    } else {
+        m = malloc(sizeof(rrd_map_t));
+        char *path_copy = m ? strdup(path) : NULL;
+        if (!path_copy) {
+            free(m);
+            if (fresh->base) munmap(fresh->base, fresh->len);
+        } else {
+            unsigned int slot = map_hash(path);
+            *m = *fresh;
+            m->path = path_copy;
+            m->next = map_slots[slot];
+            map_slots[slot] = m;
+        }
+    }
+
+    pthread_rwlock_unlock(&map_lock);
+}
+
+/* Look up the current mapping of filename. On success returns with the read
+ * lock held (release with map_release); NULL if unreadable or unsupported. */
+static const rrd_map_t *map_acquire(const char *filename) {
+    if (!filename) return NULL;
+
+    for (int attempt = 0; attempt < 2; attempt++) {
+        struct stat st;
+        if (stat(filename, &st) != 0) return NULL;
+
+        pthread_rwlock_rdlock(&map_lock);
+        const rrd_map_t *m = find_map(filename);
+        if (m && same_file(m, &st)) {
+            if (m->base) return m;
+            pthread_rwlock_unlock(&map_lock);
+            return NULL;
+        }
+        pthread_rwlock_unlock(&map_lock);
+
+        rrd_map_t fresh;
+        if (map_open(filename, &fresh) != 0) return NULL;
+        map_install(filename, &fresh);
+    }
+    return NULL;  /* Replaced again while mapping; let the caller use librrd */
+}
+
+static void map_release(void) {
+    pthread_rwlock_unlock(&map_lock);
+}
+
+/* RRA choice of rrd_fetch_r: among RRAs of the requested CF, prefer one that
+ * covers the whole window with the step closest to the desired one, else the
+ * one covering the most of it */
+static int choose_rra(const rrd_map_t *m, const char *cf, time_t last_up,
+                      time_t start, time_t end, unsigned long step) {
+    unsigned long pdp_step = m->head->pdp_step;
+    int best_full = -1, best_part = -1;
+    long best_full_diff = 0, best_part_diff = 0;
+    time_t best_match = 0;
+
+    for (unsigned long i = 0; i < m->head->rra_cnt; i++) {
+        const rrd_rra_def_t *rra = &m->rra[i];
+        if (strncmp(rra->cf_nam, cf, sizeof(rra->cf_nam)) != 0) continue;
+
+        time_t rra_step = (time_t)(rra->pdp_cnt * pdp_step);
+        time_t cal_end = last_up - last_up % rra_step;
+        time_t cal_start = cal_end - (time_t)(rra->pdp_cnt * rra->row_cnt * pdp_step);
+        long step_diff = labs((long)step - (long)pdp_step * (long)rra->pdp_cnt);
+
+        if (cal_start <= start) {
+            if (best_full < 0 || step_diff < best_full_diff) {
+                best_full = (int)i;
+                best_full_diff = step_diff;
+            }
+        } else {
+            time_t match = (end - start) - (cal_start - start);
+            if (best_part < 0 || best_match < match ||
+                (best_match == match && step_diff < best_part_diff)) {
+                best_part = (int)i;
+                best_match = match;
+                best_part_diff = step_diff;
+            }
+        }
+    }
+    return best_full >= 0 ? best_full : best_part;
+}
+
+/* Copy a window out of the mapping, rrd_fetch_r's row arithmetic */
+static int map_fetch(const rrd_map_t *m, const char *cf, time_t *start, time_t *end,
+                     unsigned long *step, unsigned long *ds_cnt, char ***ds_names,
+                     double **data) {
+    time_t last_up = *m->last_up;
+    int chosen = choose_rra(m, cf, last_up, *start, *end, *step);
+    if (chosen < 0) return -1;
+
+    const rrd_rra_def_t *rra = &m->rra[chosen];
+    unsigned long ds = m->head->ds_cnt;
+    long long row_cnt = (long long)rra->row_cnt;
+    unsigned long cur_row = m->cur_row[chosen];
+    if (cur_row >= rra->row_cnt) return -1;  /* Torn or corrupt header */
+
+    time_t out_step = (time_t)(m->head->pdp_step * rra->pdp_cnt);
+    time_t out_start = *start - *start % out_step;
+    time_t out_end = *end + (out_step - *end % out_step);
+    long long rows = (out_end - out_start) / out_step + 1;
+    if (rows <= 0) return -1;
+
+    char **names = malloc(ds * (sizeof(char *) + RRD_DS_NAM_SIZE));
+    double *values = malloc((size_t)rows * ds * sizeof(double));
+    if (!names || !values) {
+        free(names);
+        free(values);
+        return -1;
+    }
+    char *name_buf = (char *)(names + ds);
+    for (unsigned long i = 0; i < ds; i++) {
+        names[i] = name_buf + i * RRD_DS_NAM_SIZE;
+        memcpy(names[i], m->ds[i].ds_nam, RRD_DS_NAM_SIZE - 1);
+        names[i][RRD_DS_NAM_SIZE - 1] = '\0';
+    }
+
+    const double *rra_base = m->values;
+    for (int i = 0; i < chosen; i++) rra_base += m->rra[i].row_cnt * ds;
+
+    time_t rra_end = last_up - last_up % out_step;
+    time_t rra_start = rra_end - out_step * (time_t)(row_cnt - 1);
+    long long start_offset = ((long long)out_start + out_step - rra_start) / out_step;
+    long long end_offset = ((long long)rra_end - out_end) / out_step;
+    long long pointer = (long long)cur_row + 1 + (start_offset > 0 ? start_offset : 0);
+    pointer %= row_cnt;
+
+    double *out = values;
+    double *out_limit = values + rows * ds;
+    for (long long i = start_offset; i < row_cnt - end_offset && out < out_limit; i++) {
+        if (i < 0 || i >= row_cnt) {
+            /* Before the oldest or after the newest row */
+            for (unsigned long d = 0; d < ds; d++) out[d] = NAN;
+        } else {
+            if (pointer >= row_cnt) pointer -= row_cnt;
+            memcpy(out, rra_base + pointer * ds, ds * sizeof(double));
+            pointer++;
+        }
+        out += ds;
+    }
+
+    *start = out_start;
+    *end = out_end;
+    *step = (unsigned long)out_step;
+    *ds_cnt = ds;
+    *ds_names = names;
+    *data = values;
+    return 0;
+}
+
+int rrd_mmap_fetch(const char *filename, const char *cf, time_t *start, time_t *end,
+                   unsigned long *step, unsigned long *ds_cnt, char ***ds_names,
+                   double **data) {
+    if (!cf || !start || !end || !step || !ds_cnt || !ds_names || !data) return -1;
+    if (*start > *end) return -1;
+
+    const rrd_map_t *m = map_acquire(filename);
+    if (!m) return -1;
+    int status = map_fetch(m, cf, start, end, step, ds_cnt, ds_names, data);
+    map_release();
+    return status;
+}
+
+int rrd_mmap_layout(const char *filename, RRDLayout *layout) {
+    if (!layout) return -1;
+
+    const rrd_map_t *m = map_acquire(filename);
+    if (!m) return -1;
+
+    memset(layout, 0, sizeof(*layout));
+    layout->base_step = m->head->pdp_step;
+    layout->first_timestamp = -1;
+    for (unsigned long i = 0; i < m->head->rra_cnt && i < RRD_LAYOUT_MAX_RRAS; i++) {
+        RRDRraLayout r = {0};
+        r.pdp_per_row = m->rra[i].pdp_cnt;
+        r.rows = m->rra[i].row_cnt;
+        r.effective_step = r.pdp_per_row * layout->base_step;
+        if (r.effective_step > 1000000) continue;
+        strncpy(r.cf, m->rra[i].cf_nam, sizeof(r.cf) - 1);
+        r.index = (int)i;
+        layout->rras[layout->rra_count++] = r;
+    }
+
+    map_release();
+    return 0;
+}
+
+time_t rrd_mmap_first(const char *filename, int rra_index) {
+    const rrd_map_t *m = map_acquire(filename);
+    if (!m) return -1;
+
+    time_t first = -1;
+    if (rra_index >= 0 && (unsigned long)rra_index < m->head->rra_cnt) {
+        const rrd_rra_def_t *rra = &m->rra[rra_index];
+        time_t rra_step = (time_t)(rra->pdp_cnt * m->head->pdp_step);
+        time_t last_up = *m->last_up;
+        first = last_up - last_up % rra_step - (time_t)(rra->row_cnt - 1) * rra_step;
+    }
+
+    map_release();
+    return first;
+}
+
+void rrd_mmap_free(void) {
+    pthread_rwlock_wrlock(&map_lock);
+    for (int i = 0; i < RRD_MAP_BUCKETS; i++) {
+        rrd_map_t *m = map_slots[i];
+        while (m) {
+            rrd_map_t *next = m->next;
+            if (m->base) munmap(m->base, m->len);
+            free(m->path);
+            free(m);
+            m = next;
+        }
+        map_slots[i] = NULL;
+    }
+    pthread_rwlock_unlock(&map_lock);
+}
@@ -5,6 +5,9 @@
 
 #include "../include/rrd/reader.h"
 #include "../include/cfg.h"
+#include "../include/rrd/rra_cache.h"
+#include "../include/rrd/rrdc_pool.h"
+#include "../include/rrd/mmap_reader.h"
 #include <rrd.h>
 #include <rrd_client.h>
 #include <stdio.h>
@@ -12,7 +15,7 @@
 #include <string.h>
 #include <errno.h>
 #include <math.h>
-#include <unistd.h>
+#include <sys/stat.h>
 
 /* Чистая (без I/O) часть select_optimal_step: выбор шага по списку RRA.
  * Выделена из select_optimal_step для unit-тестирования; побайтово повторяет
@@ -63,123 +66,291 @@ unsigned long select_step_from_rras(const RRAStepInfo *rras, int rra_count,
     return optimal_step;
 }
 
-/* Select optimal step based on RRD file structure */
-static unsigned long select_optimal_step(const char *filename, time_t start, time_t end, int period) {
+/* Шаг под ширину графика: AVERAGE-архив, число точек которого ближе всего
+ * к окну [width, 2*width] (1–2 точки на пиксель). Расстояние — во сколько раз
+ * точек меньше width или больше 2*width; при равенстве берётся более грубый
+ * шаг. 0 = AVERAGE-архивов нет. */
+unsigned long select_step_for_width(const RRAStepInfo *rras, int rra_count,
+                                    time_t range, int width) {
+    unsigned long best_step = 0;
+    double best_miss = 0;
+    for (int i = 0; i < rra_count; i++) {
+        if (strcmp(rras[i].cf, "AVERAGE") != 0) continue;
+        unsigned long step = rras[i].effective_step;
+        if (step == 0) continue;
+
+        double num_points = (double)((range + step - 1) / step);
+        double miss = 1.0;
+        if (num_points < width) miss = width / num_points;
+        else if (num_points > 2.0 * width) miss = num_points / (2.0 * width);
+
+        if (best_step == 0 || miss < best_miss || (miss == best_miss && step > best_step)) {
+            best_step = step;
+            best_miss = miss;
+        }
+    }
+    return best_step;
+}
+
+#define DEFAULT_STEP 15
+
+static rrd_reader_backend_t reader_backend = RRD_READER_LIBRRD;
+
+int rrd_reader_backend_parse(const char *name, rrd_reader_backend_t *out) {
+    if (!name || !out) return -1;
+    if (strcmp(name, "librrd") == 0) *out = RRD_READER_LIBRRD;
+    else if (strcmp(name, "mmap") == 0) *out = RRD_READER_MMAP;
+    else return -1;
+    return 0;
+}
+
+void rrd_reader_set_backend(rrd_reader_backend_t backend) {
+    reader_backend = backend;
+}
+
+unsigned long select_step_for_layout(const RRDLayout *layout, time_t start,
+                                     time_t end, int period, int width) {
+    time_t first_timestamp = layout->first_timestamp;
+    if (first_timestamp == -1) first_timestamp = end - period;
+    if (start < first_timestamp) start = first_timestamp;
+
+    time_t range = end - start;
+    if (range <= 0) return DEFAULT_STEP;
+
+    /* Делегируем выбор шага чистой (тестируемой) функции: собираем массив
+     * RRAStepInfo и вызываем select_step_from_rras с теми же параметрами. */
+    RRAStepInfo step_rras[RRD_LAYOUT_MAX_RRAS] = {0};
+    for (int i = 0; i < layout->rra_count; i++) {
+        step_rras[i].pdp_per_row = layout->rras[i].pdp_per_row;
+        step_rras[i].effective_step = layout->rras[i].effective_step;
+        step_rras[i].cf = layout->rras[i].cf;
+    }
+    if (width > 0) {
+        unsigned long step = select_step_for_width(step_rras, layout->rra_count, range, width);
+        if (step) return step;
+    }
+    return select_step_from_rras(step_rras, layout->rra_count, range, period, DEFAULT_STEP);
+}
+
+/* Read base step and RRA table from the file header (mapped header or rrd_info_r) */
+static int load_rrd_layout(const char *filename, RRDLayout *layout) {
+    if (reader_backend == RRD_READER_MMAP && rrd_mmap_layout(filename, layout) == 0) {
+        return 0;
+    }
+
     rrd_info_t *info = rrd_info_r(filename);
-    const int default_step = 15;
-    if (!info) return default_step;
+    if (!info) return -1;
 
-    unsigned long base_step = default_step;
+    memset(layout, 0, sizeof(*layout));
+    layout->base_step = DEFAULT_STEP;
+    layout->first_timestamp = -1;
     for (rrd_info_t *ptr = info; ptr; ptr = ptr->next) {
         if (strcmp(ptr->key, "step") == 0) {
-            base_step = ptr->value.u_cnt;
+            layout->base_step = ptr->value.u_cnt;
             break;
         }
     }
 
-    typedef struct {
-        unsigned long pdp_per_row;
-        unsigned long rows;
-        unsigned long effective_step;
-        char *cf;
-        int index;
-    } RRAInfo;
-
-    RRAInfo rras[20] = {0};
-    int rra_count = 0;
-
+    /* rrd_info lists rra[i].cf before rra[i].pdp_per_row, so fields are
+     * collected by RRA index first and validated afterwards */
+    RRDRraLayout raw[RRD_LAYOUT_MAX_RRAS] = {0};
     for (rrd_info_t *ptr = info; ptr; ptr = ptr->next) {
-        if (strncmp(ptr->key, "rra[", 4) == 0) {
-            char *endptr;
-            errno = 0;
-            long rra_idx = strtol(ptr->key + 4, &endptr, 10);
-            if (errno != 0 || rra_idx < 0 || rra_idx >= 20 || *endptr != ']') continue;
-
-            if (strstr(ptr->key, ".pdp_per_row")) {
-                if (ptr->value.u_cnt == 0) continue;
-                rras[rra_count].pdp_per_row = ptr->value.u_cnt;
-                rras[rra_count].index = (int)rra_idx;
-            } else if (strstr(ptr->key, ".rows")) {
-                rras[rra_count].rows = ptr->value.u_cnt;
-            } else if (strstr(ptr->key, ".cf")) {
-                rras[rra_count].cf = strdup(ptr->value.u_str);
-                rras[rra_count].effective_step = rras[rra_count].pdp_per_row * base_step;
-                if (rras[rra_count].effective_step == 0 || rras[rra_count].effective_step > 1000000) {
-                    free(rras[rra_count].cf);
-                    rras[rra_count].cf = NULL;
-                    continue;
-                }
-                rra_count++;
-            }
+        if (strncmp(ptr->key, "rra[", 4) != 0) continue;
+
+        char *endptr;
+        errno = 0;
+        long rra_idx = strtol(ptr->key + 4, &endptr, 10);
+        if (errno != 0 || rra_idx < 0 || rra_idx >= RRD_LAYOUT_MAX_RRAS || *endptr != ']') continue;
+
+        RRDRraLayout *r = &raw[rra_idx];
+        if (strcmp(endptr, "].pdp_per_row") == 0) {
+            r->pdp_per_row = ptr->value.u_cnt;
+        } else if (strcmp(endptr, "].rows") == 0) {
+            r->rows = ptr->value.u_cnt;
+        } else if (strcmp(endptr, "].cf") == 0 && ptr->value.u_str) {
+            strncpy(r->cf, ptr->value.u_str, sizeof(r->cf) - 1);
         }
     }
+    rrd_info_free(info);
 
-    /* Find first available timestamp */
+    for (int i = 0; i < RRD_LAYOUT_MAX_RRAS; i++) {
+        RRDRraLayout *r = &raw[i];
+        if (r->pdp_per_row == 0 || r->cf[0] == '\0') continue;
+        r->effective_step = r->pdp_per_row * layout->base_step;
+        if (r->effective_step == 0 || r->effective_step > 1000000) continue;
+        r->index = i;
+        layout->rras[layout->rra_count++] = *r;
+    }
+    return 0;
+}
+
+/* First available AVERAGE timestamp, preferring the raw (pdp_per_row == 1)
+ * archive. Depends on the last update, so it is refreshed on every mtime
+ * change while the layout itself is reused. */
+static time_t layout_first_timestamp(const char *filename, const RRDLayout *layout) {
     time_t first_timestamp = -1;
-    for (int i = 0; i < rra_count; i++) {
-        if (strcmp(rras[i].cf, "AVERAGE") == 0 && (first_timestamp == -1 || rras[i].pdp_per_row == 1)) {
-            time_t ts = rrd_first_r(filename, rras[i].index);
+    for (int i = 0; i < layout->rra_count; i++) {
+        const RRDRraLayout *r = &layout->rras[i];
+        if (strcmp(r->cf, "AVERAGE") == 0 && (first_timestamp == -1 || r->pdp_per_row == 1)) {
+            time_t ts = reader_backend == RRD_READER_MMAP ? rrd_mmap_first(filename, r->index) : -1;
+            if (ts == -1) ts = rrd_first_r(filename, r->index);
             if (ts != -1) {
                 first_timestamp = ts;
-                if (rras[i].pdp_per_row == 1) break;
+                if (r->pdp_per_row == 1) break;
             }
         }
     }
-    if (first_timestamp == -1) first_timestamp = end - period;
-    if (start < first_timestamp) start = first_timestamp;
+    return first_timestamp;
+}
 
-    time_t range = end - start;
-    if (range <= 0) {
-        for (int i = 0; i < rra_count; i++) free(rras[i].cf);
-        rrd_info_free(info);
-        return default_step;
+/* Select optimal step based on RRD file structure. The layout comes from the
+ * RRA metadata cache when the file is unchanged, so a warm call is one stat()
+ * plus pure computation instead of rrd_info_r + rrd_first_r per RRA. */
+static unsigned long select_optimal_step(const char *filename, time_t start, time_t end,
+                                         int period, int width) {
+    RRDLayout layout;
+    struct stat st;
+    int have_stat = (stat(filename, &st) == 0);
+
+    rra_cache_status_t status = have_stat ? rra_cache_get(filename, &st, &layout) : RRA_CACHE_MISS;
+    if (status == RRA_CACHE_MISS && load_rrd_layout(filename, &layout) != 0) {
+        return DEFAULT_STEP;
+    }
+    if (status != RRA_CACHE_HIT) {
+        layout.first_timestamp = layout_first_timestamp(filename, &layout);
+        if (have_stat) rra_cache_put(filename, &st, &layout);
     }
 
-    /* Делегируем выбор шага чистой (тестируемой) функции: собираем массив
-     * RRAStepInfo и вызываем select_step_from_rras с теми же параметрами. */
-    RRAStepInfo step_rras[20] = {0};
-    for (int i = 0; i < rra_count; i++) {
-        step_rras[i].pdp_per_row = rras[i].pdp_per_row;
-        step_rras[i].effective_step = rras[i].effective_step;
-        step_rras[i].cf = rras[i].cf;
+    return select_step_for_layout(&layout, start, end, period, width);
+}
+
+unsigned long rrd_select_step(const char *filename, time_t start, int width) {
+    time_t end = time(NULL);
+    return select_optimal_step(filename, start, end, (int)(end - start), width);
+}
+
+#define FETCH_NO_RRDCACHED (-2)
+
+/* Fetch over a pooled rrdcached connection, flushing per the configured
+ * policy (see rrdc_pool_flush). A connection that died
+ * while idle (e.g. rrdcached restarted) is replaced and the fetch retried
+ * once. Returns FETCH_NO_RRDCACHED when the daemon is not available. */
+static int rrdcached_fetch(const char *rrdcached_addr, const char *filename,
+                           time_t *start, time_t *end, unsigned long *step,
+                           unsigned long *ds_cnt, char ***ds_names, rrd_value_t **data) {
+    for (int attempt = 0; attempt < 2; attempt++) {
+        rrd_client_t *client = rrdc_pool_acquire(rrdcached_addr);
+        if (!client) return FETCH_NO_RRDCACHED;
+
+        rrdc_pool_flush(client, filename);
+        int status = rrd_client_fetch(client, filename, "AVERAGE", start, end, step,
+                                      ds_cnt, ds_names, data);
+        int connected = rrd_client_is_connected(client);
+        rrdc_pool_release(client);
+
+        if (status == 0) rrdc_pool_mark_flushed(filename);
+        if (status == 0 || connected) return status;
     }
-    unsigned long optimal_step = select_step_from_rras(step_rras, rra_count, range, period, default_step);
+    return -1;
+}
 
-    for (int i = 0; i < rra_count; i++) {
-        if (rras[i].cf) free(rras[i].cf);
+/* Direct file read with the configured backend; the mmap reader falls back
+ * to librrd for files it cannot handle. Both allocate with malloc, so the
+ * results are released with rrd_freemem either way. */
+static int direct_fetch(const char *filename, time_t *start, time_t *end, unsigned long *step,
+                        unsigned long *ds_cnt, char ***ds_names, rrd_value_t **data) {
+    if (reader_backend == RRD_READER_MMAP &&
+        rrd_mmap_fetch(filename, "AVERAGE", start, end, step, ds_cnt, ds_names, data) == 0) {
+        return 0;
     }
-    rrd_info_free(info);
-    return optimal_step;
+    return rrd_fetch_r(filename, "AVERAGE", start, end, step, ds_cnt, ds_names, data);
 }
 
-MetricData* rrd_fetch_data(const char *rrdcached_addr, const char *filename,
-                           time_t start, const char *param1, MetricConfig *metric_config) {
-    int use_rrdcached = (rrdcached_addr != NULL && strlen(rrdcached_addr) > 0);
-    int rrdcached_connected = 0;
-
-    if (use_rrdcached) {
-        if (strncmp(rrdcached_addr, "unix:", 5) == 0 && access(rrdcached_addr + 5, F_OK) != 0) {
-            use_rrdcached = 0;
-        } else if (rrdc_connect(rrdcached_addr) == 0) {
-            rrdcached_connected = 1;
-            rrdc_flush(filename);
-        } else {
-            use_rrdcached = 0;
+/* Fetch through rrdcached when configured and available, else from the file */
+static int fetch_rows(const char *rrdcached_addr, const char *filename,
+                      time_t *start, time_t *end, unsigned long *step,
+                      unsigned long *ds_cnt, char ***ds_names, rrd_value_t **data) {
+    /* Under the "interval" flush policy a file rrdcached served recently is
+     * read straight from disk: no daemon round trip and no forced write */
+    int use_rrdcached = (rrdcached_addr != NULL && strlen(rrdcached_addr) > 0) &&
+                        !rrdc_pool_fresh_on_disk(filename);
+
+    int status = use_rrdcached
+        ? rrdcached_fetch(rrdcached_addr, filename, start, end, step, ds_cnt, ds_names, data)
+        : FETCH_NO_RRDCACHED;
+    if (status == FETCH_NO_RRDCACHED) {
+        status = direct_fetch(filename, start, end, step, ds_cnt, ds_names, data);
+    }
+    return status;
+}
+
+/* Append fetched rows after the points already in each series. Rows are
+ * labelled start + i * step; unknown and negative values are skipped, and
+ * "sum" adds the first two data sources. */
+static void append_rows(MetricData *md, const rrd_value_t *data, unsigned long ds_cnt,
+                        time_t start, unsigned long step, int num_points, int do_sum) {
+    if (do_sum) {
+        DataPoint *out = md->series_data[0];
+        for (int i = 0; i < num_points; i++) {
+            double total = 0;
+            if (ds_cnt >= 1) total += isnan(data[i * ds_cnt]) ? 0 : data[i * ds_cnt];
+            if (ds_cnt >= 2) total += isnan(data[i * ds_cnt + 1]) ? 0 : data[i * ds_cnt + 1];
+            if (total >= 0) {
+                out[md->series_counts[0]].timestamp = start + i * step;
+                out[md->series_counts[0]].value = total;
+                md->series_counts[0]++;
+            }
         }
+        return;
     }
 
+    for (unsigned long ds = 0; ds < ds_cnt; ds++) {
+        DataPoint *out = md->series_data[ds];
+        for (int i = 0; i < num_points; i++) {
+            double value = data[i * ds_cnt + ds];
+            if (!isnan(value) && value >= 0) {
+                out[md->series_counts[ds]].timestamp = start + i * step;
+                out[md->series_counts[ds]].value = value;
+                md->series_counts[ds]++;
+            }
+        }
+    }
+}
+
+/* Label of the row after the last one holding any known value: rows from
+ * there on were not written yet, so a delta fetch resumes at it */
+static time_t known_until(const rrd_value_t *data, unsigned long ds_cnt,
+                          time_t start, unsigned long step, int num_points) {
+    for (int i = num_points - 1; i >= 0; i--) {
+        for (unsigned long ds = 0; ds < ds_cnt; ds++) {
+            if (!isnan(data[i * ds_cnt + ds])) return start + (time_t)(i + 1) * step;
+        }
+    }
+    return start;
+}
+
+static int has_points(const MetricData *md) {
+    for (int ds = 0; ds < md->series_count; ds++) {
+        if (md->series_counts[ds] > 0) return 1;
+    }
+    return 0;
+}
+
+MetricData* rrd_fetch_data(const char *rrdcached_addr, const char *filename,
+                           time_t start, const char *param1, MetricConfig *metric_config) {
+    return rrd_fetch_data_step(rrdcached_addr, filename, start,
+                               rrd_select_step(filename, start, 0), param1, metric_config);
+}
+
+MetricData* rrd_fetch_data_step(const char *rrdcached_addr, const char *filename,
+                                time_t start, unsigned long step, const char *param1,
+                                MetricConfig *metric_config) {
     time_t end = time(NULL);
-    unsigned long step = select_optimal_step(filename, start, end, (int)(end - start));
     unsigned long ds_cnt;
     char **ds_names = NULL;
     rrd_value_t *data = NULL;
 
-    int status = use_rrdcached && rrdcached_connected
-        ? rrdc_fetch(filename, "AVERAGE", &start, &end, &step, &ds_cnt, &ds_names, &data)
-        : rrd_fetch_r(filename, "AVERAGE", &start, &end, &step, &ds_cnt, &ds_names, &data);
-
-    if (status != 0) {
-        if (rrdcached_connected) rrdc_disconnect();
+    if (fetch_rows(rrdcached_addr, filename, &start, &end, &step, &ds_cnt, &ds_names, &data) != 0) {
         return NULL;
     }
 
@@ -187,7 +358,6 @@ MetricData* rrd_fetch_data(const char *rrdcached_addr, const char *filename,
     if (num_points <= 0) {
         if (ds_names) rrd_freemem(ds_names);
         if (data) rrd_freemem(data);
-        if (rrdcached_connected) rrdc_disconnect();
         return NULL;
     }
 
@@ -195,7 +365,6 @@ MetricData* rrd_fetch_data(const char *rrdcached_addr, const char *filename,
     if (!metric_data) {
         if (ds_names) rrd_freemem(ds_names);
         if (data) rrd_freemem(data);
-        if (rrdcached_connected) rrdc_disconnect();
         return NULL;
     }
 
@@ -206,54 +375,124 @@ MetricData* rrd_fetch_data(const char *rrdcached_addr, const char *filename,
     metric_data->series_counts = malloc(metric_data->series_count * sizeof(int));
     metric_data->param1 = strdup(param1 ? param1 : "");
     metric_data->metric_config = metric_config;
+    metric_data->refs = 0;
+    metric_data->fetch_end = known_until(data, ds_cnt, start, step, num_points);
+    metric_data->fetch_step = step;
 
-    if (do_sum) {
-        metric_data->series_names[0] = strdup("total");
-        metric_data->series_data[0] = malloc(num_points * sizeof(DataPoint));
-        metric_data->series_counts[0] = 0;
-
-        for (int i = 0; i < num_points; i++) {
-            double total = 0;
-            if (ds_cnt >= 1) total += isnan(data[i * ds_cnt]) ? 0 : data[i * ds_cnt];
-            if (ds_cnt >= 2) total += isnan(data[i * ds_cnt + 1]) ? 0 : data[i * ds_cnt + 1];
-            if (total >= 0) {
-                metric_data->series_data[0][metric_data->series_counts[0]].timestamp = start + i * step;
-                metric_data->series_data[0][metric_data->series_counts[0]].value = total;
-                metric_data->series_counts[0]++;
-            }
-        }
-    } else {
-        for (unsigned long ds = 0; ds < ds_cnt; ds++) {
-            metric_data->series_names[ds] = strdup(ds_names[ds]);
-            metric_data->series_data[ds] = malloc(num_points * sizeof(DataPoint));
-            metric_data->series_counts[ds] = 0;
-
-            for (int i = 0; i < num_points; i++) {
-                double value = data[i * ds_cnt + ds];
-                if (!isnan(value) && value >= 0) {
-                    metric_data->series_data[ds][metric_data->series_counts[ds]].timestamp = start + i * step;
-                    metric_data->series_data[ds][metric_data->series_counts[ds]].value = value;
-                    metric_data->series_counts[ds]++;
-                }
-            }
-        }
+    for (int ds = 0; ds < metric_data->series_count; ds++) {
+        metric_data->series_names[ds] = strdup(do_sum ? "total" : ds_names[ds]);
+        metric_data->series_data[ds] = malloc(num_points * sizeof(DataPoint));
+        metric_data->series_counts[ds] = 0;
     }
+    append_rows(metric_data, data, ds_cnt, start, step, num_points, do_sum);
 
     if (ds_names) rrd_freemem(ds_names);
     if (data) rrd_freemem(data);
-    if (rrdcached_connected) rrdc_disconnect();
 
     /* Verify we got some data */
-    for (int ds = 0; ds < metric_data->series_count; ds++) {
-        if (metric_data->series_counts[ds] > 0) return metric_data;
-    }
+    if (has_points(metric_data)) return metric_data;
 
-    rrd_data_free(metric_data);
+    metric_data_release(metric_data);
     return NULL;
 }
 
-void rrd_data_free(MetricData *data) {
+/* First point at or after ts (series are sorted by timestamp) */
+static int first_point_from(const DataPoint *points, int count, time_t ts) {
+    int lo = 0, hi = count;
+    while (lo < hi) {
+        int mid = lo + (hi - lo) / 2;
+        if (points[mid].timestamp < ts) lo = mid + 1;
+        else hi = mid;
+    }
+    return lo;
+}
+
+MetricData* rrd_fetch_delta(const char *rrdcached_addr, const char *filename,
+                            const MetricData *base, time_t start) {
+    if (!base || base->fetch_step == 0 || base->series_count <= 0) return NULL;
+
+    unsigned long step = base->fetch_step;
+    time_t head = start - start % (time_t)step;
+    time_t from = base->fetch_end;
+    time_t end = time(NULL);
+    if (from <= head || from > end) return NULL;
+
+    time_t fetch_start = from;
+    unsigned long fetch_step = step;
+    unsigned long ds_cnt;
+    char **ds_names = NULL;
+    rrd_value_t *data = NULL;
+    if (fetch_rows(rrdcached_addr, filename, &fetch_start, &end, &fetch_step,
+                   &ds_cnt, &ds_names, &data) != 0) {
+        return NULL;
+    }
+
+    int do_sum = base->metric_config && strcmp(base->metric_config->transform_type, "sum") == 0;
+    int num_new = (end - fetch_start + fetch_step - 1) / fetch_step;
+    MetricData *md = NULL;
+
+    /* The same archive must answer, or the rows would not line up: a
+     * different step, alignment or DS set means a full fetch */
+    if (fetch_step != step || fetch_start != from || num_new < 0 ||
+        (!do_sum && (int)ds_cnt != base->series_count)) {
+        goto done;
+    }
+
+    md = calloc(1, sizeof(MetricData));
+    if (!md) goto done;
+    md->series_count = base->series_count;
+    md->series_names = calloc(md->series_count, sizeof(char*));
+    md->series_data = calloc(md->series_count, sizeof(DataPoint*));
+    md->series_counts = calloc(md->series_count, sizeof(int));
+    md->param1 = strdup(base->param1 ? base->param1 : "");
+    md->metric_config = base->metric_config;
+    md->fetch_step = step;
+    md->fetch_end = known_until(data, ds_cnt, fetch_start, step, num_new);
+    if (md->fetch_end == fetch_start) md->fetch_end = from;
+    if (!md->series_names || !md->series_data || !md->series_counts || !md->param1) {
+        md->series_count = 0;
+        goto fail;
+    }
+
+    /* Keep base's points in [head, from) (copied: cached data is shared and
+     * immutable), then append the refetched rows */
+    for (int ds = 0; ds < md->series_count; ds++) {
+        const DataPoint *points = base->series_data[ds];
+        int n = base->series_counts[ds];
+        int keep_from = first_point_from(points, n, head);
+        int kept = first_point_from(points, n, from) - keep_from;
+
+        md->series_names[ds] = strdup(base->series_names[ds]);
+        md->series_data[ds] = malloc((size_t)(kept + num_new + 1) * sizeof(DataPoint));
+        if (!md->series_names[ds] || !md->series_data[ds]) goto fail;
+        memcpy(md->series_data[ds], points + keep_from, (size_t)kept * sizeof(DataPoint));
+        md->series_counts[ds] = kept;
+    }
+    append_rows(md, data, ds_cnt, fetch_start, step, num_new, do_sum);
+
+    if (!has_points(md)) goto fail;
+    goto done;
+
+fail:
+    metric_data_release(md);
+    md = NULL;
+done:
+    if (ds_names) rrd_freemem(ds_names);
+    if (data) rrd_freemem(data);
+    return md;
+}
+
+MetricData* metric_data_retain(MetricData *data) {
+    if (data) __atomic_add_fetch(&data->refs, 1, __ATOMIC_RELAXED);
+    return data;
+}
+
+void metric_data_release(MetricData *data) {
     if (!data) return;
+    /* Other owners left: just drop ours. The acquire/release pair orders
+     * every owner's reads before the final free. */
+    if (__atomic_fetch_sub(&data->refs, 1, __ATOMIC_ACQ_REL) > 0) return;
+
     for (int i = 0; i < data->series_count; i++) {
         free(data->series_names[i]);
         free(data->series_data[i]);
@@ -264,3 +503,7 @@ void rrd_data_free(MetricData *data) {
     free(data->param1);
     free(data);
 }
+
+void rrd_data_free(MetricData *data) {
+    metric_data_release(data);
+}
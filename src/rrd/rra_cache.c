@@ -0,0 +1,113 @@
+/**
+ * @file rra_cache.c
+ * @brief Per-file RRA layout cache implementation
+ *
+ * One entry per RRD path; the set of files is fixed by the configuration and
+ * the filesystem, so entries are refreshed in place and never expire. A
+ * lookup copies the small RRDLayout out under the lock.
+ */
+
+#include "../include/rrd/rra_cache.h"
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+
+#define RRA_CACHE_BUCKETS 64
+
+/* Cache entry structure */
+typedef struct rra_cache_entry {
+    char *path;
+    dev_t dev;
+    ino_t ino;
+    off_t size;
+    struct timespec mtime;
+    RRDLayout layout;
+    struct rra_cache_entry *next;
+} rra_cache_entry_t;
+
+/* Global cache state */
+static rra_cache_entry_t *rra_slots[RRA_CACHE_BUCKETS] = {0};
+static pthread_mutex_t rra_cache_mutex = PTHREAD_MUTEX_INITIALIZER;
+
+/* Simple DJB2 hash function */
+static unsigned int rra_cache_hash(const char *key) {
+    unsigned int hash = 5381;
+    int c;
+    while ((c = *key++)) {
+        hash = ((hash << 5) + hash) + c;
+    }
+    return hash % RRA_CACHE_BUCKETS;
+}
+
+static rra_cache_entry_t *find_entry(const char *path) {
+    rra_cache_entry_t *entry = rra_slots[rra_cache_hash(path)];
+    while (entry && strcmp(entry->path, path) != 0) entry = entry->next;
+    return entry;
+}
+
+static void set_identity(rra_cache_entry_t *entry, const struct stat *st) {
+    entry->dev = st->st_dev;
+    entry->ino = st->st_ino;
+    entry->size = st->st_size;
+    entry->mtime = st->st_mtim;
+}
+
+rra_cache_status_t rra_cache_get(const char *path, const struct stat *st, RRDLayout *out) {
+    if (!path || !st || !out) return RRA_CACHE_MISS;
+
+    rra_cache_status_t status = RRA_CACHE_MISS;
+    pthread_mutex_lock(&rra_cache_mutex);
+
+    rra_cache_entry_t *entry = find_entry(path);
+    if (entry && entry->dev == st->st_dev && entry->ino == st->st_ino &&
+        entry->size == st->st_size) {
+        *out = entry->layout;
+        status = (entry->mtime.tv_sec == st->st_mtim.tv_sec &&
+                  entry->mtime.tv_nsec == st->st_mtim.tv_nsec)
+                 ? RRA_CACHE_HIT : RRA_CACHE_STALE;
+    }
+
+    pthread_mutex_unlock(&rra_cache_mutex);
+    return status;
+}
+
+void rra_cache_put(const char *path, const struct stat *st, const RRDLayout *layout) {
+    if (!path || !st || !layout) return;
+
+    pthread_mutex_lock(&rra_cache_mutex);
+
+    rra_cache_entry_t *entry = find_entry(path);
+    if (!entry) {
+        entry = calloc(1, sizeof(rra_cache_entry_t));
+        char *path_copy = entry ? strdup(path) : NULL;
+        if (!path_copy) {
+            /* Not cached; the next fetch reads the header again */
+            free(entry);
+            pthread_mutex_unlock(&rra_cache_mutex);
+            return;
+        }
+        entry->path = path_copy;
+        unsigned int slot = rra_cache_hash(path);
+        entry->next = rra_slots[slot];
+        rra_slots[slot] = entry;
+    }
+    set_identity(entry, st);
+    entry->layout = *layout;
+
+    pthread_mutex_unlock(&rra_cache_mutex);
+}
+
+void rra_cache_free(void) {
+    pthread_mutex_lock(&rra_cache_mutex);
+    for (int i = 0; i < RRA_CACHE_BUCKETS; i++) {
+        rra_cache_entry_t *entry = rra_slots[i];
+        while (entry) {
+            rra_cache_entry_t *next = entry->next;
+            free(entry->path);
+            free(entry);
+            entry = next;
+        }
+        rra_slots[i] = NULL;
+    }
+    pthread_mutex_unlock(&rra_cache_mutex);
+}
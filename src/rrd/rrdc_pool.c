@@ -0,0 +1,276 @@
+/**
+ * @file rrdc_pool.c
+ * @brief Pool of persistent rrdcached connections
+ *
+ * Idle clients sit on a small stack under one mutex; connects happen outside
+ * the lock. There is no hard cap on checked-out clients (one per worker in
+ * practice), only on how many stay open while idle.
+ *
+ * The flush policy keeps its own lock and a per-file table of when rrdcached
+ * last served each file; like the RRA layout cache it holds one entry per RRD
+ * path and never expires.
+ */
+
+#include "../include/rrd/rrdc_pool.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include <time.h>
+#include <unistd.h>
+
+#define RRDC_POOL_MAX_IDLE 64
+#define RRDC_POOL_DEFAULT_IDLE 4
+#define RRDC_FLUSH_DEFAULT_INTERVAL 30
+#define RRDC_FLUSH_BUCKETS 64
+
+/* Global pool state */
+static pthread_mutex_t pool_mutex = PTHREAD_MUTEX_INITIALIZER;
+static char pool_addr[256] = "";
+static int pool_max_idle = RRDC_POOL_DEFAULT_IDLE;
+static rrd_client_t *pool_idle[RRDC_POOL_MAX_IDLE];
+static int pool_idle_count = 0;
+static time_t pool_down_until = 0;
+static unsigned long pool_connects = 0;
+static unsigned long pool_connect_failures = 0;
+static unsigned long pool_dropped = 0;
+
+/* Flush policy state */
+typedef struct flushed_file {
+    char *path;
+    time_t served_at;
+    struct flushed_file *next;
+} flushed_file_t;
+
+static pthread_mutex_t flush_mutex = PTHREAD_MUTEX_INITIALIZER;
+static rrdc_flush_policy_t flush_policy = RRDC_FLUSH_FETCH;
+static int flush_interval = RRDC_FLUSH_DEFAULT_INTERVAL;
+static flushed_file_t *flushed_slots[RRDC_FLUSH_BUCKETS] = {0};
+static unsigned long flush_count = 0;
+static unsigned long flush_avoided = 0;
+
+static void set_addr_locked(const char *daemon_addr, int max_idle) {
+    strncpy(pool_addr, daemon_addr ? daemon_addr : "", sizeof(pool_addr) - 1);
+    pool_addr[sizeof(pool_addr) - 1] = '\0';
+    if (max_idle <= 0) max_idle = RRDC_POOL_DEFAULT_IDLE;
+    pool_max_idle = max_idle < RRDC_POOL_MAX_IDLE ? max_idle : RRDC_POOL_MAX_IDLE;
+}
+
+void rrdc_pool_init(const char *daemon_addr, int max_idle) {
+    pthread_mutex_lock(&pool_mutex);
+    set_addr_locked(daemon_addr, max_idle);
+    pool_down_until = 0;
+    pthread_mutex_unlock(&pool_mutex);
+}
+
+int rrdc_flush_policy_parse(const char *name, rrdc_flush_policy_t *out) {
+    if (!name || !out) return -1;
+    if (strcmp(name, "fetch") == 0) *out = RRDC_FLUSH_FETCH;
+    else if (strcmp(name, "always") == 0) *out = RRDC_FLUSH_ALWAYS;
+    else if (strcmp(name, "interval") == 0) *out = RRDC_FLUSH_INTERVAL;
+    else return -1;
+    return 0;
+}
+
+void rrdc_pool_set_flush_policy(rrdc_flush_policy_t policy, int interval_seconds) {
+    pthread_mutex_lock(&flush_mutex);
+    flush_policy = policy;
+    flush_interval = interval_seconds > 0 ? interval_seconds : RRDC_FLUSH_DEFAULT_INTERVAL;
+    pthread_mutex_unlock(&flush_mutex);
+}
+
+/* Simple DJB2 hash function */
+static unsigned int flush_hash(const char *key) {
+    unsigned int hash = 5381;
+    int c;
+    while ((c = *key++)) {
+        hash = ((hash << 5) + hash) + c;
+    }
+    return hash % RRDC_FLUSH_BUCKETS;
+}
+
+static flushed_file_t *find_flushed(const char *path) {
+    flushed_file_t *entry = flushed_slots[flush_hash(path)];
+    while (entry && strcmp(entry->path, path) != 0) entry = entry->next;
+    return entry;
+}
+
+int rrdc_pool_fresh_on_disk(const char *filename) {
+    if (!filename) return 0;
+
+    int fresh = 0;
+    pthread_mutex_lock(&flush_mutex);
+    if (flush_policy == RRDC_FLUSH_INTERVAL) {
+        flushed_file_t *entry = find_flushed(filename);
+        if (entry && time(NULL) - entry->served_at < flush_interval) {
+            fresh = 1;
+            flush_avoided++;
+        }
+    }
+    pthread_mutex_unlock(&flush_mutex);
+    return fresh;
+}
+
+void rrdc_pool_flush(rrd_client_t *client, const char *filename) {
+    pthread_mutex_lock(&flush_mutex);
+    int flush = flush_policy == RRDC_FLUSH_ALWAYS;
+    if (flush) flush_count++;
+    else flush_avoided++;
+    pthread_mutex_unlock(&flush_mutex);
+
+    if (flush) rrd_client_flush(client, filename);
+}
+
+void rrdc_pool_mark_flushed(const char *filename) {
+    if (!filename) return;
+
+    pthread_mutex_lock(&flush_mutex);
+    if (flush_policy == RRDC_FLUSH_INTERVAL) {
+        flushed_file_t *entry = find_flushed(filename);
+        if (!entry) {
+            entry = calloc(1, sizeof(flushed_file_t));
+            char *path_copy = entry ? strdup(filename) : NULL;
+            if (!path_copy) {
+                /* Not tracked; the next fetch goes through rrdcached again */
+                free(entry);
+                pthread_mutex_unlock(&flush_mutex);
+                return;
+            }
+            entry->path = path_copy;
+            unsigned int slot = flush_hash(filename);
+            entry->next = flushed_slots[slot];
+            flushed_slots[slot] = entry;
+        }
+        entry->served_at = time(NULL);
+    }
+    pthread_mutex_unlock(&flush_mutex);
+}
+
+/* Open a new connection; NULL on failure. Called without the lock. */
+static rrd_client_t *pool_connect(const char *addr) {
+    /* A missing unix socket means the daemon is not running: skip the
+     * connect attempt (and librrd's error) entirely */
+    if (strncmp(addr, "unix:", 5) == 0 && access(addr + 5, F_OK) != 0) return NULL;
+
+    rrd_client_t *client = rrd_client_new(addr);
+    if (!client) return NULL;
+    if (rrd_client_connect(client, addr) != 0) {
+        rrd_client_destroy(client);
+        return NULL;
+    }
+    return client;
+}
+
+rrd_client_t *rrdc_pool_acquire(const char *daemon_addr) {
+    char addr[sizeof(pool_addr)];
+
+    pthread_mutex_lock(&pool_mutex);
+    if (pool_addr[0] == '\0' && daemon_addr && daemon_addr[0]) {
+        /* Not initialized (e.g. library use without main): adopt the caller's address */
+        set_addr_locked(daemon_addr, pool_max_idle);
+    }
+    if (pool_addr[0] == '\0' || time(NULL) < pool_down_until) {
+        pthread_mutex_unlock(&pool_mutex);
+        return NULL;
+    }
+    if (pool_idle_count > 0) {
+        rrd_client_t *client = pool_idle[--pool_idle_count];
+        pthread_mutex_unlock(&pool_mutex);
+        return client;
+    }
+    memcpy(addr, pool_addr, sizeof(addr));
+    pthread_mutex_unlock(&pool_mutex);
+
+    rrd_client_t *client = pool_connect(addr);
+
+    pthread_mutex_lock(&pool_mutex);
+    if (client) {
+        if (pool_down_until != 0) {
+            fprintf(stderr, "rrdcached at %s reachable again\n", addr);
+        }
+        pool_connects++;
+        pool_down_until = 0;
+    } else {
+        if (pool_down_until == 0) {
+            fprintf(stderr, "Warning: rrdcached at %s unreachable, using direct file I/O "
+                    "(retry in %ds)\n", addr, RRDC_POOL_RETRY_SEC);
+        }
+        pool_connect_failures++;
+        pool_down_until = time(NULL) + RRDC_POOL_RETRY_SEC;
+    }
+    pthread_mutex_unlock(&pool_mutex);
+    return client;
+}
+
+void rrdc_pool_release(rrd_client_t *client) {
+    if (!client) return;
+
+    if (!rrd_client_is_connected(client)) {
+        /* Broken (e.g. rrdcached restarted): the next acquire reconnects */
+        pthread_mutex_lock(&pool_mutex);
+        pool_dropped++;
+        pthread_mutex_unlock(&pool_mutex);
+        rrd_client_destroy(client);
+        return;
+    }
+
+    pthread_mutex_lock(&pool_mutex);
+    if (pool_idle_count < pool_max_idle) {
+        pool_idle[pool_idle_count++] = client;
+        client = NULL;
+    }
+    pthread_mutex_unlock(&pool_mutex);
+
+    if (client) rrd_client_destroy(client);  /* more checked out than max_idle */
+}
+
+void rrdc_pool_stats(rrdc_pool_stats_t *out) {
+    if (!out) return;
+    pthread_mutex_lock(&pool_mutex);
+    out->connects = pool_connects;
+    out->connect_failures = pool_connect_failures;
+    out->dropped = pool_dropped;
+    out->idle = pool_idle_count;
+    out->healthy = time(NULL) >= pool_down_until;
+    pthread_mutex_unlock(&pool_mutex);
+
+    pthread_mutex_lock(&flush_mutex);
+    out->flushes = flush_count;
+    out->flushes_avoided = flush_avoided;
+    pthread_mutex_unlock(&flush_mutex);
+}
+
+void rrdc_pool_free(void) {
+    rrd_client_t *idle[RRDC_POOL_MAX_IDLE];
+
+    pthread_mutex_lock(&pool_mutex);
+    int count = pool_idle_count;
+    memcpy(idle, pool_idle, count * sizeof(rrd_client_t *));
+    pool_idle_count = 0;
+    pool_addr[0] = '\0';
+    pool_max_idle = RRDC_POOL_DEFAULT_IDLE;
+    pool_down_until = 0;
+    pool_connects = 0;
+    pool_connect_failures = 0;
+    pool_dropped = 0;
+    pthread_mutex_unlock(&pool_mutex);
+
+    for (int i = 0; i < count; i++) rrd_client_destroy(idle[i]);
+
+    pthread_mutex_lock(&flush_mutex);
+    for (int i = 0; i < RRDC_FLUSH_BUCKETS; i++) {
+        flushed_file_t *entry = flushed_slots[i];
+        while (entry) {
+            flushed_file_t *next = entry->next;
+            free(entry->path);
+            free(entry);
+            entry = next;
+        }
+        flushed_slots[i] = NULL;
+    }
+    flush_policy = RRDC_FLUSH_FETCH;
+    flush_interval = RRDC_FLUSH_DEFAULT_INTERVAL;
+    flush_count = 0;
+    flush_avoided = 0;
+    pthread_mutex_unlock(&flush_mutex);
+}
@@ -4,6 +4,8 @@
  */
 
 #include "../include/rrd/svg.h"
+#include "../include/rrd/svg_native.h"
+#include "../include/rrd/js_heap.h"
 #include "../include/cfg.h"
 #include <duktape.h>
 #include <stdio.h>
@@ -17,37 +19,285 @@ static char *js_cache = NULL;
 static long js_cache_len = 0;
 static volatile int js_cache_initialized = 0;
 static pthread_key_t js_context_key;
+
+/* The script compiled once and dumped with duk_dump_function(); NULL when
+ * the dump failed (syntax error, Duktape built without bytecode support) and
+ * contexts fall back to evaluating the source. */
+static char *js_bytecode = NULL;
+static duk_size_t js_bytecode_len = 0;
 static pthread_once_t key_once = PTHREAD_ONCE_INIT;
 
+/* Hot reload: svg_reload_script() swaps js_cache/js_bytecode under the write
+ * lock and bumps script_generation; each thread re-evaluates the script in
+ * its own context on its next request (read lock held while loading). The
+ * generation never goes back, also across svg_free_cache()/svg_init_cache(). */
+static pthread_rwlock_t script_lock = PTHREAD_RWLOCK_INITIALIZER;
+static pthread_mutex_t reload_lock = PTHREAD_MUTEX_INITIALIZER;
+static unsigned script_generation = 0;
+static char *script_file = NULL;
+
+/* Per-thread Duktape heap (pooled allocator, see js_heap.h) and the script
+ * generation evaluated in it */
+typedef struct {
+    duk_context *ctx;
+    js_heap_t *heap;
+    unsigned generation;            /* 0 = no script loaded yet */
+} thread_context_t;
+
 /* Verbose logging accessor - declared in cfg.h, implemented in main.c */
 extern int is_verbose_logging(void);
 
+static svg_series_format_t series_format = SVG_SERIES_TYPED;
+
+int svg_series_format_parse(const char *name, svg_series_format_t *out) {
+    if (!name || !out) return -1;
+    if (strcmp(name, "typed") == 0) *out = SVG_SERIES_TYPED;
+    else if (strcmp(name, "objects") == 0) *out = SVG_SERIES_OBJECTS;
+    else return -1;
+    return 0;
+}
+
+void svg_set_series_format(svg_series_format_t format) {
+    series_format = format;
+}
+
+static svg_render_engine_t render_engine = SVG_ENGINE_JS;
+
+int svg_render_engine_parse(const char *name, svg_render_engine_t *out) {
+    if (!name || !out) return -1;
+    if (strcmp(name, "js") == 0) *out = SVG_ENGINE_JS;
+    else if (strcmp(name, "native") == 0) *out = SVG_ENGINE_NATIVE;
+    else return -1;
+    return 0;
+}
+
+void svg_set_render_engine(svg_render_engine_t engine) {
+    render_engine = engine;
+}
+
+/* series.timestamps / series.values: two Float64Array views over one fixed
+ * buffer, filled in a single pass. No per-point heap objects or property
+ * puts, and the whole series is one GC allocation. */
+static void push_series_typed(duk_context *ctx, const DataPoint *points, int n) {
+    duk_size_t column = (duk_size_t)n * sizeof(double);
+    double *buf = duk_push_fixed_buffer(ctx, 2 * column);
+    for (int i = 0; i < n; i++) {
+        buf[i] = (double)points[i].timestamp;
+        buf[n + i] = points[i].value;
+    }
+    duk_push_buffer_object(ctx, -1, 0, column, DUK_BUFOBJ_FLOAT64ARRAY);
+    duk_put_prop_string(ctx, -3, "timestamps");
+    duk_push_buffer_object(ctx, -1, column, column, DUK_BUFOBJ_FLOAT64ARRAY);
+    duk_put_prop_string(ctx, -3, "values");
+    duk_pop(ctx);
+}
+
+/* series.data: [{timestamp, value}, ...] — the original format, for
+ * scripts written against it */
+static void push_series_objects(duk_context *ctx, const DataPoint *points, int n) {
+    duk_push_array(ctx);
+    for (int i = 0; i < n; i++) {
+        duk_push_object(ctx);
+        duk_push_number(ctx, (double)points[i].timestamp);
+        duk_put_prop_string(ctx, -2, "timestamp");
+        duk_push_number(ctx, points[i].value);
+        duk_put_prop_string(ctx, -2, "value");
+        duk_put_prop_index(ctx, -2, i);
+    }
+    duk_put_prop_string(ctx, -2, "data");
+}
+
+static void free_thread_context(void *p) {
+    thread_context_t *tc = p;
+    js_heap_destroy(tc->heap);
+    free(tc);
+}
+
 /* Initialize thread-local context key (called once) */
 static void make_context_key(void) {
-    pthread_key_create(&js_context_key, (void (*)(void*))duk_destroy_heap);
+    pthread_key_create(&js_context_key, free_thread_context);
 }
 
-/* Get or create thread-local Duktape context */
-static duk_context* get_thread_context(void) {
-    pthread_once(&key_once, make_context_key);
+typedef struct {
+    const char *source;
+    long len;
+    int compiled;                   /* set once compilation succeeded */
+} dump_args_t;
+
+/* Compile the source as program code and dump it (duk_safe_call: both
+ * steps throw on failure) */
+static duk_ret_t dump_script(duk_context *ctx, void *ud) {
+    dump_args_t *args = ud;
+    duk_compile_lstring(ctx, 0, args->source, (duk_size_t)args->len);
+    args->compiled = 1;
+    duk_dump_function(ctx);
+    return 1;
+}
+
+/* Compile source to bytecode in a scratch heap; *out stays NULL when the
+ * dump fails. With check set (reloads) a script that does not compile, throws
+ * at top level or defines no generateSVG function is rejected with -1, so a
+ * broken deploy never replaces a working script. */
+static int compile_script(const char *source, long len, int check,
+                          char **out, duk_size_t *out_len) {
+    *out = NULL;
+    *out_len = 0;
+    duk_context *ctx = duk_create_heap_default();
+    if (!ctx) return check ? -1 : 0;
+
+    int rc = 0;
+    dump_args_t args = { source, len, 0 };
+    if (duk_safe_call(ctx, dump_script, &args, 0, 1) != DUK_EXEC_SUCCESS) {
+        if (check && !args.compiled) {
+            fprintf(stderr, "svg: %s\n", duk_safe_to_string(ctx, -1));
+            rc = -1;
+        } else if (is_verbose_logging()) {
+            fprintf(stderr, "svg: bytecode dump failed (%s), evaluating source per context\n",
+                    duk_safe_to_string(ctx, -1));
+        }
+    } else {
+        duk_size_t n = 0;
+        const void *buf = duk_get_buffer(ctx, -1, &n);
+        *out = buf && n ? malloc(n) : NULL;
+        if (*out) {
+            memcpy(*out, buf, n);
+            *out_len = n;
+            if (is_verbose_logging()) {
+                fprintf(stderr, "svg: script compiled to %zu bytes of bytecode\n", (size_t)n);
+            }
+        }
+    }
+    duk_pop(ctx);
 
-    duk_context *ctx = pthread_getspecific(js_context_key);
-    if (!ctx) {
-        ctx = duk_create_heap_default();
-        if (!ctx) return NULL;
-        pthread_setspecific(js_context_key, ctx);
-
-        /* Pre-load JS cache if available */
-        if (js_cache_initialized && js_cache) {
-            if (duk_peval_string(ctx, js_cache) != 0) {
-                duk_destroy_heap(ctx);
-                pthread_setspecific(js_context_key, NULL);
-                return NULL;
+    if (rc == 0 && check) {
+        if (duk_peval_lstring(ctx, source, (duk_size_t)len) != 0) {
+            fprintf(stderr, "svg: %s\n", duk_safe_to_string(ctx, -1));
+            rc = -1;
+        } else {
+            (void)duk_get_global_string(ctx, "generateSVG");
+            if (!duk_is_function(ctx, -1)) {
+                fprintf(stderr, "svg: script defines no generateSVG function\n");
+                rc = -1;
             }
             duk_pop(ctx);
         }
+        duk_pop(ctx);
+    }
+
+    duk_destroy_heap(ctx);
+    if (rc != 0) {
+        free(*out);
+        *out = NULL;
+        *out_len = 0;
+    }
+    return rc;
+}
+
+/* Read a whole file into a NUL-terminated buffer */
+static int read_script(const char *filename, char **out, long *out_len) {
+    FILE *f = fopen(filename, "rb");
+    if (!f) return -1;
+
+    fseek(f, 0, SEEK_END);
+    long len = ftell(f);
+    fseek(f, 0, SEEK_SET);
+
+    char *buf = len >= 0 ? malloc(len + 1) : NULL;
+    if (!buf) {
+        fclose(f);
+        return -1;
+    }
+
+    size_t read_bytes = fread(buf, 1, len, f);
+    buf[len] = '\0';
+    fclose(f);
+
+    if (read_bytes != (size_t)len) {
+        free(buf);
+        return -1;
     }
-    return ctx;
+    *out = buf;
+    *out_len = len;
+    return 0;
+}
+
+/* Swap in a new script version; returns its generation */
+static unsigned publish_script(char *source, long len, char *bytecode, duk_size_t bytecode_len) {
+    pthread_rwlock_wrlock(&script_lock);
+    free(js_cache);
+    free(js_bytecode);
+    js_cache = source;
+    js_cache_len = len;
+    js_bytecode = bytecode;
+    js_bytecode_len = bytecode_len;
+    unsigned generation = __atomic_add_fetch(&script_generation, 1, __ATOMIC_RELEASE);
+    pthread_rwlock_unlock(&script_lock);
+    return generation;
+}
+
+/* Load the dumped bytecode and run it (duk_safe_call: the buffer allocation
+ * can hit js.heap_max_bytes and duk_load_function throws on a bad dump) */
+static duk_ret_t run_bytecode(duk_context *ctx, void *ud) {
+    (void)ud;
+    void *buf = duk_push_fixed_buffer(ctx, js_bytecode_len);
+    memcpy(buf, js_bytecode, js_bytecode_len);
+    duk_load_function(ctx);
+    duk_call(ctx, 0);
+    return 1;
+}
+
+/* Define the script's globals in a fresh context: run the bytecode if there
+ * is one (no parsing or compiling), otherwise eval the source. 0 on success. */
+static int load_script(duk_context *ctx) {
+    if (js_bytecode) {
+        if (duk_safe_call(ctx, run_bytecode, NULL, 0, 1) != DUK_EXEC_SUCCESS) {
+            fprintf(stderr, "JS Error: %s\n", duk_safe_to_string(ctx, -1));
+            duk_pop(ctx);
+            return -1;
+        }
+    } else if (duk_peval_string(ctx, js_cache) != 0) {
+        fprintf(stderr, "JS Error: %s\n", duk_safe_to_string(ctx, -1));
+        duk_pop(ctx);
+        return -1;
+    }
+    duk_pop(ctx);
+    return 0;
+}
+
+/* Get or create thread-local Duktape context */
+static thread_context_t* get_thread_context(void) {
+    pthread_once(&key_once, make_context_key);
+
+    thread_context_t *tc = pthread_getspecific(js_context_key);
+    if (!tc) {
+        tc = calloc(1, sizeof(*tc));
+        if (!tc) return NULL;
+        tc->ctx = js_heap_create(&tc->heap);
+        if (!tc->ctx) {
+            free(tc);
+            return NULL;
+        }
+        pthread_setspecific(js_context_key, tc);
+    }
+
+    /* Load the script on first use and again after every reload. The new
+     * version is evaluated over the old globals in the same heap. */
+    unsigned generation = __atomic_load_n(&script_generation, __ATOMIC_ACQUIRE);
+    if (tc->generation != generation && js_cache_initialized) {
+        pthread_rwlock_rdlock(&script_lock);
+        generation = script_generation;
+        int rc = js_cache ? load_script(tc->ctx) : 0;
+        pthread_rwlock_unlock(&script_lock);
+
+        if (rc != 0 && tc->generation == 0) {
+            pthread_setspecific(js_context_key, NULL);
+            free_thread_context(tc);
+            return NULL;
+        }
+        /* A failed re-evaluation keeps the previous version's globals */
+        tc->generation = generation;
+    }
+    return tc;
 }
 
 /*
@@ -56,47 +306,89 @@ static duk_context* get_thread_context(void) {
  * Returns the calling thread's local context (created lazily), or NULL on failure.
  */
 duk_context *svg_get_context(void) {
-    return get_thread_context();
+    thread_context_t *tc = get_thread_context();
+    return tc ? tc->ctx : NULL;
 }
 
+/* Also reached lazily from svg_generate() on any render thread: reload_lock
+ * makes concurrent first renders load the script once. */
 int svg_init_cache(const char *filename) {
-    if (js_cache_initialized) return 0;
-
-    FILE *f = fopen(filename, "rb");
-    if (!f) return -1;
+    if (__atomic_load_n(&js_cache_initialized, __ATOMIC_ACQUIRE)) return 0;
 
-    fseek(f, 0, SEEK_END);
-    js_cache_len = ftell(f);
-    fseek(f, 0, SEEK_SET);
+    pthread_mutex_lock(&reload_lock);
+    if (js_cache_initialized) {
+        pthread_mutex_unlock(&reload_lock);
+        return 0;
+    }
 
-    js_cache = malloc(js_cache_len + 1);
-    if (!js_cache) {
-        fclose(f);
+    char *source;
+    long len;
+    if (read_script(filename, &source, &len) != 0) {
+        pthread_mutex_unlock(&reload_lock);
         return -1;
     }
 
-    size_t read_bytes = fread(js_cache, 1, js_cache_len, f);
-    js_cache[js_cache_len] = '\0';
-    fclose(f);
+    char *bytecode;
+    duk_size_t bytecode_len;
+    compile_script(source, len, 0, &bytecode, &bytecode_len);
 
-    if (read_bytes != (size_t)js_cache_len) {
-        free(js_cache);
-        js_cache = NULL;
-        js_cache_len = 0;
+    free(script_file);
+    script_file = strdup(filename);
+    publish_script(source, len, bytecode, bytecode_len);
+    __atomic_store_n(&js_cache_initialized, 1, __ATOMIC_RELEASE);
+    pthread_mutex_unlock(&reload_lock);
+    return 0;
+}
+
+int svg_reload_script(void) {
+    pthread_mutex_lock(&reload_lock);
+    if (!js_cache_initialized || !script_file) {
+        pthread_mutex_unlock(&reload_lock);
         return -1;
     }
 
-    js_cache_initialized = 1;
+    char *source;
+    long len;
+    char *bytecode;
+    duk_size_t bytecode_len;
+    if (read_script(script_file, &source, &len) != 0) {
+        fprintf(stderr, "svg: cannot read %s, keeping script generation %u\n",
+                script_file, svg_script_generation());
+        pthread_mutex_unlock(&reload_lock);
+        return -1;
+    }
+    if (compile_script(source, len, 1, &bytecode, &bytecode_len) != 0) {
+        fprintf(stderr, "svg: %s rejected, keeping script generation %u\n",
+                script_file, svg_script_generation());
+        free(source);
+        pthread_mutex_unlock(&reload_lock);
+        return -1;
+    }
+
+    unsigned generation = publish_script(source, len, bytecode, bytecode_len);
+    fprintf(stderr, "svg: reloaded %s (script generation %u)\n", script_file, generation);
+    pthread_mutex_unlock(&reload_lock);
     return 0;
 }
 
+unsigned svg_script_generation(void) {
+    return __atomic_load_n(&script_generation, __ATOMIC_ACQUIRE);
+}
+
 void svg_free_cache(void) {
-    if (js_cache) {
-        free(js_cache);
-        js_cache = NULL;
-        js_cache_len = 0;
-        js_cache_initialized = 0;
-    }
+    pthread_mutex_lock(&reload_lock);
+    pthread_rwlock_wrlock(&script_lock);
+    free(js_cache);
+    js_cache = NULL;
+    js_cache_len = 0;
+    js_cache_initialized = 0;
+    free(js_bytecode);
+    js_bytecode = NULL;
+    js_bytecode_len = 0;
+    free(script_file);
+    script_file = NULL;
+    pthread_rwlock_unlock(&script_lock);
+    pthread_mutex_unlock(&reload_lock);
 }
 
 void svg_prewarm_context(void) {
@@ -104,57 +396,51 @@ void svg_prewarm_context(void) {
     get_thread_context();
 }
 
-char* svg_generate(const char *script_path, MetricData *data, int width, int height, const char *theme) {
-    struct timespec start, end;
-    clock_gettime(CLOCK_MONOTONIC, &start);
-
-    /* Initialize cache if needed */
-    if (!js_cache_initialized && svg_init_cache(script_path) != 0) return NULL;
+typedef struct {
+    const MetricData *data;
+    const MetricConfig *metric;
+    int width;
+    int height;
+    const char *theme;
+} render_args_t;
 
-    duk_context *ctx = get_thread_context();
-    if (!ctx) return NULL;
+/* Marshal the arguments and call generateSVG(series, options). Runs under
+ * duk_safe_call: an allocation refused at js.heap_max_bytes throws while the
+ * series are pushed too, and must fail the request, not the process. */
+static duk_ret_t render_call(duk_context *ctx, void *ud) {
+    const render_args_t *a = ud;
 
     /* Find generateSVG function */
-    duk_push_global_object(ctx);
-    if (!duk_get_prop_string(ctx, -1, "generateSVG")) {
-        duk_pop_2(ctx);
-        return NULL;
-    }
-    duk_remove(ctx, -2);
+    if (!duk_get_global_string(ctx, "generateSVG")) return 0;
 
     /* Build series array */
     duk_push_array(ctx);
     int array_idx = 0;
-    for (int s = 0; s < data->series_count; s++) {
-        if (data->series_counts[s] == 0) continue;
+    for (int s = 0; s < a->data->series_count; s++) {
+        if (a->data->series_counts[s] == 0) continue;
 
         duk_push_object(ctx);
-        duk_push_string(ctx, data->series_names[s]);
+        duk_push_string(ctx, a->data->series_names[s]);
         duk_put_prop_string(ctx, -2, "name");
 
-        duk_push_array(ctx);
-        for (int i = 0; i < data->series_counts[s]; i++) {
-            duk_push_object(ctx);
-            duk_push_number(ctx, (double)data->series_data[s][i].timestamp);
-            duk_put_prop_string(ctx, -2, "timestamp");
-            duk_push_number(ctx, data->series_data[s][i].value);
-            duk_put_prop_string(ctx, -2, "value");
-            duk_put_prop_index(ctx, -2, i);
+        if (series_format == SVG_SERIES_OBJECTS) {
+            push_series_objects(ctx, a->data->series_data[s], a->data->series_counts[s]);
+        } else {
+            push_series_typed(ctx, a->data->series_data[s], a->data->series_counts[s]);
         }
-        duk_put_prop_string(ctx, -2, "data");
         duk_put_prop_index(ctx, -2, array_idx++);
     }
 
     /* Build options object */
     duk_push_object(ctx);
-    if (data->param1 && *data->param1) {
-        duk_push_string(ctx, data->param1);
+    if (a->data->param1 && *a->data->param1) {
+        duk_push_string(ctx, a->data->param1);
         duk_put_prop_string(ctx, -2, "param1");
     }
 
     /* Add metric configuration */
-    if (data->metric_config) {
-        MetricConfig *cfg = data->metric_config;
+    const MetricConfig *cfg = a->metric ? a->metric : a->data->metric_config;
+    if (cfg) {
 
         duk_push_string(ctx, cfg->title);
         duk_put_prop_string(ctx, -2, "title");
@@ -175,32 +461,63 @@ char* svg_generate(const char *script_path, MetricData *data, int width, int hei
     }
 
     /* Add width/height options */
-    duk_push_number(ctx, width);
+    duk_push_number(ctx, a->width);
     duk_put_prop_string(ctx, -2, "width");
-    duk_push_number(ctx, height);
+    duk_push_number(ctx, a->height);
     duk_put_prop_string(ctx, -2, "height");
 
     /* Add render theme (resolved by generate_svg.js — light/dark/high-contrast) */
-    if (theme && *theme) {
-        duk_push_string(ctx, theme);
+    if (a->theme && *a->theme) {
+        duk_push_string(ctx, a->theme);
         duk_put_prop_string(ctx, -2, "theme");
     }
 
-    /* Call generateSVG */
-    if (duk_pcall(ctx, 2) != 0) {
-        fprintf(stderr, "JS Error: %s\n", duk_safe_to_string(ctx, -1));
-        duk_pop(ctx);
-        return NULL;
+    duk_call(ctx, 2);
+    return 1;
+}
+
+char* svg_generate(const char *script_path, const MetricData *data, const MetricConfig *metric,
+                   int width, int height, const char *theme, size_t *out_len) {
+    struct timespec start, end;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+
+    if (render_engine == SVG_ENGINE_NATIVE) {
+        char *svg = svg_native_generate(data, metric, width, height, theme, out_len);
+        if (is_verbose_logging()) {
+            clock_gettime(CLOCK_MONOTONIC, &end);
+            fprintf(stderr, "svg_generate (native) took %.2f ms\n",
+                    (end.tv_sec - start.tv_sec) * 1000.0 + (end.tv_nsec - start.tv_nsec) / 1e6);
+        }
+        return svg;
     }
 
-    const char *svg = duk_get_string(ctx, -1);
-    if (!svg) {
+    /* Initialize cache if needed */
+    if (!js_cache_initialized && svg_init_cache(script_path) != 0) return NULL;
+
+    thread_context_t *tc = get_thread_context();
+    if (!tc) return NULL;
+    duk_context *ctx = tc->ctx;
+
+    render_args_t args = { data, metric, width, height, theme };
+    if (duk_safe_call(ctx, render_call, &args, 0, 1) != DUK_EXEC_SUCCESS) {
+        fprintf(stderr, "JS Error: %s\n", duk_safe_to_string(ctx, -1));
         duk_pop(ctx);
+        js_heap_maybe_gc(tc->heap);
         return NULL;
     }
 
-    char *result = strdup(svg);
+    /* The one copy out of the Duktape heap; the length comes with the string
+     * and travels with the SVG to the cache and the socket */
+    duk_size_t len = 0;
+    const char *svg = duk_get_lstring(ctx, -1, &len);
+    char *result = svg ? malloc(len + 1) : NULL;
+    if (result) {
+        memcpy(result, svg, len + 1);
+        if (out_len) *out_len = len;
+    }
     duk_pop(ctx);
+    js_heap_maybe_gc(tc->heap);
+    if (!result) return NULL;
 
     clock_gettime(CLOCK_MONOTONIC, &end);
     double elapsed_ms = (end.tv_sec - start.tv_sec) * 1000.0 + (end.tv_nsec - start.tv_nsec) / 1e6;
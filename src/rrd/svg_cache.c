@@ -0,0 +1,438 @@
+/**
+ * @file svg_cache.c
+ * @brief Rendered-SVG output cache implementation
+ *
+ * Memory is bounded by max_bytes (0 = unlimited), counting each entry with
+ * its SVG and compressed variants: width, height and theme come from the
+ * query string, so clients alone decide how many keys there are. Before an
+ * insert that would exceed the budget a CLOCK hand sweeps the slots, as in
+ * cache.c: expired entries and entries not hit since the last pass go first,
+ * hit entries get a second chance. Everything runs under the one mutex.
+ *
+ * Entries hold references to immutable svg_buf_t: hits, waiters of a
+ * coalesced miss and the cache itself share one buffer per render, and the
+ * last owner frees it.
+ */
+
+#include "../include/rrd/svg_cache.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include <time.h>
+
+#define SVG_CACHE_MAX_ENTRIES 64
+#define SVG_CACHE_KEY_SIZE 512
+
+/* Cache entry structure */
+typedef struct svg_cache_entry {
+    char key[SVG_CACHE_KEY_SIZE];
+    svg_buf_t *svg;
+    svg_buf_t *variant[COMPRESS_ENCODING_COUNT];   /* compressed svg by encoding, or NULL */
+    size_t bytes;                                  /* accounted size: entry + svg + variants */
+    time_t expires_at;
+    int referenced;                                /* CLOCK bit, set by hits */
+    struct svg_cache_entry *next;
+} svg_cache_entry_t;
+
+/* In-flight render (single-flight). Unlinked when the leader completes; the
+ * last waiter to leave frees it. */
+typedef struct svg_inflight {
+    char key[SVG_CACHE_KEY_SIZE];
+    pthread_cond_t done_cond;
+    int done;
+    int waiters;
+    svg_buf_t *svg;             /* leader's result (one reference), NULL on failure */
+    struct svg_inflight *next;
+} svg_inflight_t;
+
+/* Global cache state */
+static svg_cache_entry_t *svg_slots[SVG_CACHE_MAX_ENTRIES] = {0};
+static svg_inflight_t *svg_inflight = NULL;  /* short list: one per concurrent miss */
+static pthread_mutex_t svg_cache_mutex = PTHREAD_MUTEX_INITIALIZER;
+static int svg_cache_ttl_seconds = 5;
+static int svg_cache_initialized = 0;
+static size_t svg_cache_max_bytes = 0;
+static unsigned int svg_cache_hand = 0;         /* CLOCK hand: next slot to sweep */
+
+/* Counters, guarded by svg_cache_mutex */
+static size_t svg_cache_entries = 0;
+static size_t svg_cache_bytes = 0;
+static unsigned long svg_cache_evictions = 0;
+static unsigned long svg_cache_expirations = 0;
+
+svg_buf_t* svg_buf_wrap(char *data, size_t len) {
+    if (!data) return NULL;
+    svg_buf_t *buf = malloc(sizeof(svg_buf_t));
+    if (!buf) {
+        free(data);
+        return NULL;
+    }
+    buf->refs = 0;
+    buf->len = len;
+    buf->data = data;
+    return buf;
+}
+
+svg_buf_t* svg_buf_retain(svg_buf_t *buf) {
+    if (buf) __atomic_add_fetch(&buf->refs, 1, __ATOMIC_RELAXED);
+    return buf;
+}
+
+void svg_buf_release(svg_buf_t *buf) {
+    if (!buf) return;
+    /* Same ordering as metric_data_release(): every owner's reads happen
+     * before the final free. */
+    if (__atomic_fetch_sub(&buf->refs, 1, __ATOMIC_ACQ_REL) > 0) return;
+    free(buf->data);
+    free(buf);
+}
+
+/* Simple DJB2 hash function */
+static unsigned int svg_cache_hash(const char *key) {
+    unsigned int hash = 5381;
+    int c;
+    while ((c = *key++)) {
+        hash = ((hash << 5) + hash) + c;
+    }
+    return hash % SVG_CACHE_MAX_ENTRIES;
+}
+
+/* Build flat key string; returns -1 if it does not fit (such requests are
+ * simply not cached) */
+static int build_svg_cache_key(char *buf, size_t size, const svg_cache_key_t *k) {
+    int n = snprintf(buf, size, "%s|%s|%d|%dx%d|%s|%d|%u",
+                     k->endpoint ? k->endpoint : "",
+                     k->param ? k->param : "",
+                     k->period, k->width, k->height,
+                     k->theme ? k->theme : "", k->decimate, k->script);
+    return (n < 0 || (size_t)n >= size) ? -1 : 0;
+}
+
+static void free_variants(svg_cache_entry_t *entry) {
+    for (int i = 0; i < COMPRESS_ENCODING_COUNT; i++) {
+        svg_buf_release(entry->variant[i]);
+        entry->variant[i] = NULL;
+    }
+}
+
+static void free_entry(svg_cache_entry_t *entry) {
+    free_variants(entry);
+    svg_buf_release(entry->svg);
+    free(entry);
+}
+
+/* Unlink *link (== entry), update the counters and free it. Caller holds
+ * svg_cache_mutex. */
+static void drop_entry_locked(svg_cache_entry_t **link, svg_cache_entry_t *entry) {
+    *link = entry->next;
+    svg_cache_entries--;
+    svg_cache_bytes -= entry->bytes;
+    free_entry(entry);
+}
+
+/* Evict until need more bytes fit in the budget, or two full sweeps found
+ * nothing more to take. keep is never evicted (the entry being updated).
+ * Caller holds svg_cache_mutex. */
+static void make_room_locked(size_t need, const svg_cache_entry_t *keep) {
+    time_t now = time(NULL);
+
+    for (int visited = 0; visited < 2 * SVG_CACHE_MAX_ENTRIES; visited++) {
+        if (svg_cache_bytes + need <= svg_cache_max_bytes) return;
+
+        svg_cache_entry_t **link = &svg_slots[svg_cache_hand];
+        while (*link && svg_cache_bytes + need > svg_cache_max_bytes) {
+            svg_cache_entry_t *entry = *link;
+            if (entry == keep) {
+                link = &entry->next;
+            } else if (entry->expires_at <= now) {
+                drop_entry_locked(link, entry);
+                svg_cache_expirations++;
+            } else if (!entry->referenced) {
+                drop_entry_locked(link, entry);
+                svg_cache_evictions++;
+            } else {
+                /* Hit since the last pass: second chance */
+                entry->referenced = 0;
+                link = &entry->next;
+            }
+        }
+        svg_cache_hand = (svg_cache_hand + 1) % SVG_CACHE_MAX_ENTRIES;
+    }
+}
+
+void svg_cache_init(int ttl_seconds, size_t max_bytes) {
+    pthread_mutex_lock(&svg_cache_mutex);
+    svg_cache_ttl_seconds = ttl_seconds > 0 ? ttl_seconds : 5;
+    svg_cache_max_bytes = max_bytes;
+    svg_cache_initialized = 1;
+    pthread_mutex_unlock(&svg_cache_mutex);
+}
+
+/* Live (unexpired) entry for key, or NULL. Caller holds svg_cache_mutex. */
+static svg_cache_entry_t *find_live_locked(const char *key) {
+    svg_cache_entry_t *entry = svg_slots[svg_cache_hash(key)];
+
+    while (entry) {
+        if (strcmp(entry->key, key) == 0) {
+            /* An expired entry is replaced on next put */
+            return entry->expires_at > time(NULL) ? entry : NULL;
+        }
+        entry = entry->next;
+    }
+    return NULL;
+}
+
+/* Reference to the live entry's SVG for key, or NULL. Caller holds
+ * svg_cache_mutex. */
+static svg_buf_t *lookup_locked(const char *key) {
+    svg_cache_entry_t *entry = find_live_locked(key);
+    if (!entry) return NULL;
+    /* Cache hit - share the immutable buffer; the entry may be replaced any
+     * time, our reference keeps the bytes alive */
+    entry->referenced = 1;
+    return svg_buf_retain(entry->svg);
+}
+
+/* Insert/replace key with svg (a reference is taken over). Caller holds
+ * svg_cache_mutex. */
+static void store_locked(const char *key, svg_buf_t *svg) {
+    unsigned int slot = svg_cache_hash(key);
+    time_t now = time(NULL);
+    size_t bytes = sizeof(svg_cache_entry_t) + svg->len + 1;
+
+    if (svg_cache_max_bytes && bytes > svg_cache_max_bytes) {
+        /* Larger than the whole budget: serve it uncached */
+        svg_buf_release(svg);
+        return;
+    }
+
+    /* Walk the chain: find a matching entry, drop expired ones. Unlike RRD
+     * keys, width/height/theme make the key space large, so stale entries
+     * must not pile up. */
+    svg_cache_entry_t **link = &svg_slots[slot];
+    svg_cache_entry_t *found = NULL;
+    while (*link) {
+        svg_cache_entry_t *entry = *link;
+        if (strcmp(entry->key, key) == 0) {
+            found = entry;
+            link = &entry->next;
+        } else if (entry->expires_at <= now) {
+            drop_entry_locked(link, entry);
+            svg_cache_expirations++;
+        } else {
+            link = &entry->next;
+        }
+    }
+
+    if (found) {
+        /* Update existing entry; variants of the old render are stale */
+        svg_cache_bytes -= found->bytes;
+        free_variants(found);
+        svg_buf_release(found->svg);
+        found->svg = svg;
+        found->bytes = bytes;
+        found->expires_at = now + svg_cache_ttl_seconds;
+        if (svg_cache_max_bytes) make_room_locked(bytes, found);
+        svg_cache_bytes += bytes;
+        return;
+    }
+
+    /* Make room before inserting so the new entry is never the victim */
+    if (svg_cache_max_bytes) make_room_locked(bytes, NULL);
+
+    svg_cache_entry_t *entry = malloc(sizeof(svg_cache_entry_t));
+    if (!entry) {
+        svg_buf_release(svg);
+        return;
+    }
+
+    strncpy(entry->key, key, SVG_CACHE_KEY_SIZE - 1);
+    entry->key[SVG_CACHE_KEY_SIZE - 1] = '\0';
+    entry->svg = svg;
+    memset(entry->variant, 0, sizeof(entry->variant));
+    entry->bytes = bytes;
+    entry->expires_at = now + svg_cache_ttl_seconds;
+    entry->referenced = 0;
+
+    /* Appended at the chain tail; eviction may have changed the chain */
+    entry->next = NULL;
+    link = &svg_slots[slot];
+    while (*link) link = &(*link)->next;
+    *link = entry;
+    svg_cache_entries++;
+    svg_cache_bytes += bytes;
+}
+
+svg_buf_t* svg_cache_get(const svg_cache_key_t *k) {
+    if (!svg_cache_initialized || !k) return NULL;
+
+    char key[SVG_CACHE_KEY_SIZE];
+    if (build_svg_cache_key(key, sizeof(key), k) != 0) return NULL;
+
+    pthread_mutex_lock(&svg_cache_mutex);
+    svg_buf_t *result = lookup_locked(key);
+    pthread_mutex_unlock(&svg_cache_mutex);
+    return result;
+}
+
+void svg_cache_put(const svg_cache_key_t *k, svg_buf_t *svg) {
+    if (!svg_cache_initialized || !k || !svg) return;
+
+    char key[SVG_CACHE_KEY_SIZE];
+    if (build_svg_cache_key(key, sizeof(key), k) != 0) return;
+
+    pthread_mutex_lock(&svg_cache_mutex);
+    store_locked(key, svg_buf_retain(svg));
+    pthread_mutex_unlock(&svg_cache_mutex);
+}
+
+svg_buf_t* svg_cache_get_variant(const svg_cache_key_t *k, compress_encoding_t encoding) {
+    if (!svg_cache_initialized || !k) return NULL;
+    if (encoding <= COMPRESS_IDENTITY || encoding >= COMPRESS_ENCODING_COUNT) return NULL;
+
+    char key[SVG_CACHE_KEY_SIZE];
+    if (build_svg_cache_key(key, sizeof(key), k) != 0) return NULL;
+
+    pthread_mutex_lock(&svg_cache_mutex);
+    svg_cache_entry_t *entry = find_live_locked(key);
+    svg_buf_t *result = NULL;
+    if (entry && entry->variant[encoding]) {
+        entry->referenced = 1;
+        result = svg_buf_retain(entry->variant[encoding]);
+    }
+    pthread_mutex_unlock(&svg_cache_mutex);
+    return result;
+}
+
+void svg_cache_put_variant(const svg_cache_key_t *k, compress_encoding_t encoding,
+                           const svg_buf_t *svg, svg_buf_t *data) {
+    if (!svg_cache_initialized || !k || !svg || !data) return;
+    if (encoding <= COMPRESS_IDENTITY || encoding >= COMPRESS_ENCODING_COUNT) return;
+
+    char key[SVG_CACHE_KEY_SIZE];
+    if (build_svg_cache_key(key, sizeof(key), k) != 0) return;
+
+    pthread_mutex_lock(&svg_cache_mutex);
+    /* Attach only to the render it was made from: the entry may have been
+     * re-rendered (new data points) since the caller read it. Renders are
+     * shared, not copied, so the buffer identifies it. */
+    svg_cache_entry_t *entry = find_live_locked(key);
+    if (entry && !entry->variant[encoding] && entry->svg == svg &&
+        (!svg_cache_max_bytes || entry->bytes + data->len <= svg_cache_max_bytes)) {
+        if (svg_cache_max_bytes) make_room_locked(data->len, entry);
+        entry->variant[encoding] = svg_buf_retain(data);
+        entry->bytes += data->len;
+        svg_cache_bytes += data->len;
+    }
+    pthread_mutex_unlock(&svg_cache_mutex);
+}
+
+svg_buf_t* svg_cache_acquire(const svg_cache_key_t *k, int *leader) {
+    *leader = 0;
+    if (!k) return NULL;
+
+    char key[SVG_CACHE_KEY_SIZE];
+    if (!svg_cache_initialized || build_svg_cache_key(key, sizeof(key), k) != 0) {
+        *leader = 1;  /* uncacheable: render alone, complete() is a no-op */
+        return NULL;
+    }
+
+    pthread_mutex_lock(&svg_cache_mutex);
+
+    svg_buf_t *result = lookup_locked(key);
+    if (result) {
+        pthread_mutex_unlock(&svg_cache_mutex);
+        return result;
+    }
+
+    svg_inflight_t *fl = svg_inflight;
+    while (fl && strcmp(fl->key, key) != 0) fl = fl->next;
+
+    if (!fl) {
+        /* First miss: claim the key */
+        fl = calloc(1, sizeof(svg_inflight_t));
+        if (fl) {
+            memcpy(fl->key, key, sizeof(fl->key));
+            pthread_cond_init(&fl->done_cond, NULL);
+            fl->next = svg_inflight;
+            svg_inflight = fl;
+        }
+        *leader = 1;  /* on OOM: render without coalescing */
+        pthread_mutex_unlock(&svg_cache_mutex);
+        return NULL;
+    }
+
+    /* Duplicate of an in-flight render: wait for it and share the result */
+    fl->waiters++;
+    while (!fl->done) {
+        pthread_cond_wait(&fl->done_cond, &svg_cache_mutex);
+    }
+    result = svg_buf_retain(fl->svg);
+    if (--fl->waiters == 0) {
+        pthread_cond_destroy(&fl->done_cond);
+        svg_buf_release(fl->svg);
+        free(fl);
+    }
+
+    pthread_mutex_unlock(&svg_cache_mutex);
+    return result;
+}
+
+void svg_cache_complete(const svg_cache_key_t *k, svg_buf_t *svg) {
+    if (!k) return;
+
+    char key[SVG_CACHE_KEY_SIZE];
+    if (!svg_cache_initialized || build_svg_cache_key(key, sizeof(key), k) != 0) return;
+
+    pthread_mutex_lock(&svg_cache_mutex);
+
+    if (svg) store_locked(key, svg_buf_retain(svg));
+
+    svg_inflight_t **link = &svg_inflight;
+    while (*link && strcmp((*link)->key, key) != 0) link = &(*link)->next;
+    svg_inflight_t *fl = *link;
+
+    if (fl) {
+        *link = fl->next;  /* later misses start a new flight (or hit the cache) */
+        fl->done = 1;
+        if (fl->waiters > 0) {
+            fl->svg = svg_buf_retain(svg);
+            pthread_cond_broadcast(&fl->done_cond);
+        } else {
+            pthread_cond_destroy(&fl->done_cond);
+            free(fl);
+        }
+    }
+
+    pthread_mutex_unlock(&svg_cache_mutex);
+}
+
+void svg_cache_stats(svg_cache_stats_t *out) {
+    pthread_mutex_lock(&svg_cache_mutex);
+    out->entries = svg_cache_entries;
+    out->bytes = svg_cache_bytes;
+    out->max_bytes = svg_cache_max_bytes;
+    out->evictions = svg_cache_evictions;
+    out->expirations = svg_cache_expirations;
+    pthread_mutex_unlock(&svg_cache_mutex);
+}
+
+void svg_cache_free(void) {
+    pthread_mutex_lock(&svg_cache_mutex);
+
+    for (int i = 0; i < SVG_CACHE_MAX_ENTRIES; i++) {
+        svg_cache_entry_t *entry = svg_slots[i];
+        while (entry) {
+            svg_cache_entry_t *next = entry->next;
+            free_entry(entry);
+            entry = next;
+        }
+        svg_slots[i] = NULL;
+    }
+
+    svg_cache_entries = 0;
+    svg_cache_bytes = 0;
+    svg_cache_initialized = 0;
+    pthread_mutex_unlock(&svg_cache_mutex);
+}
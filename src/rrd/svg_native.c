@@ -0,0 +1,787 @@
+/**
+ * @file svg_native.c
+ * @brief Native port of generate_svg.js (see svg_native.h)
+ *
+ * Each block mirrors the corresponding part of generateSVG() /
+ * generateStatSVG() in src/scripts/generate_svg.js, including the order of
+ * floating-point operations, so that the formatted numbers match. A change
+ * to the look of the bundled script has to be made in both places; the
+ * golden tests (tests/c/test_svg_native.c) fail until it is.
+ */
+
+#include "../include/rrd/svg_native.h"
+#include "../include/cfg.h"
+#include <math.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <time.h>
+
+/* JS rounds after every operation: no fused multiply-add contraction */
+#if defined(__clang__)
+#pragma STDC FP_CONTRACT OFF
+#elif defined(__GNUC__)
+#pragma GCC optimize ("fp-contract=off")
+#endif
+
+#define NUM_LEN 32
+
+/* THEMES in generate_svg.js (only the keys the renderers use) */
+typedef struct {
+    const char *name;
+    const char *background;
+    const char *grid_lines;
+    const char *text;
+    const char *text_primary;
+    const char *series[6];
+    const char *series_width;
+    const char *font_family;
+    const char *border;
+    const char *positive;
+    const char *negative;
+    const char *neutral;
+    const char *sparkline;
+    const char *tooltip_fill;
+    const char *tooltip_opacity;   /* as JS prints the number */
+    const char *tooltip_stroke;
+} theme_t;
+
+static const theme_t themes[] = {
+    {
+        .name = "light",
+        .background = "#ffffff", .grid_lines = "#e2e8f0",
+        .text = "#4a5568", .text_primary = "#1a202c",
+        .series = { "#3b82f6", "#10b981", "#f59e0b", "#ef4444", "#8b5cf6", "#ec4899" },
+        .series_width = "2",
+        .font_family = "-apple-system, BlinkMacSystemFont, 'Segoe UI', Roboto, sans-serif",
+        .border = "#e2e8f0", .positive = "#10b981", .negative = "#ef4444",
+        .neutral = "#6b7280", .sparkline = "#3b82f6",
+        .tooltip_fill = "#ffffff", .tooltip_opacity = "0.98", .tooltip_stroke = "#e2e8f0",
+    },
+    {
+        .name = "dark",
+        .background = "#1f2023", .grid_lines = "#2d2e32",
+        .text = "#9fa6b2", .text_primary = "#ffffff",
+        .series = { "#60a5fa", "#34d399", "#fbbf24", "#f87171", "#a78bfa", "#f472b6" },
+        .series_width = "2",
+        .font_family = "-apple-system, BlinkMacSystemFont, 'Segoe UI', Roboto, sans-serif",
+        .border = "#2d2e32", .positive = "#34d399", .negative = "#f87171",
+        .neutral = "#9ca3af", .sparkline = "#60a5fa",
+        .tooltip_fill = "#000000", .tooltip_opacity = "0.9", .tooltip_stroke = "#2d2e32",
+    },
+    {
+        .name = "high-contrast",
+        .background = "#000000", .grid_lines = "#ffffff",
+        .text = "#ffffff", .text_primary = "#ffff00",
+        .series = { "#ffff00", "#00ffff", "#ff00ff", "#00ff00", "#ff0000", "#ffffff" },
+        .series_width = "3",
+        .font_family = "'Courier New', Courier, monospace",
+        .border = "#ffffff", .positive = "#00ff00", .negative = "#ff0000",
+        .neutral = "#ffffff", .sparkline = "#ffff00",
+        .tooltip_fill = "#000000", .tooltip_opacity = "1", .tooltip_stroke = "#ffffff",
+    },
+};
+
+/* resolveTheme(): case-insensitive, unknown / missing -> light */
+static const theme_t *resolve_theme(const char *name) {
+    if (name && *name) {
+        for (size_t i = 0; i < sizeof(themes) / sizeof(themes[0]); i++) {
+            if (strcasecmp(name, themes[i].name) == 0) return &themes[i];
+        }
+    }
+    return &themes[0];
+}
+
+/* ---- Output buffer (svg.push(...) / svg.join('')) ---- */
+
+typedef struct {
+    char *buf;
+    size_t len;
+    size_t cap;
+    int failed;
+} sb_t;
+
+static void sb_putn(sb_t *sb, const char *s, size_t n) {
+    if (sb->failed) return;
+    if (sb->len + n + 1 > sb->cap) {
+        size_t cap = sb->cap ? sb->cap : 4096;
+        while (sb->len + n + 1 > cap) cap *= 2;
+        char *nb = realloc(sb->buf, cap);
+        if (!nb) {
+            sb->failed = 1;
+            return;
+        }
+        sb->buf = nb;
+        sb->cap = cap;
+    }
+    memcpy(sb->buf + sb->len, s, n);
+    sb->len += n;
+    sb->buf[sb->len] = '\0';
+}
+
+/* Append NULL-terminated list of strings */
+static void sb_cat(sb_t *sb, ...) {
+    va_list ap;
+    va_start(ap, sb);
+    const char *s;
+    while ((s = va_arg(ap, const char *)) != NULL) {
+        sb_putn(sb, s, strlen(s));
+    }
+    va_end(ap);
+}
+
+/* ---- JS number formatting ---- */
+
+/* Number.prototype.toString(): shortest round-trip digits, decimal notation
+ * for 1e-7 <= |x| < 1e21, exponent notation otherwise */
+static const char *js_number(char *out, double x) {
+    if (isnan(x)) return strcpy(out, "NaN");
+    if (isinf(x)) return strcpy(out, x < 0 ? "-Infinity" : "Infinity");
+    if (x == 0) return strcpy(out, "0");
+    if (x == floor(x) && fabs(x) < 9007199254740992.0) {
+        snprintf(out, NUM_LEN, "%.0f", x);
+        return out;
+    }
+
+    /* Shortest precision that reads back as x: "d.ddde±XX" */
+    double ax = fabs(x);
+    char e[NUM_LEN];
+    for (int p = 1; p <= 17; p++) {
+        snprintf(e, sizeof e, "%.*e", p - 1, ax);
+        if (strtod(e, NULL) == ax) break;
+    }
+    char digits[NUM_LEN];
+    int k = 0;
+    const char *c = e;
+    for (; *c && *c != 'e'; c++) {
+        if (*c != '.') digits[k++] = *c;
+    }
+    digits[k] = '\0';
+    int n = atoi(c + 1) + 1;
+
+    char *o = out;
+    if (x < 0) *o++ = '-';
+    if (k <= n && n <= 21) {
+        memcpy(o, digits, k);
+        o += k;
+        for (int i = 0; i < n - k; i++) *o++ = '0';
+    } else if (0 < n && n <= 21) {
+        memcpy(o, digits, n);
+        o += n;
+        *o++ = '.';
+        memcpy(o, digits + n, k - n);
+        o += k - n;
+    } else if (-6 < n && n <= 0) {
+        *o++ = '0';
+        *o++ = '.';
+        for (int i = 0; i < -n; i++) *o++ = '0';
+        memcpy(o, digits, k);
+        o += k;
+    } else {
+        *o++ = digits[0];
+        if (k > 1) {
+            *o++ = '.';
+            memcpy(o, digits + 1, k - 1);
+            o += k - 1;
+        }
+        o += sprintf(o, "e%c%d", n - 1 >= 0 ? '+' : '-', abs(n - 1));
+    }
+    *o = '\0';
+    return out;
+}
+
+/* Number.prototype.toFixed(digits), digits 0..2: the decimal closest to the
+ * exact binary value, exact ties to the larger magnitude (0.125 -> "0.13";
+ * printf would give "0.12"). */
+static const char *js_fixed(char *out, double x, int digits) {
+    if (isnan(x) || fabs(x) >= 1e21) return js_number(out, x);
+    if (x == 0) x = 0;                                   /* -0 -> "0.00" */
+
+    double scale = digits == 0 ? 1 : digits == 1 ? 10 : 100;
+    double ax = fabs(x);
+    double y = ax * scale;
+    double n = floor(y);
+    double frac = y - n;
+
+    if (y < 4294967296.0 && fabs(frac - 0.5) > 1e-6) {
+        /* Fast path: below 2^32 the rounding error of y is < 1e-6, so it
+         * cannot move frac across 0.5 */
+        if (frac > 0.5) n += 1;
+    } else {
+        /* printf rounds exact ties to even, toFixed() up. Split off the
+         * integer part so the tie test stays exact at any magnitude */
+        double ip = floor(ax), fp = ax - ip, z = fp * scale;
+        if (z - floor(z) != 0.5 || fma(fp, scale, -z) != 0) {
+            snprintf(out, NUM_LEN, "%.*f", digits, x);
+            return out;
+        }
+        double m = floor(z) + 1;
+        if (m == scale) {
+            ip += 1;
+            m = 0;
+        }
+        if (digits == 0)
+            snprintf(out, NUM_LEN, "%s%.0f", x < 0 ? "-" : "", ip);
+        else
+            snprintf(out, NUM_LEN, "%s%.0f.%0*d", x < 0 ? "-" : "", ip, digits, (int)m);
+        return out;
+    }
+
+    /* n (< 2^53) as digits, least significant first, at least digits + 1 */
+    char m[NUM_LEN];
+    int len = 0;
+    unsigned long long u = (unsigned long long)n;
+    do {
+        m[len++] = (char)('0' + u % 10);
+        u /= 10;
+    } while (u);
+    while (len < digits + 1) m[len++] = '0';
+
+    char *o = out;
+    if (x < 0) *o++ = '-';                               /* -0.001 -> "-0.00" */
+    while (len > 0) {
+        if (len == digits) *o++ = '.';
+        *o++ = m[--len];
+    }
+    *o = '\0';
+    return out;
+}
+
+/* Math.round() as Duktape implements it: ties toward +Infinity, and
+ * (-0.5, 0.5) -> ±0 so 0.49999999999999994 does not round up */
+static double js_round(double x) {
+    if (isnan(x) || isinf(x) || x == 0) return x;
+    if (x >= -0.5 && x < 0.5) return x < 0 ? -0.0 : 0.0;
+    return floor(x + 0.5);
+}
+
+/* The valueFormatter closures: "%d" / "%.0f", "%.1f", anything else "%.2f" */
+typedef enum { FMT_ROUND, FMT_FIXED1, FMT_FIXED2 } value_fmt_t;
+
+static value_fmt_t value_fmt(const char *value_format) {
+    if (strcmp(value_format, "%d") == 0 || strcmp(value_format, "%.0f") == 0) return FMT_ROUND;
+    if (strcmp(value_format, "%.1f") == 0) return FMT_FIXED1;
+    return FMT_FIXED2;
+}
+
+static const char *format_value(char *out, double v, value_fmt_t fmt) {
+    if (fmt == FMT_ROUND) return js_number(out, js_round(v));
+    return js_fixed(out, v, fmt == FMT_FIXED1 ? 1 : 2);
+}
+
+/* new Date(ts * 1000) in local time (TimeClip truncates the milliseconds) */
+static void js_local_time(double ts, struct tm *tm) {
+    double ms = trunc(ts * 1000);
+    time_t t = (time_t)floor(ms / 1000);
+    if (!localtime_r(&t, tm)) memset(tm, 0, sizeof *tm);
+}
+
+/* ---- Options as generate_svg.js sees them ---- */
+
+typedef struct {
+    int width;                    /* 0 -> renderer default */
+    int height;
+    const char *param1;           /* "" when absent */
+    const char *title;            /* "" when absent */
+    const char *y_label;
+    int is_percentage;
+    const char *transform_type;
+    double value_multiplier;      /* already || 1.0 */
+    double transform_divisor;     /* already || 1.0 */
+    value_fmt_t fmt;
+    const theme_t *colors;
+} options_t;
+
+/* Series as svg_generate() hands them over: empty series are skipped */
+typedef struct {
+    const char *name;
+    const DataPoint *points;
+    int n;
+} series_t;
+
+
+/* s.name.replace(/[^a-zA-Z0-9]/g, '_'): one '_' per character, not per
+ * UTF-8 byte */
+static void put_escaped_id(sb_t *sb, const char *name) {
+    for (const unsigned char *c = (const unsigned char *)name; *c; c++) {
+        if ((*c >= 'a' && *c <= 'z') || (*c >= 'A' && *c <= 'Z') || (*c >= '0' && *c <= '9')) {
+            sb_putn(sb, (const char *)c, 1);
+        } else if ((*c & 0xC0) != 0x80) {
+            sb_putn(sb, "_", 1);
+        }
+    }
+}
+
+/* s.name.replace(/'/g, "\\'") */
+static void put_escaped_js(sb_t *sb, const char *name) {
+    for (const char *c = name; *c; c++) {
+        if (*c == '\'') sb_putn(sb, "\\'", 2);
+        else sb_putn(sb, c, 1);
+    }
+}
+
+/* title.replace('%s', param1): first occurrence; "$$", "$&", "$`" and "$'"
+ * in param1 are substitution patterns, as in String.prototype.replace */
+static void put_title(sb_t *sb, const char *title, const char *param1) {
+    const char *at = *param1 ? strstr(title, "%s") : NULL;
+    if (!at) {
+        sb_cat(sb, title, NULL);
+        return;
+    }
+    sb_putn(sb, title, (size_t)(at - title));
+    for (const char *c = param1; *c; c++) {
+        if (c[0] == '$' && c[1] == '$') sb_putn(sb, "$", 1);
+        else if (c[0] == '$' && c[1] == '&') sb_putn(sb, "%s", 2);
+        else if (c[0] == '$' && c[1] == '`') sb_putn(sb, title, (size_t)(at - title));
+        else if (c[0] == '$' && c[1] == '\'') sb_cat(sb, at + 2, NULL);
+        else {
+            sb_putn(sb, c, 1);
+            continue;
+        }
+        c++;
+    }
+    sb_cat(sb, at + 2, NULL);
+}
+
+static void put_error(sb_t *sb, double width, double height, const char *font_size, const char *msg) {
+    char x[NUM_LEN], y[NUM_LEN];
+    sb_cat(sb, "<text x=\"", js_number(x, width / 2), "\" y=\"", js_number(y, height / 2),
+           "\" text-anchor=\"middle\" fill=\"#ef4444\" font-size=\"", font_size, "\">", msg,
+           "</text></svg>", NULL);
+}
+
+static double transform(const options_t *o, double val) {
+    if (strcmp(o->transform_type, "multiply") == 0) return val * o->value_multiplier;
+    if (strcmp(o->transform_type, "divide") == 0) return val / o->transform_divisor;
+    return val;
+}
+
+/* Axis label for a (fractional) timestamp; the format depends on the range */
+static void format_axis_time(char *out, size_t size, double ts, double time_range) {
+    struct tm tm;
+    js_local_time(ts, &tm);
+    if (time_range > 604800) {
+        snprintf(out, size, "%d/%d", tm.tm_mon + 1, tm.tm_mday);
+    } else if (time_range > 86400) {
+        snprintf(out, size, "%d/%d %02d:%02d", tm.tm_mon + 1, tm.tm_mday, tm.tm_hour, tm.tm_min);
+    } else if (time_range > 3600) {
+        snprintf(out, size, "%02d:%02d", tm.tm_hour, tm.tm_min);
+    } else {
+        snprintf(out, size, "%02d:%02d:%02d", tm.tm_hour, tm.tm_min, tm.tm_sec);
+    }
+}
+
+/* Valid (transformed) point of one series, with its formatted coordinates */
+typedef struct {
+    double t;
+    double v;
+    char x[NUM_LEN];
+    char y[NUM_LEN];
+} chart_point_t;
+
+/* generateSVG(): line/area chart */
+static void render_chart(sb_t *sb, const series_t *series, int series_count, const options_t *o) {
+    double width = o->width ? o->width : 800;
+    double height = o->height ? o->height : 450;
+    double m_top = fmax(30, height * 0.08);
+    double m_right = fmax(30, width * 0.05);
+    double m_bottom = fmax(65, height * 0.18);
+    double m_left = fmax(50, width * 0.08);
+    double graph_width = width - m_left - m_right;
+    double graph_height = height - m_top - m_bottom;
+    double title_size = fmax(12, fmin(18, width * 0.02));
+    const theme_t *colors = o->colors;
+    char a[NUM_LEN], b[NUM_LEN], c[NUM_LEN], d[NUM_LEN];
+
+    sb_cat(sb, "<svg width=\"100%\" height=\"100%\" viewBox=\"0 0 ", js_number(a, width), " ",
+           js_number(b, height), "\" preserveAspectRatio=\"none\" xmlns=\"http://www.w3.org/2000/svg\" style=\"font-family: ",
+           colors->font_family, ";\">", NULL);
+    sb_cat(sb, "<rect width=\"100%\" height=\"100%\" fill=\"", colors->background, "\"/>", NULL);
+
+    if (series_count == 0) {
+        put_error(sb, width, height, "14", "Error: No data series");
+        return;
+    }
+
+    const char *title = o->title[0] ? o->title : "Metric";
+    const char *y_label = o->y_label[0] ? o->y_label : "Value";
+    int needs_transform = strcmp(o->transform_type, "none") != 0;
+
+    /* One pass: valid point count, value and time ranges */
+    long valid_count = 0;
+    int max_n = 0;
+    double data_min = INFINITY, data_max = -INFINITY;
+    double min_time = INFINITY, max_time = -INFINITY;
+    for (int si = 0; si < series_count; si++) {
+        if (series[si].n > max_n) max_n = series[si].n;
+        for (int di = 0; di < series[si].n; di++) {
+            double val = series[si].points[di].value;
+            if (isnan(val) || val < 0) continue;
+            val = transform(o, val);
+            valid_count++;
+            if (val < data_min) data_min = val;
+            if (val > data_max) data_max = val;
+            double t = (double)series[si].points[di].timestamp;
+            if (t < min_time) min_time = t;
+            if (t > max_time) max_time = t;
+        }
+    }
+
+    if (valid_count == 0) {
+        put_error(sb, width, height, "14", "Error: No valid data points");
+        return;
+    }
+
+    double min_val, max_val;
+    if (o->is_percentage) {
+        min_val = 0;
+        max_val = 100;
+    } else {
+        min_val = data_min;
+        max_val = data_max;
+        double padding = (max_val - min_val) * 0.1;
+        if (padding == 0) {
+            padding = fabs(max_val) * 0.1;
+            if (padding == 0 || isnan(padding)) padding = 1;
+        }
+        min_val = fmax(0, min_val - padding);
+        max_val = max_val + padding;
+    }
+
+    double time_range = max_time - min_time;
+    if (time_range == 0) time_range = 1;
+    double value_range = max_val - min_val;
+
+    sb_cat(sb, "<g transform=\"translate(", js_number(a, m_left), ",", js_number(b, m_top), ")\">", NULL);
+    sb_cat(sb, "<rect width=\"", js_number(a, graph_width), "\" height=\"", js_number(b, graph_height),
+           "\" fill=\"", colors->background, "\" stroke=\"", colors->grid_lines, "\" stroke-width=\"1\"/>", NULL);
+
+    /* Grid lines and value labels */
+    int y_steps = 5;
+    js_number(c, graph_width);
+    for (int i = 0; i <= y_steps; i++) {
+        js_fixed(a, graph_height * (1 - (double)i / y_steps), 2);
+        double value = min_val + value_range * ((double)i / y_steps);
+        sb_cat(sb, "<line x1=\"0\" y1=\"", a, "\" x2=\"", c, "\" y2=\"", a, "\" stroke=\"",
+               colors->grid_lines, "\" stroke-width=\"1\" opacity=\"0.5\"/>", NULL);
+        sb_cat(sb, "<text x=\"-10\" y=\"", js_fixed(b, strtod(a, NULL) + 4, 2),
+               "\" text-anchor=\"end\" font-size=\"11\" fill=\"", colors->text, "\">",
+               format_value(d, value, o->fmt), "</text>", NULL);
+    }
+
+    /* Time grid and labels */
+    int x_steps = (int)fmin(8, fmax(4, floor(graph_width / 100)));
+    js_number(c, graph_height);
+    js_number(d, graph_height + 20);
+    for (int i = 0; i <= x_steps; i++) {
+        char time_str[32];
+        js_fixed(a, graph_width * i / x_steps, 2);
+        format_axis_time(time_str, sizeof time_str, min_time + time_range * i / x_steps, time_range);
+        sb_cat(sb, "<line x1=\"", a, "\" y1=\"0\" x2=\"", a, "\" y2=\"", c, "\" stroke=\"",
+               colors->grid_lines, "\" stroke-width=\"1\" opacity=\"0.5\"/>", NULL);
+        sb_cat(sb, "<text x=\"", a, "\" y=\"", d, "\" text-anchor=\"middle\" font-size=\"11\" fill=\"",
+               colors->text, "\">", time_str, "</text>", NULL);
+    }
+
+    /* Series: gradient area + line per segment, then hover points */
+    double avg_step = time_range / ((double)valid_count / series_count);
+    double gap_threshold = avg_step * 3;
+    chart_point_t *pts = malloc((size_t)(max_n > 0 ? max_n : 1) * sizeof(chart_point_t));
+    if (!pts) {
+        sb->failed = 1;
+        return;
+    }
+    char gh[NUM_LEN];
+    js_number(gh, graph_height);
+
+    for (int si = 0; si < series_count; si++) {
+        const char *color = colors->series[si % 6];
+        int n = 0;
+        for (int di = 0; di < series[si].n; di++) {
+            double val = series[si].points[di].value;
+            if (needs_transform) val = transform(o, val);
+            if (isnan(val) || val < 0) continue;
+            chart_point_t *p = &pts[n++];
+            p->t = (double)series[si].points[di].timestamp;
+            p->v = val;
+            js_fixed(p->x, graph_width * (p->t - min_time) / time_range, 2);
+            js_fixed(p->y, graph_height * (1 - (fmin(max_val, fmax(min_val, val)) - min_val) / value_range), 2);
+        }
+        if (n == 0) continue;
+
+        int seg_start = 0;
+        for (int segi = 0; seg_start < n; segi++) {
+            int seg_end = seg_start + 1;
+            while (seg_end < n && !(pts[seg_end].t - pts[seg_end - 1].t > gap_threshold)) seg_end++;
+            if (seg_end - seg_start >= 2) {
+                char gradient_id[32];
+                snprintf(gradient_id, sizeof gradient_id, "g%d-%d", si, segi);
+                sb_cat(sb, "<defs><linearGradient id=\"", gradient_id, "\" x1=\"0%\" y1=\"0%\" x2=\"0%\" y2=\"100%\">", NULL);
+                sb_cat(sb, "<stop offset=\"0%\" style=\"stop-color:", color, ";stop-opacity:0.3\"/>", NULL);
+                sb_cat(sb, "<stop offset=\"100%\" style=\"stop-color:", color, ";stop-opacity:0.05\"/>", NULL);
+                sb_cat(sb, "</linearGradient></defs>", NULL);
+
+                sb_cat(sb, "<path d=\"M", pts[seg_start].x, ",", gh, NULL);
+                for (int i = seg_start; i < seg_end; i++) {
+                    sb_cat(sb, " L", pts[i].x, ",", pts[i].y, NULL);
+                }
+                sb_cat(sb, " L", pts[seg_end - 1].x, ",", gh, " Z\" fill=\"url(#", gradient_id, ")\"/>", NULL);
+
+                sb_cat(sb, "<path d=\"M", pts[seg_start].x, ",", pts[seg_start].y, NULL);
+                for (int i = seg_start + 1; i < seg_end; i++) {
+                    sb_cat(sb, " L", pts[i].x, ",", pts[i].y, NULL);
+                }
+                sb_cat(sb, "\" stroke=\"", color, "\" fill=\"none\" stroke-width=\"", colors->series_width,
+                       "\" stroke-linejoin=\"round\" stroke-linecap=\"round\"/>", NULL);
+            }
+            seg_start = seg_end;
+        }
+
+        for (int i = 0; i < n; i++) {
+            struct tm tm;
+            char time_str[16], index[16];
+            js_local_time(pts[i].t, &tm);
+            snprintf(time_str, sizeof time_str, "%02d:%02d:%02d", tm.tm_hour, tm.tm_min, tm.tm_sec);
+            snprintf(index, sizeof index, "%d", i);
+            sb_cat(sb, "<circle id=\"p-", NULL);
+            put_escaped_id(sb, series[si].name);
+            sb_cat(sb, "-", index, "\" cx=\"", pts[i].x, "\" cy=\"", pts[i].y, "\" r=\"4\" fill=\"", color,
+                   "\" opacity=\"0\" style=\"cursor: pointer;\" onmouseover=\"showTooltip(evt, '", NULL);
+            put_escaped_js(sb, series[si].name);
+            sb_cat(sb, "', '", format_value(a, pts[i].v, o->fmt), "', '", time_str, "', ", pts[i].x, ", ",
+                   pts[i].y, ")\" onmouseout=\"hideTooltip()\"/>", NULL);
+        }
+    }
+    free(pts);
+
+    sb_cat(sb, "</g>", NULL);
+
+    /* Title and Y-axis label */
+    sb_cat(sb, "<text x=\"", js_number(a, width / 2), "\" y=\"25\" text-anchor=\"middle\" font-size=\"",
+           js_number(b, title_size), "\" font-weight=\"600\" fill=\"", colors->text_primary, "\">", NULL);
+    put_title(sb, title, o->param1);
+    sb_cat(sb, "</text>", NULL);
+    js_number(a, height / 2);
+    sb_cat(sb, "<text x=\"20\" y=\"", a, "\" text-anchor=\"middle\" transform=\"rotate(-90,20,", a,
+           ")\" font-size=\"12\" font-weight=\"500\" fill=\"", colors->text, "\">", y_label, "</text>", NULL);
+
+    /* Legend: last value of each series */
+    double legend_y = height - 35;
+    double legend_x = m_left;
+    sb_cat(sb, "<g font-size=\"11\">", NULL);
+    for (int si = 0; si < series_count; si++) {
+        double raw = series[si].points[series[si].n - 1].value;
+        if (isnan(raw) || raw < 0) continue;
+        if (needs_transform) raw = transform(o, raw);
+
+        const char *color = colors->series[si % 6];
+        double item_width = 180;
+        sb_cat(sb, "<rect x=\"", js_number(a, legend_x), "\" y=\"", js_number(b, legend_y - 12),
+               "\" width=\"180\" height=\"18\" fill=\"", colors->grid_lines, "\" opacity=\"0.3\" rx=\"3\"/>", NULL);
+        sb_cat(sb, "<rect x=\"", js_number(a, legend_x + 5), "\" y=\"", js_number(b, legend_y - 7),
+               "\" width=\"10\" height=\"10\" fill=\"", color, "\" rx=\"2\"/>", NULL);
+        js_number(b, legend_y + 2);
+        sb_cat(sb, "<text x=\"", js_number(a, legend_x + 20), "\" y=\"", b, "\" fill=\"", colors->text_primary,
+               "\" font-weight=\"500\">", series[si].name, ":</text>", NULL);
+        sb_cat(sb, "<text x=\"", js_number(a, legend_x + 90), "\" y=\"", b, "\" fill=\"", color,
+               "\" font-weight=\"600\">", format_value(c, raw, o->fmt), "</text>", NULL);
+
+        legend_x += item_width + 15;
+        if (legend_x > width - 200) {
+            legend_x = m_left;
+            legend_y += 25;
+        }
+    }
+    sb_cat(sb, "</g>", NULL);
+
+    /* Tooltip group */
+    sb_cat(sb, "<g id=\"tooltip\" visibility=\"hidden\">", NULL);
+    sb_cat(sb, "<rect x=\"0\" y=\"0\" width=\"160\" height=\"50\" fill=\"", colors->tooltip_fill, "\" opacity=\"",
+           colors->tooltip_opacity, "\" rx=\"6\" stroke=\"", colors->tooltip_stroke,
+           "\" stroke-width=\"1\" style=\"filter: drop-shadow(0px 2px 4px rgba(0,0,0,0.1))\"/>", NULL);
+    sb_cat(sb, "<text x=\"8\" y=\"18\" font-size=\"11\" fill=\"", colors->text, "\" id=\"tooltip-series\"></text>", NULL);
+    sb_cat(sb, "<text x=\"8\" y=\"35\" font-size=\"12\" font-weight=\"600\" fill=\"", colors->text_primary,
+           "\" id=\"tooltip-value\"></text>", NULL);
+    sb_cat(sb, "</g>", NULL);
+    sb_cat(sb, "</svg>", NULL);
+}
+
+/* allData.sort() by timestamp; the index makes it stable (Duktape's sort is
+ * not, so the JS order of equal timestamps from different series varies) */
+typedef struct {
+    double t;
+    double v;
+    int index;
+} stat_point_t;
+
+static int stat_point_cmp(const void *a, const void *b) {
+    const stat_point_t *pa = a, *pb = b;
+    if (pa->t != pb->t) return pa->t < pb->t ? -1 : 1;
+    return pa->index - pb->index;
+}
+
+/* generateStatSVG(): current value, trend vs the first value, sparkline */
+static void render_stat(sb_t *sb, const series_t *series, int series_count, const options_t *o) {
+    double width = o->width ? o->width : 300;
+    double height = o->height ? o->height : 150;
+    double value_size = fmax(18, fmin(32, height * 0.25));
+    double title_size = fmax(10, fmin(14, height * 0.1));
+    double spark_height = fmax(12, fmin(30, height * 0.2));
+    double spark_width = fmax(40, fmin(100, width * 0.3));
+    const char *title = o->title[0] ? o->title : "Metric";
+    const char *y_label = o->y_label;
+    const theme_t *colors = o->colors;
+    int divide = strcmp(o->transform_type, "divide") == 0;
+    char a[NUM_LEN], b[NUM_LEN];
+
+    int total = 0;
+    for (int si = 0; si < series_count; si++) total += series[si].n;
+    stat_point_t *all = malloc((size_t)(total > 0 ? total : 1) * sizeof(stat_point_t));
+    if (!all) {
+        sb->failed = 1;
+        return;
+    }
+    int n = 0;
+    for (int si = 0; si < series_count; si++) {
+        for (int di = 0; di < series[si].n; di++) {
+            double val = series[si].points[di].value;
+            if (isnan(val) || val < 0) continue;
+            if (divide) val = val / o->transform_divisor;
+            all[n].t = (double)series[si].points[di].timestamp;
+            all[n].v = val;
+            all[n].index = n;
+            n++;
+        }
+    }
+
+    if (n == 0) {
+        free(all);
+        sb_cat(sb, "<svg width=\"100%\" height=\"100%\" viewBox=\"0 0 ", js_number(a, width), " ",
+               js_number(b, height), "\" preserveAspectRatio=\"none\" xmlns=\"http://www.w3.org/2000/svg\">", NULL);
+        sb_cat(sb, "<rect width=\"100%\" height=\"100%\" fill=\"", colors->background, "\"/>", NULL);
+        put_error(sb, width, height, "12", "No data");
+        return;
+    }
+
+    qsort(all, (size_t)n, sizeof(stat_point_t), stat_point_cmp);
+
+    double current = all[n - 1].v;
+    double first = all[0].v;
+    double trend = current - first;
+    double trend_percent = first != 0 ? (trend / first * 100) : 0;
+
+    char formatted_value[NUM_LEN], formatted_trend[NUM_LEN + 1], formatted_percent[NUM_LEN + 2];
+    format_value(formatted_value, current, o->fmt);
+    format_value(a, fabs(trend), o->fmt);
+    snprintf(formatted_trend, sizeof formatted_trend, "%s%s", trend >= 0 ? "+" : "", a);
+    js_fixed(a, trend_percent, 1);
+    snprintf(formatted_percent, sizeof formatted_percent, "%s%s%%", trend_percent >= 0 ? "+" : "", a);
+
+    const char *trend_color = colors->neutral;
+    const char *trend_arrow = "\xe2\x86\x92";           /* → */
+    if (trend > 0) {
+        trend_color = colors->positive;
+        trend_arrow = "\xe2\x86\x91";                   /* ↑ */
+    } else if (trend < 0) {
+        trend_color = colors->negative;
+        trend_arrow = "\xe2\x86\x93";                   /* ↓ */
+    }
+
+    sb_cat(sb, "<svg width=\"100%\" height=\"100%\" viewBox=\"0 0 ", js_number(a, width), " ",
+           js_number(b, height), "\" preserveAspectRatio=\"none\" xmlns=\"http://www.w3.org/2000/svg\" style=\"font-family: ",
+           colors->font_family, ";\">", NULL);
+    sb_cat(sb, "<rect width=\"100%\" height=\"100%\" fill=\"", colors->background, "\" stroke=\"", colors->border,
+           "\" stroke-width=\"1\" rx=\"4\"/>", NULL);
+
+    sb_cat(sb, "<text x=\"12\" y=\"22\" font-size=\"", js_number(a, title_size), "\" font-weight=\"600\" fill=\"",
+           colors->text, "\">", title, "</text>", NULL);
+
+    sb_cat(sb, "<text x=\"12\" y=\"", js_fixed(a, height * 0.45, 0), "\" font-size=\"", js_number(b, value_size),
+           "\" font-weight=\"700\" fill=\"", colors->text_primary, "\">", formatted_value, NULL);
+    if (y_label[0]) {
+        sb_cat(sb, "<tspan font-size=\"12\" font-weight=\"400\" fill=\"", colors->text, "\"> ", y_label, "</tspan>", NULL);
+    }
+    sb_cat(sb, "</text>", NULL);
+
+    sb_cat(sb, "<text x=\"12\" y=\"", js_fixed(a, height * 0.6, 0), "\" font-size=\"12\" font-weight=\"500\">", NULL);
+    sb_cat(sb, "<tspan fill=\"", trend_color, "\">", trend_arrow, " ", formatted_trend, NULL);
+    if (y_label[0]) {
+        sb_cat(sb, " (", formatted_percent, ")", NULL);
+    }
+    sb_cat(sb, "</tspan></text>", NULL);
+
+    if (n > 1) {
+        double spark_x = 10;
+        double spark_y = height - spark_height - 10;
+        double min_val = INFINITY, max_val = -INFINITY;
+        for (int i = 0; i < n; i++) {
+            if (all[i].v < min_val) min_val = all[i].v;
+            if (all[i].v > max_val) max_val = all[i].v;
+        }
+        double value_range = max_val - min_val;
+        if (value_range == 0) value_range = 1;
+        double time_range = all[n - 1].t - all[0].t;
+        if (time_range == 0) time_range = 1;
+
+        sb_cat(sb, "<path d=\"", NULL);
+        for (int i = 0; i < n; i++) {
+            double x = spark_x + (all[i].t - all[0].t) / time_range * spark_width;
+            double y = spark_y + spark_height - (all[i].v - min_val) / value_range * spark_height;
+            sb_cat(sb, i == 0 ? "M" : " L", js_fixed(a, x, 2), ",", js_fixed(b, y, 2), NULL);
+        }
+        sb_cat(sb, "\" stroke=\"", colors->sparkline,
+               "\" fill=\"none\" stroke-width=\"1.5\" stroke-linecap=\"round\" stroke-linejoin=\"round\"/>", NULL);
+    }
+
+    sb_cat(sb, "</svg>", NULL);
+    free(all);
+}
+
+char* svg_native_generate(const MetricData *data, const MetricConfig *metric,
+                          int width, int height, const char *theme, size_t *out_len) {
+    const MetricConfig *cfg = metric ? metric : data->metric_config;
+    options_t o = {
+        .width = width,
+        .height = height,
+        .param1 = data->param1 ? data->param1 : "",
+        .title = cfg ? cfg->title : "",
+        .y_label = cfg ? cfg->y_label : "",
+        .is_percentage = cfg ? cfg->is_percentage : 0,
+        .transform_type = cfg && cfg->transform_type[0] ? cfg->transform_type : "none",
+        .value_multiplier = cfg && cfg->value_multiplier != 0 && !isnan(cfg->value_multiplier)
+                            ? cfg->value_multiplier : 1.0,
+        .transform_divisor = cfg && cfg->transform_divisor != 0 && !isnan(cfg->transform_divisor)
+                             ? cfg->transform_divisor : 1.0,
+        .fmt = value_fmt(cfg ? cfg->value_format : ""),
+        .colors = resolve_theme(theme),
+    };
+
+    /* Empty series are not passed to generateSVG (see svg_generate()) */
+    series_t *series = malloc((size_t)(data->series_count > 0 ? data->series_count : 1) * sizeof(series_t));
+    if (!series) return NULL;
+    int series_count = 0;
+    for (int s = 0; s < data->series_count; s++) {
+        if (data->series_counts[s] == 0) continue;
+        series[series_count].name = data->series_names[s];
+        series[series_count].points = data->series_data[s];
+        series[series_count].n = data->series_counts[s];
+        series_count++;
+    }
+
+    sb_t sb = { 0 };
+    if (cfg && strcmp(cfg->panel_type, "stat") == 0) {
+        render_stat(&sb, series, series_count, &o);
+    } else {
+        render_chart(&sb, series, series_count, &o);
+    }
+    free(series);
+
+    if (sb.failed) {
+        free(sb.buf);
+        return NULL;
+    }
+    if (out_len) *out_len = sb.len;
+    return sb.buf;
+}
@@ -0,0 +1,199 @@
+/**
+ * @file svg_reload.c
+ * @brief Hot reload of the generate_svg script (SIGHUP / inotify)
+ *
+ * One thread polls a self-pipe, written by svg_reload_request() (the SIGHUP
+ * handler) and by svg_reload_stop(), plus in "inotify" mode an inotify watch
+ * on the script's directory. The directory is watched rather than the file
+ * because editors and deploy tools replace the file by rename, which would
+ * orphan a watch on the old inode. After the first event the thread waits
+ * until RELOAD_DEBOUNCE_MS pass without another, then reloads once.
+ */
+
+#include "../include/rrd/svg_reload.h"
+#include "../include/rrd/svg.h"
+#include <errno.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <poll.h>
+#include <pthread.h>
+#include <signal.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/inotify.h>
+#include <unistd.h>
+
+#define RELOAD_DEBOUNCE_MS 200
+
+static int wake_pipe[2] = { -1, -1 };
+static int inotify_fd = -1;
+static char watch_name[NAME_MAX + 1];
+static pthread_t reload_thread;
+static int reload_running = 0;
+
+int svg_reload_mode_parse(const char *name, svg_reload_mode_t *out) {
+    if (!name || !out) return -1;
+    if (strcmp(name, "sighup") == 0) *out = SVG_RELOAD_SIGHUP;
+    else if (strcmp(name, "inotify") == 0) *out = SVG_RELOAD_INOTIFY;
+    else return -1;
+    return 0;
+}
+
+/* Watch the script's directory; watch_name filters the events */
+static int watch_script(const char *script_path) {
+    char dir[PATH_MAX];
+    const char *slash = strrchr(script_path, '/');
+    const char *name = slash ? slash + 1 : script_path;
+    if (!*name || strlen(name) >= sizeof(watch_name)) return -1;
+    if (!slash) {
+        strcpy(dir, ".");
+    } else if (slash == script_path) {
+        strcpy(dir, "/");
+    } else {
+        size_t len = (size_t)(slash - script_path);
+        if (len >= sizeof(dir)) return -1;
+        memcpy(dir, script_path, len);
+        dir[len] = '\0';
+    }
+    strcpy(watch_name, name);
+
+    inotify_fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if (inotify_fd < 0) return -1;
+    if (inotify_add_watch(inotify_fd, dir, IN_CLOSE_WRITE | IN_MOVED_TO) < 0) {
+        close(inotify_fd);
+        inotify_fd = -1;
+        return -1;
+    }
+    return 0;
+}
+
+/* Drain pending inotify events; 1 if one of them is about the script */
+static int drain_inotify(void) {
+    char buf[4096] __attribute__((aligned(__alignof__(struct inotify_event))));
+    int hit = 0;
+    ssize_t n;
+    while ((n = read(inotify_fd, buf, sizeof(buf))) > 0) {
+        for (char *p = buf; p < buf + n;) {
+            const struct inotify_event *ev = (const struct inotify_event *)p;
+            if ((ev->mask & IN_Q_OVERFLOW) ||
+                (ev->len && strcmp(ev->name, watch_name) == 0)) {
+                hit = 1;
+            }
+            p += sizeof(*ev) + ev->len;
+        }
+    }
+    return hit;
+}
+
+/* Drain the self-pipe: 'q' = stop, anything else = reload. Returns -1 on
+ * stop, 1 on reload, 0 when empty. */
+static int drain_pipe(void) {
+    char buf[64];
+    int result = 0;
+    ssize_t n;
+    while ((n = read(wake_pipe[0], buf, sizeof(buf))) > 0) {
+        for (ssize_t i = 0; i < n; i++) {
+            if (buf[i] == 'q') return -1;
+            result = 1;
+        }
+    }
+    return result;
+}
+
+/* Wait up to timeout_ms; -1 on stop, 1 if a reload was triggered, 0 otherwise */
+static int wait_event(int timeout_ms) {
+    struct pollfd fds[2] = {
+        { .fd = wake_pipe[0], .events = POLLIN },
+        { .fd = inotify_fd, .events = POLLIN },
+    };
+    int n = poll(fds, inotify_fd >= 0 ? 2 : 1, timeout_ms);
+    if (n <= 0) return 0;       /* timeout or EINTR */
+
+    int result = 0;
+    if (fds[0].revents & POLLIN) {
+        result = drain_pipe();
+        if (result < 0) return -1;
+    }
+    if (inotify_fd >= 0 && (fds[1].revents & POLLIN) && drain_inotify()) result = 1;
+    return result;
+}
+
+static void *reload_main(void *arg) {
+    (void)arg;
+    for (;;) {
+        int ev = wait_event(-1);
+        if (ev < 0) break;
+        if (ev == 0) continue;
+
+        /* An editor save or a deploy is several events in a row */
+        while ((ev = wait_event(RELOAD_DEBOUNCE_MS)) > 0) {
+        }
+        if (ev < 0) break;
+        svg_reload_script();
+    }
+    return NULL;
+}
+
+int svg_reload_start(const char *script_path, svg_reload_mode_t mode) {
+    if (reload_running) return 0;
+    if (pipe(wake_pipe) != 0) {
+        wake_pipe[0] = wake_pipe[1] = -1;
+        return -1;
+    }
+    for (int i = 0; i < 2; i++) {
+        fcntl(wake_pipe[i], F_SETFL, O_NONBLOCK);
+        fcntl(wake_pipe[i], F_SETFD, FD_CLOEXEC);
+    }
+
+    int rc = 0;
+    if (mode == SVG_RELOAD_INOTIFY && (!script_path || watch_script(script_path) != 0)) {
+        fprintf(stderr, "Warning: cannot watch %s (%s), reload on SIGHUP only\n",
+                script_path ? script_path : "(null)", strerror(errno));
+        rc = -1;
+    }
+
+    /* Signals stay with the other threads: SIGINT/SIGTERM must interrupt
+     * the server loop, SIGHUP only needs to reach the pipe */
+    sigset_t block, old;
+    sigfillset(&block);
+    pthread_sigmask(SIG_BLOCK, &block, &old);
+    int created = pthread_create(&reload_thread, NULL, reload_main, NULL);
+    pthread_sigmask(SIG_SETMASK, &old, NULL);
+
+    if (created != 0) {
+        fprintf(stderr, "Warning: script reload thread not started\n");
+        svg_reload_stop();
+        return -1;
+    }
+    reload_running = 1;
+    return rc;
+}
+
+void svg_reload_request(void) {
+    int saved_errno = errno;
+    if (wake_pipe[1] >= 0) {
+        char c = 'r';
+        if (write(wake_pipe[1], &c, 1) < 0) {
+            /* Pipe full: a reload is already pending */
+        }
+    }
+    errno = saved_errno;
+}
+
+void svg_reload_stop(void) {
+    if (reload_running) {
+        char c = 'q';
+        while (write(wake_pipe[1], &c, 1) < 0 && errno == EAGAIN) {
+            /* The thread drains the pipe; retry until there is room */
+            usleep(1000);
+        }
+        pthread_join(reload_thread, NULL);
+        reload_running = 0;
+    }
+    if (inotify_fd >= 0) close(inotify_fd);
+    inotify_fd = -1;
+    for (int i = 0; i < 2; i++) {
+        if (wake_pipe[i] >= 0) close(wake_pipe[i]);
+        wake_pipe[i] = -1;
+    }
+}
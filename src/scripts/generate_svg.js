@@ -8,6 +8,10 @@
 // To add a new theme: append a key here and it is immediately usable as
 // ?theme=<name> / "server.theme": "<name>" with NO C recompile. That is the
 // whole point of doing rendering in JS — appearance is data, not code.
+//
+// src/rrd/svg_native.c ("server.render_engine": "native") is a C port of this
+// file. Keep them in step: after a visual change here, port it and regenerate
+// tests/c/golden/ (SVGD_UPDATE_GOLDEN=1) — test_svg_native fails otherwise.
 // ============================================================================
 var THEMES = {
     // Default. Exact values the dashboard (gate/static/script.js) matches on,
@@ -83,6 +87,23 @@ function resolveTheme(name) {
     return THEMES.light;
 }
 
+// Points of one series as columns: t[i] / v[i], n points. svgd hands series
+// over as Float64Arrays (s.timestamps / s.values, used as-is); with
+// js.series_format "objects" they arrive as s.data = [{timestamp, value}].
+function seriesColumns(s) {
+    if (s && s.timestamps && s.values) {
+        return { t: s.timestamps, v: s.values, n: s.values.length };
+    }
+    if (!s || !s.data || !Array.isArray(s.data)) return { t: [], v: [], n: 0 };
+    var n = s.data.length;
+    var t = new Array(n), v = new Array(n);
+    for (var i = 0; i < n; i++) {
+        t[i] = s.data[i].timestamp;
+        v[i] = s.data[i].value;
+    }
+    return { t: t, v: v, n: n };
+}
+
 function generateSVG(series, options) {
     // Validate inputs
     if (typeof series === 'undefined' || typeof options === 'undefined') {
@@ -139,26 +160,35 @@ function generateSVG(series, options) {
         title = title.replace('%s', param1);
     }
 
-    // Collect all data points
-    var allData = [];
+    // One pass over all series: count the valid points and take the value
+    // (after transformation) and time ranges, reading the columns directly
+    var needsTransform = transformType !== 'none';
+    var cols = [];
+    var validCount = 0;
+    var dataMin = Infinity, dataMax = -Infinity;
+    var minTime = Infinity, maxTime = -Infinity;
     var seriesCount = series.length;
     for (var si = 0; si < seriesCount; si++) {
-        var s = series[si];
-        if (!s.data || !Array.isArray(s.data)) continue;
-        var dataLen = s.data.length;
-        for (var di = 0; di < dataLen; di++) {
-            var d = s.data[di];
-            if (!isNaN(d.value) && d.value >= 0) {
-                allData.push({ 
-                    timestamp: d.timestamp, 
-                    value: d.value, 
-                    seriesName: s.name 
-                });
+        var c = seriesColumns(series[si]);
+        cols.push(c);
+        for (var di = 0; di < c.n; di++) {
+            var val = c.v[di];
+            if (isNaN(val) || val < 0) continue;
+            if (transformType === 'multiply') {
+                val *= valueMultiplier;
+            } else if (transformType === 'divide') {
+                val /= transformDivisor;
             }
+            validCount++;
+            if (val < dataMin) dataMin = val;
+            if (val > dataMax) dataMax = val;
+            var t = c.t[di];
+            if (t < minTime) minTime = t;
+            if (t > maxTime) maxTime = t;
         }
     }
 
-    if (allData.length === 0) {
+    if (validCount === 0) {
         svg.push('<text x="', width / 2, '" y="', height / 2, '" text-anchor="middle" fill="#ef4444" font-size="14">Error: No valid data points</text></svg>');
         return svg.join('');
     }
@@ -175,45 +205,14 @@ function generateSVG(series, options) {
         valueFormatter = function(v) { return v.toFixed(2); };
     }
 
-    // Apply transformations based on transformType
-    var needsTransform = transformType !== 'none';
-    
-    if (needsTransform) {
-        var allDataLen = allData.length;
-        if (transformType === 'multiply') {
-            for (var i = 0; i < allDataLen; i++) {
-                allData[i].value *= valueMultiplier;
-            }
-        } else if (transformType === 'divide') {
-            for (var i = 0; i < allDataLen; i++) {
-                allData[i].value /= transformDivisor;
-            }
-        } else if (transformType === 'ps_cputime_sum') {
-            // Special handling is done in C code
-        }
-    }
-
-    // Calculate value range and time range
-    var minVal, maxVal, minTime, maxTime;
+    // Value range ("ps_cputime_sum" and other transforms are done in C)
+    var minVal, maxVal;
     if (isPercentage) {
         minVal = 0;
         maxVal = 100;
     } else {
-        minVal = Infinity;
-        maxVal = -Infinity;
-    }
-    minTime = Infinity;
-    maxTime = -Infinity;
-
-    var allDataLen = allData.length;
-    for (var i = 0; i < allDataLen; i++) {
-        var d = allData[i];
-        if (!isPercentage) {
-            if (d.value < minVal) minVal = d.value;
-            if (d.value > maxVal) maxVal = d.value;
-        }
-        if (d.timestamp < minTime) minTime = d.timestamp;
-        if (d.timestamp > maxTime) maxTime = d.timestamp;
+        minVal = dataMin;
+        maxVal = dataMax;
     }
 
     // Add padding for non-percentage
@@ -283,21 +282,20 @@ function generateSVG(series, options) {
     }
 
     // Draw series data
-    var avgStep = timeRange / (allData.length / series.length);
+    var avgStep = timeRange / (validCount / series.length);
     var gapThreshold = avgStep * 3;
 
     for (var si = 0; si < seriesCount; si++) {
         var s = series[si];
-        if (!s.data || s.data.length === 0) continue;
+        var c = cols[si];
+        if (c.n === 0) continue;
         
         var color = colors.series[si % colors.series.length];
         var validData = [];
         
         // Filter and transform valid data
-        var dataLen = s.data.length;
-        for (var di = 0; di < dataLen; di++) {
-            var d = s.data[di];
-            var val = d.value;
+        for (var di = 0; di < c.n; di++) {
+            var val = c.v[di];
             
             // Apply transformations
             if (needsTransform) {
@@ -309,7 +307,7 @@ function generateSVG(series, options) {
             }
             
             if (!isNaN(val) && val >= 0) {
-                validData.push({ timestamp: d.timestamp, value: val });
+                validData.push({ timestamp: c.t[di], value: val });
             }
         }
 
@@ -399,12 +397,12 @@ function generateSVG(series, options) {
     svg.push('<g font-size="11">');
     for (var si = 0; si < seriesCount; si++) {
         var s = series[si];
-        if (!s.data || s.data.length === 0) continue;
-        
-        var lastPoint = s.data[s.data.length - 1];
-        if (!lastPoint || isNaN(lastPoint.value) || lastPoint.value < 0) continue;
+        var c = cols[si];
+        if (c.n === 0) continue;
         
-        var rawValue = lastPoint.value;
+        var rawValue = c.v[c.n - 1];
+        if (isNaN(rawValue) || rawValue < 0) continue;
+
         if (needsTransform) {
             if (transformType === 'multiply') {
                 rawValue = rawValue * valueMultiplier;
@@ -462,16 +460,14 @@ function generateStatSVG(series, options) {
     // Collect all data points
     var allData = [];
     for (var si = 0; si < series.length; si++) {
-        var s = series[si];
-        if (!s.data || !Array.isArray(s.data)) continue;
-        for (var di = 0; di < s.data.length; di++) {
-            var d = s.data[di];
-            if (!isNaN(d.value) && d.value >= 0) {
-                var val = d.value;
+        var c = seriesColumns(series[si]);
+        for (var di = 0; di < c.n; di++) {
+            var val = c.v[di];
+            if (!isNaN(val) && val >= 0) {
                 if (transformType === 'divide') {
                     val = val / transformDivisor;
                 }
-                allData.push({ timestamp: d.timestamp, value: val });
+                allData.push({ timestamp: c.t[di], value: val });
             }
         }
     }
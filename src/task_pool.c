@@ -0,0 +1,139 @@
+/**
+ * @file task_pool.c
+ * @brief Render thread pool for fan-out inside one request
+ *
+ * Batches wait in a FIFO. Task indexes are claimed under the pool lock by
+ * the pool threads (from the oldest batch) and by each batch's own caller;
+ * whoever claims the last index unlinks the batch. Tasks are whole panel
+ * renders (milliseconds), so one mutex is not a bottleneck.
+ */
+
+#include "../include/task_pool.h"
+#include "../include/rrd/svg.h"  /* svg_prewarm_context */
+#include <stdio.h>
+#include <stdlib.h>
+#include <pthread.h>
+
+typedef struct batch {
+    task_fn fn;
+    void *arg;
+    int count;
+    int next;                   /* Next unclaimed index */
+    int done;                   /* Finished tasks */
+    pthread_cond_t finished;
+    struct batch *qnext;
+} batch_t;
+
+static struct {
+    pthread_mutex_t lock;
+    pthread_cond_t work;
+    batch_t *head, *tail;
+    pthread_t *threads;
+    int thread_count;
+    int running;
+} pool = { .lock = PTHREAD_MUTEX_INITIALIZER, .work = PTHREAD_COND_INITIALIZER };
+
+/* Unlink b from the queue (pool.lock held) */
+static void queue_remove(batch_t *b) {
+    batch_t *prev = NULL;
+    for (batch_t *it = pool.head; it; prev = it, it = it->qnext) {
+        if (it != b) continue;
+        if (prev) prev->qnext = it->qnext;
+        else pool.head = it->qnext;
+        if (pool.tail == it) pool.tail = prev;
+        return;
+    }
+}
+
+/* Claim the next index of b, -1 when all are taken (pool.lock held) */
+static int claim(batch_t *b) {
+    if (b->next >= b->count) return -1;
+    int index = b->next++;
+    if (b->next == b->count) queue_remove(b);
+    return index;
+}
+
+static void run_task(batch_t *b, int index) {
+    b->fn(b->arg, index);
+    pthread_mutex_lock(&pool.lock);
+    if (++b->done == b->count) pthread_cond_signal(&b->finished);
+    pthread_mutex_unlock(&pool.lock);
+}
+
+static void *pool_main(void *unused) {
+    (void)unused;
+    svg_prewarm_context();
+
+    pthread_mutex_lock(&pool.lock);
+    for (;;) {
+        while (pool.running && !pool.head) pthread_cond_wait(&pool.work, &pool.lock);
+        if (!pool.running) break;
+        batch_t *b = pool.head;
+        int index = claim(b);
+        pthread_mutex_unlock(&pool.lock);
+        run_task(b, index);
+        pthread_mutex_lock(&pool.lock);
+    }
+    pthread_mutex_unlock(&pool.lock);
+    return NULL;
+}
+
+int task_pool_start(int threads) {
+    if (threads <= 0 || pool.threads) return 0;
+    pool.threads = calloc((size_t)threads, sizeof(pthread_t));
+    if (!pool.threads) return -1;
+
+    pool.running = 1;
+    for (int i = 0; i < threads; i++) {
+        if (pthread_create(&pool.threads[pool.thread_count], NULL, pool_main, NULL) != 0) {
+            fprintf(stderr, "Warning: render pool started %d of %d threads\n",
+                    pool.thread_count, threads);
+            break;
+        }
+        pool.thread_count++;
+    }
+    if (pool.thread_count == 0) {
+        pool.running = 0;
+        free(pool.threads);
+        pool.threads = NULL;
+        return -1;
+    }
+    return 0;
+}
+
+void task_pool_run(task_fn fn, void *arg, int count) {
+    if (count <= 0) return;
+
+    batch_t b = { .fn = fn, .arg = arg, .count = count };
+    pthread_cond_init(&b.finished, NULL);
+
+    pthread_mutex_lock(&pool.lock);
+    if (pool.running && count > 1) {
+        if (pool.tail) pool.tail->qnext = &b;
+        else pool.head = &b;
+        pool.tail = &b;
+        if (count > 2) pthread_cond_broadcast(&pool.work);
+        else pthread_cond_signal(&pool.work);
+    }
+    for (int index; (index = claim(&b)) >= 0;) {
+        pthread_mutex_unlock(&pool.lock);
+        run_task(&b, index);
+        pthread_mutex_lock(&pool.lock);
+    }
+    while (b.done < b.count) pthread_cond_wait(&b.finished, &pool.lock);
+    pthread_mutex_unlock(&pool.lock);
+
+    pthread_cond_destroy(&b.finished);
+}
+
+void task_pool_stop(void) {
+    pthread_mutex_lock(&pool.lock);
+    pool.running = 0;
+    pthread_cond_broadcast(&pool.work);
+    pthread_mutex_unlock(&pool.lock);
+
+    for (int i = 0; i < pool.thread_count; i++) pthread_join(pool.threads[i], NULL);
+    free(pool.threads);
+    pool.threads = NULL;
+    pool.thread_count = 0;
+}
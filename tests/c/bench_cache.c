@@ -0,0 +1,145 @@
+/**
+ * @file bench_cache.c
+ * @brief Микробенчмарк конкурентности RRD-кэша (src/rrd/cache.c)
+ *
+ * N потоков крутят rrd_cache_get() фиксированное время и считают попадания.
+ * Два режима:
+ *   spread — каждый поток читает свой набор ключей (разные бакеты);
+ *   hot    — все потоки читают один ключ (общий дашборд, один бакет).
+ * Печатает ops/s и масштабирование относительно 1 потока. При глобальном
+ * мьютексе обе колонки стоят на ~1.0x; с блокировками по бакетам (rwlock)
+ * попадания должны расти с числом потоков вплоть до числа ядер.
+ *
+ * Запуск: make bench-cache [BENCH_THREADS="1 2 4 8"] [BENCH_POINTS=720]
+ */
+#include "rrd/cache.h"
+#include "rrd/reader.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include <time.h>
+
+#define BENCH_KEYS 32
+#define BENCH_SECONDS 1.0
+
+static int bench_points = 720;       /* точек в серии (сутки при step=120) */
+static int bench_stop = 0;            /* __atomic: читается всеми потоками */
+
+typedef struct {
+    int id;
+    int hot;
+    unsigned long ops;
+} bench_thread_t;
+
+static MetricData *make_data(int points) {
+    MetricData *d = calloc(1, sizeof(MetricData));
+    d->series_count = 1;
+    d->series_names = calloc(1, sizeof(char *));
+    d->series_names[0] = strdup("value");
+    d->series_counts = calloc(1, sizeof(int));
+    d->series_counts[0] = points;
+    d->series_data = calloc(1, sizeof(DataPoint *));
+    d->series_data[0] = calloc(points, sizeof(DataPoint));
+    for (int i = 0; i < points; i++) {
+        d->series_data[0][i].timestamp = 1000 + i * 120;
+        d->series_data[0][i].value = i;
+    }
+    d->param1 = strdup("");
+    return d;
+}
+
+static double now_sec(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static void *bench_worker(void *arg) {
+    bench_thread_t *t = arg;
+    char path[64];
+    unsigned long ops = 0;
+    int k = t->id;
+
+    while (!__atomic_load_n(&bench_stop, __ATOMIC_RELAXED)) {
+        snprintf(path, sizeof(path), "/bench/key%d.rrd", t->hot ? 0 : k % BENCH_KEYS);
+        MetricData *d = rrd_cache_get(path, 3600);
+        if (d) {
+            metric_data_release(d);
+            ops++;
+        }
+        k += 7;  /* обход ключей вразнобой, без синхронного шага потоков */
+    }
+    t->ops = ops;
+    return NULL;
+}
+
+static double run(int threads, int hot) {
+    pthread_t tid[threads];
+    bench_thread_t args[threads];
+
+    __atomic_store_n(&bench_stop, 0, __ATOMIC_RELAXED);
+    for (int i = 0; i < threads; i++) {
+        args[i] = (bench_thread_t){ .id = i, .hot = hot, .ops = 0 };
+        pthread_create(&tid[i], NULL, bench_worker, &args[i]);
+    }
+
+    double start = now_sec();
+    struct timespec wait = { (time_t)BENCH_SECONDS, 0 };
+    nanosleep(&wait, NULL);
+    __atomic_store_n(&bench_stop, 1, __ATOMIC_RELAXED);
+
+    unsigned long total = 0;
+    for (int i = 0; i < threads; i++) {
+        pthread_join(tid[i], NULL);
+        total += args[i].ops;
+    }
+    return total / (now_sec() - start);
+}
+
+int main(int argc, char **argv) {
+    const char *env = getenv("BENCH_POINTS");
+    if (env && atoi(env) > 0) bench_points = atoi(env);
+
+    /* TTL с запасом: все запросы — попадания */
+    rrd_cache_init(3600, 0);
+    for (int i = 0; i < BENCH_KEYS; i++) {
+        char path[64];
+        snprintf(path, sizeof(path), "/bench/key%d.rrd", i);
+        rrd_cache_put(path, 3600, make_data(bench_points));
+    }
+
+    int default_threads[] = { 1, 2, 4, 8 };
+    int counts[32];
+    int n = 0;
+    if (argc > 1) {
+        for (int i = 1; i < argc && n < 32; i++) {
+            if (atoi(argv[i]) > 0) counts[n++] = atoi(argv[i]);
+        }
+    }
+    if (n == 0) {
+        memcpy(counts, default_threads, sizeof(default_threads));
+        n = 4;
+    }
+
+    printf("RRD cache hit throughput (%d keys, %d points/series, %.0fs per run)\n",
+           BENCH_KEYS, bench_points, BENCH_SECONDS);
+    printf("%8s %14s %8s %14s %8s\n", "threads", "spread ops/s", "scale", "hot ops/s", "scale");
+
+    run(1, 0);  /* прогрев: первые malloc/page faults не должны портить базу */
+
+    double base_spread = 0, base_hot = 0;
+    for (int i = 0; i < n; i++) {
+        double spread = run(counts[i], 0);
+        double hot = run(counts[i], 1);
+        if (i == 0) {
+            base_spread = spread / counts[0];
+            base_hot = hot / counts[0];
+        }
+        printf("%8d %14.0f %7.2fx %14.0f %7.2fx\n", counts[i],
+               spread, spread / base_spread, hot, hot / base_hot);
+    }
+
+    rrd_cache_free();
+    return 0;
+}
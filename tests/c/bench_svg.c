@@ -0,0 +1,129 @@
+/**
+ * @file bench_svg.c
+ * @brief Микробенчмарк передачи серий в Duktape (src/rrd/svg.c)
+ *
+ * Сравнивает два формата svg_generate(): "objects" — JS-объект
+ * {timestamp, value} на каждую точку, и "typed" — два Float64Array на серию.
+ * По умолчанию generateSVG — минимальный скрипт, который только читает все
+ * точки: время вызова ≈ маршалинг + доступ из JS, без построения SVG.
+ * BENCH_SCRIPT=src/scripts/generate_svg.js меряет полный рендер.
+ *
+ * Запуск: make bench-svg [BENCH_SIZES="1000 10000 100000"]
+ */
+#include "rrd/svg.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#define BENCH_MIN_SECONDS 0.3
+#define BENCH_MIN_CALLS 3
+
+/* Читает обе раскладки, как generate_svg.js: typed (timestamps/values) или data[] */
+static const char *read_only_script =
+    "function generateSVG(series, options) {\n"
+    "    var sum = 0;\n"
+    "    for (var si = 0; si < series.length; si++) {\n"
+    "        var s = series[si];\n"
+    "        if (s.values) {\n"
+    "            for (var i = 0; i < s.values.length; i++) sum += s.timestamps[i] + s.values[i];\n"
+    "        } else {\n"
+    "            for (var i = 0; i < s.data.length; i++) sum += s.data[i].timestamp + s.data[i].value;\n"
+    "        }\n"
+    "    }\n"
+    "    return '<svg>' + sum + '</svg>';\n"
+    "}\n";
+
+/* svg.c берёт флаг verbose из main.c */
+int is_verbose_logging(void) { return 0; }
+
+static MetricData *make_data(int points) {
+    MetricData *d = calloc(1, sizeof(MetricData));
+    d->series_count = 1;
+    d->series_names = calloc(1, sizeof(char *));
+    d->series_names[0] = strdup("value");
+    d->series_counts = calloc(1, sizeof(int));
+    d->series_counts[0] = points;
+    d->series_data = calloc(1, sizeof(DataPoint *));
+    d->series_data[0] = calloc(points, sizeof(DataPoint));
+    for (int i = 0; i < points; i++) {
+        d->series_data[0][i].timestamp = 1000000 + i * 10;
+        d->series_data[0][i].value = (i * 7919) % 1000 / 10.0;
+    }
+    d->param1 = strdup("");
+    return d;
+}
+
+static double now_sec(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+/* Среднее время одного svg_generate() в мс; -1 при ошибке рендера */
+static double run(const char *script, MetricData *data, svg_series_format_t format) {
+    MetricConfig metric = { .title = "bench", .transform_type = "none",
+                            .value_format = "%.2f", .panel_type = "chart" };
+    svg_set_series_format(format);
+
+    char *warm = svg_generate(script, data, &metric, 800, 450, "light", NULL);
+    if (!warm) return -1;
+    free(warm);
+
+    int calls = 0;
+    double start = now_sec(), elapsed = 0;
+    while (calls < BENCH_MIN_CALLS || elapsed < BENCH_MIN_SECONDS) {
+        free(svg_generate(script, data, &metric, 800, 450, "light", NULL));
+        calls++;
+        elapsed = now_sec() - start;
+    }
+    return elapsed * 1000.0 / calls;
+}
+
+int main(int argc, char **argv) {
+    char tmp_script[] = "/tmp/svgd_bench_svg_XXXXXX";
+    const char *script = getenv("BENCH_SCRIPT");
+    if (!script || !*script) {
+        int fd = mkstemp(tmp_script);
+        if (fd < 0 || write(fd, read_only_script, strlen(read_only_script)) < 0) {
+            perror("bench_svg: temp script");
+            return 1;
+        }
+        close(fd);
+        script = tmp_script;
+    }
+
+    int default_sizes[] = { 1000, 10000, 100000 };
+    int sizes[32];
+    int n = 0;
+    for (int i = 1; i < argc && n < 32; i++) {
+        if (atoi(argv[i]) > 0) sizes[n++] = atoi(argv[i]);
+    }
+    if (n == 0) {
+        memcpy(sizes, default_sizes, sizeof(default_sizes));
+        n = 3;
+    }
+
+    printf("svg_generate series marshalling (%s)\n",
+           script == tmp_script ? "read-only script" : script);
+    printf("%8s %14s %14s %8s\n", "points", "objects ms", "typed ms", "speedup");
+
+    int rc = 0;
+    for (int i = 0; i < n; i++) {
+        MetricData *data = make_data(sizes[i]);
+        double objects = run(script, data, SVG_SERIES_OBJECTS);
+        double typed = run(script, data, SVG_SERIES_TYPED);
+        metric_data_release(data);
+        if (objects < 0 || typed < 0) {
+            fprintf(stderr, "bench_svg: generateSVG failed at %d points\n", sizes[i]);
+            rc = 1;
+            break;
+        }
+        printf("%8d %14.3f %14.3f %7.1fx\n", sizes[i], objects, typed, objects / typed);
+    }
+
+    svg_free_cache();
+    if (script == tmp_script) unlink(tmp_script);
+    return rc;
+}
@@ -0,0 +1,123 @@
+/**
+ * @file rrd_synth.h
+ * @brief Синтетический RRD-файл для тестов ридера (test_mmap_reader, test_delta)
+ *
+ * Файл собирается по явным смещениям формата librrd (rrd_format.h, LP64), без
+ * librrd и без структур ридера. Раскладка фиксирована: 2 DS ("user",
+ * "system"), базовый шаг 10 с, три RRA — AVERAGE 1×10 строк, AVERAGE 6×5,
+ * MAX 1×10. Значение строки = её время + номер DS (+ 0.5 для MAX), так что
+ * по данным видно, какая строка прочитана.
+ *
+ * Подключается только под __LP64__.
+ */
+#ifndef SVGD_TEST_RRD_SYNTH_H
+#define SVGD_TEST_RRD_SYNTH_H
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+/* Смещения rrd_format.h на LP64 */
+#define STAT_HEAD_SIZE 128
+#define DS_DEF_SIZE    120
+#define RRA_DEF_SIZE   120
+#define LIVE_HEAD_SIZE 16
+#define PDP_PREP_SIZE  112
+#define CDP_PREP_SIZE  80
+
+#define SYNTH_COOKIE 8.642135E130
+#define DS_CNT   2
+#define RRA_CNT  3
+#define PDP_STEP 10
+
+static const char *rra_cf[RRA_CNT] = { "AVERAGE", "AVERAGE", "MAX" };
+static const unsigned long rra_pdp[RRA_CNT] = { 1, 6, 1 };
+static const unsigned long rra_rows[RRA_CNT] = { 10, 5, 10 };
+static const unsigned long rra_cur[RRA_CNT] = { 3, 1, 7 };
+
+static char synth_dir[] = "/tmp/svgd_rrd_synth_XXXXXX";
+
+static int synth_ensure_dir(void) {
+    if (access(synth_dir, F_OK) == 0) return 0;
+    return (mkdtemp(synth_dir) != NULL) ? 0 : -1;
+}
+
+/* Время строки: новейшая (cur_row) стоит на last_up, выровненном по шагу RRA. */
+static time_t synth_row_time(int rra, unsigned long phys, time_t last_up) {
+    time_t rra_step = (time_t)(rra_pdp[rra] * PDP_STEP);
+    time_t rra_end = last_up - last_up % rra_step;
+    unsigned long age = (rra_cur[rra] + rra_rows[rra] - phys) % rra_rows[rra];
+    return rra_end - (time_t)age * rra_step;
+}
+
+static double synth_row_value(int rra, time_t t, int ds) {
+    return (double)t + ds + (rra == 2 ? 0.5 : 0);
+}
+
+/* Собрать файл synth_dir/name. Пишется через rename, как rrdtool resize:
+ * новый inode, старое отображение не трогается. */
+static const char *synth_write_rrd(const char *name, time_t last_up, double cookie) {
+    static char path[512];
+    snprintf(path, sizeof path, "%s/%s", synth_dir, name);
+
+    size_t header = STAT_HEAD_SIZE + DS_CNT * DS_DEF_SIZE + RRA_CNT * RRA_DEF_SIZE +
+                    LIVE_HEAD_SIZE + DS_CNT * PDP_PREP_SIZE +
+                    RRA_CNT * DS_CNT * CDP_PREP_SIZE + RRA_CNT * 8;
+    size_t rows = 0;
+    for (int r = 0; r < RRA_CNT; r++) rows += rra_rows[r];
+    size_t len = header + rows * DS_CNT * sizeof(double);
+    char *buf = calloc(1, len);
+    if (!buf) return NULL;
+
+    memcpy(buf, "RRD", 4);
+    memcpy(buf + 4, "0003", 5);
+    memcpy(buf + 16, &cookie, 8);
+    unsigned long v = DS_CNT;   memcpy(buf + 24, &v, 8);
+    v = RRA_CNT;                memcpy(buf + 32, &v, 8);
+    v = PDP_STEP;               memcpy(buf + 40, &v, 8);
+
+    size_t off = STAT_HEAD_SIZE;
+    strcpy(buf + off, "user");
+    strcpy(buf + off + 20, "GAUGE");
+    strcpy(buf + off + DS_DEF_SIZE, "system");
+    strcpy(buf + off + DS_DEF_SIZE + 20, "GAUGE");
+    off += DS_CNT * DS_DEF_SIZE;
+
+    for (int r = 0; r < RRA_CNT; r++) {
+        strcpy(buf + off, rra_cf[r]);
+        memcpy(buf + off + 24, &rra_rows[r], 8);
+        memcpy(buf + off + 32, &rra_pdp[r], 8);
+        off += RRA_DEF_SIZE;
+    }
+
+    memcpy(buf + off, &last_up, 8);
+    off += LIVE_HEAD_SIZE + DS_CNT * PDP_PREP_SIZE + RRA_CNT * DS_CNT * CDP_PREP_SIZE;
+    for (int r = 0; r < RRA_CNT; r++) {
+        memcpy(buf + off, &rra_cur[r], 8);
+        off += 8;
+    }
+
+    for (int r = 0; r < RRA_CNT; r++) {
+        for (unsigned long p = 0; p < rra_rows[r]; p++) {
+            time_t t = synth_row_time(r, p, last_up);
+            for (int d = 0; d < DS_CNT; d++) {
+                double val = synth_row_value(r, t, d);
+                memcpy(buf + off, &val, 8);
+                off += 8;
+            }
+        }
+    }
+
+    char tmp[600];
+    snprintf(tmp, sizeof tmp, "%s.tmp", path);
+    FILE *f = fopen(tmp, "wb");
+    int ok = f && fwrite(buf, 1, len, f) == len;
+    if (f) fclose(f);
+    free(buf);
+    if (!ok || rename(tmp, path) != 0) return NULL;
+    return path;
+}
+
+#endif /* SVGD_TEST_RRD_SYNTH_H */
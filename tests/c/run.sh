@@ -47,14 +47,30 @@ run_test() {
 }
 
 echo "=== C unit tests (svgd pure logic) ==="
-run_test test_step   tests/c/test_step.c   src/rrd/reader.c -- -lrrd -lm
+run_test test_step   tests/c/test_step.c   src/rrd/reader.c src/rrd/rra_cache.c src/rrd/rrdc_pool.c src/rrd/mmap_reader.c -- -lrrd -lpthread -lm
 run_test test_cfg    tests/c/test_cfg.c    src/cfg.c        -- -lduktape
 run_test test_path   tests/c/test_path.c   src/path_util.c  --
 run_test test_config tests/c/test_config.c src/cfg.c        -- -lduktape
 run_test test_source tests/c/test_source.c --
-run_test test_proc    tests/c/test_proc.c    src/proc_source.c src/rrd/reader.c -- -lrrd -lpthread -lm
-run_test test_prom    tests/c/test_prom.c    src/prometheus_source.c src/rrd/reader.c -- -lrrd -lm
-run_test test_cache   tests/c/test_cache.c   src/rrd/cache.c src/rrd/reader.c -- -lrrd -lpthread -lm
+run_test test_proc    tests/c/test_proc.c    src/proc_source.c src/rrd/reader.c src/rrd/rra_cache.c src/rrd/rrdc_pool.c src/rrd/mmap_reader.c -- -lrrd -lpthread -lm
+run_test test_prom    tests/c/test_prom.c    src/prometheus_source.c src/rrd/reader.c src/rrd/rra_cache.c src/rrd/rrdc_pool.c src/rrd/mmap_reader.c -- -lrrd -lpthread -lm
+run_test test_cache   tests/c/test_cache.c   src/rrd/cache.c src/rrd/reader.c src/rrd/rra_cache.c src/rrd/rrdc_pool.c src/rrd/mmap_reader.c -- -lrrd -lpthread -lm
+run_test test_svg_cache tests/c/test_svg_cache.c src/rrd/svg_cache.c -- -lpthread
+run_test test_compress tests/c/test_compress.c src/compress.c -- -lz
+run_test test_rra_cache tests/c/test_rra_cache.c src/rrd/rra_cache.c -- -lpthread
+run_test test_rrdc_pool tests/c/test_rrdc_pool.c src/rrd/rrdc_pool.c -- -lpthread
+run_test test_mmap_reader tests/c/test_mmap_reader.c src/rrd/mmap_reader.c -- -lrrd -lpthread -lm
+run_test test_delta  tests/c/test_delta.c  src/rrd/reader.c src/rrd/rra_cache.c src/rrd/rrdc_pool.c src/rrd/mmap_reader.c -- -lrrd -lpthread -lm
+run_test test_decimate tests/c/test_decimate.c src/rrd/decimate.c src/rrd/reader.c src/rrd/rra_cache.c src/rrd/rrdc_pool.c src/rrd/mmap_reader.c -- -lrrd -lpthread -lm
+run_test test_http    tests/c/test_http.c    src/http.c --
+run_test test_http_server tests/c/test_http_server.c src/http_server.c src/http.c -- -lpthread
+run_test test_svg     tests/c/test_svg.c     src/rrd/svg.c src/rrd/svg_native.c src/rrd/svg_reload.c src/rrd/js_heap.c -- -lduktape -lpthread -lm
+run_test test_svg_native tests/c/test_svg_native.c src/rrd/svg.c src/rrd/svg_native.c src/rrd/js_heap.c -- -lduktape -lpthread -lm
+run_test test_task_pool tests/c/test_task_pool.c src/task_pool.c -- -lpthread
+run_test test_backend_pool tests/c/test_backend_pool.c gate/backend_pool.c -- -lpthread
+sh gate/embed_static.sh gate/static "$BUILD/static_assets.c" >/dev/null
+run_test test_static_assets tests/c/test_static_assets.c "$BUILD/static_assets.c" -Igate --
+run_test test_js_heap tests/c/test_js_heap.c src/rrd/js_heap.c src/rrd/svg.c src/rrd/svg_native.c -- -lduktape -lpthread -lm
 
 echo
 echo "C unit tests: $PASS passed, $FAIL failed"
@@ -0,0 +1,203 @@
+/**
+ * @file test_backend_pool.c
+ * @brief Unit-тесты пула LSRP-соединений svgd-gate (gate/backend_pool.c)
+ *
+ * Вместо svgd — фейковый LSRP-бэкенд на 127.0.0.1 в отдельном потоке: отвечает
+ * "ok:<params>" и считает принятые соединения. Он либо держит соединение
+ * (несколько запросов подряд), либо закрывает его после ответа, как
+ * однозапросный сервер. Проверяем переиспользование, работу с закрывающим
+ * бэкендом, idle-таймаут, evict, отключённый пул и ошибки бэкенда.
+ */
+#include "minitest.h"
+#include "../../gate/backend_pool.h"
+#include <stdlib.h>
+#include <stdint.h>
+#include <unistd.h>      /* sleep() */
+#include <pthread.h>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+
+/* ---- фейковый LSRP-бэкенд ---- */
+typedef struct {
+    int listen_fd;
+    int port;
+    int keep_alive;         /* 0: закрыть соединение после ответа */
+    int accepts;
+    pthread_t thread;
+} fake_backend_t;
+
+static int read_full(int fd, void *buf, size_t len) {
+    size_t got = 0;
+    while (got < len) {
+        ssize_t n = recv(fd, (char *)buf + got, len - got, 0);
+        if (n <= 0) return -1;
+        got += (size_t)n;
+    }
+    return 0;
+}
+
+/* Один запрос: "LSRP" | be32 len | params -> "LSRP" | status | be32 len | data */
+static int serve_one(int fd) {
+    unsigned char head[8];
+    if (read_full(fd, head, sizeof(head)) != 0 || memcmp(head, "LSRP", 4) != 0) return -1;
+    uint32_t len = ((uint32_t)head[4] << 24) | ((uint32_t)head[5] << 16) |
+                   ((uint32_t)head[6] << 8) | head[7];
+    char params[4096];
+    if (len >= sizeof(params) || read_full(fd, params, len) != 0) return -1;
+    params[len] = '\0';
+
+    char out[4200];
+    int status = strcmp(params, "fail") == 0;
+    int n = snprintf(out + 9, sizeof(out) - 9, status ? "no such metric" : "ok:%s", params);
+    memcpy(out, "LSRP", 4);
+    out[4] = (char)status;
+    out[5] = (char)((n >> 24) & 0xff);
+    out[6] = (char)((n >> 16) & 0xff);
+    out[7] = (char)((n >> 8) & 0xff);
+    out[8] = (char)(n & 0xff);
+    return send(fd, out, (size_t)n + 9, MSG_NOSIGNAL) == n + 9 ? 0 : -1;
+}
+
+static void *fake_main(void *arg) {
+    fake_backend_t *fb = arg;
+    for (;;) {
+        int fd = accept(fb->listen_fd, NULL, NULL);
+        if (fd < 0) break;
+        __atomic_add_fetch(&fb->accepts, 1, __ATOMIC_SEQ_CST);
+        while (serve_one(fd) == 0 && fb->keep_alive) {}
+        close(fd);
+    }
+    return NULL;
+}
+
+static void fake_start(fake_backend_t *fb, int keep_alive) {
+    memset(fb, 0, sizeof(*fb));
+    fb->keep_alive = keep_alive;
+    fb->listen_fd = socket(AF_INET, SOCK_STREAM, 0);
+    struct sockaddr_in addr = { .sin_family = AF_INET, .sin_addr.s_addr = htonl(INADDR_LOOPBACK) };
+    bind(fb->listen_fd, (struct sockaddr *)&addr, sizeof(addr));
+    listen(fb->listen_fd, 16);
+    socklen_t alen = sizeof(addr);
+    getsockname(fb->listen_fd, (struct sockaddr *)&addr, &alen);
+    fb->port = ntohs(addr.sin_port);
+    pthread_create(&fb->thread, NULL, fake_main, fb);
+}
+
+static void fake_stop(fake_backend_t *fb) {
+    shutdown(fb->listen_fd, SHUT_RDWR);
+    pthread_join(fb->thread, NULL);
+    close(fb->listen_fd);
+}
+
+static int accepts(fake_backend_t *fb) {
+    return __atomic_load_n(&fb->accepts, __ATOMIC_SEQ_CST);
+}
+
+/* Отправить params, проверить ответ "ok:<params>"; 0 при успехе. */
+static int send_ok(fake_backend_t *fb, const char *params) {
+    lsrp_response_t resp = {0};
+    if (backend_pool_send("127.0.0.1", fb->port, params, &resp) != 0) return -1;
+    char want[256];
+    snprintf(want, sizeof(want), "ok:%s", params);
+    int ok = resp.status == 0 && resp.data_len == strlen(want) &&
+             strcmp((const char *)resp.data, want) == 0;
+    free(resp.data);
+    return ok ? 0 : -1;
+}
+
+/* Держащий соединение бэкенд: все запросы идут по одному соединению. */
+TEST(backend_pool_reuses_connection) {
+    fake_backend_t fb;
+    fake_start(&fb, 1);
+    for (int i = 0; i < 5; i++) ASSERT(send_ok(&fb, "endpoint=cpu&period=3600") == 0);
+    ASSERT(accepts(&fb) == 1);
+    backend_pool_evict("127.0.0.1", fb.port);
+    fake_stop(&fb);
+}
+
+/* Бэкенд, закрывающий соединение после ответа: каждый запрос — новое соединение. */
+TEST(backend_pool_handles_closing_backend) {
+    fake_backend_t fb;
+    fake_start(&fb, 0);
+    for (int i = 0; i < 3; i++) ASSERT(send_ok(&fb, "endpoint=ram") == 0);
+    ASSERT(accepts(&fb) == 3);
+    fake_stop(&fb);
+}
+
+/* Ошибка бэкенда (status != 0) — это ответ, соединение остаётся в пуле. */
+TEST(backend_pool_returns_backend_errors) {
+    fake_backend_t fb;
+    fake_start(&fb, 1);
+    lsrp_response_t resp = {0};
+    ASSERT(backend_pool_send("127.0.0.1", fb.port, "fail", &resp) == 0);
+    ASSERT(resp.status == 1);
+    ASSERT_STR((const char *)resp.data, "no such metric");
+    free(resp.data);
+    ASSERT(send_ok(&fb, "endpoint=cpu") == 0);
+    ASSERT(accepts(&fb) == 1);
+    backend_pool_evict("127.0.0.1", fb.port);
+    fake_stop(&fb);
+}
+
+/* evict закрывает простаивающие соединения бэкенда. */
+TEST(backend_pool_evict_closes_idle) {
+    fake_backend_t fb;
+    fake_start(&fb, 1);
+    ASSERT(send_ok(&fb, "endpoint=cpu") == 0);
+    backend_pool_evict("127.0.0.1", fb.port);
+    ASSERT(send_ok(&fb, "endpoint=cpu") == 0);
+    ASSERT(accepts(&fb) == 2);
+    backend_pool_evict("127.0.0.1", fb.port);
+    fake_stop(&fb);
+}
+
+/* Соединение, простоявшее дольше idle-таймаута, не переиспользуется. */
+TEST(backend_pool_idle_timeout) {
+    backend_pool_init(BACKEND_POOL_DEFAULT_MAX_IDLE, 1);
+    fake_backend_t fb;
+    fake_start(&fb, 1);
+    ASSERT(send_ok(&fb, "endpoint=cpu") == 0);
+    ASSERT(send_ok(&fb, "endpoint=cpu") == 0);
+    ASSERT(accepts(&fb) == 1);
+    sleep(3);
+    ASSERT(send_ok(&fb, "endpoint=cpu") == 0);
+    ASSERT(accepts(&fb) == 2);
+    backend_pool_evict("127.0.0.1", fb.port);
+    fake_stop(&fb);
+    backend_pool_init(BACKEND_POOL_DEFAULT_MAX_IDLE, BACKEND_POOL_DEFAULT_IDLE_SEC);
+}
+
+/* Недоступный бэкенд — ошибка, без зависаний. */
+TEST(backend_pool_unreachable_backend) {
+    fake_backend_t fb;
+    fake_start(&fb, 1);
+    int port = fb.port;
+    fake_stop(&fb);
+
+    lsrp_response_t resp = {0};
+    ASSERT(backend_pool_send("127.0.0.1", port, "endpoint=cpu", &resp) == -1);
+    ASSERT(resp.data == NULL);
+}
+
+/* max_idle = 0 отключает пул для новых бэкендов. */
+TEST(backend_pool_disabled) {
+    backend_pool_init(0, BACKEND_POOL_DEFAULT_IDLE_SEC);
+    fake_backend_t fb;
+    fake_start(&fb, 1);
+    for (int i = 0; i < 3; i++) ASSERT(send_ok(&fb, "endpoint=cpu") == 0);
+    ASSERT(accepts(&fb) == 3);
+    fake_stop(&fb);
+    backend_pool_init(BACKEND_POOL_DEFAULT_MAX_IDLE, BACKEND_POOL_DEFAULT_IDLE_SEC);
+}
+
+TEST_MAIN()
+    RUN(backend_pool_reuses_connection);
+    RUN(backend_pool_handles_closing_backend);
+    RUN(backend_pool_returns_backend_errors);
+    RUN(backend_pool_evict_closes_idle);
+    RUN(backend_pool_idle_timeout);
+    RUN(backend_pool_unreachable_backend);
+    RUN(backend_pool_disabled);
+    backend_pool_free();
+TEST_RETURN()
@@ -3,11 +3,14 @@
  * @brief Unit-тесты RRD-кэша (src/rrd/cache.c)
  *
  * Кэш теперь инициализируется в обоих режимах (LSRP и HTTP — parity с v0.2.0),
- * поэтому эти тесты покрывают механику put/get/clone/TTL для общего пути.
+ * поэтому эти тесты покрывают механику put/get/refcount/TTL для общего пути,
+ * а также бюджет max_bytes (CLOCK-вытеснение), рост таблицы и фоновый sweeper,
+ * и удержание истёкших RRD-данных для дельта-обновления (get_stale).
  */
 #include "minitest.h"
 #include "rrd/cache.h"   /* rrd_cache_init/put/get/free */
-#include "rrd/reader.h"  /* MetricData, DataPoint, free_metric_data */
+#include "rrd/reader.h"  /* MetricData, DataPoint, metric_data_retain/release */
+#include <stdio.h>
 #include <stdlib.h>
 #include <unistd.h>      /* sleep() */
 
@@ -30,30 +33,66 @@ static MetricData *make_test_data(const char *name, double v1, double v2) {
     return d;
 }
 
-/* put → get возвращает независимый клон с теми же значениями. */
-TEST(cache_put_get_clone) {
-    rrd_cache_init(60);
+/* put → get возвращает те же (разделяемые) данные без копирования. */
+TEST(cache_put_get_shared) {
+    rrd_cache_init(60, 0);
 
     MetricData *orig = make_test_data("cpu", 50.0, 75.0);
-    rrd_cache_put("clone.rrd", 3600, orig);  /* кэш забирает владение */
-
-    MetricData *clone = rrd_cache_get("clone.rrd", 3600);
-    ASSERT(clone != NULL);
-    ASSERT(clone != orig);                          /* другой указатель */
-    ASSERT(clone->series_count == 1);
-    ASSERT_STR(clone->series_names[0], "cpu");
-    ASSERT(clone->series_counts[0] == 2);
-    ASSERT(clone->series_data[0][0].value == 50.0);
-    ASSERT(clone->series_data[0][1].value == 75.0);
-    ASSERT_STR(clone->param1, "testparam");
-
-    free_metric_data(clone);
+    rrd_cache_put("shared.rrd", 3600, orig);  /* кэш забирает владение */
+
+    MetricData *a = rrd_cache_get("shared.rrd", 3600);
+    MetricData *b = rrd_cache_get("shared.rrd", 3600);
+    ASSERT(a != NULL);
+    ASSERT(a == orig);                          /* тот же указатель, не клон */
+    ASSERT(b == a);
+    ASSERT(a->series_count == 1);
+    ASSERT_STR(a->series_names[0], "cpu");
+    ASSERT(a->series_counts[0] == 2);
+    ASSERT(a->series_data[0][0].value == 50.0);
+    ASSERT(a->series_data[0][1].value == 75.0);
+    ASSERT_STR(a->param1, "testparam");
+
+    metric_data_release(a);
+    metric_data_release(b);
+    rrd_cache_free();
+}
+
+/* Читатель держит свою ссылку: вытеснение записи и free кэша её не рушат. */
+TEST(cache_reference_outlives_entry) {
+    rrd_cache_init(60, 0);
+
+    rrd_cache_put("hold.rrd", 3600, make_test_data("old", 1.0, 2.0));
+    MetricData *held = rrd_cache_get("hold.rrd", 3600);
+    ASSERT(held != NULL);
+
+    rrd_cache_put("hold.rrd", 3600, make_test_data("new", 3.0, 4.0));
     rrd_cache_free();
+
+    /* Кэш уже отпустил свою ссылку — данные живы, пока держим свою. */
+    ASSERT_STR(held->series_names[0], "old");
+    ASSERT(held->series_data[0][1].value == 2.0);
+    metric_data_release(held);
+}
+
+/* retain/release: последний владелец освобождает, NULL безопасен. */
+TEST(metric_data_retain_release) {
+    MetricData *d = make_test_data("ref", 1.0, 2.0);
+    ASSERT(d->refs == 0);                       /* calloc → единственный владелец */
+
+    ASSERT(metric_data_retain(d) == d);
+    ASSERT(d->refs == 1);
+    metric_data_release(d);
+    ASSERT(d->refs == 0);
+    ASSERT(d->series_data[0][0].value == 1.0);  /* ещё не освобождено */
+    free_metric_data(d);                        /* алиас release — последний */
+
+    ASSERT(metric_data_retain(NULL) == NULL);
+    metric_data_release(NULL);
 }
 
 /* Get по неизвестному ключу (другой путь или другой период) → NULL. */
 TEST(cache_miss_unknown_key) {
-    rrd_cache_init(60);
+    rrd_cache_init(60, 0);
 
     MetricData *d = make_test_data("mem", 10.0, 20.0);
     rrd_cache_put("alpha.rrd", 3600, d);
@@ -73,7 +112,7 @@ TEST(cache_get_before_init_returns_null) {
 
 /* Истечение TTL: после TTL запись считается просроченной → NULL. */
 TEST(cache_ttl_expiry) {
-    rrd_cache_init(1);  /* TTL = 1 секунда */
+    rrd_cache_init(1, 0);  /* TTL = 1 секунда */
 
     MetricData *d = make_test_data("net", 1.0, 2.0);
     rrd_cache_put("net.rrd", 3600, d);
@@ -93,7 +132,7 @@ TEST(cache_ttl_expiry) {
 
 /* Повторный put по тому же ключу заменяет запись. */
 TEST(cache_put_replaces_entry) {
-    rrd_cache_init(60);
+    rrd_cache_init(60, 0);
 
     MetricData *first = make_test_data("old", 1.0, 2.0);
     rrd_cache_put("replace.rrd", 3600, first);
@@ -110,10 +149,156 @@ TEST(cache_put_replaces_entry) {
     rrd_cache_free();
 }
 
+/* Размер одной записи make_test_data() с ключом фиксированной длины. */
+static size_t entry_size(void) {
+    rrd_cache_stats_t st;
+    rrd_cache_init(60, 0);
+    rrd_cache_put("x.rrd", 3600, make_test_data("cpu", 1.0, 2.0));
+    rrd_cache_stats(&st);
+    rrd_cache_free();
+    return st.bytes;
+}
+
+/* Бюджет на ~2.5 записи: третья вытесняет ту, к которой не было обращений. */
+TEST(cache_budget_evicts_unreferenced) {
+    size_t one = entry_size();
+    ASSERT(one > 0);
+    rrd_cache_init(60, one * 5 / 2);
+
+    rrd_cache_put("a.rrd", 3600, make_test_data("cpu", 1.0, 2.0));
+    rrd_cache_put("b.rrd", 3600, make_test_data("cpu", 3.0, 4.0));
+    MetricData *a = rrd_cache_get("a.rrd", 3600);  /* a получает второй шанс */
+    ASSERT(a != NULL);
+    metric_data_release(a);
+
+    rrd_cache_put("c.rrd", 3600, make_test_data("cpu", 5.0, 6.0));
+
+    rrd_cache_stats_t st;
+    rrd_cache_stats(&st);
+    ASSERT(st.entries == 2);
+    ASSERT(st.evictions == 1);
+    ASSERT(st.bytes <= st.max_bytes);
+
+    MetricData *got;
+    ASSERT((got = rrd_cache_get("a.rrd", 3600)) != NULL);
+    metric_data_release(got);
+    ASSERT(rrd_cache_get("b.rrd", 3600) == NULL);  /* вытеснена */
+    ASSERT((got = rrd_cache_get("c.rrd", 3600)) != NULL);
+    metric_data_release(got);
+
+    rrd_cache_free();
+}
+
+/* Запись больше всего бюджета не кэшируется (и не вытесняет остальные). */
+TEST(cache_budget_rejects_oversized) {
+    size_t one = entry_size();
+    rrd_cache_init(60, one + one / 2);
+
+    rrd_cache_put("a.rrd", 3600, make_test_data("cpu", 1.0, 2.0));
+
+    MetricData *big = make_test_data("cpu", 1.0, 2.0);
+    free(big->series_data[0]);
+    big->series_counts[0] = 1000;
+    big->series_data[0] = calloc(1000, sizeof(DataPoint));
+    rrd_cache_put("big.rrd", 3600, big);   /* освобождается внутри */
+
+    ASSERT(rrd_cache_get("big.rrd", 3600) == NULL);
+    MetricData *a = rrd_cache_get("a.rrd", 3600);
+    ASSERT(a != NULL);
+    metric_data_release(a);
+
+    rrd_cache_free();
+}
+
+/* Таблица растёт при длинных цепочках; все ключи остаются доступны. */
+TEST(cache_table_grows) {
+    rrd_cache_init(60, 0);
+
+    rrd_cache_stats_t st;
+    rrd_cache_stats(&st);
+    size_t initial = st.buckets;
+
+    char path[64];
+    for (int i = 0; i < 1000; i++) {
+        snprintf(path, sizeof(path), "proc-%d.rrd", i);
+        rrd_cache_put(path, 3600, make_test_data("cpu", i, i));
+    }
+
+    rrd_cache_stats(&st);
+    ASSERT(st.entries == 1000);
+    ASSERT(st.buckets > initial);
+    ASSERT(st.entries <= st.buckets * 2);
+
+    for (int i = 0; i < 1000; i++) {
+        snprintf(path, sizeof(path), "proc-%d.rrd", i);
+        MetricData *d = rrd_cache_get(path, 3600);
+        ASSERT(d != NULL);
+        ASSERT(d->series_data[0][0].value == (double)i);
+        metric_data_release(d);
+    }
+
+    rrd_cache_free();
+}
+
+/* Sweeper убирает просроченные записи, даже если их больше никто не запросит. */
+TEST(cache_sweeper_removes_expired) {
+    rrd_cache_init(1, 0);
+
+    rrd_cache_put("s1.rrd", 3600, make_test_data("cpu", 1.0, 2.0));
+    rrd_cache_put("s2.rrd", 3600, make_test_data("cpu", 1.0, 2.0));
+
+    sleep(3);  /* TTL 1 с, sweeper просыпается раз в TTL */
+
+    rrd_cache_stats_t st;
+    rrd_cache_stats(&st);
+    ASSERT(st.entries == 0);
+    ASSERT(st.bytes == 0);
+    ASSERT(st.expirations == 2);
+
+    rrd_cache_free();
+}
+
+/* Истёкшие RRD-данные (fetch_step != 0) доступны через get_stale и
+ * переживают sweeper; прочие (proc/prometheus) — нет. */
+TEST(cache_stale_kept_for_delta) {
+    rrd_cache_init(1, 0);
+
+    MetricData *rrd = make_test_data("cpu", 1.0, 2.0);
+    rrd->fetch_step = 10;
+    rrd->fetch_end = 2010;
+    rrd_cache_put("delta.rrd", 3600, rrd);
+    rrd_cache_put("proc:cpu", 3600, make_test_data("cpu", 1.0, 2.0));
+
+    sleep(3);  /* TTL истёк, sweeper успел пройти */
+    ASSERT(rrd_cache_get("delta.rrd", 3600) == NULL);
+
+    MetricData *stale = rrd_cache_get_stale("delta.rrd", 3600);
+    ASSERT(stale == rrd);
+    ASSERT(stale->fetch_end == 2010);
+    metric_data_release(stale);
+    ASSERT(rrd_cache_get_stale("proc:cpu", 3600) == NULL);
+    ASSERT(rrd_cache_get_stale("missing.rrd", 3600) == NULL);
+
+    rrd_cache_stats_t st;
+    rrd_cache_stats(&st);
+    ASSERT(st.entries == 1);
+    ASSERT(st.expirations == 1);
+    ASSERT(st.stale_hits == 1);
+
+    rrd_cache_free();
+}
+
 TEST_MAIN()
-    RUN(cache_put_get_clone);
+    RUN(cache_put_get_shared);
+    RUN(cache_reference_outlives_entry);
+    RUN(metric_data_retain_release);
     RUN(cache_miss_unknown_key);
     RUN(cache_get_before_init_returns_null);
     RUN(cache_ttl_expiry);
     RUN(cache_put_replaces_entry);
+    RUN(cache_budget_evicts_unreferenced);
+    RUN(cache_budget_rejects_oversized);
+    RUN(cache_table_grows);
+    RUN(cache_sweeper_removes_expired);
+    RUN(cache_stale_kept_for_delta);
 TEST_RETURN()
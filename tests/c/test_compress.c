@@ -0,0 +1,170 @@
+/**
+ * @file test_compress.c
+ * @brief Unit-тесты сжатия ответов (src/compress.c)
+ *
+ * Согласование по Accept-Encoding (q-значения, "*", приоритет gzip),
+ * распаковка результата zlib'ом обратно в исходные байты для gzip и
+ * deflate, порог min_bytes, level 0 и несжимаемые тела.
+ */
+#include "minitest.h"
+#include "compress.h"
+#include <stdlib.h>
+#include <zlib.h>
+
+#define NEGOTIATE(s) compress_negotiate((s), strlen(s))
+
+/* SVG-подобный текст заданной длины: повторяющаяся разметка жмётся хорошо. */
+static char *svg_text(size_t len) {
+    static const char pattern[] = "<path d=\"M10 20 L30 40\" stroke=\"#4e79a7\"/>\n";
+    char *buf = malloc(len + 1);
+    for (size_t i = 0; i < len; i++) buf[i] = pattern[i % (sizeof(pattern) - 1)];
+    buf[len] = '\0';
+    return buf;
+}
+
+/* Распаковка через zlib; window_bits как у inflateInit2 (31 = gzip, 15 = zlib). */
+static char *inflate_all(const char *data, size_t len, int window_bits, size_t cap, size_t *out_len) {
+    char *out = malloc(cap);
+    z_stream zs = {0};
+    if (inflateInit2(&zs, window_bits) != Z_OK) { free(out); return NULL; }
+    zs.next_in = (Bytef *)data;
+    zs.avail_in = (uInt)len;
+    zs.next_out = (Bytef *)out;
+    zs.avail_out = (uInt)cap;
+    int rc = inflate(&zs, Z_FINISH);
+    *out_len = zs.total_out;
+    inflateEnd(&zs);
+    if (rc != Z_STREAM_END) { free(out); return NULL; }
+    return out;
+}
+
+/* Простые случаи: gzip, deflate, ничего, пусто, регистр, x-gzip. */
+TEST(negotiate_basic) {
+    compress_configure(6, 1024);
+    ASSERT(NEGOTIATE("gzip") == COMPRESS_GZIP);
+    ASSERT(NEGOTIATE("deflate") == COMPRESS_DEFLATE);
+    ASSERT(NEGOTIATE("gzip, deflate, br") == COMPRESS_GZIP);
+    ASSERT(NEGOTIATE("deflate, gzip") == COMPRESS_GZIP);
+    ASSERT(NEGOTIATE("GZIP") == COMPRESS_GZIP);
+    ASSERT(NEGOTIATE("x-gzip") == COMPRESS_GZIP);
+    ASSERT(NEGOTIATE("br, identity") == COMPRESS_IDENTITY);
+    ASSERT(NEGOTIATE("") == COMPRESS_IDENTITY);
+    ASSERT(compress_negotiate(NULL, 0) == COMPRESS_IDENTITY);
+}
+
+/* q-значения: q=0 запрещает, больший q выигрывает, "*" покрывает неназванные. */
+TEST(negotiate_qvalues) {
+    compress_configure(6, 1024);
+    ASSERT(NEGOTIATE("gzip;q=0") == COMPRESS_IDENTITY);
+    ASSERT(NEGOTIATE("gzip;q=0, deflate") == COMPRESS_DEFLATE);
+    ASSERT(NEGOTIATE("gzip;q=0.5, deflate;q=0.8") == COMPRESS_DEFLATE);
+    ASSERT(NEGOTIATE("gzip ; q=0.9 , deflate;q=0.9") == COMPRESS_GZIP);
+    ASSERT(NEGOTIATE("*") == COMPRESS_GZIP);
+    ASSERT(NEGOTIATE("gzip;q=0, *") == COMPRESS_DEFLATE);
+    ASSERT(NEGOTIATE("*;q=0") == COMPRESS_IDENTITY);
+}
+
+/* Значение берётся по длине, а не до NUL. */
+TEST(negotiate_uses_length) {
+    compress_configure(6, 1024);
+    const char *v = "deflate, gzip";
+    ASSERT(compress_negotiate(v, 7) == COMPRESS_DEFLATE);
+}
+
+/* level 0 выключает и согласование, и сжатие. */
+TEST(level_zero_disables) {
+    compress_configure(0, 0);
+    ASSERT(NEGOTIATE("gzip") == COMPRESS_IDENTITY);
+    char *text = svg_text(8192);
+    size_t n = 0;
+    ASSERT(compress_body(text, 8192, COMPRESS_GZIP, &n) == NULL);
+    free(text);
+}
+
+/* gzip: магия 1f 8b, тело меньше, распаковывается в исходные байты. */
+TEST(gzip_round_trip) {
+    compress_configure(6, 1024);
+    size_t len = 20000;
+    char *text = svg_text(len);
+    size_t z_len = 0;
+    char *z = compress_body(text, len, COMPRESS_GZIP, &z_len);
+    ASSERT(z != NULL);
+    ASSERT(z_len < len / 4);
+    ASSERT((unsigned char)z[0] == 0x1f && (unsigned char)z[1] == 0x8b);
+
+    size_t back_len = 0;
+    char *back = inflate_all(z, z_len, 15 + 16, len + 16, &back_len);
+    ASSERT(back != NULL);
+    ASSERT(back_len == len);
+    ASSERT(memcmp(back, text, len) == 0);
+    free(back);
+    free(z);
+    free(text);
+}
+
+/* deflate по HTTP — zlib-поток (RFC 1950), не «сырой» deflate. */
+TEST(deflate_round_trip) {
+    compress_configure(9, 1024);
+    size_t len = 5000;
+    char *text = svg_text(len);
+    size_t z_len = 0;
+    char *z = compress_body(text, len, COMPRESS_DEFLATE, &z_len);
+    ASSERT(z != NULL);
+    ASSERT((((unsigned char)z[0] << 8) | (unsigned char)z[1]) % 31 == 0);  /* заголовок zlib */
+
+    size_t back_len = 0;
+    char *back = inflate_all(z, z_len, 15, len + 16, &back_len);
+    ASSERT(back != NULL);
+    ASSERT(back_len == len);
+    ASSERT(memcmp(back, text, len) == 0);
+    free(back);
+    free(z);
+    free(text);
+}
+
+/* Тела короче min_bytes и несжимаемые тела остаются как есть (NULL). */
+TEST(small_and_incompressible_skipped) {
+    compress_configure(6, 1024);
+    char *text = svg_text(1023);
+    size_t n = 0;
+    ASSERT(compress_body(text, 1023, COMPRESS_GZIP, &n) == NULL);
+    free(text);
+
+    text = svg_text(1024);
+    char *z = compress_body(text, 1024, COMPRESS_GZIP, &n);
+    ASSERT(z != NULL);
+    free(z);
+    free(text);
+
+    /* Псевдослучайные байты не сжимаются: заголовок gzip только удлинит тело */
+    size_t len = 4096;
+    char *noise = malloc(len);
+    unsigned x = 12345;
+    for (size_t i = 0; i < len; i++) { x = x * 1103515245u + 12345u; noise[i] = (char)(x >> 16); }
+    ASSERT(compress_body(noise, len, COMPRESS_GZIP, &n) == NULL);
+    free(noise);
+
+    ASSERT(compress_body("x", 1, COMPRESS_IDENTITY, &n) == NULL);
+}
+
+/* Имена Content-Encoding туда и обратно. */
+TEST(encoding_names) {
+    ASSERT_STR(compress_encoding_name(COMPRESS_GZIP), "gzip");
+    ASSERT_STR(compress_encoding_name(COMPRESS_DEFLATE), "deflate");
+    ASSERT(compress_encoding_name(COMPRESS_IDENTITY) == NULL);
+    ASSERT(compress_encoding_parse("gzip") == COMPRESS_GZIP);
+    ASSERT(compress_encoding_parse("deflate") == COMPRESS_DEFLATE);
+    ASSERT(compress_encoding_parse("br") == COMPRESS_IDENTITY);
+    ASSERT(compress_encoding_parse(NULL) == COMPRESS_IDENTITY);
+}
+
+TEST_MAIN()
+    RUN(negotiate_basic);
+    RUN(negotiate_qvalues);
+    RUN(negotiate_uses_length);
+    RUN(level_zero_disables);
+    RUN(gzip_round_trip);
+    RUN(deflate_round_trip);
+    RUN(small_and_incompressible_skipped);
+    RUN(encoding_names);
+TEST_RETURN()
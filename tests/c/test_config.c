@@ -45,8 +45,10 @@ TEST(parses_full_config) {
     ASSERT(ensure_tmpdir() == 0);
     const char *json =
         "{"
-        "  \"server\": { \"tcp_port\": 9090, \"thread_pool_size\": 8 },"
-        "  \"rrd\": { \"base_path\": \"/var/rrd\" },"
+        "  \"server\": { \"tcp_port\": 9090, \"thread_pool_size\": 8, \"listen_shards\": 2 },"
+        "  \"rrd\": { \"base_path\": \"/var/rrd\", \"flush_policy\": \"interval\","
+        "             \"flush_interval_seconds\": 60 },"
+        "  \"cache\": { \"max_bytes\": 3000000000 },"
         "  \"js\": { \"script_path\": \"./src/scripts/generate_svg.js\" },"
         "  \"metrics\": ["
         "    { \"endpoint\": \"cpu\", \"rrd_path\": \"cpu/percent.rrd\" },"
@@ -54,7 +56,8 @@ TEST(parses_full_config) {
         "      \"rrd_path\": \"processes-%s/ps_cputime.rrd\","
         "      \"requires_param\": true,"
         "      \"param_name\": \"process_name\","
-        "      \"transform_type\": \"sum\" }"
+        "      \"transform_type\": \"sum\","
+        "      \"decimate\": \"lttb\" }"
         "  ]"
         "}";
     const char *path = write_config("full.json", json);
@@ -63,7 +66,11 @@ TEST(parses_full_config) {
     Config c = load_config(ctx, path);
     ASSERT(c.tcp_port == 9090);
     ASSERT(c.thread_pool_size == 8);
+    ASSERT(c.listen_shards == 2);
+    ASSERT(c.cache_max_bytes == (size_t)3000000000UL);  /* больше INT_MAX */
     ASSERT_STR(c.rrd_base_path, "/var/rrd");
+    ASSERT_STR(c.rrd_flush_policy, "interval");
+    ASSERT(c.rrd_flush_interval == 60);
     ASSERT_STR(c.js_script_path, "./src/scripts/generate_svg.js");
     ASSERT(c.metrics_count == 2);
     ASSERT_STR(c.metrics[0].endpoint, "cpu");
@@ -74,6 +81,8 @@ TEST(parses_full_config) {
     ASSERT(c.metrics[1].requires_param == 1);
     ASSERT_STR(c.metrics[1].param_name, "process_name");
     ASSERT_STR(c.metrics[1].transform_type, "sum");
+    ASSERT_STR(c.metrics[0].decimate, "none");
+    ASSERT_STR(c.metrics[1].decimate, "lttb");
 
     free_config(&c);
     duk_destroy_heap(ctx);
@@ -232,6 +241,8 @@ TEST(missing_server_section_keeps_defaults) {
     Config c = load_config(ctx, path);
     ASSERT(c.tcp_port == 8080);          /* default */
     ASSERT(c.thread_pool_size == 4);     /* default */
+    ASSERT(c.listen_shards == 1);        /* default */
+    ASSERT(c.cache_max_bytes == 32u * 1024 * 1024);  /* default, секции cache нет */
     ASSERT(c.metrics_count == 1);
     ASSERT_STR(c.metrics[0].endpoint, "cpu");
 
@@ -255,6 +266,8 @@ TEST(missing_rrd_and_js_sections) {
 
     Config c = load_config(ctx, path);
     ASSERT(c.tcp_port == 4242);
+    ASSERT_STR(c.rrd_flush_policy, "fetch");  /* default, секции rrd нет */
+    ASSERT(c.rrd_flush_interval == 30);
     ASSERT(c.metrics_count == 1);
     ASSERT_STR(c.metrics[0].endpoint, "cpu");
 
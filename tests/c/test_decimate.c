@@ -0,0 +1,142 @@
+/**
+ * @file test_decimate.c
+ * @brief Unit-тесты прореживания точек M4 / LTTB (src/rrd/decimate.c)
+ *
+ * Инварианты: бюджет точек соблюдается, порядок по времени сохраняется,
+ * первая/последняя точка и экстремумы (для M4 — всегда, для LTTB — одиночный
+ * выброс) остаются; короткие ряды и разделяемые (кэшированные) данные не
+ * трогаются.
+ */
+#include "minitest.h"
+#include "rrd/decimate.h"
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define N 10000
+
+/* Синусоида с шагом 10 с и двумя выбросами — вверх и вниз. */
+static DataPoint *make_series(void) {
+    DataPoint *p = malloc(N * sizeof(DataPoint));
+    for (int i = 0; i < N; i++) {
+        p[i].timestamp = 1000000 + (time_t)i * 10;
+        p[i].value = 50 + 10 * sin(i / 50.0);
+    }
+    p[1234].value = 500;
+    p[7777].value = -3;
+    return p;
+}
+
+static int sorted(const DataPoint *p, int n) {
+    for (int i = 1; i < n; i++) {
+        if (p[i].timestamp <= p[i - 1].timestamp) return 0;
+    }
+    return 1;
+}
+
+static int contains(const DataPoint *p, int n, double value) {
+    for (int i = 0; i < n; i++) {
+        if (p[i].value == value) return 1;
+    }
+    return 0;
+}
+
+TEST(mode_parse_and_budget) {
+    decimate_mode_t m = DECIMATE_M4;
+    ASSERT(decimate_mode_parse("none", &m) == 0 && m == DECIMATE_NONE);
+    ASSERT(decimate_mode_parse("", &m) == 0 && m == DECIMATE_NONE);
+    ASSERT(decimate_mode_parse("m4", &m) == 0 && m == DECIMATE_M4);
+    ASSERT(decimate_mode_parse("lttb", &m) == 0 && m == DECIMATE_LTTB);
+    ASSERT(decimate_mode_parse("LTTB", &m) == -1);
+    ASSERT(decimate_mode_parse(NULL, &m) == -1);
+
+    /* Поля generate_svg.js: 800 → 64 + 40, область 696 px; 200 → 50 + 30 */
+    ASSERT(decimate_max_points(800) == 1392);
+    ASSERT(decimate_max_points(200) == 240);
+}
+
+/* M4: ≤ бюджета, по времени, первая/последняя точки и оба выброса на месте. */
+TEST(m4_keeps_extremes_within_budget) {
+    DataPoint *in = make_series();
+    DataPoint out[400];
+    int n = decimate_m4(in, N, out, 400);
+    ASSERT(n > 200 && n <= 400);
+    ASSERT(sorted(out, n));
+    ASSERT(out[0].timestamp == in[0].timestamp);
+    ASSERT(out[n - 1].timestamp == in[N - 1].timestamp);
+    ASSERT(contains(out, n, 500));
+    ASSERT(contains(out, n, -3));
+    free(in);
+}
+
+/* LTTB: ровно бюджет, концы сохранены, одиночный выброс не теряется. */
+TEST(lttb_exact_budget_keeps_spike) {
+    DataPoint *in = make_series();
+    DataPoint out[300];
+    int n = decimate_lttb(in, N, out, 300);
+    ASSERT(n == 300);
+    ASSERT(sorted(out, n));
+    ASSERT(out[0].timestamp == in[0].timestamp);
+    ASSERT(out[n - 1].timestamp == in[N - 1].timestamp);
+    ASSERT(contains(out, n, 500));
+    ASSERT(contains(out, n, -3));
+    free(in);
+}
+
+/* Ряд короче бюджета копируется как есть. */
+TEST(short_series_copied) {
+    DataPoint *in = make_series();
+    DataPoint out[50];
+    ASSERT(decimate_m4(in, 50, out, 100) == 50);
+    ASSERT(memcmp(in, out, 50 * sizeof(DataPoint)) == 0);
+    ASSERT(decimate_lttb(in, 50, out, 100) == 50);
+    ASSERT(memcmp(in, out, 50 * sizeof(DataPoint)) == 0);
+    free(in);
+}
+
+static MetricData *make_data(int points) {
+    MetricData *md = calloc(1, sizeof(MetricData));
+    md->series_count = 2;
+    md->series_names = calloc(2, sizeof(char*));
+    md->series_data = calloc(2, sizeof(DataPoint*));
+    md->series_counts = calloc(2, sizeof(int));
+    md->param1 = strdup("");
+    md->fetch_step = 10;
+    md->series_names[0] = strdup("user");
+    md->series_names[1] = strdup("system");
+    md->series_data[0] = make_series();
+    md->series_counts[0] = points;
+    md->series_data[1] = make_series();
+    md->series_counts[1] = 10;                   /* короткий ряд */
+    return md;
+}
+
+/* Разделяемые данные не меняются: вызывающий получает новую копию. */
+TEST(metric_data_decimate_copies_shared) {
+    MetricData *shared = make_data(N);
+    metric_data_retain(shared);                  /* «кэш» держит свою ссылку */
+
+    MetricData *out = metric_data_decimate(shared, DECIMATE_M4, 400);
+    ASSERT(out != shared);
+    ASSERT(out->series_count == 2);
+    ASSERT_STR(out->series_names[1], "system");
+    ASSERT(out->series_counts[0] <= 400);
+    ASSERT(out->series_counts[1] == 10);
+    ASSERT(out->fetch_step == 0);                /* дельта к прореженному нельзя */
+    ASSERT(shared->series_counts[0] == N);
+    ASSERT(shared->series_data[0][1234].value == 500);
+    metric_data_release(out);
+
+    /* Нечего прореживать / режим none → тот же объект. */
+    ASSERT(metric_data_decimate(shared, DECIMATE_LTTB, N) == shared);
+    ASSERT(metric_data_decimate(shared, DECIMATE_NONE, 10) == shared);
+    metric_data_release(shared);
+}
+
+TEST_MAIN()
+    RUN(mode_parse_and_budget);
+    RUN(m4_keeps_extremes_within_budget);
+    RUN(lttb_exact_budget_keeps_spike);
+    RUN(short_series_copied);
+    RUN(metric_data_decimate_copies_shared);
+TEST_RETURN()
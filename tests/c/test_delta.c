@@ -0,0 +1,133 @@
+/**
+ * @file test_delta.c
+ * @brief Unit-тесты дельта-обновления RRD-данных (rrd_fetch_delta, src/rrd/reader.c)
+ *
+ * Данные читаются из синтетического RRD (rrd_synth.h) через mmap-ридер, так
+ * что librrd не нужна. Сценарий: полный fetch → файл «обновляется» (новый
+ * last_up) → rrd_fetch_delta дочитывает хвост. Главный инвариант: результат
+ * дельты совпадает точка в точку с полным fetch того же окна.
+ */
+#include "minitest.h"
+#include "rrd/reader.h"
+#include "rrd/mmap_reader.h"
+#include "rrd/rra_cache.h"
+#include "rrd_synth.h"
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+
+#if defined(__LP64__)
+
+/* Окно в 150 с: select_optimal_step не опускается ниже DEFAULT_STEP (15 с),
+ * поэтому данные идут из архива AVERAGE 6×10 — шаг 60. При любой секунде
+ * текущей минуты окно захватывает строку, записанную до last_up. */
+#define PERIOD 150
+#define STEP   60
+
+static MetricConfig plain_cfg = { .transform_type = "none" };
+static MetricConfig sum_cfg = { .transform_type = "sum" };
+
+static int same_data(const MetricData *a, const MetricData *b) {
+    if (a->series_count != b->series_count) return 0;
+    for (int s = 0; s < a->series_count; s++) {
+        if (strcmp(a->series_names[s], b->series_names[s]) != 0) return 0;
+        if (a->series_counts[s] != b->series_counts[s]) return 0;
+        for (int i = 0; i < a->series_counts[s]; i++) {
+            if (a->series_data[s][i].timestamp != b->series_data[s][i].timestamp) return 0;
+            if (a->series_data[s][i].value != b->series_data[s][i].value) return 0;
+        }
+    }
+    return 1;
+}
+
+static int total_points(const MetricData *d) {
+    int n = 0;
+    for (int s = 0; s < d->series_count; s++) n += d->series_counts[s];
+    return n;
+}
+
+/* Полный fetch, файл дописан на одну строку, дельта == полный fetch. */
+static void check_delta_matches_full(MetricConfig *cfg) {
+    ASSERT(synth_ensure_dir() == 0);
+    rrd_reader_set_backend(RRD_READER_MMAP);
+
+    time_t now = time(NULL);
+    time_t minute = now - now % STEP;
+    const char *path = synth_write_rrd("delta.rrd", minute - STEP, SYNTH_COOKIE);
+    ASSERT(path != NULL);
+    MetricData *base = rrd_fetch_data(NULL, path, now - PERIOD, "", cfg);
+    ASSERT(base != NULL);
+    if (!base) return;
+    ASSERT(base->fetch_step == STEP);
+    ASSERT(base->fetch_end == minute - STEP);
+
+    ASSERT(synth_write_rrd("delta.rrd", minute, SYNTH_COOKIE) != NULL);
+    time_t start = time(NULL) - PERIOD;
+    MetricData *delta = rrd_fetch_delta(NULL, path, base, start);
+    MetricData *full = rrd_fetch_data(NULL, path, start, "", cfg);
+    ASSERT(delta != NULL && full != NULL);
+    if (delta && full) {
+        ASSERT(same_data(delta, full));
+        ASSERT(delta->fetch_end == full->fetch_end);
+        ASSERT(delta->fetch_end == minute);
+        ASSERT(delta->fetch_step == STEP);
+        ASSERT(total_points(delta) > total_points(base) || cfg == &sum_cfg);
+    }
+
+    metric_data_release(base);
+    metric_data_release(delta);
+    metric_data_release(full);
+}
+
+TEST(delta_matches_full_fetch) {
+    check_delta_matches_full(&plain_cfg);
+}
+
+/* "sum": строки без данных дают нули — они не должны «застрять» в дельте. */
+TEST(delta_matches_full_fetch_sum) {
+    check_delta_matches_full(&sum_cfg);
+}
+
+/* Дельта невозможна → NULL (вызывающий делает полный fetch). */
+TEST(delta_refuses_incompatible_base) {
+    ASSERT(synth_ensure_dir() == 0);
+    rrd_reader_set_backend(RRD_READER_MMAP);
+
+    time_t now = time(NULL);
+    const char *path = synth_write_rrd("delta.rrd", now - now % STEP, SYNTH_COOKIE);
+    ASSERT(path != NULL);
+    MetricData *base = rrd_fetch_data(NULL, path, now - PERIOD, "", &plain_cfg);
+    ASSERT(base != NULL);
+    if (!base) return;
+
+    MetricData other = *base;                      /* поверхностная копия, не освобождается */
+    other.fetch_step = 20;                         /* архива с таким шагом нет */
+    ASSERT(rrd_fetch_delta(NULL, path, &other, now - PERIOD) == NULL);
+
+    other.fetch_step = 0;                          /* не RRD-данные */
+    ASSERT(rrd_fetch_delta(NULL, path, &other, now - PERIOD) == NULL);
+
+    /* Окно ушло целиком за прочитанное: переиспользовать нечего. */
+    ASSERT(rrd_fetch_delta(NULL, path, base, base->fetch_end + 100) == NULL);
+
+    ASSERT(rrd_fetch_delta(NULL, path, NULL, now - PERIOD) == NULL);
+
+    metric_data_release(base);
+    rrd_mmap_free();
+    rra_cache_free();
+}
+
+TEST_MAIN()
+    RUN(delta_matches_full_fetch);
+    RUN(delta_matches_full_fetch_sum);
+    RUN(delta_refuses_incompatible_base);
+TEST_RETURN()
+
+#else
+
+int main(void) {
+    printf("test_delta: смещения формата RRD заданы для LP64, пропущено\n");
+    return 0;
+}
+
+#endif
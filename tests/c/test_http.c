@@ -0,0 +1,227 @@
+/**
+ * @file test_http.c
+ * @brief Тесты разбора HTTP-запросов (src/http.c) для epoll-сервера
+ *
+ * Покрывает чистую логику, на которую опирается реактор http_server.c:
+ * определение keep-alive по версии и заголовку Connection, а также
+ * http_request_length — границу запроса при частичном чтении и pipelining.
+ * Отправка ответа: заголовки и тело уходят одним writev без склейки.
+ * Сжатие: Accept-Encoding запроса и Content-Encoding/Vary ответа.
+ */
+#define _GNU_SOURCE      /* memmem() */
+#include "minitest.h"
+#include "http.h"
+#include <stdlib.h>
+#include <unistd.h>
+#include <sys/socket.h>
+
+/* HTTP/1.1 без Connection → keep-alive; path/query разбираются как раньше. */
+TEST(http11_defaults_to_keep_alive) {
+    const char *raw = "GET /cpu?period=3600 HTTP/1.1\r\nHost: x\r\n\r\n";
+    http_request_t req;
+    ASSERT(http_parse_request(raw, strlen(raw), &req) == 0);
+    ASSERT_STR(req.method, "GET");
+    ASSERT_STR(req.path, "/cpu");
+    ASSERT_STR(req.query, "period=3600");
+    ASSERT(req.keep_alive == 1);
+}
+
+/* HTTP/1.0 по умолчанию закрывает соединение; keep-alive — только явно. */
+TEST(http10_defaults_to_close) {
+    const char *raw = "GET /cpu HTTP/1.0\r\n\r\n";
+    http_request_t req;
+    ASSERT(http_parse_request(raw, strlen(raw), &req) == 0);
+    ASSERT(req.keep_alive == 0);
+
+    const char *ka = "GET /cpu HTTP/1.0\r\nconnection: Keep-Alive\r\n\r\n";
+    ASSERT(http_parse_request(ka, strlen(ka), &req) == 0);
+    ASSERT(req.keep_alive == 1);
+}
+
+/* Connection: close перекрывает умолчание HTTP/1.1 (имя без учёта регистра). */
+TEST(connection_close_overrides_http11) {
+    const char *raw = "GET /ram HTTP/1.1\r\nHost: x\r\nCONNECTION:  close \r\n\r\n";
+    http_request_t req;
+    ASSERT(http_parse_request(raw, strlen(raw), &req) == 0);
+    ASSERT(req.keep_alive == 0);
+}
+
+/* Тот же разбор без http_request_t — для реактора и svgd-gate. */
+TEST(request_keep_alive_rules) {
+    const char *r11 = "GET / HTTP/1.1\r\nHost: x\r\n\r\n";
+    const char *r11c = "GET / HTTP/1.1\r\nCONNECTION:  Close \r\n\r\n";
+    const char *r10 = "GET / HTTP/1.0\r\n\r\n";
+    const char *r10k = "GET / HTTP/1.0\r\nConnection: keep-alive\r\n\r\n";
+    ASSERT(http_request_keep_alive(r11, strlen(r11)) == 1);
+    ASSERT(http_request_keep_alive(r11c, strlen(r11c)) == 0);
+    ASSERT(http_request_keep_alive(r10, strlen(r10)) == 0);
+    ASSERT(http_request_keep_alive(r10k, strlen(r10k)) == 1);
+
+    size_t len = 0;
+    const char *v = http_find_header(r11c, strlen(r11c), "connection", &len);
+    ASSERT(v && len == 5 && memcmp(v, "Close", 5) == 0);
+    ASSERT(http_find_header(r11, strlen(r11), "Connection", &len) == NULL);
+}
+
+/* Неполные заголовки → 0 (ждать данных); позиция поиска сохраняется, и
+ * терминатор, разрезанный между двумя чтениями, всё равно находится. */
+TEST(request_length_incremental) {
+    const char *raw = "GET /cpu HTTP/1.1\r\nHost: x\r\n\r\n";
+    size_t full = strlen(raw);
+    size_t scan = 0, head = 0;
+    ASSERT(http_request_length(raw, full - 2, &scan, &head) == 0);
+    ASSERT(scan == full - 2);
+    ASSERT(http_request_length(raw, full, &scan, &head) == (long)full);
+    ASSERT(head == full);       /* длина заголовков */
+}
+
+/* Content-Length учитывается: запрос полон только вместе с телом. */
+TEST(request_length_with_body) {
+    const char *raw = "POST /x HTTP/1.1\r\nContent-Length: 4\r\n\r\nabcd";
+    size_t full = strlen(raw);
+    ASSERT(http_request_length(raw, full - 1, NULL, NULL) == 0);
+    ASSERT(http_request_length(raw, full, NULL, NULL) == (long)full);
+}
+
+/* Тело приходит следующим чтением: сохранённая позиция поиска не должна
+ * перескочить уже найденный конец заголовков. */
+TEST(request_length_body_in_later_read) {
+    const char *raw = "POST /x HTTP/1.1\r\nContent-Length: 5\r\n\r\nhello";
+    size_t full = strlen(raw);
+    size_t headers = full - 5;
+    size_t scan = 0, head = 0;
+    ASSERT(http_request_length(raw, headers, &scan, &head) == 0);
+    ASSERT(head == headers);
+    ASSERT(http_request_length(raw, headers + 2, &scan, &head) == 0);
+    ASSERT(http_request_length(raw, full, &scan, &head) == (long)full);
+    ASSERT(head == headers);
+}
+
+/* Pipelining: возвращается длина только первого запроса. */
+TEST(request_length_pipelined) {
+    const char *first = "GET /a HTTP/1.1\r\n\r\n";
+    const char *raw = "GET /a HTTP/1.1\r\n\r\nGET /b HTTP/1.1\r\n\r\n";
+    ASSERT(http_request_length(raw, strlen(raw), NULL, NULL) == (long)strlen(first));
+}
+
+/* Битый Content-Length и превышение HTTP_MAX_REQUEST → -1. */
+TEST(request_length_rejects_bad_input) {
+    const char *neg = "POST /x HTTP/1.1\r\nContent-Length: -5\r\n\r\n";
+    ASSERT(http_request_length(neg, strlen(neg), NULL, NULL) == -1);
+
+    const char *huge = "POST /x HTTP/1.1\r\nContent-Length: 999999999\r\n\r\n";
+    ASSERT(http_request_length(huge, strlen(huge), NULL, NULL) == -1);
+
+    static char junk[HTTP_MAX_REQUEST + 1];
+    memset(junk, 'a', sizeof(junk));
+    ASSERT(http_request_length(junk, sizeof(junk), NULL, NULL) == -1);
+}
+
+/* Ответ несёт Connection в соответствии с keep_alive. */
+TEST(response_connection_header) {
+    http_response_t resp = {0};
+    resp.status = 200;
+    strcpy(resp.content_type, "image/svg+xml");
+    resp.body = "<svg/>";
+    resp.body_len = 6;
+    resp.keep_alive = 1;
+
+    size_t len;
+    char *raw = http_build_response(&resp, &len);
+    ASSERT(raw != NULL);
+    ASSERT(memmem(raw, len, "Connection: keep-alive\r\n", 24) != NULL);
+    ASSERT(memcmp(raw + len - 6, "<svg/>", 6) == 0);
+    free(raw);
+
+    raw = http_build_error(404, "nope", 0, &len);
+    ASSERT(raw != NULL);
+    ASSERT(memmem(raw, len, "Connection: close\r\n", 19) != NULL);
+    ASSERT(memmem(raw, len, "{\"error\":\"nope\"}", 16) != NULL);
+    free(raw);
+}
+
+/* Accept-Encoding копируется в запрос; Content-Encoding и Vary — в ответ. */
+TEST(content_encoding_headers) {
+    const char *raw = "GET /cpu HTTP/1.1\r\nAccept-Encoding:  gzip, deflate \r\n\r\n";
+    http_request_t req;
+    ASSERT(http_parse_request(raw, strlen(raw), &req) == 0);
+    ASSERT_STR(req.accept_encoding, "gzip, deflate");
+
+    const char *plain = "GET /cpu HTTP/1.1\r\n\r\n";
+    ASSERT(http_parse_request(plain, strlen(plain), &req) == 0);
+    ASSERT_STR(req.accept_encoding, "");
+
+    http_response_t resp = {0};
+    resp.status = 200;
+    strcpy(resp.content_type, "image/svg+xml");
+    resp.body_len = 10;
+    char head[HTTP_MAX_HEAD];
+    int len = http_format_head(&resp, head, sizeof(head));
+    ASSERT(len > 0);
+    ASSERT(memmem(head, len, "Content-Encoding", 16) == NULL);
+    ASSERT(memmem(head, len, "Vary: Accept-Encoding\r\n", 23) != NULL);
+
+    resp.content_encoding = "gzip";
+    len = http_format_head(&resp, head, sizeof(head));
+    ASSERT(len > 0);
+    ASSERT(memmem(head, len, "Content-Encoding: gzip\r\n", 24) != NULL);
+}
+
+/* Заголовки + тело через writev: на сокете ровно те же байты, что
+ * собирает http_build_response(); продвижение iovec через границу частей. */
+TEST(send_response_matches_build) {
+    static char body[200000];
+    for (size_t i = 0; i < sizeof(body); i++) body[i] = 'a' + i % 26;
+
+    int sv[2];
+    ASSERT(socketpair(AF_UNIX, SOCK_STREAM, 0, sv) == 0);
+    /* Тело больше буфера сокета: читаем в фоне, пока пишет http_send_response */
+    pid_t pid = fork();
+    ASSERT(pid >= 0);
+    if (pid == 0) {
+        close(sv[0]);
+        http_send_response(sv[1], "image/svg+xml", body, sizeof(body));
+        _exit(0);
+    }
+    close(sv[1]);
+    size_t cap = sizeof(body) + HTTP_MAX_HEAD, got = 0;
+    char *buf = malloc(cap);
+    ssize_t n;
+    while ((n = read(sv[0], buf + got, cap - got)) > 0) got += (size_t)n;
+    close(sv[0]);
+
+    http_response_t resp = {0};
+    resp.status = 200;
+    strcpy(resp.content_type, "image/svg+xml");
+    resp.body = body;
+    resp.body_len = sizeof(body);
+    size_t len;
+    char *want = http_build_response(&resp, &len);
+    ASSERT(want != NULL);
+    ASSERT(got == len);
+    ASSERT(memcmp(buf, want, len) == 0);
+    free(want);
+    free(buf);
+
+    char a[] = "head", b[] = "body";
+    struct iovec iov[2] = { { a, 4 }, { b, 4 } };
+    http_iov_advance(iov, 2, 6);
+    ASSERT(iov[0].iov_len == 0);
+    ASSERT(iov[1].iov_len == 2);
+    ASSERT(memcmp(iov[1].iov_base, "dy", 2) == 0);
+}
+
+TEST_MAIN()
+    RUN(http11_defaults_to_keep_alive);
+    RUN(http10_defaults_to_close);
+    RUN(connection_close_overrides_http11);
+    RUN(request_keep_alive_rules);
+    RUN(request_length_incremental);
+    RUN(request_length_with_body);
+    RUN(request_length_body_in_later_read);
+    RUN(request_length_pipelined);
+    RUN(request_length_rejects_bad_input);
+    RUN(response_connection_header);
+    RUN(send_response_matches_build);
+    RUN(content_encoding_headers);
+TEST_RETURN()
@@ -0,0 +1,322 @@
+/**
+ * @file test_http_server.c
+ * @brief Тесты epoll-сервера HTTP (src/http_server.c): HTTP-режим svgd и svgd-gate
+ *
+ * Живой сервер на 127.0.0.1 с тестовым обработчиком: keep-alive, тело POST,
+ * pipelining, медленный клиент и медленный обработчик не блокируют остальных,
+ * ответы клиенту, который после запроса закрыл свою сторону (shutdown(SHUT_WR),
+ * `nc -N`): запрос, уже лежащий в буфере, должен быть обработан. Ошибка
+ * обработчика → 500, статическое тело не освобождается, тело с владельцем
+ * отдаётся через body_release, worker_init
+ * вызывается на каждом рабочем потоке, шардов не больше, чем потоков.
+ */
+#include "minitest.h"
+#include "http_server.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>      /* usleep() */
+#include <time.h>
+#include <pthread.h>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+
+#define SERVER_WORKERS 4
+
+static int server_port;
+static pthread_t server_thread;
+static int workers_inited;
+static int bodies_released;
+
+/* Владелец тела ответа: как общий буфер кэша SVG */
+typedef struct {
+    char data[16];
+} owned_body_t;
+
+static void release_owned(void *owner) {
+    free(owner);
+    __atomic_add_fetch(&bodies_released, 1, __ATOMIC_SEQ_CST);
+}
+
+static void count_worker(void) {
+    __atomic_add_fetch(&workers_inited, 1, __ATOMIC_SEQ_CST);
+}
+
+/* Отвечает путём запроса и длиной тела; /slow спит 1 с (как долгий бэкенд),
+ * /fail — ошибка обработчика, /static — тело без malloc, /owned — тело
+ * внутри объекта-владельца. */
+static int echo_handler(const http_raw_request_t *req, http_reply_t *reply) {
+    static char static_body[] = "static";
+    char path[128] = "";
+    sscanf(req->raw, "%*s %127s", path);
+    if (strcmp(path, "/slow") == 0) sleep(1);
+    if (strcmp(path, "/fail") == 0) return -1;
+
+    char *body = static_body;
+    int len = (int)strlen(static_body);
+    if (strcmp(path, "/static") == 0) {
+        reply->body_static = 1;
+    } else if (strcmp(path, "/owned") == 0) {
+        owned_body_t *owner = malloc(sizeof(*owner));
+        if (!owner) return -1;
+        len = snprintf(owner->data, sizeof(owner->data), "owned");
+        body = owner->data;
+        reply->body_release = release_owned;
+        reply->body_owner = owner;
+    } else {
+        body = malloc(160);
+        if (!body) return -1;
+        len = snprintf(body, 160, "%s %zu", path, req->body_len);
+    }
+
+    http_response_t resp = {0};
+    resp.status = 200;
+    strncpy(resp.content_type, "text/plain", sizeof(resp.content_type) - 1);
+    resp.body_len = (size_t)len;
+    resp.keep_alive = reply->keep_alive;
+    reply->head_len = (size_t)http_format_head(&resp, reply->head, sizeof(reply->head));
+    reply->body = body;
+    reply->body_len = (size_t)len;
+    return 0;
+}
+
+static int server_shards = 1;
+
+static void *server_main(void *arg) {
+    (void)arg;
+    http_server_start(server_port, echo_handler, count_worker, SERVER_WORKERS, server_shards);
+    return NULL;
+}
+
+static int connect_server(void) {
+    int fd = socket(AF_INET, SOCK_STREAM, 0);
+    struct sockaddr_in addr = { .sin_family = AF_INET, .sin_port = htons(server_port),
+                                .sin_addr.s_addr = htonl(INADDR_LOOPBACK) };
+    for (int i = 0; i < 100; i++) {     /* сервер мог ещё не начать слушать */
+        if (connect(fd, (struct sockaddr *)&addr, sizeof(addr)) == 0) return fd;
+        usleep(10000);
+    }
+    close(fd);
+    return -1;
+}
+
+static void send_str(int fd, const char *s) {
+    ssize_t n = send(fd, s, strlen(s), MSG_NOSIGNAL);
+    (void)n;
+}
+
+/* Читает до закрытия соединения сервером (или want ответов); возвращает
+ * число ответов "HTTP/1.1 ". *closed = 1, если сервер закрыл соединение. */
+static int read_until_close(int fd, char *buf, size_t size, int want, int *closed) {
+    size_t len = 0;
+    int count = 0;
+    *closed = 0;
+    buf[0] = '\0';
+    while (len < size - 1) {
+        ssize_t n = recv(fd, buf + len, size - 1 - len, 0);
+        if (n <= 0) {
+            *closed = 1;
+            break;
+        }
+        len += (size_t)n;
+        buf[len] = '\0';
+        count = 0;
+        for (const char *p = buf; (p = strstr(p, "HTTP/1.1 ")); p++) count++;
+        if (want && count >= want) break;
+    }
+    return count;
+}
+
+static double now_sec(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+/* Свободный порт: занять 0, узнать номер, отпустить */
+static int free_port(void) {
+    int fd = socket(AF_INET, SOCK_STREAM, 0);
+    struct sockaddr_in addr = { .sin_family = AF_INET, .sin_addr.s_addr = htonl(INADDR_LOOPBACK) };
+    bind(fd, (struct sockaddr *)&addr, sizeof(addr));
+    socklen_t alen = sizeof(addr);
+    getsockname(fd, (struct sockaddr *)&addr, &alen);
+    close(fd);
+    return ntohs(addr.sin_port);
+}
+
+TEST(http_server_starts) {
+    server_port = free_port();
+    ASSERT(pthread_create(&server_thread, NULL, server_main, NULL) == 0);
+    int c = connect_server();
+    ASSERT(c >= 0);
+    close(c);
+}
+
+/* Keep-alive: соединение остаётся открытым после ответа, тело POST доходит. */
+TEST(http_server_keep_alive) {
+    int fd = connect_server();
+    char buf[1024];
+    int closed = 0;
+    send_str(fd, "GET /a HTTP/1.1\r\n\r\n");
+    ASSERT(read_until_close(fd, buf, sizeof(buf), 1, &closed) == 1);
+    ASSERT(!closed);
+    ASSERT(strstr(buf, "\r\n\r\n/a 0") != NULL);
+    ASSERT(strstr(buf, "keep-alive") != NULL);
+    send_str(fd, "POST /b HTTP/1.1\r\nContent-Length: 5\r\n\r\nhello");
+    ASSERT(read_until_close(fd, buf, sizeof(buf), 1, &closed) == 1);
+    ASSERT(strstr(buf, "/b 5") != NULL);
+    close(fd);
+}
+
+/* Pipelining: ответы в порядке запросов; HTTP/1.0 закрывает соединение. */
+TEST(http_server_pipelining) {
+    int fd = connect_server();
+    char buf[2048];
+    int closed = 0;
+    send_str(fd, "GET /one HTTP/1.1\r\n\r\nGET /two HTTP/1.1\r\n\r\nGET /three HTTP/1.0\r\n\r\n");
+    ASSERT(read_until_close(fd, buf, sizeof(buf), 0, &closed) == 3);
+    ASSERT(closed);
+    const char *one = strstr(buf, "/one"), *two = strstr(buf, "/two"), *three = strstr(buf, "/three");
+    ASSERT(one && two && three && one < two && two < three);
+    ASSERT(strstr(buf, "Connection: close") != NULL);
+    close(fd);
+}
+
+/* Клиент с недосланным запросом и долгий обработчик не задерживают других. */
+TEST(http_server_no_head_of_line_blocking) {
+    int stalled = connect_server();
+    send_str(stalled, "GET /partial HTTP/1.1\r\nHost:");
+
+    int slow = connect_server();
+    send_str(slow, "GET /slow HTTP/1.1\r\n\r\n");
+    usleep(50000);
+
+    double t0 = now_sec();
+    int fd = connect_server();
+    char buf[1024];
+    int closed = 0;
+    send_str(fd, "GET /fast HTTP/1.1\r\n\r\n");
+    ASSERT(read_until_close(fd, buf, sizeof(buf), 1, &closed) == 1);
+    ASSERT(now_sec() - t0 < 0.5);
+
+    ASSERT(read_until_close(slow, buf, sizeof(buf), 1, &closed) == 1);
+    ASSERT(strstr(buf, "/slow") != NULL);
+    close(fd);
+    close(slow);
+    close(stalled);
+}
+
+/* Запрос, затем shutdown(SHUT_WR): ответ приходит, потом сервер закрывает. */
+TEST(http_server_half_close_answered) {
+    int fd = connect_server();
+    char buf[1024];
+    int closed = 0;
+    send_str(fd, "GET /half HTTP/1.1\r\n\r\n");
+    shutdown(fd, SHUT_WR);
+    ASSERT(read_until_close(fd, buf, sizeof(buf), 0, &closed) == 1);
+    ASSERT(closed);
+    ASSERT(strstr(buf, "/half") != NULL);
+    close(fd);
+}
+
+/* Несколько запросов в буфере до EOF (в том числе POST с телом) — ответы
+ * на все, по порядку. */
+TEST(http_server_half_close_pipelined) {
+    int fd = connect_server();
+    char buf[2048];
+    int closed = 0;
+    send_str(fd, "GET /one HTTP/1.1\r\n\r\nPOST /two HTTP/1.1\r\nContent-Length: 2\r\n\r\nhi");
+    shutdown(fd, SHUT_WR);
+    ASSERT(read_until_close(fd, buf, sizeof(buf), 0, &closed) == 2);
+    ASSERT(closed);
+    const char *one = strstr(buf, "/one 0"), *two = strstr(buf, "/two 2");
+    ASSERT(one && two && one < two);
+    close(fd);
+}
+
+/* Недосланный запрос и EOF: ответа нет, соединение закрыто сразу. */
+TEST(http_server_half_close_incomplete) {
+    int fd = connect_server();
+    char buf[1024];
+    int closed = 0;
+    send_str(fd, "GET /partial HTTP/1.1\r\nHost:");
+    shutdown(fd, SHUT_WR);
+    ASSERT(read_until_close(fd, buf, sizeof(buf), 0, &closed) == 0);
+    ASSERT(closed);
+    close(fd);
+}
+
+/* Ошибка обработчика → 500, соединение живо; статическое тело отдаётся
+ * как есть, тело с владельцем отпускается через body_release (ASan поймал
+ * бы free() не-malloc'ного буфера). */
+TEST(http_server_handler_failure_and_static_body) {
+    int fd = connect_server();
+    char buf[1024];
+    int closed = 0;
+    send_str(fd, "GET /fail HTTP/1.1\r\n\r\n");
+    ASSERT(read_until_close(fd, buf, sizeof(buf), 1, &closed) == 1);
+    ASSERT(strstr(buf, "500 Internal Server Error") != NULL);
+    send_str(fd, "GET /static HTTP/1.1\r\n\r\n");
+    ASSERT(read_until_close(fd, buf, sizeof(buf), 1, &closed) == 1);
+    ASSERT(!closed);
+    ASSERT(strstr(buf, "\r\n\r\nstatic") != NULL);
+    send_str(fd, "GET /owned HTTP/1.1\r\n\r\n");
+    ASSERT(read_until_close(fd, buf, sizeof(buf), 1, &closed) == 1);
+    ASSERT(strstr(buf, "\r\n\r\nowned") != NULL);
+    close(fd);
+    for (int i = 0; i < 100 && !__atomic_load_n(&bodies_released, __ATOMIC_SEQ_CST); i++) {
+        usleep(10000);
+    }
+    ASSERT(bodies_released == 1);
+}
+
+/* Битый запрос → 400 и закрытие соединения. */
+TEST(http_server_rejects_oversized) {
+    int fd = connect_server();
+    char buf[1024];
+    int closed = 0;
+    send_str(fd, "POST /x HTTP/1.1\r\nContent-Length: 999999999\r\n\r\n");
+    ASSERT(read_until_close(fd, buf, sizeof(buf), 0, &closed) == 1);
+    ASSERT(closed);
+    ASSERT(strstr(buf, "400 Bad Request") != NULL);
+    close(fd);
+}
+
+TEST(http_server_stops) {
+    http_server_stop();
+    ASSERT(pthread_join(server_thread, NULL) == 0);
+    ASSERT(workers_inited == SERVER_WORKERS);
+}
+
+/* Шардов больше, чем потоков (listen_shards: 0 на многоядерной машине):
+ * шардов становится столько же, сколько потоков, потоков не прибавляется. */
+TEST(http_server_caps_shards_to_workers) {
+    workers_inited = 0;
+    server_shards = SERVER_WORKERS * 4;
+    server_port = free_port();
+    ASSERT(pthread_create(&server_thread, NULL, server_main, NULL) == 0);
+    int fd = connect_server();
+    char buf[1024];
+    int closed = 0;
+    send_str(fd, "GET /sharded HTTP/1.1\r\n\r\n");
+    ASSERT(read_until_close(fd, buf, sizeof(buf), 1, &closed) == 1);
+    close(fd);
+
+    http_server_stop();
+    ASSERT(pthread_join(server_thread, NULL) == 0);
+    ASSERT(workers_inited == SERVER_WORKERS);
+}
+
+TEST_MAIN()
+    RUN(http_server_starts);
+    RUN(http_server_keep_alive);
+    RUN(http_server_pipelining);
+    RUN(http_server_no_head_of_line_blocking);
+    RUN(http_server_half_close_answered);
+    RUN(http_server_half_close_pipelined);
+    RUN(http_server_half_close_incomplete);
+    RUN(http_server_handler_failure_and_static_body);
+    RUN(http_server_rejects_oversized);
+    RUN(http_server_stops);
+    RUN(http_server_caps_shards_to_workers);
+TEST_RETURN()
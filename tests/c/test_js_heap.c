@@ -0,0 +1,199 @@
+/**
+ * @file test_js_heap.c
+ * @brief Тесты пулового аллокатора Duktape-кучи (src/rrd/js_heap.c)
+ *
+ * Куча на пуловом аллокаторе выполняет обычный JS (мелкие объекты, рост
+ * массивов и строк через realloc, большие буферы мимо пула); живые байты
+ * считаются и возвращаются к исходному уровню. Потолок js.heap_max_bytes
+ * роняет только сам вызов ("alloc failed"), куча остаётся рабочей — в том числе
+ * при рендере через svg_generate(). Рост на heap_gc_bytes запускает duk_gc(),
+ * который собирает циклический мусор. Статистика видит все живые кучи.
+ */
+#include "minitest.h"
+#include "rrd/js_heap.h"
+#include "rrd/svg.h"
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#define MiB (1024 * 1024)
+
+/* svg.c берёт флаг verbose из main.c */
+int is_verbose_logging(void) { return 0; }
+
+/* Выполняет выражение; возвращает строковый результат (strdup) или NULL при ошибке */
+static char *eval(duk_context *ctx, const char *src) {
+    if (duk_peval_string(ctx, src) != 0) {
+        duk_pop(ctx);
+        return NULL;
+    }
+    char *out = strdup(duk_safe_to_string(ctx, -1));
+    duk_pop(ctx);
+    return out;
+}
+
+TEST(pooled_heap_runs_js_and_counts_bytes) {
+    js_heap_set_limits(0, 0);
+    js_heap_t *heap = NULL;
+    duk_context *ctx = js_heap_create(&heap);
+    ASSERT(ctx != NULL);
+    size_t base = js_heap_bytes(heap);
+    ASSERT(base > 0);
+
+    /* Мелкие объекты, рост массива и строки (realloc между классами и за
+     * пределы пула), большой буфер мимо пула */
+    char *r = eval(ctx,
+        "var a = []; for (var i = 0; i < 20000; i++) a.push({ i: i, s: 'x' + i });\n"
+        "var s = ''; for (var j = 0; j < 5000; j++) s += j;\n"
+        "var b = new Float64Array(100000); b[99999] = 7;\n"
+        "a.length + ':' + s.length + ':' + b[99999] + ':' + a[12345].s");
+    ASSERT(r != NULL);
+    ASSERT_STR(r, "20000:18890:7:x12345");
+    free(r);
+    size_t peak = js_heap_bytes(heap);
+    ASSERT(peak > base + MiB);
+
+    /* Освобождение возвращает учёт к исходному уровню (плюс выросшая
+     * таблица строк) */
+    r = eval(ctx, "a = null; s = null; b = null; 'ok'");
+    free(r);
+    duk_gc(ctx, 0);
+    ASSERT(js_heap_bytes(heap) < peak / 8);
+
+    js_heap_destroy(heap);
+}
+
+TEST(ceiling_fails_call_not_heap) {
+    js_heap_set_limits(4 * MiB, 0);
+    js_heap_stats_t before;
+    js_heap_stats(&before);
+
+    js_heap_t *heap = NULL;
+    duk_context *ctx = js_heap_create(&heap);
+    ASSERT(ctx != NULL);
+
+    /* Буфер больше потолка и постепенный рост до потолка */
+    ASSERT(eval(ctx, "new Uint8Array(8 * 1024 * 1024).length") == NULL);
+    ASSERT(eval(ctx, "var k = []; while (true) k.push({ v: k.length }); 0") == NULL);
+    ASSERT(js_heap_bytes(heap) <= 4 * MiB);
+
+    /* Мусор упавшего вызова собирается, куча работает дальше */
+    char *r = eval(ctx, "k = null; [1, 2, 3].map(function (x) { return x * 2; }).join(',')");
+    ASSERT(r != NULL);
+    ASSERT_STR(r, "2,4,6");
+    free(r);
+
+    js_heap_stats_t after;
+    js_heap_stats(&after);
+    ASSERT(after.limit_failures > before.limit_failures);
+    ASSERT(after.max_bytes == 4 * MiB);
+
+    js_heap_destroy(heap);
+    js_heap_set_limits(0, 0);
+}
+
+TEST(growth_forces_gc) {
+    js_heap_set_limits(0, 256 * 1024);
+    js_heap_stats_t before;
+    js_heap_stats(&before);
+
+    js_heap_t *heap = NULL;
+    duk_context *ctx = js_heap_create(&heap);
+    ASSERT(ctx != NULL);
+    size_t base = js_heap_bytes(heap);
+
+    /* Циклы не освобождаются подсчётом ссылок — только mark-and-sweep.
+     * Пока массив жив, фоновая сборка Duktape их не трогает. */
+    char *r = eval(ctx,
+        "var keep = []; for (var i = 0; i < 20000; i++) { var a = {}, b = { a: a };"
+        " a.b = b; keep.push(a); } keep = null; 'ok'");
+    free(r);
+    size_t grown = js_heap_bytes(heap);
+    ASSERT(grown > base + 256 * 1024);
+
+    js_heap_maybe_gc(heap);
+    js_heap_stats_t after;
+    js_heap_stats(&after);
+    ASSERT(after.forced_gcs == before.forced_gcs + 1);
+    ASSERT(js_heap_bytes(heap) < grown / 2);
+
+    /* Без нового роста повторный вызов GC не запускает */
+    js_heap_maybe_gc(heap);
+    js_heap_stats(&after);
+    ASSERT(after.forced_gcs == before.forced_gcs + 1);
+
+    js_heap_destroy(heap);
+    js_heap_set_limits(0, 0);
+}
+
+TEST(stats_list_live_heaps) {
+    js_heap_stats_t s0;
+    js_heap_stats(&s0);
+
+    js_heap_t *h1 = NULL, *h2 = NULL;
+    ASSERT(js_heap_create(&h1) != NULL);
+    ASSERT(js_heap_create(&h2) != NULL);
+
+    js_heap_stats_t s;
+    js_heap_stats(&s);
+    ASSERT(s.heaps == s0.heaps + 2);
+    ASSERT(s.bytes == s0.bytes + js_heap_bytes(h1) + js_heap_bytes(h2));
+
+    js_heap_destroy(h1);
+    js_heap_destroy(h2);
+    js_heap_stats(&s);
+    ASSERT(s.heaps == s0.heaps);
+}
+
+/* Рендер через svg_generate(): серия больше потолка — NULL, следующий
+ * запрос в том же потоке рендерится */
+TEST(render_over_ceiling_fails_cleanly) {
+    static const char *script =
+        "function generateSVG(series, options) {\n"
+        "    return '<svg>' + series[0].values.length + '</svg>';\n"
+        "}\n";
+    char path[] = "/tmp/svgd_test_js_heap_XXXXXX";
+    int fd = mkstemp(path);
+    ASSERT(fd >= 0);
+    ASSERT(write(fd, script, strlen(script)) == (ssize_t)strlen(script));
+    close(fd);
+    ASSERT(svg_init_cache(path) == 0);
+
+    int n = 600000;                          /* 2 x 8 байт x n ≈ 9.6 MiB */
+    DataPoint *points = calloc(n, sizeof(DataPoint));
+    ASSERT(points != NULL);
+    char *names[1] = { "v" };
+    DataPoint *series[1] = { points };
+    int counts[1] = { n };
+    MetricData md;
+    memset(&md, 0, sizeof md);
+    md.series_count = 1;
+    md.series_names = names;
+    md.series_data = series;
+    md.series_counts = counts;
+    md.param1 = "";
+    MetricConfig metric = { .title = "t", .transform_type = "none",
+                            .value_format = "%.2f", .panel_type = "chart" };
+
+    js_heap_set_limits(4 * MiB, 0);
+    ASSERT(svg_generate(path, &md, &metric, 640, 200, "light", NULL) == NULL);
+
+    counts[0] = 1000;
+    char *svg = svg_generate(path, &md, &metric, 640, 200, "light", NULL);
+    ASSERT(svg != NULL);
+    ASSERT_STR(svg, "<svg>1000</svg>");
+    free(svg);
+
+    js_heap_set_limits(0, 0);
+    free(points);
+    svg_free_cache();
+    unlink(path);
+}
+
+TEST_MAIN()
+    RUN(pooled_heap_runs_js_and_counts_bytes);
+    RUN(ceiling_fails_call_not_heap);
+    RUN(growth_forces_gc);
+    RUN(stats_list_live_heaps);
+    RUN(render_over_ceiling_fails_cleanly);
+TEST_RETURN()
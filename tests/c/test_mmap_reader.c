@@ -0,0 +1,228 @@
+/**
+ * @file test_mmap_reader.c
+ * @brief Unit-тесты нативного mmap-ридера RRD (src/rrd/mmap_reader.c)
+ *
+ * Синтетический RRD (rrd_synth.h) пишется по явным смещениям формата librrd
+ * (rrd_format.h, LP64) — независимо от структур ридера, так что тест ловит и
+ * ошибку раскладки. Ожидаемые окна посчитаны вручную по арифметике rrd_fetch_r:
+ * выравнивание start/end по шагу, выбор RRA (полное покрытие с ближайшим
+ * шагом, иначе наибольшее частичное), NaN до старейшей и после новейшей строки.
+ *
+ * Если в demo/rrd/ есть фикстуры (demo/generate-rrd.sh), каждый файл
+ * дополнительно сверяется с rrd_fetch_r построчно.
+ */
+#define _XOPEN_SOURCE 700
+#include "minitest.h"
+#include "rrd/mmap_reader.h"
+#include "rrd_synth.h"
+#include <rrd.h>
+#include <ftw.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#if defined(__LP64__)
+
+#define LAST_UP 1000005
+
+/* Окно внутри сырого архива: шаг 10, строки (start, end], хвост — NaN. */
+TEST(mmap_fetch_window) {
+    ASSERT(synth_ensure_dir() == 0);
+    const char *path = synth_write_rrd("cpu.rrd", LAST_UP, SYNTH_COOKIE);
+    ASSERT(path != NULL);
+
+    time_t start = 999950, end = 1000000;
+    unsigned long step = 10, ds_cnt = 0;
+    char **names = NULL;
+    double *data = NULL;
+    ASSERT(rrd_mmap_fetch(path, "AVERAGE", &start, &end, &step, &ds_cnt, &names, &data) == 0);
+    ASSERT(start == 999950);
+    ASSERT(end == 1000010);
+    ASSERT(step == 10);
+    ASSERT(ds_cnt == 2);
+    ASSERT_STR(names[0], "user");
+    ASSERT_STR(names[1], "system");
+    for (int i = 0; i < 5; i++) {
+        ASSERT(data[i * 2] == 999960.0 + i * 10);
+        ASSERT(data[i * 2 + 1] == 999961.0 + i * 10);
+    }
+    ASSERT(isnan(data[10]) && isnan(data[11]));     /* после last_up */
+    free(names);
+    free(data);
+
+    rrd_mmap_free();
+}
+
+/* Сырой архив не покрывает начало → берётся RRA с шагом 60, покрывающий всё. */
+TEST(mmap_fetch_picks_covering_rra) {
+    ASSERT(synth_ensure_dir() == 0);
+    const char *path = synth_write_rrd("cpu.rrd", LAST_UP, SYNTH_COOKIE);
+    ASSERT(path != NULL);
+
+    time_t start = 999800, end = 999950;
+    unsigned long step = 10, ds_cnt = 0;
+    char **names = NULL;
+    double *data = NULL;
+    ASSERT(rrd_mmap_fetch(path, "AVERAGE", &start, &end, &step, &ds_cnt, &names, &data) == 0);
+    ASSERT(step == 60);
+    ASSERT(start == 999780);
+    ASSERT(end == 999960);
+    ASSERT(data[0] == 999840.0);                    /* строка (999780, 999840] */
+    ASSERT(data[4] == 999960.0);
+    free(names);
+    free(data);
+
+    rrd_mmap_free();
+}
+
+/* Единственный MAX-архив покрывает окно частично: голова — NaN. */
+TEST(mmap_fetch_partial_head_is_nan) {
+    ASSERT(synth_ensure_dir() == 0);
+    const char *path = synth_write_rrd("cpu.rrd", LAST_UP, SYNTH_COOKIE);
+    ASSERT(path != NULL);
+
+    time_t start = 999880, end = 1000000;
+    unsigned long step = 10, ds_cnt = 0;
+    char **names = NULL;
+    double *data = NULL;
+    ASSERT(rrd_mmap_fetch(path, "MAX", &start, &end, &step, &ds_cnt, &names, &data) == 0);
+    ASSERT(step == 10);
+    ASSERT(isnan(data[0]) && isnan(data[2]));       /* 999890, 999900: до старейшей */
+    ASSERT(data[4] == 999910.5);                    /* старейшая строка MAX */
+    ASSERT(data[5] == 999911.5);
+    free(names);
+    free(data);
+
+    unsigned long ds = 0;
+    ASSERT(rrd_mmap_fetch(path, "LAST", &start, &end, &step, &ds, &names, &data) == -1);
+
+    rrd_mmap_free();
+}
+
+/* Раскладка и first — как у rrd_info_r / rrd_first_r. */
+TEST(mmap_layout_and_first) {
+    ASSERT(synth_ensure_dir() == 0);
+    const char *path = synth_write_rrd("cpu.rrd", LAST_UP, SYNTH_COOKIE);
+    ASSERT(path != NULL);
+
+    RRDLayout l;
+    ASSERT(rrd_mmap_layout(path, &l) == 0);
+    ASSERT(l.base_step == 10);
+    ASSERT(l.rra_count == 3);
+    ASSERT(l.rras[1].pdp_per_row == 6);
+    ASSERT(l.rras[1].rows == 5);
+    ASSERT(l.rras[1].effective_step == 60);
+    ASSERT_STR(l.rras[2].cf, "MAX");
+    ASSERT(l.rras[2].index == 2);
+    ASSERT(l.first_timestamp == -1);
+
+    ASSERT(rrd_mmap_first(path, 0) == 999910);
+    ASSERT(rrd_mmap_first(path, 1) == 999720);
+    ASSERT(rrd_mmap_first(path, 3) == -1);
+
+    rrd_mmap_free();
+}
+
+/* Заменённый файл (новый inode) перечитывается; чужие файлы отвергаются. */
+TEST(mmap_remaps_and_rejects) {
+    ASSERT(synth_ensure_dir() == 0);
+    const char *path = synth_write_rrd("cpu.rrd", LAST_UP, SYNTH_COOKIE);
+    ASSERT(path != NULL);
+    ASSERT(rrd_mmap_first(path, 0) == 999910);
+
+    path = synth_write_rrd("cpu.rrd", LAST_UP + 100, SYNTH_COOKIE);
+    ASSERT(path != NULL);
+    ASSERT(rrd_mmap_first(path, 0) == 1000010);
+
+    const char *foreign = synth_write_rrd("foreign.rrd", LAST_UP, 1.0);   /* float cookie */
+    ASSERT(foreign != NULL);
+    RRDLayout l;
+    ASSERT(rrd_mmap_layout(foreign, &l) == -1);
+    ASSERT(rrd_mmap_layout(foreign, &l) == -1);     /* запомнен как неподдерживаемый */
+
+    char missing[600];
+    snprintf(missing, sizeof missing, "%s/missing.rrd", synth_dir);
+    ASSERT(rrd_mmap_first(missing, 0) == -1);
+
+    rrd_mmap_free();
+}
+
+/* ---- сверка с librrd на demo/rrd ---- */
+static int fixtures_checked = 0;
+
+static int same_value(double a, double b) {
+    return (isnan(a) && isnan(b)) || a == b;
+}
+
+static void compare_window(const char *path, time_t start, time_t end) {
+    time_t s1 = start, e1 = end, s2 = start, e2 = end;
+    unsigned long st1 = 1, st2 = 1, ds1 = 0, ds2 = 0;
+    char **n1 = NULL, **n2 = NULL;
+    rrd_value_t *d1 = NULL;
+    double *d2 = NULL;
+
+    ASSERT(rrd_fetch_r(path, "AVERAGE", &s1, &e1, &st1, &ds1, &n1, &d1) == 0);
+    ASSERT(rrd_mmap_fetch(path, "AVERAGE", &s2, &e2, &st2, &ds2, &n2, &d2) == 0);
+    ASSERT(s1 == s2 && e1 == e2 && st1 == st2 && ds1 == ds2);
+    if (s1 == s2 && e1 == e2 && st1 == st2 && ds1 == ds2) {
+        for (unsigned long d = 0; d < ds1; d++) ASSERT_STR(n1[d], n2[d]);
+        size_t n = (size_t)((e1 - s1) / (time_t)st1) * ds1;
+        for (size_t i = 0; i < n; i++) ASSERT(same_value(d1[i], d2[i]));
+    }
+    if (n1) {
+        for (unsigned long d = 0; d < ds1; d++) rrd_freemem(n1[d]);
+        rrd_freemem(n1);
+    }
+    if (d1) rrd_freemem(d1);
+    free(n2);
+    free(d2);
+}
+
+static void check_file(const char *path) {
+    time_t last = rrd_last_r(path);
+    ASSERT(last > 0);
+    compare_window(path, last - 3600, last);
+    compare_window(path, last - 86400, last);
+    compare_window(path, last - 7 * 86400, last);
+    compare_window(path, last - 3600 - 17, last - 1234);  /* невыровненные края */
+    fixtures_checked++;
+}
+
+static int check_fixture(const char *path, const struct stat *sb, int type, struct FTW *ftw) {
+    (void)sb;
+    (void)ftw;
+    size_t len = strlen(path);
+    if (type == FTW_F && len > 4 && strcmp(path + len - 4, ".rrd") == 0) check_file(path);
+    return 0;
+}
+
+TEST(mmap_matches_librrd_on_demo_fixtures) {
+    if (access("demo/rrd", F_OK) != 0) {
+        printf("    (demo/rrd отсутствует — сверка с librrd пропущена)\n");
+        return;
+    }
+    ASSERT(nftw("demo/rrd", check_fixture, 16, FTW_PHYS) == 0);
+    ASSERT(fixtures_checked > 0);
+    printf("    сверено с librrd: %d файлов\n", fixtures_checked);
+    rrd_mmap_free();
+}
+
+TEST_MAIN()
+    RUN(mmap_fetch_window);
+    RUN(mmap_fetch_picks_covering_rra);
+    RUN(mmap_fetch_partial_head_is_nan);
+    RUN(mmap_layout_and_first);
+    RUN(mmap_remaps_and_rejects);
+    RUN(mmap_matches_librrd_on_demo_fixtures);
+TEST_RETURN()
+
+#else
+
+int main(void) {
+    printf("test_mmap_reader: смещения формата RRD заданы для LP64, пропущено\n");
+    return 0;
+}
+
+#endif
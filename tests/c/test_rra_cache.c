@@ -0,0 +1,114 @@
+/**
+ * @file test_rra_cache.c
+ * @brief Unit-тесты кэша раскладки RRA (src/rrd/rra_cache.c)
+ *
+ * Кэш хранит base_step, таблицу RRA и first_timestamp на путь; валидность —
+ * по stat(): dev/ino/size фиксируют раскладку (иначе MISS), mtime —
+ * first_timestamp (иначе STALE с раскладкой). Тесты подставляют struct stat
+ * вручную, файловая система не нужна.
+ */
+#include "minitest.h"
+#include "rrd/rra_cache.h"
+#include <string.h>
+
+static struct stat mk_stat(ino_t ino, off_t size, time_t mtime) {
+    struct stat st;
+    memset(&st, 0, sizeof(st));
+    st.st_dev = 1;
+    st.st_ino = ino;
+    st.st_size = size;
+    st.st_mtim.tv_sec = mtime;
+    return st;
+}
+
+static RRDLayout mk_layout(void) {
+    RRDLayout l = {0};
+    l.base_step = 10;
+    l.rra_count = 2;
+    l.rras[0] = (RRDRraLayout){ .pdp_per_row = 1, .rows = 100, .effective_step = 10, .cf = "AVERAGE", .index = 0 };
+    l.rras[1] = (RRDRraLayout){ .pdp_per_row = 6, .rows = 100, .effective_step = 60, .cf = "MAX", .index = 3 };
+    l.first_timestamp = 5000;
+    return l;
+}
+
+/* put → get с тем же stat → HIT и точная копия раскладки. */
+TEST(rra_cache_hit) {
+    struct stat st = mk_stat(42, 4096, 1000);
+    RRDLayout in = mk_layout();
+    rra_cache_put("/rrd/cpu.rrd", &st, &in);
+
+    RRDLayout out;
+    memset(&out, 0, sizeof(out));
+    ASSERT(rra_cache_get("/rrd/cpu.rrd", &st, &out) == RRA_CACHE_HIT);
+    ASSERT(out.base_step == 10);
+    ASSERT(out.rra_count == 2);
+    ASSERT_STR(out.rras[1].cf, "MAX");
+    ASSERT(out.rras[1].index == 3);
+    ASSERT(out.first_timestamp == 5000);
+
+    rra_cache_free();
+}
+
+/* Файл обновлён (mtime сдвинулся): раскладка ещё годна → STALE. */
+TEST(rra_cache_mtime_change_is_stale) {
+    struct stat st = mk_stat(42, 4096, 1000);
+    RRDLayout in = mk_layout();
+    rra_cache_put("/rrd/cpu.rrd", &st, &in);
+
+    struct stat updated = mk_stat(42, 4096, 1010);
+    RRDLayout out;
+    ASSERT(rra_cache_get("/rrd/cpu.rrd", &updated, &out) == RRA_CACHE_STALE);
+    ASSERT(out.rra_count == 2);
+
+    /* Обновление first_timestamp по новому stat → снова HIT. */
+    out.first_timestamp = 5010;
+    rra_cache_put("/rrd/cpu.rrd", &updated, &out);
+    ASSERT(rra_cache_get("/rrd/cpu.rrd", &updated, &out) == RRA_CACHE_HIT);
+    ASSERT(out.first_timestamp == 5010);
+
+    /* Наносекунды тоже учитываются (файлы пишутся чаще раза в секунду). */
+    updated.st_mtim.tv_nsec = 1;
+    ASSERT(rra_cache_get("/rrd/cpu.rrd", &updated, &out) == RRA_CACHE_STALE);
+
+    rra_cache_free();
+}
+
+/* Файл пересоздан (другой inode) или изменён размер (rrdtool resize) → MISS. */
+TEST(rra_cache_replaced_file_is_miss) {
+    struct stat st = mk_stat(42, 4096, 1000);
+    RRDLayout in = mk_layout();
+    rra_cache_put("/rrd/cpu.rrd", &st, &in);
+
+    RRDLayout out;
+    struct stat other_ino = mk_stat(43, 4096, 1000);
+    ASSERT(rra_cache_get("/rrd/cpu.rrd", &other_ino, &out) == RRA_CACHE_MISS);
+    struct stat other_size = mk_stat(42, 8192, 1000);
+    ASSERT(rra_cache_get("/rrd/cpu.rrd", &other_size, &out) == RRA_CACHE_MISS);
+    struct stat other_dev = mk_stat(42, 4096, 1000);
+    other_dev.st_dev = 2;
+    ASSERT(rra_cache_get("/rrd/cpu.rrd", &other_dev, &out) == RRA_CACHE_MISS);
+
+    rra_cache_free();
+}
+
+/* Неизвестный путь, NULL-аргументы и get после free → MISS. */
+TEST(rra_cache_unknown_path_is_miss) {
+    struct stat st = mk_stat(42, 4096, 1000);
+    RRDLayout in = mk_layout();
+    rra_cache_put("/rrd/cpu.rrd", &st, &in);
+
+    RRDLayout out;
+    ASSERT(rra_cache_get("/rrd/mem.rrd", &st, &out) == RRA_CACHE_MISS);
+    ASSERT(rra_cache_get(NULL, &st, &out) == RRA_CACHE_MISS);
+    ASSERT(rra_cache_get("/rrd/cpu.rrd", NULL, &out) == RRA_CACHE_MISS);
+
+    rra_cache_free();
+    ASSERT(rra_cache_get("/rrd/cpu.rrd", &st, &out) == RRA_CACHE_MISS);
+}
+
+TEST_MAIN()
+    RUN(rra_cache_hit);
+    RUN(rra_cache_mtime_change_is_stale);
+    RUN(rra_cache_replaced_file_is_miss);
+    RUN(rra_cache_unknown_path_is_miss);
+TEST_RETURN()
@@ -0,0 +1,233 @@
+/**
+ * @file test_rrdc_pool.c
+ * @brief Unit-тесты пула соединений rrdcached (src/rrd/rrdc_pool.c)
+ *
+ * librrd не линкуется: rrd_client_* подменены фейками ниже, которые считают
+ * вызовы и позволяют «уронить» соединение или сделать демон недоступным.
+ * Проверяем переиспользование соединений, сброс сломанных, backoff после
+ * неудачного connect, ограничение простаивающих и ленивую инициализацию,
+ * а также политику flush (rrd.flush_policy) и её счётчики.
+ */
+#include "minitest.h"
+#include "rrd/rrdc_pool.h"
+#include <stdlib.h>
+#include <unistd.h>      /* sleep() */
+
+/* ---- фейковый клиент librrd ---- */
+struct rrd_client { int connected; };
+
+static int fake_connect_ok = 1;
+static int fake_connects = 0;
+static int fake_destroys = 0;
+static int fake_flushes = 0;
+
+rrd_client_t *rrd_client_new(const char *daemon_addr) {
+    (void)daemon_addr;
+    return calloc(1, sizeof(rrd_client_t));
+}
+void rrd_client_destroy(rrd_client_t *client) {
+    fake_destroys++;
+    free(client);
+}
+int rrd_client_connect(rrd_client_t *client, const char *daemon_addr) {
+    (void)daemon_addr;
+    fake_connects++;
+    client->connected = fake_connect_ok;
+    return fake_connect_ok ? 0 : -1;
+}
+int rrd_client_is_connected(rrd_client_t *client) {
+    return client->connected;
+}
+int rrd_client_flush(rrd_client_t *client, const char *filename) {
+    (void)client;
+    (void)filename;
+    fake_flushes++;
+    return 0;
+}
+
+static void reset(const char *addr, int max_idle) {
+    rrdc_pool_free();
+    fake_connect_ok = 1;
+    fake_connects = 0;
+    fake_destroys = 0;
+    fake_flushes = 0;
+    if (addr) rrdc_pool_init(addr, max_idle);
+}
+
+/* Соединение переживает release и переиспользуется без нового connect. */
+TEST(pool_reuses_connection) {
+    reset("127.0.0.1:42217", 4);
+
+    rrd_client_t *a = rrdc_pool_acquire(NULL);
+    ASSERT(a != NULL);
+    rrdc_pool_release(a);
+    rrd_client_t *b = rrdc_pool_acquire(NULL);
+    ASSERT(b == a);
+    ASSERT(fake_connects == 1);
+    rrdc_pool_release(b);
+
+    rrdc_pool_stats_t st;
+    rrdc_pool_stats(&st);
+    ASSERT(st.connects == 1);
+    ASSERT(st.idle == 1);
+    ASSERT(st.healthy == 1);
+}
+
+/* Сломанное соединение (rrdcached перезапущен) уничтожается на release,
+ * следующий acquire открывает новое. */
+TEST(pool_drops_broken_connection) {
+    reset("127.0.0.1:42217", 4);
+
+    rrd_client_t *a = rrdc_pool_acquire(NULL);
+    ASSERT(a != NULL);
+    a->connected = 0;
+    rrdc_pool_release(a);
+    ASSERT(fake_destroys == 1);
+
+    rrd_client_t *b = rrdc_pool_acquire(NULL);
+    ASSERT(b != NULL);
+    ASSERT(b->connected);
+    ASSERT(fake_connects == 2);
+    rrdc_pool_release(b);
+
+    rrdc_pool_stats_t st;
+    rrdc_pool_stats(&st);
+    ASSERT(st.dropped == 1);
+}
+
+/* Неудачный connect: RRDC_POOL_RETRY_SEC без новых попыток, затем повтор. */
+TEST(pool_backoff_after_connect_failure) {
+    reset("127.0.0.1:42217", 4);
+    fake_connect_ok = 0;
+
+    ASSERT(rrdc_pool_acquire(NULL) == NULL);
+    ASSERT(rrdc_pool_acquire(NULL) == NULL);
+    ASSERT(fake_connects == 1);               /* вторая попытка не делалась */
+    ASSERT(fake_destroys == 1);
+
+    rrdc_pool_stats_t st;
+    rrdc_pool_stats(&st);
+    ASSERT(st.connect_failures == 1);
+    ASSERT(st.healthy == 0);
+
+    fake_connect_ok = 1;
+    sleep(RRDC_POOL_RETRY_SEC + 1);
+    rrd_client_t *c = rrdc_pool_acquire(NULL);
+    ASSERT(c != NULL);
+    ASSERT(fake_connects == 2);
+    rrdc_pool_release(c);
+
+    rrdc_pool_stats(&st);
+    ASSERT(st.healthy == 1);
+}
+
+/* Больше max_idle возвращённых соединений не держим открытыми. */
+TEST(pool_caps_idle_connections) {
+    reset("127.0.0.1:42217", 1);
+
+    rrd_client_t *a = rrdc_pool_acquire(NULL);
+    rrd_client_t *b = rrdc_pool_acquire(NULL);
+    ASSERT(a != NULL && b != NULL && a != b);
+    rrdc_pool_release(a);
+    rrdc_pool_release(b);
+    ASSERT(fake_destroys == 1);
+
+    rrdc_pool_stats_t st;
+    rrdc_pool_stats(&st);
+    ASSERT(st.idle == 1);
+}
+
+/* Без init: пустой адрес → NULL; адрес вызывающего принимается лениво. */
+TEST(pool_lazy_init_and_disabled) {
+    reset(NULL, 0);
+
+    ASSERT(rrdc_pool_acquire(NULL) == NULL);
+    ASSERT(rrdc_pool_acquire("") == NULL);
+    ASSERT(fake_connects == 0);
+
+    rrd_client_t *a = rrdc_pool_acquire("127.0.0.1:42217");
+    ASSERT(a != NULL);
+    rrdc_pool_release(a);
+    ASSERT(rrdc_pool_acquire(NULL) == a);     /* адрес запомнен */
+    rrdc_pool_release(a);
+}
+
+/* Несуществующий unix-сокет: демон не запущен, connect даже не пробуем. */
+TEST(pool_missing_unix_socket) {
+    reset("unix:/nonexistent/svgd-test-rrdcached.sock", 4);
+
+    ASSERT(rrdc_pool_acquire(NULL) == NULL);
+    ASSERT(fake_connects == 0);
+
+    rrdc_pool_free();
+}
+
+/* Имена политик из config.json; неизвестное имя не трогает out. */
+TEST(flush_policy_parse) {
+    rrdc_flush_policy_t p = RRDC_FLUSH_ALWAYS;
+    ASSERT(rrdc_flush_policy_parse("fetch", &p) == 0 && p == RRDC_FLUSH_FETCH);
+    ASSERT(rrdc_flush_policy_parse("always", &p) == 0 && p == RRDC_FLUSH_ALWAYS);
+    ASSERT(rrdc_flush_policy_parse("interval", &p) == 0 && p == RRDC_FLUSH_INTERVAL);
+    ASSERT(rrdc_flush_policy_parse("sometimes", &p) == -1 && p == RRDC_FLUSH_INTERVAL);
+    ASSERT(rrdc_flush_policy_parse(NULL, &p) == -1);
+}
+
+/* "always" шлёт FLUSH; "fetch" (умолчание) — нет, считая его сэкономленным. */
+TEST(flush_policy_always_vs_fetch) {
+    reset("127.0.0.1:42217", 4);
+    rrd_client_t *c = rrdc_pool_acquire(NULL);
+    ASSERT(c != NULL);
+
+    rrdc_pool_flush(c, "/rrd/cpu.rrd");
+    ASSERT(fake_flushes == 0);
+
+    rrdc_pool_set_flush_policy(RRDC_FLUSH_ALWAYS, 0);
+    rrdc_pool_flush(c, "/rrd/cpu.rrd");
+    rrdc_pool_flush(c, "/rrd/cpu.rrd");
+    ASSERT(fake_flushes == 2);
+    rrdc_pool_release(c);
+
+    rrdc_pool_stats_t st;
+    rrdc_pool_stats(&st);
+    ASSERT(st.flushes == 2);
+    ASSERT(st.flushes_avoided == 1);
+
+    /* Без "interval" недавно прочитанный файл всё равно идёт через демон. */
+    rrdc_pool_mark_flushed("/rrd/cpu.rrd");
+    ASSERT(rrdc_pool_fresh_on_disk("/rrd/cpu.rrd") == 0);
+}
+
+/* "interval": файл, отданный демоном в пределах окна, читается с диска. */
+TEST(flush_policy_interval) {
+    reset("127.0.0.1:42217", 4);
+    rrdc_pool_set_flush_policy(RRDC_FLUSH_INTERVAL, 1);
+
+    ASSERT(rrdc_pool_fresh_on_disk("/rrd/cpu.rrd") == 0);   /* ещё не читался */
+    rrdc_pool_mark_flushed("/rrd/cpu.rrd");
+    ASSERT(rrdc_pool_fresh_on_disk("/rrd/cpu.rrd") == 1);
+    ASSERT(rrdc_pool_fresh_on_disk("/rrd/cpu.rrd") == 1);
+    ASSERT(rrdc_pool_fresh_on_disk("/rrd/mem.rrd") == 0);   /* другой файл */
+
+    rrdc_pool_stats_t st;
+    rrdc_pool_stats(&st);
+    ASSERT(st.flushes_avoided == 2);
+    ASSERT(st.flushes == 0);
+
+    sleep(2);                                                /* окно истекло */
+    ASSERT(rrdc_pool_fresh_on_disk("/rrd/cpu.rrd") == 0);
+
+    rrdc_pool_free();
+    ASSERT(rrdc_pool_fresh_on_disk("/rrd/cpu.rrd") == 0);   /* free сбрасывает политику */
+}
+
+TEST_MAIN()
+    RUN(pool_reuses_connection);
+    RUN(pool_drops_broken_connection);
+    RUN(pool_backoff_after_connect_failure);
+    RUN(pool_caps_idle_connections);
+    RUN(pool_lazy_init_and_disabled);
+    RUN(pool_missing_unix_socket);
+    RUN(flush_policy_parse);
+    RUN(flush_policy_always_vs_fetch);
+    RUN(flush_policy_interval);
+TEST_RETURN()
@@ -0,0 +1,94 @@
+/**
+ * @file test_static_assets.c
+ * @brief Тесты встроенного UI svgd-gate (gate/embed_static.sh → static_assets.c)
+ *
+ * run.sh генерирует static_assets.c из gate/static/ и линкует его сюда.
+ * Проверяем, что каждый файл каталога встроен побайтно, gzip-вариант —
+ * корректный gzip того же содержимого (магия и ISIZE в трейлере; zlib для
+ * распаковки не нужен) и меньше оригинала, а ETag'и сильные и различаются.
+ */
+#include "minitest.h"
+#include "../../gate/static_assets.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+
+#define STATIC_DIR "gate/static"
+
+static const StaticAsset *find(const char *path) {
+    for (int i = 0; i < static_asset_count; i++) {
+        if (strcmp(static_assets[i].path, path) == 0) return &static_assets[i];
+    }
+    return NULL;
+}
+
+/* Файл с диска целиком (malloc); NULL при ошибке. */
+static char *read_file(const char *path, size_t *len) {
+    FILE *f = fopen(path, "rb");
+    if (!f) return NULL;
+    fseek(f, 0, SEEK_END);
+    long size = ftell(f);
+    fseek(f, 0, SEEK_SET);
+    char *buf = malloc(size > 0 ? (size_t)size : 1);
+    *len = buf ? fread(buf, 1, (size_t)size, f) : 0;
+    fclose(f);
+    return buf;
+}
+
+/* Страницы UI встроены, таблица завершается пустой записью. */
+TEST(static_assets_has_ui_files) {
+    ASSERT(static_asset_count >= 4);
+    ASSERT(find("/index.html") != NULL);
+    ASSERT(find("/login.html") != NULL);
+    ASSERT(find("/script.js") != NULL);
+    ASSERT(find("/auth.js") != NULL);
+    ASSERT(static_assets[static_asset_count].path == NULL);
+}
+
+/* Несжатый вариант совпадает с файлом на диске побайтно. */
+TEST(static_assets_match_disk) {
+    for (int i = 0; i < static_asset_count; i++) {
+        const StaticAsset *a = &static_assets[i];
+        char path[256];
+        snprintf(path, sizeof(path), "%s%s", STATIC_DIR, a->path);
+        size_t len = 0;
+        char *disk = read_file(path, &len);
+        ASSERT(disk != NULL);
+        ASSERT(len == a->len);
+        ASSERT(memcmp(disk, a->data, len) == 0);
+        free(disk);
+    }
+}
+
+/* gzip-вариант: магия 1f 8b, deflate, ISIZE = исходная длина; и он меньше. */
+TEST(static_assets_gzip_variant) {
+    for (int i = 0; i < static_asset_count; i++) {
+        const StaticAsset *a = &static_assets[i];
+        ASSERT(a->gz_len > 18);
+        ASSERT(a->gz[0] == 0x1f && a->gz[1] == 0x8b && a->gz[2] == 8);
+        const unsigned char *t = a->gz + a->gz_len - 4;
+        uint32_t isize = (uint32_t)t[0] | ((uint32_t)t[1] << 8) |
+                         ((uint32_t)t[2] << 16) | ((uint32_t)t[3] << 24);
+        ASSERT(isize == (uint32_t)a->len);
+        ASSERT(a->gz_len < a->len);
+    }
+}
+
+/* ETag: в кавычках, не слабый, у двух вариантов разный. */
+TEST(static_assets_etags) {
+    for (int i = 0; i < static_asset_count; i++) {
+        const StaticAsset *a = &static_assets[i];
+        size_t n = strlen(a->etag);
+        ASSERT(n > 2 && a->etag[0] == '"' && a->etag[n - 1] == '"');
+        ASSERT(a->etag_gz[0] == '"');
+        ASSERT(strcmp(a->etag, a->etag_gz) != 0);
+        for (int j = 0; j < i; j++) ASSERT(strcmp(a->etag, static_assets[j].etag) != 0);
+    }
+}
+
+TEST_MAIN()
+    RUN(static_assets_has_ui_files);
+    RUN(static_assets_match_disk);
+    RUN(static_assets_gzip_variant);
+    RUN(static_assets_etags);
+TEST_RETURN()
@@ -5,6 +5,9 @@
  * Покрывает все ветви алгоритма: попадание в окно [100,2400] точек, все RRA
  * с недостатком точек, все RRA с избытком, пропуск не-AVERAGE, fallback на
  * «сырой» RRA (pdp_per_row==1), пустой список, шаг ниже min_step.
+ * Плюс select_step_for_layout — обрезка диапазона по first_timestamp перед
+ * выбором шага (то, что раньше делалось inline после rrd_first_r) — и
+ * select_step_for_width, выбор шага под ширину графика.
  */
 #include "minitest.h"
 #include "rrd/reader.h"
@@ -78,6 +81,80 @@ TEST(non_average_range_over_period_returns_base) {
     ASSERT(select_step_from_rras(rras, 1, 7200, 3600, 15) == 15);
 }
 
+/* Раскладка 15с/120с/3600с AVERAGE, как у типичного collectd-RRD. */
+static RRDLayout mk_layout(time_t first_timestamp) {
+    RRDLayout l = {0};
+    l.base_step = 15;
+    l.rra_count = 3;
+    l.rras[0] = (RRDRraLayout){ .pdp_per_row = 1,   .rows = 1200, .effective_step = 15,   .cf = "AVERAGE" };
+    l.rras[1] = (RRDRraLayout){ .pdp_per_row = 8,   .rows = 1200, .effective_step = 120,  .cf = "AVERAGE" };
+    l.rras[2] = (RRDRraLayout){ .pdp_per_row = 240, .rows = 1200, .effective_step = 3600, .cf = "AVERAGE" };
+    l.first_timestamp = first_timestamp;
+    return l;
+}
+
+/* Данные есть за весь период: 3600с / 15с = 240 точек — сырой RRA. */
+TEST(layout_full_range) {
+    RRDLayout l = mk_layout(0);
+    ASSERT(select_step_for_layout(&l, 100000 - 3600, 100000, 3600, 0) == 15);
+}
+
+/* Запрошена неделя, но данные только за последний час: диапазон обрезается
+ * по first_timestamp, и выбирается сырой шаг вместо часового. */
+TEST(layout_clamps_to_first_timestamp) {
+    RRDLayout l = mk_layout(1000000 - 3600);
+    ASSERT(select_step_for_layout(&l, 1000000 - 604800, 1000000, 604800, 0) == 15);
+    RRDLayout full = mk_layout(0);
+    ASSERT(select_step_for_layout(&full, 1000000 - 604800, 1000000, 604800, 0) == 3600);
+}
+
+/* first_timestamp неизвестен (-1) → обрезка по end - period, как раньше. */
+TEST(layout_unknown_first_uses_period) {
+    RRDLayout l = mk_layout(-1);
+    ASSERT(select_step_for_layout(&l, 100000 - 3600, 100000, 3600, 0) == 15);
+}
+
+/* Пустой диапазон (данные начинаются после end) → шаг по умолчанию 15. */
+TEST(layout_empty_range_returns_default) {
+    RRDLayout l = mk_layout(200000);
+    l.rras[0].effective_step = 60;  /* чтобы 15 не совпало с шагом сырого RRA */
+    ASSERT(select_step_for_layout(&l, 100000 - 3600, 100000, 3600, 0) == 15);
+}
+
+/* Сутки на архивах 15с/120с/3600с: 5760 / 720 / 24 точки. */
+TEST(width_picks_closest_to_two_points_per_pixel) {
+    RRAStepInfo rras[] = {
+        mk(1,   15,   "AVERAGE"),
+        mk(8,   120,  "AVERAGE"),
+        mk(240, 3600, "AVERAGE"),
+        mk(1,   15,   "MAX"),
+    };
+    ASSERT(select_step_for_width(rras, 4, 86400, 400) == 120);   /* 720 — в окне [400, 800] */
+    ASSERT(select_step_for_width(rras, 4, 86400, 200) == 120);   /* 720/400 < 200/24 */
+    ASSERT(select_step_for_width(rras, 4, 86400, 12) == 3600);   /* 24 — в окне [12, 24] */
+    ASSERT(select_step_for_width(rras, 4, 86400, 3000) == 15);   /* 3000/720 > 5760/6000 */
+}
+
+/* Оба шага в окне → более грубый; без AVERAGE → 0. */
+TEST(width_tie_prefers_coarser_and_needs_average) {
+    RRAStepInfo rras[] = { mk(1, 10, "AVERAGE"), mk(2, 20, "AVERAGE") };
+    ASSERT(select_step_for_width(rras, 2, 4000, 200) == 20);     /* 400 и 200 точек */
+    RRAStepInfo max_only[] = { mk(1, 10, "MAX") };
+    ASSERT(select_step_for_width(max_only, 1, 4000, 200) == 0);
+    ASSERT(select_step_for_width(NULL, 0, 4000, 200) == 0);
+}
+
+/* Неделя: без ширины — часовой архив (168 точек, окно 100–2400); спарклайну
+ * 200 px тоже он, панели 1600 px — 120с (5040 точек ближе к [1600, 3200]). */
+TEST(layout_width_selects_per_panel) {
+    RRDLayout l = mk_layout(0);
+    ASSERT(select_step_for_layout(&l, 1000000 - 604800, 1000000, 604800, 0) == 3600);
+    ASSERT(select_step_for_layout(&l, 1000000 - 604800, 1000000, 604800, 200) == 3600);
+    ASSERT(select_step_for_layout(&l, 1000000 - 604800, 1000000, 604800, 1600) == 120);
+    /* Час: 240 сырых точек против 30 двухминутных — 200 px берёт сырые. */
+    ASSERT(select_step_for_layout(&l, 100000 - 3600, 100000, 3600, 200) == 15);
+}
+
 TEST_MAIN()
     RUN(in_window_first_match_wins);
     RUN(all_below_window_picks_most_points);
@@ -87,4 +164,11 @@ TEST_MAIN()
     RUN(empty_rras_returns_base_step);
     RUN(step_below_min_skipped_no_fallback);
     RUN(non_average_range_over_period_returns_base);
+    RUN(layout_full_range);
+    RUN(layout_clamps_to_first_timestamp);
+    RUN(layout_unknown_first_uses_period);
+    RUN(layout_empty_range_returns_default);
+    RUN(width_picks_closest_to_two_points_per_pixel);
+    RUN(width_tie_prefers_coarser_and_needs_average);
+    RUN(layout_width_selects_per_panel);
 TEST_RETURN()
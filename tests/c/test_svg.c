@@ -0,0 +1,221 @@
+/**
+ * @file test_svg.c
+ * @brief Тесты загрузки generate_svg-скрипта в контексты Duktape (src/rrd/svg.c)
+ *
+ * svg_init_cache() один раз компилирует скрипт в байткод; каждый новый
+ * поточный контекст загружает байткод вместо разбора исходника. Проверяется,
+ * что глобальные функции и переменные скрипта доступны в новых контекстах
+ * (в том числе в других потоках) и что скрипт с синтаксической ошибкой даёт
+ * NULL, а не падение. Контексты поточные, поэтому каждый сценарий со своим
+ * скриптом выполняется в отдельном потоке.
+ *
+ * Горячая перезагрузка: svg_reload_script() подменяет скрипт в уже прогретом
+ * контексте (тот же поток), отвергнутый скрипт оставляет прежний; поток
+ * svg_reload.c перезагружает по изменению файла (inotify) и по
+ * svg_reload_request() (SIGHUP).
+ */
+#include "minitest.h"
+#include "rrd/svg.h"
+#include "rrd/svg_reload.h"
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+/* Глобальная переменная + функция: оба должны пережить дамп/загрузку. */
+static const char *good_script =
+    "var PREFIX = 'pts:';\n"
+    "function count(s) { return s.values ? s.values.length : s.data.length; }\n"
+    "function generateSVG(series, options) {\n"
+    "    var n = 0;\n"
+    "    for (var i = 0; i < series.length; i++) n += count(series[i]);\n"
+    "    return '<svg>' + PREFIX + n + ':' + options.width + '</svg>';\n"
+    "}\n";
+
+static const char *broken_script = "function generateSVG(series, options) {\n";
+
+static const char *v1_script = "function generateSVG(s, o) { return '<svg>v1</svg>'; }\n";
+static const char *v2_script = "function generateSVG(s, o) { return '<svg>v2</svg>'; }\n";
+
+/* svg.c берёт флаг verbose из main.c */
+int is_verbose_logging(void) { return 0; }
+
+static char script_path[64];
+
+static void write_script(const char *body) {
+    snprintf(script_path, sizeof script_path, "/tmp/svgd_test_svg_XXXXXX");
+    int fd = mkstemp(script_path);
+    if (fd < 0) return;
+    if (write(fd, body, strlen(body)) < 0) script_path[0] = '\0';
+    close(fd);
+}
+
+/* Как при деплое: пишем рядом и переименовываем поверх */
+static void rewrite_script(const char *body) {
+    char tmp[80];
+    snprintf(tmp, sizeof tmp, "%s.new", script_path);
+    FILE *fp = fopen(tmp, "w");
+    if (!fp) return;
+    fputs(body, fp);
+    fclose(fp);
+    rename(tmp, script_path);
+}
+
+static MetricData *make_data(void) {
+    static DataPoint points[3] = { { 1000, 1.0 }, { 1060, 2.0 }, { 1120, 3.0 } };
+    static char *names[1] = { "value" };
+    static DataPoint *series[1] = { points };
+    static int counts[1] = { 3 };
+    static MetricData md;
+    md.series_count = 1;
+    md.series_names = names;
+    md.series_data = series;
+    md.series_counts = counts;
+    md.param1 = "";
+    return &md;
+}
+
+static void *render_thread(void *out) {
+    MetricConfig metric = { .title = "t", .transform_type = "none",
+                            .value_format = "%.2f", .panel_type = "chart" };
+    *(char **)out = svg_generate(script_path, make_data(), &metric, 640, 200, "light", NULL);
+    return NULL;
+}
+
+/* svg_generate() в текущем потоке (его контекст переживает перезагрузки) */
+static char *render_here(void) {
+    char *svg = NULL;
+    render_thread(&svg);
+    return svg;
+}
+
+/* svg_generate() в новом потоке (= в новом контексте) */
+static char *render_in_new_thread(void) {
+    char *svg = NULL;
+    pthread_t t;
+    if (pthread_create(&t, NULL, render_thread, &svg) != 0) return NULL;
+    pthread_join(t, NULL);
+    return svg;
+}
+
+TEST(bytecode_defines_globals_in_every_context) {
+    write_script(good_script);
+    ASSERT(script_path[0]);
+    ASSERT(svg_init_cache(script_path) == 0);
+
+    for (int i = 0; i < 2; i++) {
+        char *svg = render_in_new_thread();
+        ASSERT(svg != NULL);
+        ASSERT_STR(svg, "<svg>pts:3:640</svg>");
+        free(svg);
+    }
+
+    /* Старый формат серий идёт через тот же загруженный скрипт */
+    svg_set_series_format(SVG_SERIES_OBJECTS);
+    char *svg = render_in_new_thread();
+    svg_set_series_format(SVG_SERIES_TYPED);
+    ASSERT(svg != NULL);
+    ASSERT_STR(svg, "<svg>pts:3:640</svg>");
+    free(svg);
+
+    svg_free_cache();
+    unlink(script_path);
+}
+
+TEST(syntax_error_fails_render) {
+    write_script(broken_script);
+    ASSERT(script_path[0]);
+    ASSERT(svg_init_cache(script_path) == 0);      /* файл прочитан */
+    ASSERT(render_in_new_thread() == NULL);
+    svg_free_cache();
+    unlink(script_path);
+}
+
+TEST(reload_swaps_script_in_warm_context) {
+    write_script(v1_script);
+    ASSERT(script_path[0]);
+    ASSERT(svg_init_cache(script_path) == 0);
+    char *svg = render_here();
+    ASSERT(svg != NULL);
+    ASSERT_STR(svg, "<svg>v1</svg>");
+    free(svg);
+    unsigned generation = svg_script_generation();
+
+    rewrite_script(v2_script);
+    ASSERT(svg_reload_script() == 0);
+    ASSERT(svg_script_generation() == generation + 1);
+    svg = render_here();
+    ASSERT(svg != NULL);
+    ASSERT_STR(svg, "<svg>v2</svg>");
+    free(svg);
+    svg = render_in_new_thread();
+    ASSERT(svg != NULL);
+    ASSERT_STR(svg, "<svg>v2</svg>");
+    free(svg);
+
+    /* Синтаксическая ошибка, исключение при загрузке, нет generateSVG —
+     * отвергаются, продолжает работать v2 */
+    const char *rejected[] = { broken_script, "throw new Error('boom');\n", "var x = 1;\n" };
+    for (int i = 0; i < 3; i++) {
+        rewrite_script(rejected[i]);
+        ASSERT(svg_reload_script() == -1);
+    }
+    ASSERT(svg_script_generation() == generation + 1);
+    svg = render_here();
+    ASSERT(svg != NULL);
+    ASSERT_STR(svg, "<svg>v2</svg>");
+    free(svg);
+
+    svg_free_cache();
+    unlink(script_path);
+    ASSERT(svg_reload_script() == -1);       /* кэш не инициализирован */
+}
+
+/* Ждёт, пока поколение скрипта станет больше since (до 3 с) */
+static int wait_generation(unsigned since) {
+    for (int i = 0; i < 300; i++) {
+        if (svg_script_generation() > since) return 1;
+        usleep(10000);
+    }
+    return 0;
+}
+
+TEST(reload_thread_follows_file_and_request) {
+    write_script(v1_script);
+    ASSERT(script_path[0]);
+    ASSERT(svg_init_cache(script_path) == 0);
+    ASSERT(svg_reload_start(script_path, SVG_RELOAD_INOTIFY) == 0);
+
+    unsigned generation = svg_script_generation();
+    rewrite_script(v2_script);
+    ASSERT(wait_generation(generation));
+    char *svg = render_here();
+    ASSERT(svg != NULL);
+    ASSERT_STR(svg, "<svg>v2</svg>");
+    free(svg);
+
+    generation = svg_script_generation();
+    svg_reload_request();
+    ASSERT(wait_generation(generation));
+
+    svg_reload_stop();
+    svg_free_cache();
+    unlink(script_path);
+}
+
+TEST(reload_mode_parse) {
+    svg_reload_mode_t mode = SVG_RELOAD_SIGHUP;
+    ASSERT(svg_reload_mode_parse("inotify", &mode) == 0 && mode == SVG_RELOAD_INOTIFY);
+    ASSERT(svg_reload_mode_parse("sighup", &mode) == 0 && mode == SVG_RELOAD_SIGHUP);
+    ASSERT(svg_reload_mode_parse("watch", &mode) == -1);
+}
+
+TEST_MAIN()
+    RUN(bytecode_defines_globals_in_every_context);
+    RUN(syntax_error_fails_render);
+    RUN(reload_swaps_script_in_warm_context);
+    RUN(reload_thread_follows_file_and_request);
+    RUN(reload_mode_parse);
+TEST_RETURN()
@@ -0,0 +1,387 @@
+/**
+ * @file test_svg_cache.c
+ * @brief Unit-тесты кэша отрендеренных SVG (src/rrd/svg_cache.c)
+ *
+ * Второй уровень кэша перед svg_generate(): ключ — (endpoint, param, period,
+ * width, height, theme), TTL как у RRD-кэша. Проверяем put/get и общий
+ * буфер вместо копии, что каждое поле ключа различает записи, истечение TTL
+ * и single-flight (параллельные промахи по одному ключу рендерятся один раз,
+ * ожидающие получают тот же буфер), а также сжатые варианты записи: привязка
+ * к своему рендеру и сброс при замене, и бюджет памяти: вытеснение CLOCK,
+ * учёт вариантов.
+ */
+#include "minitest.h"
+#include "rrd/svg_cache.h"
+#include <stdlib.h>
+#include <unistd.h>      /* sleep(), usleep() */
+#include <pthread.h>
+
+static svg_cache_key_t base_key(void) {
+    svg_cache_key_t k = {
+        .endpoint = "cpu/process",
+        .param = "postgres",
+        .period = 3600,
+        .width = 800,
+        .height = 450,
+        .theme = "light"
+    };
+    return k;
+}
+
+/* Буфер с одним владельцем из строки */
+static svg_buf_t *buf_of(const char *s, size_t len) {
+    char *data = malloc(len + 1);
+    memcpy(data, s, len);
+    data[len] = '\0';
+    return svg_buf_wrap(data, len);
+}
+
+/* Положить строку в кэш, отпустив свою ссылку */
+static void put_str(const svg_cache_key_t *k, const char *s, size_t len) {
+    svg_buf_t *b = buf_of(s, len);
+    svg_cache_put(k, b);
+    svg_buf_release(b);
+}
+
+/* put → get отдаёт тот же буфер, без копии; он живёт, пока его держат,
+ * даже если запись уже заменена и кэш очищен (ASan поймал бы use-after-free). */
+TEST(svg_cache_put_get_shares_buffer) {
+    svg_cache_init(60, 0);
+    svg_cache_key_t k = base_key();
+
+    svg_buf_t *svg = buf_of("<svg>one</svg>", 14);
+    svg_cache_put(&k, svg);
+
+    svg_buf_t *got = svg_cache_get(&k);
+    ASSERT(got == svg);
+    ASSERT(got->len == 14);
+    ASSERT_STR(got->data, "<svg>one</svg>");
+    svg_buf_release(svg);
+
+    put_str(&k, "<svg>two</svg>", 14);
+    svg_cache_free();
+    ASSERT_STR(got->data, "<svg>one</svg>");
+    svg_buf_release(got);
+}
+
+/* Любое отличающееся поле ключа — промах. */
+TEST(svg_cache_key_fields_distinguish) {
+    svg_cache_init(60, 0);
+    svg_cache_key_t k = base_key();
+    put_str(&k, "<svg/>", 6);
+
+    svg_cache_key_t other = base_key(); other.param = "nginx";
+    ASSERT(svg_cache_get(&other) == NULL);
+    other = base_key(); other.param = NULL;
+    ASSERT(svg_cache_get(&other) == NULL);
+    other = base_key(); other.period = 86400;
+    ASSERT(svg_cache_get(&other) == NULL);
+    other = base_key(); other.width = 1200;
+    ASSERT(svg_cache_get(&other) == NULL);
+    other = base_key(); other.height = 300;
+    ASSERT(svg_cache_get(&other) == NULL);
+    other = base_key(); other.theme = "dark";
+    ASSERT(svg_cache_get(&other) == NULL);
+    other = base_key(); other.endpoint = "cpu";
+    ASSERT(svg_cache_get(&other) == NULL);
+    other = base_key(); other.decimate = 1;
+    ASSERT(svg_cache_get(&other) == NULL);
+    other = base_key(); other.script = 2;
+    ASSERT(svg_cache_get(&other) == NULL);
+
+    svg_buf_t *got = svg_cache_get(&k);
+    ASSERT(got != NULL);
+    svg_buf_release(got);
+
+    svg_cache_free();
+}
+
+/* До init кэш выключен: put игнорируется, get → NULL. */
+TEST(svg_cache_disabled_before_init) {
+    svg_cache_key_t k = base_key();
+    put_str(&k, "<svg/>", 6);
+    ASSERT(svg_cache_get(&k) == NULL);
+}
+
+/* Повторный put заменяет запись. */
+TEST(svg_cache_put_replaces_entry) {
+    svg_cache_init(60, 0);
+    svg_cache_key_t k = base_key();
+    put_str(&k, "<svg>old</svg>", 14);
+    put_str(&k, "<svg>new!</svg>", 15);
+
+    svg_buf_t *got = svg_cache_get(&k);
+    ASSERT(got != NULL);
+    ASSERT(got->len == 15);
+    ASSERT_STR(got->data, "<svg>new!</svg>");
+    svg_buf_release(got);
+
+    svg_cache_free();
+}
+
+/* Сжатый вариант хранится рядом с SVG и отдаётся тем же буфером; по кодировкам раздельно. */
+TEST(svg_cache_variant_stored_with_entry) {
+    svg_cache_init(60, 0);
+    svg_cache_key_t k = base_key();
+    svg_buf_t *svg = buf_of("<svg>panel</svg>", 16);
+    svg_buf_t *gz = buf_of("\x1f\x8bgz", 4);
+    ASSERT(svg_cache_get_variant(&k, COMPRESS_GZIP) == NULL);
+
+    /* Нет записи — варианту не к чему привязаться */
+    svg_cache_put_variant(&k, COMPRESS_GZIP, svg, gz);
+    ASSERT(svg_cache_get_variant(&k, COMPRESS_GZIP) == NULL);
+
+    svg_cache_put(&k, svg);
+    svg_cache_put_variant(&k, COMPRESS_GZIP, svg, gz);
+    svg_buf_t *got = svg_cache_get_variant(&k, COMPRESS_GZIP);
+    ASSERT(got == gz);
+    ASSERT(got->len == 4);
+    ASSERT(memcmp(got->data, "\x1f\x8bgz", 4) == 0);
+    svg_buf_release(got);
+    ASSERT(svg_cache_get_variant(&k, COMPRESS_DEFLATE) == NULL);
+    ASSERT(svg_cache_get_variant(&k, COMPRESS_IDENTITY) == NULL);
+
+    /* Сам SVG не затронут */
+    got = svg_cache_get(&k);
+    ASSERT(got == svg);
+    ASSERT_STR(got->data, "<svg>panel</svg>");
+    svg_buf_release(got);
+
+    svg_buf_release(gz);
+    svg_buf_release(svg);
+    svg_cache_free();
+}
+
+/* Вариант чужого рендера не принимается (даже с теми же байтами: рендеры
+ * не копируются, запись узнаёт свой по буферу); замена SVG сбрасывает варианты. */
+TEST(svg_cache_variant_follows_render) {
+    svg_cache_init(60, 0);
+    svg_cache_key_t k = base_key();
+    svg_buf_t *old = buf_of("<svg>new</svg>", 14);
+    svg_buf_t *cur = buf_of("<svg>new</svg>", 14);
+    svg_cache_put(&k, cur);
+
+    /* Сжимали старый рендер, а запись уже перерисована */
+    svg_buf_t *z = buf_of("old-gz", 6);
+    svg_cache_put_variant(&k, COMPRESS_GZIP, old, z);
+    svg_buf_release(z);
+    ASSERT(svg_cache_get_variant(&k, COMPRESS_GZIP) == NULL);
+
+    z = buf_of("new-gz", 6);
+    svg_cache_put_variant(&k, COMPRESS_GZIP, cur, z);
+    svg_buf_release(z);
+    svg_buf_t *got = svg_cache_get_variant(&k, COMPRESS_GZIP);
+    ASSERT(got != NULL);
+    ASSERT(memcmp(got->data, "new-gz", 6) == 0);
+    svg_buf_release(got);
+
+    put_str(&k, "<svg>newer</svg>", 16);
+    ASSERT(svg_cache_get_variant(&k, COMPRESS_GZIP) == NULL);
+
+    svg_buf_release(old);
+    svg_buf_release(cur);
+    svg_cache_free();
+}
+
+/* По истечении TTL запись не отдаётся; put другого ключа её вычищает. */
+TEST(svg_cache_ttl_expiry) {
+    svg_cache_init(1, 0);
+    svg_cache_key_t k = base_key();
+    put_str(&k, "<svg/>", 6);
+
+    svg_buf_t *got = svg_cache_get(&k);
+    ASSERT(got != NULL);
+    svg_buf_release(got);
+
+    sleep(2);
+    ASSERT(svg_cache_get(&k) == NULL);
+
+    svg_cache_key_t other = base_key(); other.width = 1000;
+    put_str(&other, "<svg>2</svg>", 12);
+    got = svg_cache_get(&other);
+    ASSERT(got != NULL);
+    svg_buf_release(got);
+
+    svg_cache_free();
+}
+
+/* single-flight: N потоков промахиваются по одному ключу одновременно,
+ * рендерит только лидер, остальные получают его буфер. */
+#define SF_THREADS 8
+static int sf_renders = 0;
+static int sf_fail = 0;
+static pthread_mutex_t sf_lock = PTHREAD_MUTEX_INITIALIZER;
+
+static void *sf_worker(void *arg) {
+    svg_buf_t **out = arg;
+    svg_cache_key_t k = base_key();
+    int leader = 0;
+    svg_buf_t *svg = svg_cache_acquire(&k, &leader);
+    if (leader) {
+        pthread_mutex_lock(&sf_lock);
+        sf_renders++;
+        pthread_mutex_unlock(&sf_lock);
+        usleep(200 * 1000);  /* «рендер» дольше, чем старт остальных потоков */
+        if (sf_fail) {
+            svg_cache_complete(&k, NULL);
+        } else {
+            svg = buf_of("<svg>shared</svg>", 17);
+            svg_cache_complete(&k, svg);
+        }
+    }
+    *out = svg;
+    return NULL;
+}
+
+static int run_single_flight(svg_buf_t **results) {
+    pthread_t t[SF_THREADS];
+    sf_renders = 0;
+    for (int i = 0; i < SF_THREADS; i++) {
+        pthread_create(&t[i], NULL, sf_worker, &results[i]);
+    }
+    for (int i = 0; i < SF_THREADS; i++) pthread_join(t[i], NULL);
+    return sf_renders;
+}
+
+TEST(svg_cache_single_flight_shares_result) {
+    svg_cache_init(60, 0);
+    sf_fail = 0;
+    svg_buf_t *results[SF_THREADS];
+
+    ASSERT(run_single_flight(results) == 1);
+    for (int i = 0; i < SF_THREADS; i++) {
+        ASSERT(results[i] == results[0]);
+        ASSERT_STR(results[i]->data, "<svg>shared</svg>");
+    }
+
+    /* После завершения результат лежит в кэше — тот же буфер. */
+    svg_cache_key_t k = base_key();
+    svg_buf_t *got = svg_cache_get(&k);
+    ASSERT(got == results[0]);
+    svg_buf_release(got);
+    for (int i = 0; i < SF_THREADS; i++) svg_buf_release(results[i]);
+
+    svg_cache_free();
+}
+
+/* Ошибка лидера разделяется ожидающими (NULL), в кэш ничего не попадает,
+ * следующий промах снова становится лидером. */
+TEST(svg_cache_single_flight_shares_failure) {
+    svg_cache_init(60, 0);
+    sf_fail = 1;
+    svg_buf_t *results[SF_THREADS];
+
+    ASSERT(run_single_flight(results) == 1);
+    for (int i = 0; i < SF_THREADS; i++) ASSERT(results[i] == NULL);
+
+    svg_cache_key_t k = base_key();
+    int leader = 0;
+    ASSERT(svg_cache_acquire(&k, &leader) == NULL);
+    ASSERT(leader == 1);
+    svg_cache_complete(&k, NULL);
+
+    svg_cache_free();
+}
+
+/* Ключ с уникальной шириной — как клиент, перебирающий ?width= */
+static svg_cache_key_t width_key(int width) {
+    svg_cache_key_t k = base_key();
+    k.width = width;
+    return k;
+}
+
+/* Бюджет: перебор ширин не раздувает кэш, учтённые байты не выходят за max_bytes. */
+TEST(svg_cache_budget_bounds_memory) {
+    size_t max_bytes = 64 * 1024;
+    svg_cache_init(60, max_bytes);
+    char *svg = malloc(4096);
+    memset(svg, 'x', 4096);
+
+    for (int w = 100; w < 1100; w++) {
+        svg_cache_key_t k = width_key(w);
+        put_str(&k, svg, 4096);
+    }
+
+    svg_cache_stats_t st;
+    svg_cache_stats(&st);
+    ASSERT(st.max_bytes == max_bytes);
+    ASSERT(st.bytes <= max_bytes);
+    ASSERT(st.entries > 0 && st.entries < 16);
+    ASSERT(st.evictions > 0);
+
+    /* Последний put всегда в кэше: место освобождается до вставки */
+    svg_cache_key_t last = width_key(1099);
+    svg_buf_t *got = svg_cache_get(&last);
+    ASSERT(got != NULL);
+    svg_buf_release(got);
+
+    free(svg);
+    svg_cache_free();
+}
+
+/* Запись, по которой были попадания, переживает проход часовой стрелки. */
+TEST(svg_cache_budget_keeps_hit_entries) {
+    svg_cache_init(60, 32 * 1024);
+    char *svg = malloc(4096);
+    memset(svg, 'y', 4096);
+
+    svg_cache_key_t hot = width_key(1);
+    put_str(&hot, svg, 4096);
+    for (int w = 2; w < 200; w++) {
+        svg_buf_t *got = svg_cache_get(&hot);  /* панель открыта на дашборде */
+        ASSERT(got != NULL);
+        svg_buf_release(got);
+        svg_cache_key_t k = width_key(w);
+        put_str(&k, svg, 4096);
+    }
+
+    free(svg);
+    svg_cache_free();
+}
+
+/* Варианты входят в бюджет; SVG больше всего бюджета не кэшируется. */
+TEST(svg_cache_budget_counts_variants) {
+    svg_cache_init(60, 16 * 1024);
+    svg_cache_key_t k = base_key();
+    svg_buf_t *svg = buf_of("<svg/>", 6);
+    svg_buf_t *gz = buf_of("\x1f\x8bgz", 4);
+    svg_cache_put(&k, svg);
+
+    svg_cache_stats_t before, after;
+    svg_cache_stats(&before);
+    svg_cache_put_variant(&k, COMPRESS_GZIP, svg, gz);
+    svg_cache_stats(&after);
+    ASSERT(after.bytes == before.bytes + 4);
+    svg_buf_release(gz);
+    svg_buf_release(svg);
+
+    /* Замена SVG списывает и его варианты */
+    put_str(&k, "<svg>2</svg>", 12);
+    svg_cache_stats(&after);
+    ASSERT(after.bytes == before.bytes + 6);
+    ASSERT(after.entries == 1);
+
+    char *big = malloc(32 * 1024);
+    memset(big, 'z', 32 * 1024);
+    svg_cache_key_t other = width_key(2000);
+    put_str(&other, big, 32 * 1024);
+    ASSERT(svg_cache_get(&other) == NULL);
+    free(big);
+
+    svg_cache_free();
+}
+
+TEST_MAIN()
+    RUN(svg_cache_put_get_shares_buffer);
+    RUN(svg_cache_key_fields_distinguish);
+    RUN(svg_cache_disabled_before_init);
+    RUN(svg_cache_put_replaces_entry);
+    RUN(svg_cache_variant_stored_with_entry);
+    RUN(svg_cache_variant_follows_render);
+    RUN(svg_cache_ttl_expiry);
+    RUN(svg_cache_single_flight_shares_result);
+    RUN(svg_cache_single_flight_shares_failure);
+    RUN(svg_cache_budget_bounds_memory);
+    RUN(svg_cache_budget_keeps_hit_entries);
+    RUN(svg_cache_budget_counts_variants);
+TEST_RETURN()
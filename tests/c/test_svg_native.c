@@ -0,0 +1,270 @@
+/**
+ * @file test_svg_native.c
+ * @brief Golden-тесты нативного рендерера (src/rrd/svg_native.c)
+ *
+ * Эталоны tests/c/golden/<name>.svg — вывод generate_svg.js (движок "js").
+ * Для каждого набора данных оба движка должны совпасть с эталоном байт в
+ * байт: нативный — чтобы порт не расходился с JS, JS — чтобы изменение
+ * внешнего вида в скрипте не прошло без правки порта.
+ *
+ * Наборы покрывают все ветки подписей времени, темы, преобразования,
+ * форматы значений (включая точные «половинки» toFixed), разрывы рядов,
+ * экранирование имён, перенос легенды, цикл цветов, stat-панель и ошибки.
+ *
+ * Обновить эталоны после правки generate_svg.js (и svg_native.c):
+ *   SVGD_UPDATE_GOLDEN=1 make test-c
+ * Время — в UTC (TZ задаётся тестом).
+ */
+#include "minitest.h"
+#include "rrd/svg.h"
+#include "rrd/svg_native.h"
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#define GOLDEN_DIR "tests/c/golden/"
+#define SCRIPT "src/scripts/generate_svg.js"
+#define MAX_SERIES 8
+#define MAX_POINTS 64
+#define T0 1700000000
+
+typedef struct {
+    const char *name;               /* tests/c/golden/<name>.svg */
+    int width, height;
+    const char *theme;
+    const char *param1;
+    const char *series_names[MAX_SERIES];
+    int series_count;
+    MetricConfig metric;
+} fixture_t;
+
+static DataPoint points[MAX_SERIES][MAX_POINTS];
+static int counts[MAX_SERIES];
+
+/* svg.c берёт флаг verbose из main.c */
+int is_verbose_logging(void) { return 0; }
+
+/* Детерминированный «шумный» ряд: base + amp * ((i * 37 + phase) % 101) / 100 */
+static void fill(int s, int n, time_t start, int step, double base, double amp, int phase) {
+    counts[s] = n;
+    for (int i = 0; i < n; i++) {
+        points[s][i].timestamp = start + (time_t)i * step;
+        points[s][i].value = base + amp * ((i * 37 + phase) % 101) / 100.0;
+    }
+}
+
+static void fill_fixture(const char *name) {
+    memset(counts, 0, sizeof counts);
+    if (strcmp(name, "chart_light") == 0) {
+        /* 47 мин (ЧЧ:ММ:СС), NaN, отрицательное значение, разрыв по времени */
+        fill(0, 48, T0, 60, 10, 80, 0);
+        fill(1, 48, T0, 60, 5, 20, 13);
+        points[0][7].value = NAN;
+        points[1][20].value = -1;
+        for (int i = 30; i < 48; i++) {
+            points[0][i].timestamp += 600;
+            points[1][i].timestamp += 600;
+        }
+        points[0][47].value = 0.125;                 /* toFixed(2): "0.13" */
+    } else if (strcmp(name, "chart_dark_percent") == 0) {
+        /* 5 ч (ЧЧ:ММ), проценты, multiply, имя с кавычкой и пробелом */
+        fill(0, 30, T0, 600, 0, 1, 3);
+        points[0][29].value = 0.5;
+    } else if (strcmp(name, "chart_hc_divide") == 0) {
+        /* 3 дня (М/Д ЧЧ:ММ), divide, "%d", перенос легенды */
+        fill(0, 36, T0, 7200, 0, 8192, 5);
+        fill(1, 36, T0, 7200, 1024, 4096, 50);
+        fill(2, 36, T0, 7200, 0, 2048, 77);
+        points[0][35].value = 2560;                  /* 2.5 -> Math.round: 3 */
+        points[1][35].value = 1536;                  /* 1.5 -> 2 */
+    } else if (strcmp(name, "chart_week") == 0) {
+        /* 10.5 дней (М/Д), 7 рядов — цвета по кругу, точные половинки */
+        for (int s = 0; s < 7; s++) fill(s, 8, T0, 129600, s, 3, s * 11);
+        points[0][7].value = 2.675;
+        points[1][7].value = 1.005;
+        points[2][7].value = 0.375;
+        points[3][7].value = 1099511627776.125;      /* > 2^32 * 100: printf дал бы .12 */
+    } else if (strcmp(name, "chart_flat") == 0) {
+        /* Одна точка во втором ряду, постоянные значения, пустой ряд */
+        fill(0, 12, T0, 10, 42, 0, 0);
+        fill(2, 1, T0 + 50, 10, 7, 0, 0);
+    } else if (strcmp(name, "chart_no_valid") == 0) {
+        fill(0, 5, T0, 60, -5, 1, 0);
+    } else if (strcmp(name, "stat_light") == 0) {
+        fill(0, 40, T0, 60, 100, 50, 9);
+        points[0][0].value = 100;
+        points[0][39].value = 112.125;
+    } else if (strcmp(name, "stat_dark_divide") == 0) {
+        /* Два ряда со сдвигом 30 с: сортировка по времени перемешивает их */
+        fill(0, 20, T0, 60, 2048, 1024, 1);
+        fill(1, 20, T0 + 30, 60, 1024, 1024, 40);
+        points[0][0].value = 4096;
+        points[1][19].value = 1000;
+    } else if (strcmp(name, "stat_no_data") == 0) {
+        fill(0, 3, T0, 60, 0, 0, 0);
+        for (int i = 0; i < 3; i++) points[0][i].value = NAN;
+    }
+}
+
+static const fixture_t fixtures[] = {
+    { "chart_light", 800, 450, "light", "postgres", { "user", "system" }, 2,
+      { .title = "CPU %s ($&)", .y_label = "%", .transform_type = "none",
+        .value_format = "%.2f", .panel_type = "chart" } },
+    { "chart_dark_percent", 640, 360, "Dark", "", { "it's a b" }, 1,
+      { .title = "Usage", .y_label = "", .is_percentage = 1, .transform_type = "multiply",
+        .value_multiplier = 100, .value_format = "%.1f", .panel_type = "chart" } },
+    { "chart_hc_divide", 333, 177, "high-contrast", "", { "rx", "tx", "дисk" }, 3,
+      { .title = "Net", .y_label = "KiB/s", .transform_type = "divide",
+        .transform_divisor = 1024, .value_format = "%d", .panel_type = "chart" } },
+    { "chart_week", 1200, 300, "light", "", { "a", "b", "c", "d", "e", "f", "g" }, 7,
+      { .title = "", .y_label = "load", .transform_type = "none",
+        .value_format = "%.2f", .panel_type = "" } },
+    { "chart_flat", 500, 250, "nope", "", { "flat", "empty", "one" }, 3,
+      { .title = "Flat", .transform_type = "none", .value_format = "%.0f",
+        .panel_type = "chart" } },
+    { "chart_no_valid", 400, 200, "dark", "", { "neg" }, 1,
+      { .title = "x", .transform_type = "none", .value_format = "%.2f", .panel_type = "chart" } },
+    { "chart_no_series", 400, 200, "light", "", { "empty" }, 1,
+      { .title = "x", .transform_type = "none", .value_format = "%.2f", .panel_type = "chart" } },
+    { "stat_light", 300, 150, "light", "", { "ram" }, 1,
+      { .title = "RAM", .y_label = "MB", .transform_type = "none",
+        .value_format = "%.2f", .panel_type = "stat" } },
+    { "stat_dark_divide", 250, 120, "dark", "", { "a", "b" }, 2,
+      { .title = "", .y_label = "", .transform_type = "divide", .transform_divisor = 1024,
+        .value_format = "%.1f", .panel_type = "stat" } },
+    { "stat_no_data", 300, 150, "high-contrast", "", { "nan" }, 1,
+      { .title = "Empty", .transform_type = "none", .value_format = "%.2f",
+        .panel_type = "stat" } },
+};
+
+#define FIXTURE_COUNT ((int)(sizeof fixtures / sizeof fixtures[0]))
+
+static MetricData make_data(const fixture_t *f) {
+    static char *names[MAX_SERIES];
+    static DataPoint *series[MAX_SERIES];
+    fill_fixture(f->name);
+    for (int s = 0; s < f->series_count; s++) {
+        names[s] = (char *)f->series_names[s];
+        series[s] = points[s];
+    }
+    MetricData md;
+    memset(&md, 0, sizeof md);
+    md.series_count = f->series_count;
+    md.series_names = names;
+    md.series_data = series;
+    md.series_counts = counts;
+    md.param1 = (char *)f->param1;
+    return md;
+}
+
+static char *render(const fixture_t *f, svg_render_engine_t engine) {
+    MetricData md = make_data(f);
+    svg_set_render_engine(engine);
+    size_t len = 0;
+    char *svg = svg_generate(SCRIPT, &md, &f->metric, f->width, f->height, f->theme, &len);
+    svg_set_render_engine(SVG_ENGINE_JS);
+    /* Длина уходит в кэш и в Content-Length без strlen — должна совпадать */
+    if (svg && len != strlen(svg)) {
+        printf("\n    %s: out_len %zu, strlen %zu\n", f->name, len, strlen(svg));
+        free(svg);
+        return NULL;
+    }
+    return svg;
+}
+
+static char *read_file(const char *path) {
+    FILE *fp = fopen(path, "rb");
+    if (!fp) return NULL;
+    fseek(fp, 0, SEEK_END);
+    long len = ftell(fp);
+    fseek(fp, 0, SEEK_SET);
+    char *buf = malloc(len + 1);
+    if (buf && fread(buf, 1, len, fp) != (size_t)len) {
+        free(buf);
+        buf = NULL;
+    }
+    if (buf) buf[len] = '\0';
+    fclose(fp);
+    return buf;
+}
+
+/* Печатает место первого расхождения — проще найти, что разошлось */
+static int same(const char *what, const char *name, const char *got, const char *want) {
+    if (got && want && strcmp(got, want) == 0) return 1;
+    if (!got || !want) {
+        printf("\n    %s %s: %s\n", what, name, got ? "no golden file" : "render failed");
+        return 0;
+    }
+    size_t i = 0;
+    while (got[i] && got[i] == want[i]) i++;
+    size_t from = i > 40 ? i - 40 : 0;
+    printf("\n    %s %s differs at byte %zu:\n      got:  %.100s\n      want: %.100s\n",
+           what, name, i, got + from, want + from);
+    return 0;
+}
+
+static void update_golden(void) {
+    for (int i = 0; i < FIXTURE_COUNT; i++) {
+        char path[256];
+        snprintf(path, sizeof path, GOLDEN_DIR "%s.svg", fixtures[i].name);
+        char *svg = render(&fixtures[i], SVG_ENGINE_JS);
+        FILE *fp = svg ? fopen(path, "wb") : NULL;
+        if (fp) {
+            fputs(svg, fp);
+            fclose(fp);
+        }
+        printf("  updated %s%s\n", path, fp ? "" : " (FAILED)");
+        free(svg);
+    }
+}
+
+TEST(native_matches_golden) {
+    int ok = 1;
+    for (int i = 0; i < FIXTURE_COUNT; i++) {
+        char path[256];
+        snprintf(path, sizeof path, GOLDEN_DIR "%s.svg", fixtures[i].name);
+        char *want = read_file(path);
+        char *got = render(&fixtures[i], SVG_ENGINE_NATIVE);
+        ok &= same("native", fixtures[i].name, got, want);
+        free(got);
+        free(want);
+    }
+    ASSERT(ok);
+}
+
+TEST(js_matches_golden) {
+    int ok = 1;
+    for (int i = 0; i < FIXTURE_COUNT; i++) {
+        char path[256];
+        snprintf(path, sizeof path, GOLDEN_DIR "%s.svg", fixtures[i].name);
+        char *want = read_file(path);
+        char *got = render(&fixtures[i], SVG_ENGINE_JS);
+        ok &= same("js", fixtures[i].name, got, want);
+        free(got);
+        free(want);
+    }
+    ASSERT(ok);
+}
+
+TEST(engine_parse) {
+    svg_render_engine_t e = SVG_ENGINE_JS;
+    ASSERT(svg_render_engine_parse("native", &e) == 0 && e == SVG_ENGINE_NATIVE);
+    ASSERT(svg_render_engine_parse("js", &e) == 0 && e == SVG_ENGINE_JS);
+    ASSERT(svg_render_engine_parse("Native", &e) == -1);
+    ASSERT(svg_render_engine_parse(NULL, &e) == -1);
+}
+
+TEST_MAIN()
+    setenv("TZ", "UTC", 1);
+    tzset();
+    if (svg_init_cache(SCRIPT) != 0) {
+        printf("  cannot read %s\n", SCRIPT);
+        return 1;
+    }
+    if (getenv("SVGD_UPDATE_GOLDEN")) update_golden();
+    RUN(native_matches_golden);
+    RUN(js_matches_golden);
+    RUN(engine_parse);
+    svg_free_cache();
+TEST_RETURN()
@@ -0,0 +1,139 @@
+/**
+ * @file test_task_pool.c
+ * @brief Unit-тесты пула рендер-потоков для _batch (src/task_pool.c)
+ *
+ * svg.c не линкуется: svg_prewarm_context() подменён фейком, который считает
+ * прогретые потоки. Проверяем, что каждый индекс выполняется ровно один раз,
+ * что без пула задачи идут на вызывающем потоке, что пул действительно
+ * распараллеливает и что несколько одновременных batch-запросов завершаются.
+ */
+#include "minitest.h"
+#include "task_pool.h"
+#include <stdlib.h>
+#include <unistd.h>      /* usleep() */
+#include <pthread.h>
+
+/* ---- фейковый прогрев контекста ---- */
+static int fake_prewarms = 0;
+static pthread_mutex_t fake_lock = PTHREAD_MUTEX_INITIALIZER;
+
+void svg_prewarm_context(void) {
+    pthread_mutex_lock(&fake_lock);
+    fake_prewarms++;
+    pthread_mutex_unlock(&fake_lock);
+}
+
+/* Ждёт до 1 с, пока прогреются n потоков; возвращает число прогретых. */
+static int wait_prewarms(int n) {
+    int seen = 0;
+    for (int i = 0; i < 100; i++) {
+        pthread_mutex_lock(&fake_lock);
+        seen = fake_prewarms;
+        pthread_mutex_unlock(&fake_lock);
+        if (seen >= n) break;
+        usleep(10000);
+    }
+    return seen;
+}
+
+#define MAX_TASKS 256
+
+typedef struct {
+    int runs[MAX_TASKS];
+    pthread_t threads[MAX_TASKS];
+    int sleep_us;
+    pthread_mutex_t lock;
+} tasks_t;
+
+static void record_task(void *arg, int index) {
+    tasks_t *t = arg;
+    if (t->sleep_us) usleep((useconds_t)t->sleep_us);
+    pthread_mutex_lock(&t->lock);
+    t->runs[index]++;
+    t->threads[index] = pthread_self();
+    pthread_mutex_unlock(&t->lock);
+}
+
+static int each_ran_once(const tasks_t *t, int count) {
+    for (int i = 0; i < count; i++) {
+        if (t->runs[i] != 1) return 0;
+    }
+    return 1;
+}
+
+static int distinct_threads(const tasks_t *t, int count) {
+    int n = 0;
+    for (int i = 0; i < count; i++) {
+        int seen = 0;
+        for (int j = 0; j < i && !seen; j++) seen = pthread_equal(t->threads[i], t->threads[j]);
+        if (!seen) n++;
+    }
+    return n;
+}
+
+/* Без запущенного пула всё выполняется на вызывающем потоке. */
+TEST(task_pool_inline_without_threads) {
+    static tasks_t t = { .lock = PTHREAD_MUTEX_INITIALIZER };
+    task_pool_run(record_task, &t, 10);
+    ASSERT(each_ran_once(&t, 10));
+    for (int i = 0; i < 10; i++) ASSERT(pthread_equal(t.threads[i], pthread_self()));
+
+    /* count <= 0 — ничего не делает */
+    task_pool_run(record_task, &t, 0);
+    ASSERT(each_ran_once(&t, 10));
+
+    ASSERT(task_pool_start(0) == 0);
+    ASSERT(wait_prewarms(0) == 0);
+}
+
+/* С пулом задачи расходятся по нескольким потокам, каждая — один раз. */
+TEST(task_pool_runs_in_parallel) {
+    ASSERT(task_pool_start(3) == 0);
+    ASSERT(wait_prewarms(3) == 3);
+
+    static tasks_t t = { .sleep_us = 2000, .lock = PTHREAD_MUTEX_INITIALIZER };
+    task_pool_run(record_task, &t, 64);
+    ASSERT(each_ran_once(&t, 64));
+    ASSERT(distinct_threads(&t, 64) > 1);
+
+    task_pool_stop();
+}
+
+#define CALLERS 6
+
+static void *caller_main(void *arg) {
+    task_pool_run(record_task, arg, 40);
+    return NULL;
+}
+
+/* Одновременные batch-запросы делят пул и все завершаются. */
+TEST(task_pool_concurrent_batches) {
+    ASSERT(task_pool_start(2) == 0);
+
+    static tasks_t t[CALLERS];
+    pthread_t callers[CALLERS];
+    for (int i = 0; i < CALLERS; i++) {
+        pthread_mutex_init(&t[i].lock, NULL);
+        t[i].sleep_us = 500;
+        pthread_create(&callers[i], NULL, caller_main, &t[i]);
+    }
+    for (int i = 0; i < CALLERS; i++) pthread_join(callers[i], NULL);
+    for (int i = 0; i < CALLERS; i++) ASSERT(each_ran_once(&t[i], 40));
+
+    task_pool_stop();
+}
+
+/* После stop пул снова работает inline. */
+TEST(task_pool_inline_after_stop) {
+    static tasks_t t = { .lock = PTHREAD_MUTEX_INITIALIZER };
+    task_pool_run(record_task, &t, 5);
+    ASSERT(each_ran_once(&t, 5));
+    for (int i = 0; i < 5; i++) ASSERT(pthread_equal(t.threads[i], pthread_self()));
+}
+
+TEST_MAIN()
+    RUN(task_pool_inline_without_threads);
+    RUN(task_pool_runs_in_parallel);
+    RUN(task_pool_concurrent_batches);
+    RUN(task_pool_inline_after_stop);
+TEST_RETURN()